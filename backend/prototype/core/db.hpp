@@ -2,25 +2,24 @@
 
 #include <cassert>
 #include <cstring>
-#include <mutex>
 #include <unordered_map>
 #include <vector>
 
 #include "../storage/policy/basic_partitioning_strategy.hpp"
 #include "../storage/guard.hpp"
+#include "../storage/persistence/table.hpp"
 #include "../storage/vmcache.hpp"
 
 #define ROOT_PID 0
 
 class ExecutionContext;
-struct TableBasepage;
 
 class DB {
     friend class ColumnHelper;
 
 public:
-    DB(size_t memory_limit, const std::string& path, bool sandbox, bool no_dirty_writeback, bool flush_asynchronously, bool use_eviction_target, const size_t num_workers, bool use_exmap, bool stats_on_shutdown, std::unique_ptr<PartitioningStrategy>&& partitioning_strategy, size_t max_size_in_pages = 4ull * 1024ull * 1024ull);
-    DB(size_t memory_limit, const std::string& path, bool sandbox, bool no_dirty_writeback, bool flush_asynchronously, bool use_eviction_target, const size_t num_workers, bool use_exmap, bool stats_on_shutdown = false, size_t max_size_in_pages = 4ull * 1024ull * 1024ull);
+    DB(const VMCacheConfig& config, std::unique_ptr<PartitioningStrategy>&& partitioning_strategy);
+    explicit DB(const VMCacheConfig& config); // uses clock eviction
 
     uint64_t createSchema(const std::string& schema_name, uint32_t worker_id);
     uint64_t createTable(uint64_t schema_id, const std::string& table_name, size_t num_columns, uint32_t worker_id);
@@ -32,15 +31,26 @@ public:
     void appendValues(size_t existing_rows, PageId column_base, typename std::vector<T>::iterator begin, typename std::vector<T>::iterator end, uint32_t worker_id);
     void appendFixedSizeValue(size_t existing_rows, PageId column_base, const void* value, size_t len, uint32_t worker_id);
     void appendFixedSizeValues(size_t existing_rows, PageId column_base, const void* values, size_t value_len, size_t num_values, uint32_t worker_id);
+    // returns the next row id of the block of rows the worker has reserved in the relation (see 'VisibilityBitmap::reserveBlock()'), a new block is reserved once it is used up
+    // workers that insert concurrently thus latch different bitmap and column data pages, the row is inserted with 'VisibilityBitmap::insertReserved()'
+    RowId reserveRowId(PageId visibility_basepage, uint32_t worker_id);
     size_t getNumTables(uint32_t worker_id);
     PageId getTableBasepageId(uint64_t tid, uint32_t worker_id);
     PageId getTableBasepageId(const std::string& table_name, uint32_t worker_id);
+    // columns of tables created afterwards store their data in extents of EXTENT_NUM_PAGES pages instead of single pages (see 'VMCache::allocateExtent()'), so scans fault, latch and evict a sixteenth of the data pages; the page size is persisted per column
+    void setColumnExtents(bool enabled);
 
     VMCache vmcache;
     uint64_t default_schema_id;
 
 private:
     PageId createTableInternal(size_t num_columns, uint32_t worker_id);
-    std::mutex append_pids_mutex;
-    std::unordered_map<PageId, PageId> append_pids;
+    // rows are appended by several threads at a time, each thread only accesses its own state
+    struct alignas(64) AppendState {
+        std::unordered_map<PageId, std::pair<size_t, PageId>> data_pages; // index and pid of the data page of a column (by its basepage) that was appended to last
+        std::unordered_map<PageId, size_t> data_page_sizes; // number of pages per data page of a column (by its basepage), which is fixed when the column is created
+        std::unordered_map<PageId, std::pair<RowId, RowId>> reserved_rows; // the range of row ids of a relation (by its visibility basepage) that is still reserved for the thread
+    };
+    std::vector<AppendState> append_states; // one per thread
+    bool column_extents;
 };
\ No newline at end of file
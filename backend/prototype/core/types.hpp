@@ -4,6 +4,7 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 typedef int32_t Integer;
 typedef uint32_t Identifier;
@@ -7,6 +7,8 @@ const size_t LOCAL_HT_SIZE = PAGE_SIZE;
 #define LOCAL_HT_NUM_PAGES (PAGE_SIZE / LOCAL_HT_SIZE)
 #define LOCAL_HT_BITSET_SIZE(capacity) ((((capacity) + 7) / 8 + 7) / 8 * 8)
 #define LOCAL_HT_SIZE_SIZE sizeof(uint64_t)
+// estimated cost of aggregating a row into a local hash table, used to hint the cost of recomputing the hash table (see 'VMCache::allocateTemporaryHugePage()')
+#define LOCAL_HT_NS_PER_ROW 10ull
 
 #define BITSET_BLOCK_SIZE (sizeof(uint64_t) * 8)
 #define BIT_SET(bitset, slot) ((((bitset)[(slot) / BITSET_BLOCK_SIZE] >> ((slot) % BITSET_BLOCK_SIZE)) & 0x1) != 0)
@@ -30,7 +32,8 @@ AggregationBreaker::AggregationBreaker(VMCache& vmcache, BatchDescription& batch
 void AggregationBreaker::push(std::shared_ptr<Batch> batch, uint32_t worker_id) {
     // allocate local HT if not allocated yet
     if (hts[worker_id] == nullptr) {
-        hts[worker_id] = vmcache.allocateTemporaryHugePage(LOCAL_HT_NUM_PAGES, worker_id);
+        // a full local hash table holds the aggregates of at least 'ht_capacity' rows
+        hts[worker_id] = vmcache.allocateTemporaryHugePage(LOCAL_HT_NUM_PAGES, worker_id, ht_capacity * LOCAL_HT_NS_PER_ROW / LOCAL_HT_NUM_PAGES);
         memset(hts[worker_id], 0, ht_data_offset);
     }
     // insert keys into local HT
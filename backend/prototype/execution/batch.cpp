@@ -1,20 +1,50 @@
 #include "batch.hpp"
 
-Batch::Batch(VMCache& vmcache, uint32_t row_size, uint32_t worker_id)
+Batch::Batch(VMCache& vmcache, uint32_t row_size, uint32_t worker_id, bool spillable)
 : valid_row_count(0)
 , first_valid_row_id(0)
 , row_size(row_size)
 , current_size(0)
 , max_size(PAGE_SIZE * 8 / (row_size * 8 + 1))
 , worker_id(worker_id)
-, vmcache(vmcache) {
-    char* data_raw = vmcache.allocateTemporaryPage(worker_id);
-    data = reinterpret_cast<uint8_t*>(data_raw);
-    clear(); // pre-fault the page
+, vmcache(vmcache)
+, pid(INVALID_PAGE_ID)
+, pinned(true)
+, modified(true) {
+    if (spillable) {
+        // spillable pages are allocated latched and zeroed
+        pid = vmcache.allocateSpillablePage(worker_id);
+        data = reinterpret_cast<uint8_t*>(vmcache.toPointer(pid));
+    } else {
+        char* data_raw = vmcache.allocateTemporaryPage(worker_id);
+        data = reinterpret_cast<uint8_t*>(data_raw);
+        clear(); // pre-fault the page
+    }
 }
 
 Batch::~Batch() {
-    vmcache.dropTemporaryPage(reinterpret_cast<char*>(data), worker_id);
+    // batches may be destroyed by another worker than the one that created them (e.g., the deferred batches of 'JoinProbe'), so the page is dropped using the current worker's per-worker state
+    //  note: temporary pages are still returned to the pool of the creating worker (see 'TempBlockHeader')
+    const uint32_t dropping_worker_id = VMCache::getCurrentWorkerId(worker_id);
+    if (isSpillable()) {
+        unpin();
+        vmcache.dropSpillablePage(pid, dropping_worker_id);
+    } else {
+        vmcache.dropTemporaryPage(reinterpret_cast<char*>(data), dropping_worker_id);
+    }
+}
+
+std::shared_ptr<Batch> Batch::spillIfOverBudget(std::shared_ptr<Batch> batch, uint32_t worker_id) {
+    const TempMemoryBudget* budget = batch->vmcache.getTempMemoryBudget(worker_id);
+    if (batch->isSpillable() || budget == nullptr || !budget->isExceeded())
+        return batch;
+    std::shared_ptr<Batch> spilled = std::make_shared<Batch>(batch->vmcache, batch->row_size, worker_id, true);
+    memcpy(spilled->data, batch->data, ((batch->max_size + 7) / 8) + batch->current_size * batch->row_size);
+    spilled->valid_row_count = batch->valid_row_count;
+    spilled->first_valid_row_id = batch->first_valid_row_id;
+    spilled->current_size = batch->current_size;
+    spilled->unpin();
+    return spilled;
 }
 
 void BatchDescription::swap(BatchDescription& other) {
@@ -110,7 +110,8 @@ public:
     };
 
     // TODO: dynamic batch sizes depending on row_size, instead of always using 4 kiB?
-    Batch(VMCache& vmcache, uint32_t row_size, uint32_t worker_id);
+    // spillable batches are backed by a page that can be evicted by the cache while the batch is unpinned (see 'unpin()')
+    Batch(VMCache& vmcache, uint32_t row_size, uint32_t worker_id, bool spillable = false);
     ~Batch();
 
     Batch(const Batch& other) = delete;
@@ -207,6 +208,34 @@ public:
         return num_rows;
     }
 
+    bool isSpillable() const { return pid != INVALID_PAGE_ID; }
+    bool isPinned() const { return pinned; }
+
+    // spill path for breakers: if the query that 'worker_id' executes for exceeds its temporary memory budget, the rows of 'batch' are copied into an unpinned spillable batch, so that its page is no longer held as temporary memory; returns the batch that holds the rows afterwards
+    //  note: the returned batch has to be pinned before it is accessed again
+    static std::shared_ptr<Batch> spillIfOverBudget(std::shared_ptr<Batch> batch, uint32_t worker_id);
+
+    // allows the cache to evict the batch's page, the batch must not be accessed until it is pinned again
+    void unpin() {
+        if (isSpillable() && pinned) {
+            if (modified)
+                vmcache.unfixExclusive(pid);
+            else
+                vmcache.unfixExclusiveUnmodified(pid);
+            pinned = false;
+        }
+    }
+
+    // faults the batch's page back in if necessary; 'worker_id' identifies the calling worker, which may differ from the one that created the batch
+    //  a batch pinned with 'modify = false' must only be read until it is unpinned, its page is then not written back again when it is evicted
+    void pin(uint32_t worker_id, bool modify = true) {
+        if (isSpillable() && !pinned) {
+            vmcache.fixExclusive(pid, worker_id);
+            pinned = true;
+            modified = modify;
+        }
+    }
+
     void clear() {
         std::memset(data, 0, (max_size + 7) / 8);
         valid_row_count = 0;
@@ -220,7 +249,10 @@ protected:
     uint32_t row_size; // in bytes
     uint32_t current_size; // in rows
     uint32_t max_size; // in rows
-    uint32_t worker_id;
+    uint32_t worker_id; // worker that created the batch
     VMCache& vmcache;
     uint8_t* data; // stores a bitvector for row validity and the raw tuple data
+    PageId pid; // page backing 'data' for spillable batches, otherwise INVALID_PAGE_ID
+    bool pinned;
+    bool modified; // whether the batch may have been modified since it was last pinned
 };
\ No newline at end of file
@@ -9,8 +9,8 @@
 
 #include "../utils/CSV.hpp"
 #include "../core/db.hpp"
-#include "../storage/persistence/btree.hpp"
 #include "../storage/persistence/table.hpp"
+#include "../storage/persistence/visibility_bitmap.hpp"
 #include "pipeline.hpp"
 #include "pipeline_breaker.hpp"
 
@@ -99,50 +99,50 @@ public:
         }
         const size_t parsed_rows = parse_csv_chunk(csv, from, to - from, sep, types, local_destinations);
 
-        // thread-local access to the relation's visibility B+-Tree
-        BTree<RowId, bool> visibility(db.vmcache, visibility_root_pid, worker_id);
-
-        // copy parsed rows to main db
-        {
-            for (size_t j = 0; j < parsed_rows; j++) {
-                auto insert_guard = visibility.insertNext(true);
-                RowId rid = insert_guard.key;
-                for (size_t i = 0; i < num_columns; i++) {
-                    auto iter = columns.find(i);
-                    if (iter != columns.end()) {
-                        switch (iter->second.type.type) {
-                            case ParseType::Int32: {
-                                    std::vector<uint32_t>* vec = reinterpret_cast<std::vector<uint32_t>*>(local_destinations[i]);
-                                    db.appendFixedSizeValue(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(uint32_t), worker_id);
-                                    break;
-                                }
-                            case ParseType::Date: {
-                                    std::vector<uint32_t>* vec = reinterpret_cast<std::vector<uint32_t>*>(local_destinations[i]);
-                                    db.appendFixedSizeValue(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(uint32_t), worker_id);
-                                    break;
-                                }
-                            case ParseType::DateTime: {
-                                    std::vector<uint64_t>* vec = reinterpret_cast<std::vector<uint64_t>*>(local_destinations[i]);
-                                    db.appendFixedSizeValue(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(uint64_t), worker_id);
-                                    break;
-                                }
-                            case ParseType::Decimal: {
-                                    std::vector<int64_t>* vec = reinterpret_cast<std::vector<int64_t>*>(local_destinations[i]);
-                                    db.appendFixedSizeValue(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(int64_t), worker_id);
-                                    break;
-                                }
-                            case ParseType::Char: {
-                                    std::vector<char>* vec = reinterpret_cast<std::vector<char>*>(local_destinations[i]);
-                                    const size_t str_len = iter->second.type.params.len;
-                                    db.appendFixedSizeValue(rid, iter->second.destination_column_basepage, vec->data() + j * str_len, str_len, worker_id);
-                                    break;
-                                }
-                            default:
-                                throw std::runtime_error("Unsupported type in CSVColumnSpec");
-                        }
+        // thread-local access to the relation's visibility bitmap
+        VisibilityBitmap visibility(db.vmcache, visibility_root_pid, worker_id);
+
+        // copy parsed rows to main db, reserving as many consecutive row ids as fit into the last visibility bitmap page at once so that its latch is acquired once per reserved range instead of once per row
+        for (size_t j = 0; j < parsed_rows; ) {
+            auto insert_guard = visibility.insertNext(true, parsed_rows - j);
+            const RowId rid = insert_guard.rid;
+            const size_t count = insert_guard.count;
+            for (size_t i = 0; i < num_columns; i++) {
+                auto iter = columns.find(i);
+                if (iter != columns.end()) {
+                    switch (iter->second.type.type) {
+                        case ParseType::Int32: {
+                                std::vector<uint32_t>* vec = reinterpret_cast<std::vector<uint32_t>*>(local_destinations[i]);
+                                db.appendFixedSizeValues(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(uint32_t), count, worker_id);
+                                break;
+                            }
+                        case ParseType::Date: {
+                                std::vector<uint32_t>* vec = reinterpret_cast<std::vector<uint32_t>*>(local_destinations[i]);
+                                db.appendFixedSizeValues(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(uint32_t), count, worker_id);
+                                break;
+                            }
+                        case ParseType::DateTime: {
+                                std::vector<uint64_t>* vec = reinterpret_cast<std::vector<uint64_t>*>(local_destinations[i]);
+                                db.appendFixedSizeValues(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(uint64_t), count, worker_id);
+                                break;
+                            }
+                        case ParseType::Decimal: {
+                                std::vector<int64_t>* vec = reinterpret_cast<std::vector<int64_t>*>(local_destinations[i]);
+                                db.appendFixedSizeValues(rid, iter->second.destination_column_basepage, vec->data() + j, sizeof(int64_t), count, worker_id);
+                                break;
+                            }
+                        case ParseType::Char: {
+                                std::vector<char>* vec = reinterpret_cast<std::vector<char>*>(local_destinations[i]);
+                                const size_t str_len = iter->second.type.params.len;
+                                db.appendFixedSizeValues(rid, iter->second.destination_column_basepage, vec->data() + j * str_len, str_len, count, worker_id);
+                                break;
+                            }
+                        default:
+                            throw std::runtime_error("Unsupported type in CSVColumnSpec");
                     }
                 }
             }
+            j += count;
         }
         csv.close();
         for (size_t i = 0; i < num_columns; i++) {
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "../core/types.hpp"
+#include "../scheduling/dispatcher.hpp"
+#include "../scheduling/execution_context.hpp"
+#include "../scheduling/job.hpp"
+#include "../storage/persistence/btree.hpp"
+#include "../storage/persistence/table.hpp"
+#include "../storage/persistence/visibility_bitmap.hpp"
+#include "paged_vector_iterator.hpp"
+
+#define INDEX_BUILD_EXPECTED_TIME_PER_ROW 0.0000002
+#define INDEX_BUILD_MIN_MORSEL_SIZE 4096ul
+
+class IndexBuildJobBase : public Job {
+public:
+    IndexBuildJobBase() : finished(false) { }
+
+    void finalize(const ExecutionContext) override { finished = true; }
+
+    // helps executing scheduled jobs until this job has finished
+    void waitForExecution(const ExecutionContext context) const {
+        while (!finished)
+            context.getDispatcher().runNext(context, true);
+    }
+
+private:
+    std::atomic_bool finished;
+};
+
+/*
+Extracts the (composite) keys of all visible rows of a table, each morsel of rows yields one run of key/row id pairs that
+is sorted by key. The runs are stored in temporary pages, so that they are accounted and limited like the memory of other
+operators. Once the job has finished, the runs can be bulk loaded into an index, see 'buildCompositeKeyIndex()'.
+*/
+template <size_t n>
+class IndexBuildJob : public IndexBuildJobBase {
+public:
+    typedef std::pair<CompositeKey<n>, size_t> Entry;
+
+    // a run occupies the temporary pages allocated for the morsel's rows, of which the visible ones are used
+    struct Run {
+        Entry* entries;
+        size_t num_entries;
+        size_t num_pages;
+
+        size_t size() const { return num_entries; }
+        bool empty() const { return num_entries == 0; }
+        const Entry& operator[](size_t i) const { return entries[i]; }
+    };
+
+    // 'key_columns': basepages of the uint32_t columns that make up the key, in key order
+    IndexBuildJob(VMCache& vmcache, PageId visibility_basepage, const std::array<PageId, n>& key_columns, const uint32_t worker_id)
+        : vmcache(vmcache)
+        , visibility_basepage(visibility_basepage)
+        , key_columns(key_columns)
+        , worker_id(worker_id) {
+        next_row = 0;
+        last_row = VisibilityBitmap(vmcache, visibility_basepage, worker_id).getNumRows();
+    }
+
+    ~IndexBuildJob() {
+        // the runs are returned to the temporary page pool of the worker that created the job
+        for (const Run& run : runs)
+            vmcache.dropTemporaryHugePage(reinterpret_cast<char*>(run.entries), run.num_pages, worker_id);
+    }
+
+    size_t getSize() const override { return last_row - std::min(next_row.load(), last_row); }
+    double getExpectedTimePerUnit() const override { return INDEX_BUILD_EXPECTED_TIME_PER_ROW; }
+    size_t getMinMorselSize() const override { return INDEX_BUILD_MIN_MORSEL_SIZE; }
+
+    bool executeNextMorsel(size_t morsel_size, const ExecutionContext context) override {
+        const size_t from = next_row.fetch_add(morsel_size);
+        if (from >= last_row)
+            return false;
+        const size_t to = std::min(from + morsel_size, last_row);
+
+        Run run;
+        run.num_entries = 0;
+        run.num_pages = ((to - from) * sizeof(Entry) + PAGE_SIZE - 1) / PAGE_SIZE;
+        // losing the run means extracting the morsel's keys again
+        const uint64_t page_cost_ns = std::max<uint64_t>(INDEX_BUILD_EXPECTED_TIME_PER_ROW * 1e9 * (to - from) / run.num_pages, 1);
+        run.entries = reinterpret_cast<Entry*>(vmcache.allocateTemporaryHugePage(run.num_pages, context.getWorkerId(), page_cost_ns));
+        {
+            VisibilityBitmap visibility(vmcache, visibility_basepage, context.getWorkerId());
+            std::vector<PagedVectorIterator<uint32_t>> key_its;
+            key_its.reserve(n);
+            for (size_t i = 0; i < n; i++)
+                key_its.emplace_back(vmcache, key_columns[i], GeneralPagedVectorIterator::UNLOAD, context.getWorkerId());
+            visibility.forEachVisible(from, to, [&](RowId rid) {
+                CompositeKey<n> key;
+                for (size_t i = 0; i < n; i++) {
+                    key_its[i].reposition(rid);
+                    key.keys[i] = *key_its[i];
+                }
+                new (&run.entries[run.num_entries++]) Entry(key, rid);
+                return true;
+            }, [&] {
+                // the key columns' pages must not stay latched while the next bitmap page is latched, as concurrent inserts latch them in the opposite order
+                for (size_t i = 0; i < n; i++)
+                    key_its[i].release();
+            });
+        }
+        std::sort(run.entries, run.entries + run.num_entries, [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::unique_lock<std::mutex> lock(runs_mutex);
+        runs.push_back(std::move(run));
+        return true;
+    }
+
+    const std::vector<Run>& getRuns() const { return runs; }
+
+private:
+    VMCache& vmcache;
+    const PageId visibility_basepage;
+    const std::array<PageId, n> key_columns;
+    const uint32_t worker_id;
+    std::atomic<size_t> next_row;
+    size_t last_row;
+    std::mutex runs_mutex;
+    std::vector<Run> runs;
+};
+
+// extracts the keys of all visible rows in parallel and bulk loads them into the (empty) 'index'
+template <size_t n>
+void buildCompositeKeyIndex(BTree<CompositeKey<n>, size_t>& index, VMCache& vmcache, PageId visibility_basepage, const std::array<PageId, n>& key_columns, const ExecutionContext context) {
+    auto job = std::make_shared<IndexBuildJob<n>>(vmcache, visibility_basepage, key_columns, context.getWorkerId());
+    context.getDispatcher().scheduleJob(job, context);
+    job->waitForExecution(context);
+    index.bulkLoad(job->getRuns());
+}
\ No newline at end of file
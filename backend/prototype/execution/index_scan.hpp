@@ -5,6 +5,7 @@
 #include "../storage/guard.hpp"
 #include "../storage/persistence/btree.hpp"
 #include "../storage/persistence/table.hpp"
+#include "../storage/persistence/visibility_bitmap.hpp"
 #include "../utils/memcpy.hpp"
 #include "pipeline_starter.hpp"
 #include "paged_vector_iterator.hpp"
@@ -49,7 +50,7 @@ public:
         assert(from == 0);
         assert(to == 1);
         BTree<CompositeKey<n_keys>, size_t> index(db.vmcache, index_root_page, worker_id);
-        BTree<RowId, bool> visibility(db.vmcache, visibility_root_page, worker_id);
+        VisibilityBitmap visibility(db.vmcache, visibility_root_page, worker_id);
         auto it = index.lookup(from_search_value);
         std::vector<GeneralPagedVectorIterator> worker_iterators;
         worker_iterators.reserve(basepages.size());
@@ -69,7 +70,7 @@ public:
             // TODO: can we do better? perhaps with optimistic latches?
             it.release();
             // check if row is visible
-            if (!visibility.lookupValue(val.second).value_or(false))
+            if (!visibility.isVisible(val.second))
                 continue;
             // output result row
             char* loc = intermediates.addRow();
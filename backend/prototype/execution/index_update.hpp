@@ -5,6 +5,7 @@
 #include "../storage/guard.hpp"
 #include "../storage/persistence/btree.hpp"
 #include "../storage/persistence/table.hpp"
+#include "../storage/persistence/visibility_bitmap.hpp"
 #include "../utils/memcpy.hpp"
 #include "pipeline_starter.hpp"
 #include "paged_vector_iterator.hpp"
@@ -48,7 +49,7 @@ public:
         assert(from == 0);
         assert(to == 1);
         BTree<CompositeKey<n_keys>, size_t> index(db.vmcache, index_root_pid, worker_id);
-        BTree<RowId, bool> visibility(db.vmcache, visibility_root_pid, worker_id);
+        VisibilityBitmap visibility(db.vmcache, visibility_root_pid, worker_id);
         auto it = index.lookup(from_search_value);
         std::vector<GeneralPagedVectorIterator> worker_iterators;
         worker_iterators.reserve(column_basepage_pids.size());
@@ -66,7 +67,7 @@ public:
             // NOTE: this is inefficient, but required to avoid deadlocks with concurrent inserts (which first latch visibility exclusively and then may perform a primary key insert - if we do not release the shared latch on the primary key here, the insert operation will keep holding the visibility latch while waiting for the primary key page to become available; this causes a deadlock when we attempt to lookup visibility below)
             // TODO: can we do better? perhaps with optimistic latches?
             it.release();
-            // check if row is visible and latch visibility leaf page
+            // check if row is visible and latch its visibility bitmap page
             auto update_guard = visibility.latchForUpdate(val.second);
             if (!update_guard.has_value() || !update_guard->prev_value)
                 continue;
@@ -3,6 +3,61 @@
 #include "../utils/memcpy.hpp"
 #include "../utils/MurmurHash3.hpp"
 
+void JoinBreaker::push(std::shared_ptr<Batch> batch, uint32_t worker_id) {
+    const uint32_t row_size = batch->getRowSize();
+    if (row_size != batch_description.getRowSize() - sizeof(void*))
+        throw std::runtime_error("JoinBreaker: Batch row size does not match batch_description");
+    if (key_size == 0)
+        throw std::runtime_error("JoinBreaker: Key size has not been set");
+    const uint32_t row_size_including_next_ptr = row_size + sizeof(void*);
+
+    // copy rows to the batches of their partitions, leave space for pointers for chained addressing
+    for (uint32_t i = 0; i < batch->getCurrentSize(); i++) {
+        if (!batch->isRowValid(i))
+            continue;
+        const void* row = batch->getRow(i);
+        uint32_t hash;
+        MurmurHash3_x86_32(row, key_size, 1, &hash);
+        std::vector<std::shared_ptr<Batch>>& partition_batches = batches[worker_id][PARTITION_FROM_HASH(hash)];
+        uint32_t row_id;
+        void* loc = partition_batches.empty() ? nullptr : partition_batches.back()->addRowIfPossible(row_id);
+        if (loc == nullptr) {
+            // full batches are not accessed again until the hash table is built, so allow the cache to spill them under memory pressure
+            if (!partition_batches.empty())
+                partition_batches.back()->unpin();
+            partition_batches.push_back(std::make_shared<Batch>(vmcache, row_size_including_next_ptr, worker_id, true));
+            loc = partition_batches.back()->addRowIfPossible(row_id);
+        }
+        *reinterpret_cast<void**>(loc) = nullptr;
+        memcpy(reinterpret_cast<char*>(loc) + sizeof(void*), row, row_size);
+    }
+    valid_row_count += batch->getValidRowCount();
+}
+
+void JoinBreaker::consumePartitions(std::vector<std::shared_ptr<Batch>>& target, std::vector<size_t>& partition_offsets) {
+    if (!target.empty()) {
+        throw std::runtime_error("Target not empty");
+    }
+
+    // TODO: ensure that NUMA-locality is maintained as much as possible
+    size_t batch_count = 0;
+    for (const JoinPartitionBatches& worker_batches : batches) {
+        for (const std::vector<std::shared_ptr<Batch>>& partition_batches : worker_batches)
+            batch_count += partition_batches.size();
+    }
+    target.reserve(batch_count);
+    partition_offsets.clear();
+    for (size_t partition = 0; partition < JOIN_PARTITION_COUNT; partition++) {
+        partition_offsets.push_back(target.size());
+        for (JoinPartitionBatches& worker_batches : batches) {
+            for (std::shared_ptr<Batch>& batch : worker_batches[partition])
+                target.push_back(std::move(batch));
+            worker_batches[partition].clear();
+        }
+    }
+    partition_offsets.push_back(target.size());
+}
+
 template <typename key_type>
 void JoinBuild::joinBuildKernel(size_t from, size_t to) {
     for (size_t i = from; i < to; i++) {
@@ -59,7 +114,7 @@ template void JoinBuild::joinBuildKernel<uint64_t>(size_t from, size_t to);
 
 
 template <typename key_type>
-void JoinProbe::joinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates) {
+void JoinProbe::joinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, bool defer, uint32_t worker_id) {
     for (uint32_t row_id = 0; row_id < batch->getCurrentSize(); row_id++) {
         if (!batch->isRowValid(row_id))
             continue;
@@ -67,6 +122,10 @@ void JoinProbe::joinProbeKernel(const std::shared_ptr<Batch>& batch, Intermediat
         const char* key = reinterpret_cast<const char*>(row);
         uint32_t hash;
         MurmurHash3_x86_32(key, sizeof(key_type), 1, &hash);
+        if (defer && PARTITION_FROM_HASH(hash) != 0) {
+            deferRow(row, batch->getRowSize(), PARTITION_FROM_HASH(hash), worker_id);
+            continue;
+        }
         const size_t slot = (hash >> HASH_TAG_BITS_LOG2) & ((1ull << build->ht_bits) - 1ull);
         const uint64_t expected_tag = TAG_FROM_HASH(hash);
         uint64_t bucket_val = (uint64_t)(reinterpret_cast<void**>(build->ht)[slot]);
@@ -91,7 +150,7 @@ void JoinProbe::joinProbeKernel(const std::shared_ptr<Batch>& batch, Intermediat
     }
 }
 
-void JoinProbe::generalJoinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, size_t key_size) {
+void JoinProbe::generalJoinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, size_t key_size, bool defer, uint32_t worker_id) {
     for (uint32_t row_id = 0; row_id < batch->getCurrentSize(); row_id++) {
         if (!batch->isRowValid(row_id))
             continue;
@@ -99,6 +158,10 @@ void JoinProbe::generalJoinProbeKernel(const std::shared_ptr<Batch>& batch, Inte
         const char* key = reinterpret_cast<const char*>(row);
         uint32_t hash;
         MurmurHash3_x86_32(key, key_size, 1, &hash);
+        if (defer && PARTITION_FROM_HASH(hash) != 0) {
+            deferRow(row, batch->getRowSize(), PARTITION_FROM_HASH(hash), worker_id);
+            continue;
+        }
         const size_t slot = (hash >> HASH_TAG_BITS_LOG2) & ((1ull << build->ht_bits) - 1ull);
         const uint64_t expected_tag = TAG_FROM_HASH(hash);
         uint64_t bucket_val = (uint64_t)(reinterpret_cast<void**>(build->ht)[slot]);
@@ -122,13 +185,87 @@ void JoinProbe::generalJoinProbeKernel(const std::shared_ptr<Batch>& batch, Inte
     }
 }
 
-template void JoinProbe::joinProbeKernel<uint32_t>(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates);
-template void JoinProbe::joinProbeKernel<uint64_t>(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates);
+template void JoinProbe::joinProbeKernel<uint32_t>(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, bool defer, uint32_t worker_id);
+template void JoinProbe::joinProbeKernel<uint64_t>(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, bool defer, uint32_t worker_id);
+
+void JoinProbe::deferRow(const void* row, uint32_t row_size, size_t partition, uint32_t worker_id) {
+    std::vector<std::shared_ptr<Batch>>& batches = deferred_batches[worker_id][partition];
+    uint32_t row_id;
+    void* loc = batches.empty() ? nullptr : batches.back()->addRowIfPossible(row_id);
+    if (loc == nullptr) {
+        // full batches are not accessed again until their partition is probed
+        if (!batches.empty())
+            batches.back()->unpin();
+        batches.push_back(std::make_shared<Batch>(vmcache, row_size, worker_id, true));
+        loc = batches.back()->addRowIfPossible(row_id);
+    }
+    memcpy(loc, row, row_size);
+}
+
+void JoinProbe::finishPush(const ExecutionContext& context, std::function<void(const ExecutionContext&)>&& done) {
+    build->unpinBatches();
+    if (!partitioned) {
+        done(context);
+        return;
+    }
+    // probe the deferred rows one partition at a time, partitions without deferred rows are skipped
+    for (size_t partition = 1; partition < JOIN_PARTITION_COUNT; partition++) {
+        std::vector<std::shared_ptr<Batch>> batches;
+        for (JoinPartitionBatches& worker_batches : deferred_batches) {
+            for (std::shared_ptr<Batch>& batch : worker_batches[partition]) {
+                batch->unpin();
+                batches.push_back(std::move(batch));
+            }
+            worker_batches[partition].clear();
+        }
+        if (!batches.empty())
+            partition_jobs.push_back(std::make_shared<JoinPartitionProbeJob>(*this, partition_jobs.size(), partition, std::move(batches), context.getTempMemoryBudget()));
+    }
+    this->done = std::move(done);
+    startPartitionJob(0, context);
+}
+
+void JoinProbe::startPartitionJob(size_t i, const ExecutionContext& context) {
+    if (i == partition_jobs.size()) {
+        // note: 'done' may destroy this operator, so it is moved out of it first
+        std::function<void(const ExecutionContext&)> done = std::move(this->done);
+        done(context);
+        return;
+    }
+    build->pinPartition(partition_jobs[i]->getPartition(), context.getWorkerId());
+    context.getDispatcher().scheduleJob(partition_jobs[i], context);
+}
+
+void JoinProbe::partitionJobFinished(size_t i, const ExecutionContext& context) {
+    build->unpinPartition(partition_jobs[i]->getPartition());
+    startPartitionJob(i + 1, context);
+}
+
+bool JoinPartitionProbeJob::executeNextMorsel(size_t morsel_size, const ExecutionContext context) {
+    const size_t from = next_batch.fetch_add(morsel_size);
+    if (from >= batches.size())
+        return false;
+    const size_t to = std::min(from + morsel_size, batches.size());
+    TempMemoryBudgetScope budget_scope(context, budget);
+    for (size_t i = from; i < to; i++) {
+        batches[i]->pin(context.getWorkerId(), false);
+        probe.probeBatch(batches[i], false, context.getWorkerId());
+        batches[i] = nullptr; // the deferred rows are not needed anymore
+    }
+    return true;
+}
+
+void JoinPartitionProbeJob::finalize(const ExecutionContext context) {
+    TempMemoryBudgetScope budget_scope(context, budget);
+    // note: this may destroy the job
+    probe.partitionJobFinished(job_index, context);
+}
 
 std::shared_ptr<JoinBuild> JoinFactory::createBuildPipelines(std::vector<std::unique_ptr<ExecutablePipeline>>& pipelines, VMCache& vmcache, const Pipeline& input, const size_t key_size) {
     auto breaker = std::dynamic_pointer_cast<JoinBreaker>(input.breaker);
     if (breaker == nullptr)
         throw std::runtime_error("Pipeline without join breaker supplied as input in createBuildPipelines()!");
+    breaker->setKeySize(key_size);
     BatchDescription output_desc = BatchDescription(std::vector<NamedColumn>({}));
     auto join_build = std::make_shared<JoinBuild>(vmcache, output_desc, breaker, key_size);
     auto join_init = JoinHTInit::create(join_build);
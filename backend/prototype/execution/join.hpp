@@ -1,71 +1,56 @@
 #pragma once
 
+#include <array>
+#include <functional>
+#include <mutex>
+
 #include "pipeline_breaker.hpp"
 #include "../storage/vmcache.hpp"
 
 #define HASH_TAG_BITS 4
 #define HASH_TAG_BITS_LOG2 2
 #define HASH_TAG_MASK (((1ull << HASH_TAG_BITS) - 1ull) << (64 - HASH_TAG_BITS))
+// estimated cost of inserting a build side row into the hash table, used to hint the cost of recomputing the hash table's pages (see 'VMCache::allocateTemporaryHugePage()')
+#define JOIN_BUILD_NS_PER_ROW 20ull
 #define TAG_FROM_HASH(hash) (1ull << (((hash & (HASH_TAG_BITS - 1)) + 64 - HASH_TAG_BITS)))
 
+// the build side rows are split into partitions by their hash; a join whose build side does not fit into memory probes one partition at a time (see 'JoinProbe::finishPush()')
+#define JOIN_PARTITION_BITS 4
+#define JOIN_PARTITION_COUNT (1ull << JOIN_PARTITION_BITS)
+// the partition is given by the lowest bits of the row's hash table slot, so that the chain of a slot only contains rows of a single partition
+#define PARTITION_FROM_HASH(hash) ((hash >> HASH_TAG_BITS_LOG2) & (JOIN_PARTITION_COUNT - 1ull))
+// fraction of the cache's frames that the build side batches may take up while the probe keeps all partitions pinned
+#define JOIN_MAX_RESIDENT_BUILD_FRACTION 0.25
+
+using JoinPartitionBatches = std::array<std::vector<std::shared_ptr<Batch>>, JOIN_PARTITION_COUNT>;
+
 class JoinBreaker : public PipelineBreakerBase {
 public:
-    JoinBreaker(VMCache& vmcache, BatchDescription& batch_description, size_t num_workers) : PipelineBreakerBase(batch_description), vmcache(vmcache), batches(num_workers), valid_row_count(0) { }
+    JoinBreaker(VMCache& vmcache, BatchDescription& batch_description, size_t num_workers) : PipelineBreakerBase(batch_description), vmcache(vmcache), batches(num_workers), key_size(0), valid_row_count(0) { }
 
-    void push(std::shared_ptr<Batch> batch, uint32_t worker_id) override {
-        std::shared_ptr<Batch> current_batch;
-        const uint32_t row_size = batch->getRowSize();
-        if (row_size != batch_description.getRowSize() - sizeof(void*))
-            throw std::runtime_error("JoinBreaker: Batch row size does not match batch_description");
-        const uint32_t row_size_including_next_ptr = row_size + sizeof(void*);
-        if (batches[worker_id].empty()) {
-            batches[worker_id].push_back(std::make_shared<Batch>(vmcache, row_size_including_next_ptr, worker_id));
-        }
-        current_batch = batches[worker_id].back();
-
-        // copy rows to new batches, leave space for pointers for chained addressing
-        for (uint32_t i = 0; i < batch->getCurrentSize(); i++) {
-            if (!batch->isRowValid(i))
-                continue;
-            uint32_t row_id;
-            void* loc = current_batch->addRowIfPossible(row_id);
-            if (loc == nullptr) {
-                batches[worker_id].push_back(std::make_shared<Batch>(vmcache, row_size_including_next_ptr, worker_id));
-                current_batch = batches[worker_id].back();
-                loc = current_batch->addRowIfPossible(row_id);
-            }
-            *reinterpret_cast<void**>(loc) = nullptr;
-            memcpy(reinterpret_cast<char*>(loc) + sizeof(void*), batch->getRow(i), row_size);
-        }
-        valid_row_count += batch->getValidRowCount();
-    }
+    void push(std::shared_ptr<Batch> batch, uint32_t worker_id) override;
 
     void consumeBatches(std::vector<std::shared_ptr<Batch>>& target, uint32_t) override {
-        if (!target.empty()) {
-            throw std::runtime_error("Target not empty");
-        }
-
-        // TODO: ensure that NUMA-locality is maintained as much as possible
-        size_t batch_count = 0;
-        for (const std::vector<std::shared_ptr<Batch>>& worker_batches : batches) {
-            batch_count += worker_batches.size();
-        }
-        target.reserve(batch_count);
-        for (std::vector<std::shared_ptr<Batch>>& worker_batches : batches) {
-            for (std::shared_ptr<Batch>& batch : worker_batches) {
-                target.push_back(batch);
-                batch = nullptr;
-            }
-        }
+        std::vector<size_t> partition_offsets;
+        consumePartitions(target, partition_offsets);
     }
 
+    // moves the batches to 'target' ordered by partition, partition i consists of the batches 'target[partition_offsets[i]]' up to 'target[partition_offsets[i + 1] - 1]'
+    void consumePartitions(std::vector<std::shared_ptr<Batch>>& target, std::vector<size_t>& partition_offsets);
+
+    // rows are partitioned by the hash of their key, so this has to be set before the first push (see 'JoinFactory::createBuildPipelines()')
+    void setKeySize(size_t key_size) { this->key_size = key_size; }
+
     size_t getValidRowCount() const {
         return valid_row_count.load();
     }
 
+    size_t getWorkerCount() const { return batches.size(); }
+
 private:
     VMCache& vmcache;
-    std::vector<std::vector<std::shared_ptr<Batch>>> batches;
+    std::vector<JoinPartitionBatches> batches; // per worker
+    size_t key_size;
     std::atomic_size_t valid_row_count;
 };
 
@@ -74,14 +59,25 @@ public:
     friend class JoinProbe;
     friend class JoinHTInit;
 
-    JoinBuild(VMCache& vmcache, BatchDescription& batch_description, std::shared_ptr<JoinBreaker> input, size_t key_size) : PipelineStarterBreakerBase(batch_description), input(input), key_size(key_size), ht_bits(0), vmcache(vmcache), ht(nullptr) { }
+    JoinBuild(VMCache& vmcache, BatchDescription& batch_description, std::shared_ptr<JoinBreaker> input, size_t key_size)
+    : PipelineStarterBreakerBase(batch_description)
+    , input(input)
+    , key_size(key_size)
+    , ht_bits(0)
+    , max_resident_pages(static_cast<size_t>(vmcache.getMaxPhysicalPages() * JOIN_MAX_RESIDENT_BUILD_FRACTION))
+    , vmcache(vmcache)
+    , ht(nullptr) { }
 
     ~JoinBuild() {
+        unpinBatches();
         if (ht != nullptr)
             vmcache.dropTemporaryHugePage(reinterpret_cast<char*>(ht), std::max((1ull << ht_bits) * sizeof(void*), PAGE_SIZE) / PAGE_SIZE, worker_id);
     }
 
-    void execute(size_t from, size_t to, uint32_t) override {
+    void execute(size_t from, size_t to, uint32_t worker_id) override {
+        // the hash table points directly into the build side batches, which keep their addresses while they are spilled, so they are only pinned while they are accessed (see 'JoinProbe')
+        for (size_t i = from; i < to; i++)
+            batches[i]->pin(worker_id);
         switch (key_size) {
             case 4:
                 joinBuildKernel<uint32_t>(from, to);
@@ -93,6 +89,8 @@ public:
                 generalJoinBuildKernel(from, to, key_size);
                 break;
         }
+        for (size_t i = from; i < to; i++)
+            batches[i]->unpin();
     }
 
     // this operator does not produce any batches, instead it builds the hash table 'ht', which is used by the 'JoinProbe' operator for the probe operation
@@ -101,16 +99,40 @@ public:
     size_t getInputSize() const override { return batches.size(); }
     double getExpectedTimePerUnit() const override { return 0.02; } // morsel size = 1 batch
 
+    // build sides with more batches (i.e., pages) than this are probed one partition at a time
+    void setMaxResidentPages(size_t pages) { max_resident_pages = pages; }
+
 private:
+    // the probe follows the hash table's pointers into the build side batches of a probed row's partition, so these have to be pinned while the partition is probed
+    bool isPartitioned() const { return batches.size() > max_resident_pages; }
+
+    void pinPartition(size_t partition, uint32_t worker_id) {
+        for (size_t i = partition_offsets[partition]; i < partition_offsets[partition + 1]; i++)
+            batches[i]->pin(worker_id, false);
+    }
+
+    void unpinPartition(size_t partition) {
+        for (size_t i = partition_offsets[partition]; i < partition_offsets[partition + 1]; i++)
+            batches[i]->unpin();
+    }
+
+    void unpinBatches() {
+        for (auto& batch : batches)
+            batch->unpin();
+    }
+
     void allocateHT(uint32_t worker_id) {
-        this->worker_id = worker_id; // TODO: remove unneeded worker_id for temporary allocations
+        this->worker_id = worker_id; // the hash table is returned to this worker's temporary page pool on destruction
         // get input tuples
-        input->consumeBatches(batches, worker_id);
+        input->consumePartitions(batches, partition_offsets);
         // allocate hash table
         const size_t min_ht_size = input->getValidRowCount() * 2;
         ht_bits = (64 - __builtin_clzl(min_ht_size - 1)); // use next power of 2 as actual hash table size
+        ht_bits = std::max<size_t>(ht_bits, JOIN_PARTITION_BITS); // each slot has to belong to a single partition
         const size_t ht_size = std::max((1ull << ht_bits) * sizeof(void*), PAGE_SIZE);
-        ht = reinterpret_cast<std::atomic<void*>*>(vmcache.allocateTemporaryHugePage(ht_size / PAGE_SIZE, worker_id));
+        // losing any part of the hash table means rebuilding it from all build side rows
+        const uint64_t page_cost_ns = std::max<uint64_t>(input->getValidRowCount() * JOIN_BUILD_NS_PER_ROW / (ht_size / PAGE_SIZE), 1);
+        ht = reinterpret_cast<std::atomic<void*>*>(vmcache.allocateTemporaryHugePage(ht_size / PAGE_SIZE, worker_id, page_cost_ns));
         //std::cout << "Building ht with size " << ht_size << " (" << ht_size / 1024 / 1024 << " MiB)" << " for " << input->getValidRowCount() << " build tuples" << std::endl;
     }
 
@@ -119,9 +141,11 @@ private:
     void generalJoinBuildKernel(size_t from, size_t to, size_t key_size);
 
     std::shared_ptr<JoinBreaker> input;
-    std::vector<std::shared_ptr<Batch>> batches;
+    std::vector<std::shared_ptr<Batch>> batches; // ordered by partition
+    std::vector<size_t> partition_offsets; // index of each partition's first batch in 'batches', followed by 'batches.size()'
     size_t key_size;
     size_t ht_bits;
+    size_t max_resident_pages;
     VMCache& vmcache;
     std::atomic<void*>* ht;
     uint32_t worker_id;
@@ -153,11 +177,49 @@ private:
     std::shared_ptr<JoinBuild> output;
 };
 
+class JoinProbe;
+
+// probes the deferred rows of one partition (see 'JoinProbe::finishPush()'), the partition's build side batches are pinned while the job is executing
+class JoinPartitionProbeJob : public Job {
+public:
+    JoinPartitionProbeJob(JoinProbe& probe, size_t job_index, size_t partition, std::vector<std::shared_ptr<Batch>>&& batches, TempMemoryBudget* budget)
+    : probe(probe)
+    , job_index(job_index)
+    , partition(partition)
+    , batches(std::move(batches))
+    , next_batch(0)
+    , budget(budget) { }
+
+    size_t getSize() const override { return batches.size(); }
+    double getExpectedTimePerUnit() const override { return 0.02; } // morsel size = 1 batch
+    bool executeNextMorsel(size_t morsel_size, const ExecutionContext context) override;
+    void finalize(const ExecutionContext context) override;
+
+    size_t getPartition() const { return partition; }
+
+private:
+    JoinProbe& probe;
+    const size_t job_index;
+    const size_t partition;
+    std::vector<std::shared_ptr<Batch>> batches;
+    std::atomic_size_t next_batch;
+    TempMemoryBudget* const budget; // budget of the query, the deferred rows are probed on its behalf
+};
+
+/*
+Probes the hash table built by 'JoinBuild'. If the build side fits into memory, all of its partitions are pinned while the probe input is pushed.
+Otherwise (grace hash join), only the first partition is pinned and the probe side rows of all other partitions are deferred into spillable batches.
+Once the probe input has been consumed, the deferred rows are probed one partition at a time, so that only a single partition of each side has to be resident.
+*/
 class JoinProbe : public OperatorBase {
+    friend class JoinPartitionProbeJob;
+
 public:
     JoinProbe(VMCache& vmcache, std::shared_ptr<JoinBuild> build, BatchDescription& build_columns, BatchDescription& probe_columns, BatchDescription& output_columns)
     : vmcache(vmcache)
     , build(build)
+    , partitioned(false)
+    , deferred_batches(build->input->getWorkerCount())
     {
         this->build_columns.swap(build_columns);
         this->probe_columns.swap(probe_columns);
@@ -176,25 +238,48 @@ public:
         }
     }
 
+    ~JoinProbe() {
+        build->unpinBatches();
+    }
+
     void push(std::shared_ptr<Batch> batch, uint32_t worker_id) override {
+        std::call_once(build_pinned, [&]() {
+            partitioned = build->isPartitioned();
+            for (size_t partition = 0; partition < (partitioned ? 1 : JOIN_PARTITION_COUNT); partition++)
+                build->pinPartition(partition, worker_id);
+        });
+        probeBatch(batch, partitioned, worker_id);
+    }
+
+    void finishPush(const ExecutionContext& context, std::function<void(const ExecutionContext&)>&& done) override;
+
+private:
+    // rows of partitions other than the first one are deferred if 'defer' is set
+    void probeBatch(const std::shared_ptr<Batch>& batch, bool defer, uint32_t worker_id) {
         IntermediateHelper intermediates(vmcache, output_columns.getRowSize(), next_operator, worker_id);
         switch (build->key_size) {
             case 4:
-                joinProbeKernel<uint32_t>(batch, intermediates);
+                joinProbeKernel<uint32_t>(batch, intermediates, defer, worker_id);
                 break;
             case 8:
-                joinProbeKernel<uint64_t>(batch, intermediates);
+                joinProbeKernel<uint64_t>(batch, intermediates, defer, worker_id);
                 break;
             default:
-                generalJoinProbeKernel(batch, intermediates, build->key_size);
+                generalJoinProbeKernel(batch, intermediates, build->key_size, defer, worker_id);
                 break;
         }
     }
 
-private:
     template <typename key_type>
-    void joinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates);
-    void generalJoinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, size_t key_size);
+    void joinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, bool defer, uint32_t worker_id);
+    void generalJoinProbeKernel(const std::shared_ptr<Batch>& batch, IntermediateHelper& intermediates, size_t key_size, bool defer, uint32_t worker_id);
+
+    // copies the row to the worker's deferred batches of its partition
+    void deferRow(const void* row, uint32_t row_size, size_t partition, uint32_t worker_id);
+
+    // pins the build side partition of the i-th partition job and schedules the job, calls 'done' once all partition jobs have finished
+    void startPartitionJob(size_t i, const ExecutionContext& context);
+    void partitionJobFinished(size_t i, const ExecutionContext& context);
 
     VMCache& vmcache;
     std::shared_ptr<JoinBuild> build;
@@ -207,6 +292,12 @@ private:
         bool from_probe;
     };
     std::vector<JoinColumnInfo> output_column_infos;
+
+    std::once_flag build_pinned;
+    bool partitioned;
+    std::vector<JoinPartitionBatches> deferred_batches; // per worker
+    std::vector<std::shared_ptr<JoinPartitionProbeJob>> partition_jobs;
+    std::function<void(const ExecutionContext&)> done;
 };
 
 class JoinFactory {
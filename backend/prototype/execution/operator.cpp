@@ -1,5 +1,7 @@
 #include "operator.hpp"
 
+#include "../scheduling/execution_context.hpp"
+
 OperatorBase::OperatorBase() { }
 
 OperatorBase::~OperatorBase() { }
@@ -11,6 +13,10 @@ void OperatorBase::setNextOperator(std::shared_ptr<OperatorBase> next_operator)
     this->next_operator = std::move(next_operator);
 }
 
+void OperatorBase::finishPush(const ExecutionContext& context, std::function<void(const ExecutionContext&)>&& done) {
+    done(context);
+}
+
 std::shared_ptr<OperatorBase> OperatorBase::getNextOperator() const {
     return next_operator;
 }
\ No newline at end of file
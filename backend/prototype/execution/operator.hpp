@@ -1,9 +1,12 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 
 #include "batch.hpp"
 
+class ExecutionContext;
+
 class OperatorBase {
 protected:
     std::shared_ptr<OperatorBase> next_operator = nullptr;
@@ -13,6 +16,9 @@ public:
     virtual ~OperatorBase();
 
     virtual void push(std::shared_ptr<Batch> batch, uint32_t worker_id) = 0;
+    // called once all batches have been pushed to the operator; operators that hold back rows (e.g., the deferred partitions of 'JoinProbe') push them on, possibly from other jobs, and call 'done' afterwards
+    //  note: 'done' may finish the pipeline and destroy the operator
+    virtual void finishPush(const ExecutionContext& context, std::function<void(const ExecutionContext&)>&& done);
 
     void setNextOperator(std::shared_ptr<OperatorBase> next_operator);
 
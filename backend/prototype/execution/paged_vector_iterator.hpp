@@ -8,6 +8,10 @@
 
 struct GeneralPagedVectorIterator {
     static constexpr size_t UNLOAD = std::numeric_limits<size_t>::max();
+    // sequential readahead: once READAHEAD_TRIGGER consecutive data pages have been loaded, the following pages are prefetched in windows that grow from READAHEAD_MIN_WINDOW up to READAHEAD_MAX_WINDOW pages
+    static constexpr size_t READAHEAD_TRIGGER = 2;
+    static constexpr size_t READAHEAD_MIN_WINDOW = 8;
+    static constexpr size_t READAHEAD_MAX_WINDOW = PREFETCH_BATCH_SIZE;
 
     GeneralPagedVectorIterator(VMCache& vmcache, PageId basepage, size_t i, size_t value_size, uint32_t worker_id)
         : vmcache(vmcache)
@@ -17,11 +21,17 @@ struct GeneralPagedVectorIterator {
         , current_page_exclusive(false)
         , basepage(vmcache, basepage, worker_id)
         , basepage_num(0)
-        , values_per_page(PAGE_SIZE / value_size)
+        , data_page_size(getDataPageSize(vmcache, basepage, worker_id))
+        , values_per_page(data_page_size * PAGE_SIZE / value_size)
         , page_num(i / values_per_page)
         , i(i % values_per_page)
         , value_size(value_size)
         , worker_id(worker_id)
+        , loaded_page_num(UNLOAD)
+        , sequential_pages(0)
+        , readahead_window(READAHEAD_MIN_WINDOW)
+        , readahead_end(0)
+        , readahead_trigger(0)
     {
         if (i != UNLOAD)
             loadPage(false);
@@ -42,11 +52,17 @@ struct GeneralPagedVectorIterator {
         , current_page_exclusive(other.current_page_exclusive)
         , basepage(other.basepage)
         , basepage_num(other.basepage_num)
+        , data_page_size(other.data_page_size)
         , values_per_page(other.values_per_page)
         , page_num(other.page_num)
         , i(other.i)
         , value_size(other.value_size)
         , worker_id(other.worker_id)
+        , loaded_page_num(other.loaded_page_num)
+        , sequential_pages(other.sequential_pages)
+        , readahead_window(other.readahead_window)
+        , readahead_end(other.readahead_end)
+        , readahead_trigger(other.readahead_trigger)
     {
         // acquire shared latches for this new iterator instance
         if (page != nullptr) {
@@ -67,11 +83,17 @@ struct GeneralPagedVectorIterator {
         , current_page_exclusive(other.current_page_exclusive)
         , basepage(other.basepage)
         , basepage_num(other.basepage_num)
+        , data_page_size(other.data_page_size)
         , values_per_page(other.values_per_page)
         , page_num(other.page_num)
         , i(other.i)
         , value_size(other.value_size)
         , worker_id(other.worker_id)
+        , loaded_page_num(other.loaded_page_num)
+        , sequential_pages(other.sequential_pages)
+        , readahead_window(other.readahead_window)
+        , readahead_end(other.readahead_end)
+        , readahead_trigger(other.readahead_trigger)
     {
         // shared latches are now held by this instance
         other.page = nullptr;
@@ -85,11 +107,17 @@ struct GeneralPagedVectorIterator {
         current_page_exclusive = other.current_page_exclusive;
         basepage = std::move(other.basepage);
         basepage_num = other.basepage_num;
+        data_page_size = other.data_page_size;
         values_per_page = other.values_per_page;
         page_num = other.page_num;
         i = other.i;
         value_size = other.value_size;
         worker_id = other.worker_id;
+        loaded_page_num = other.loaded_page_num;
+        sequential_pages = other.sequential_pages;
+        readahead_window = other.readahead_window;
+        readahead_end = other.readahead_end;
+        readahead_trigger = other.readahead_trigger;
         // shared latches are now held by this instance
         other.page = nullptr;
         return *this;
@@ -135,6 +163,18 @@ struct GeneralPagedVectorIterator {
         }
     }
 
+    // number of pages per data page of the column (see 'ColumnBasepage::data_page_size')
+    static size_t getDataPageSize(VMCache& vmcache, PageId basepage_pid, uint32_t worker_id) {
+        while (true) {
+            try {
+                OptimisticGuard<ColumnBasepage> basepage(vmcache, basepage_pid, worker_id);
+                const size_t result = basepage->data_page_size;
+                basepage.release();
+                return result;
+            } catch (const OLRestartException&) { }
+        }
+    }
+
 protected:
     VMCache& vmcache;
     PageId basepage_pid;
@@ -143,15 +183,22 @@ protected:
     bool current_page_exclusive; // true if we are holding an exclusive lock on the current page, false if only holding a shared lock
     OptimisticGuard<ColumnBasepage> basepage;
     size_t basepage_num;
+    size_t data_page_size;
     size_t values_per_page;
     size_t page_num;
     size_t i;
     size_t value_size;
     uint32_t worker_id;
+    // readahead state
+    size_t loaded_page_num;
+    size_t sequential_pages;
+    size_t readahead_window;
+    size_t readahead_end; // first data page that has not been prefetched yet
+    size_t readahead_trigger; // data page whose load requests the next window
 
     inline void unfixCurrentPage() {
         if (current_page_exclusive)
-            vmcache.unfixExclusive(current_page_pid);
+            vmcache.unfixExclusive(current_page_pid, worker_id);
         else
             vmcache.unfixShared(current_page_pid);
         page = nullptr;
@@ -162,6 +209,11 @@ protected:
         const size_t data_pages_per_basepage = (PAGE_SIZE - sizeof(ColumnBasepage)) / sizeof(PageId);
         const size_t req_basepage_num = page_num / data_pages_per_basepage;
         const size_t off_in_basepage = page_num % data_pages_per_basepage;
+        const bool read_ahead = !for_write && updateSequentialAccess();
+        PageId readahead_pids[READAHEAD_MAX_WINDOW];
+        size_t num_readahead_pids = 0;
+        size_t readahead_begin = 0;
+        size_t readahead_window_end = 0;
         for (size_t restart_counter = 0; ; restart_counter++) {
             try {
                 while (basepage_num != req_basepage_num || basepage.isReleased()) {
@@ -179,14 +231,50 @@ protected:
                     unfixCurrentPage();
                 }
                 current_page_pid = basepage->data_pages[off_in_basepage];
+                if (read_ahead) {
+                    // collect the pids of the readahead window (the current page is included so that its read is batched with the others); readahead does not cross basepage boundaries
+                    const size_t first_page_in_basepage = page_num - off_in_basepage;
+                    readahead_window_end = std::min(page_num + readahead_window, first_page_in_basepage + data_pages_per_basepage);
+                    readahead_begin = std::max(page_num, readahead_end);
+                    num_readahead_pids = 0;
+                    for (size_t p = readahead_begin; p < readahead_window_end; p++) {
+                        const PageId pid = basepage->data_pages[p - first_page_in_basepage];
+                        // pages of rows that are not appended in row id order may not have been allocated yet (see 'DB::reserveRowId()'), so holes are skipped rather than taken as the end of the column
+                        if (pid != 0)
+                            readahead_pids[num_readahead_pids++] = pid;
+                    }
+                }
                 basepage.checkVersionAndRestart();
                 break;
             } catch (const OLRestartException&) { }
         }
 
+        if (num_readahead_pids > 0) {
+            vmcache.prefetch(readahead_pids, num_readahead_pids, true, worker_id);
+            readahead_end = readahead_window_end;
+            readahead_trigger = readahead_begin + (readahead_window_end - readahead_begin) / 2;
+            readahead_window = std::min(readahead_window * 2, READAHEAD_MAX_WINDOW);
+        }
         page = for_write ? vmcache.fixExclusive(current_page_pid, worker_id) : vmcache.fixShared(current_page_pid, worker_id, true);
         current_page_exclusive = for_write;
     }
+
+    // tracks whether data pages are being loaded in sequential order; returns true if the next readahead window should be prefetched
+    inline bool updateSequentialAccess() {
+        if (page_num == loaded_page_num)
+            return false; // reloading the same page (e.g., after a release() between rows)
+        if (page_num == loaded_page_num + 1) {
+            sequential_pages++;
+        } else {
+            sequential_pages = 1;
+            readahead_window = READAHEAD_MIN_WINDOW;
+            readahead_end = 0;
+            readahead_trigger = 0;
+        }
+        loaded_page_num = page_num;
+        // prefetch once half of the previous window has been consumed
+        return sequential_pages >= READAHEAD_TRIGGER && page_num >= readahead_trigger;
+    }
 };
 
 template <typename T>
@@ -37,6 +37,19 @@ void Pipeline::addBreaker(const std::shared_ptr<PipelineBreakerBase>& breaker) {
     this->breaker = breaker;
 }
 
+void Pipeline::finishExecution(const ExecutionContext& context) {
+    finishOperators(starter->getNextOperator(), context);
+}
+
+void Pipeline::finishOperators(std::shared_ptr<OperatorBase> op, const ExecutionContext& context) {
+    if (op == nullptr) {
+        // note: this may destroy the pipeline
+        qep->pipelineFinished(id, context);
+        return;
+    }
+    op->finishPush(context, [this, op](const ExecutionContext& context) { finishOperators(op->getNextOperator(), context); });
+}
+
 std::shared_ptr<DefaultBreaker> Pipeline::addDefaultBreaker(const ExecutionContext context) {
     std::shared_ptr<DefaultBreaker> breaker = std::make_shared<DefaultBreaker>(current_columns, context.getWorkerCount());
     addBreaker(breaker);
@@ -52,12 +52,18 @@ public:
     std::shared_ptr<AggregationOperator> addAggregation(VMCache& vmcache, const Pipeline& input);
     std::shared_ptr<SortOperator> addSort(VMCache& vmcache, const Pipeline& input);
 
+    // called once the starter has processed its whole input: lets the operators push the rows that they held back (see 'OperatorBase::finishPush()') in pipeline order, and notifies the QEP afterwards
+    void finishExecution(const ExecutionContext& context);
+
     QEP* getQEP() const { return qep; }
     const std::vector<size_t>& getDependencies() const { return pipeline_dependencies; }
 
     std::shared_ptr<PipelineBreakerBase> getBreaker() const { return breaker; }
 
     friend class JoinFactory;
+
+private:
+    void finishOperators(std::shared_ptr<OperatorBase> op, const ExecutionContext& context);
 };
 
 class ExecutablePipeline: public Pipeline {
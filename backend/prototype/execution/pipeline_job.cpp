@@ -84,6 +84,7 @@ bool PipelineJob::executeNextMorsel(size_t morsel_size, const ExecutionContext c
 
     if (got_job) {
         const size_t to = std::min(m + morsel_size, last_row[socket_candidate]);
+        TempMemoryBudgetScope budget_scope(context, starter->pipeline->getQEP()->getTempMemoryBudget());
 #ifdef VTUNE_PROFILING
         if (getPipelineId() < 20) {
             __itt_task_begin(itt_domain, __itt_null, __itt_null, itt_handle_morsel[4 * getPipelineId() + socket]);
@@ -101,7 +102,9 @@ bool PipelineJob::executeNextMorsel(size_t morsel_size, const ExecutionContext c
 }
 
 void PipelineJob::finalize(const ExecutionContext context) {
-    starter->pipeline->getQEP()->pipelineFinished(starter->getPipelineId(), context);
+    // note: the temporary memory of completed pipelines is released during finalization
+    TempMemoryBudgetScope budget_scope(context, starter->pipeline->getQEP()->getTempMemoryBudget());
+    starter->pipeline->finishExecution(context);
 }
 
 size_t PipelineJob::getSize() const {
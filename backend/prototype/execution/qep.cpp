@@ -5,6 +5,7 @@
 #include <thread>
 
 void QEP::begin(const ExecutionContext context) {
+    TempMemoryBudgetScope budget_scope(context, temp_memory_budget.get());
     std::bitset<MAX_PIPELINE_COUNT> pipelines_to_execute;
     {
         std::lock_guard<std::mutex> guard(sched_mutex);
@@ -29,8 +30,11 @@ void QEP::pipelineFinished(size_t id, const ExecutionContext context) {
         if (id != pipelines.size() - 1)
             pipelines[id] = nullptr;
         if (completed_pipelines.count() == pipelines.size()) {
-            // done
+            // done; pooled temporary pages stay available to concurrent and later queries and are only released under memory pressure (see 'CachePartition::relievePressure()')
             finished = true;
+        } else if (temp_memory_budget && temp_memory_budget->isExceeded() && (executing_pipelines & ~completed_pipelines).any()) {
+            // admission control: delay starting further pipelines until another pipeline has finished (and possibly released its temporary memory)
+            num_delayed_pipelines++;
         } else {
             // schedule next pipeline(s)
             for (size_t i = 0; i < pipelines.size(); i++) {
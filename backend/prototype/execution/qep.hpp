@@ -18,6 +18,7 @@ public:
         , completed_pipelines()
         , executing_pipelines()
         , finished(false)
+        , num_delayed_pipelines(0)
     {
         if (this->pipelines.size() > MAX_PIPELINE_COUNT)
             throw std::runtime_error("More than " stringify(MAX_PIPELINE_COUNT) " pipelines are currently not supported in a single QEP!");
@@ -39,10 +40,18 @@ public:
         return pipelines.back()->getBreaker();
     }
 
+    // limits the temporary memory of the QEP; while the budget is exceeded, ready pipelines are only started once no other pipeline of the QEP is executing anymore
+    //  note: this has to be called before 'begin()'
+    void setTempMemoryBudget(size_t max_pages) { temp_memory_budget = TempMemoryBudget::create(max_pages); }
+    TempMemoryBudget* getTempMemoryBudget() const { return temp_memory_budget.get(); }
+    size_t getNumDelayedPipelines() const { return num_delayed_pipelines.load(); }
+
 private:
     std::vector<std::unique_ptr<ExecutablePipeline>> pipelines;
     std::bitset<MAX_PIPELINE_COUNT> completed_pipelines;
     std::bitset<MAX_PIPELINE_COUNT> executing_pipelines;
     std::mutex sched_mutex;
     std::atomic_bool finished;
+    std::unique_ptr<TempMemoryBudget, TempMemoryBudget::Releaser> temp_memory_budget;
+    std::atomic_uint64_t num_delayed_pipelines;
 };
\ No newline at end of file
@@ -2,8 +2,8 @@
 
 #include "../core/db.hpp"
 #include "../storage/guard.hpp"
-#include "../storage/persistence/btree.hpp"
 #include "../storage/persistence/table.hpp"
+#include "../storage/persistence/visibility_bitmap.hpp"
 #include "../utils/memcpy.hpp"
 #include "pipeline_starter.hpp"
 #include "paged_vector_iterator.hpp"
@@ -20,11 +20,11 @@ public:
         uint64_t basepage_pid = db.getTableBasepageId(table_name, context.getWorkerId());
         SharedGuard<TableBasepage> basepage(db.vmcache, basepage_pid, context.getWorkerId());
         visibility_basepage = basepage->visibility_basepage;
-        auto key_range = BTree<RowId, bool>(db.vmcache, visibility_basepage, context.getWorkerId()).keyRange();
-        if (key_range.first >= key_range.second) { // table currently empty
+        const RowId num_rows = VisibilityBitmap(db.vmcache, visibility_basepage, context.getWorkerId()).getNumRows();
+        if (num_rows == 0) { // table currently empty
             input_size = 1; // set input size to 1 so that we execute on at least one thread to push an empty output batch
         } else {
-            input_size = key_range.second - key_range.first;
+            input_size = num_rows;
         }
         for (auto col : scan_columns) {
             auto table_col = std::dynamic_pointer_cast<TableColumnBase>(col.column);
@@ -46,35 +46,30 @@ public:
         Derived* derived = static_cast<Derived*>(this);
         std::vector<GeneralPagedVectorIterator>& worker_iterators = iterators[worker_id];
         worker_iterators.clear();
-        BTree<RowId, bool> visibility(db.vmcache, visibility_basepage, worker_id);
-        auto it = visibility.lookup(from);
-        auto end = visibility.lookup(to);
+        VisibilityBitmap visibility(db.vmcache, visibility_basepage, worker_id);
         // safeguard in case rows were added between constructing the scan operator and executing it
         if (to == input_size)
-            end = visibility.end();
+            to = std::max<size_t>(to, visibility.getNumRows());
         IntermediateHelper intermediates(db.vmcache, derived->getRowSize(), next_operator, worker_id);
-        if (it == end) { // empty input, abort scan
-            return;
-        }
-        for (size_t i = 0; i < basepages.size(); i++) {
-            worker_iterators.emplace_back(db.vmcache, basepages[i], (*it).first, value_sizes[i], worker_id);
-        }
-        for (; it != end; ++it) {
-            if (!(*it).second)
-                continue;
-            RowId rid = (*it).first;
-            for (size_t j = 0; j < basepages.size(); j++) {
-                worker_iterators[j].reposition(rid);
+        // the column iterators stay positioned across rows and only load a page when the rows move on to the next one
+        visibility.forEachVisible(from, to, [&](RowId rid) {
+            if (worker_iterators.empty()) {
+                for (size_t i = 0; i < basepages.size(); i++)
+                    worker_iterators.emplace_back(db.vmcache, basepages[i], rid, value_sizes[i], worker_id);
+            } else {
+                for (size_t j = 0; j < basepages.size(); j++)
+                    worker_iterators[j].reposition(rid);
             }
             if (derived->filter(worker_iterators)) {
                 char* loc = intermediates.addRow();
                 derived->project(loc, worker_iterators);
             }
-            // TODO: improve with optimistic visibility scans/lookups
-            for (size_t j = 0; j < basepages.size(); j++) {
+            return true;
+        }, [&] {
+            // column pages must not stay latched while the next bitmap page is latched
+            for (size_t j = 0; j < worker_iterators.size(); j++)
                 worker_iterators[j].release();
-            }
-        }
+        });
         worker_iterators.clear();
     }
 
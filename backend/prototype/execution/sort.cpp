@@ -191,7 +191,7 @@ void SortBreaker::push(std::shared_ptr<Batch> batch, uint32_t worker_id) {
     if (batch->full()) {
         // immediately sort the batch and add it to the thread-local list of batches
         introsort(batch->begin(), batch->end(), comp);
-        batches.at(worker_id).push_back(batch);
+        batches.at(worker_id).push_back(Batch::spillIfOverBudget(batch, worker_id));
     } else {
         while (!batch->empty()) {
             if (batches.at(worker_id).empty() || batches.at(worker_id).back()->full()) {
@@ -203,6 +203,7 @@ void SortBreaker::push(std::shared_ptr<Batch> batch, uint32_t worker_id) {
             batches.at(worker_id).back()->append(batch);
             if (batches.at(worker_id).back()->full()) {
                 introsort(batches.at(worker_id).back()->begin(), batches.at(worker_id).back()->end(), comp);
+                batches.at(worker_id).back() = Batch::spillIfOverBudget(batches.at(worker_id).back(), worker_id);
             }
         }
     }
@@ -231,27 +232,70 @@ void SortBreaker::consumeBatches(std::vector<std::shared_ptr<Batch>>& target, ui
 }
 
 
+template <typename F>
+void SortOperator::merge(std::vector<Run>& runs, uint32_t worker_id, F&& emit) {
+    for (Run& run : runs)
+        run.advance(worker_id);
+    while (true) {
+        // find next row in the heads of the runs
+        Run* candidate_run = nullptr;
+        for (Run& run : runs) {
+            if (run.exhausted())
+                continue;
+            if (candidate_run == nullptr || breaker->comp(*run.getHead()->begin(), *candidate_run->getHead()->begin()) < 0)
+                candidate_run = &run;
+        }
+        if (candidate_run == nullptr)
+            return;
+        const std::shared_ptr<Batch>& head = candidate_run->getHead();
+        Batch::Iterator candidate = head->begin();
+        emit(*candidate);
+        // TODO: it could be more concise to just implement markInvalid() in Batch::Iterator
+        head->markInvalid(candidate);
+        if (head->empty())
+            candidate_run->advance(worker_id);
+    }
+}
+
 void SortOperator::execute(size_t, size_t, uint32_t worker_id) {
     // TODO: implement parallel multiway mergesort to parallelize this
     const size_t row_size = breaker->batch_description.getRowSize();
-    IntermediateHelper intermediates(vmcache, row_size, next_operator, worker_id);
-    for (size_t i = 0; i < breaker->getValidRowCount(); i++) {
-        char* loc = intermediates.addRow();
-        // find next row in the pre-sorted batches
-        assert(batches.size() > 0);
-        Batch::Iterator candidate = batches.front()->end();
-        size_t candidate_batch_i = 0;
-        for (size_t j = 0; j < batches.size(); j++) {
-            if (!batches[j]->empty()) {
-                auto b_begin = batches[j]->begin();
-                if (!candidate || breaker->comp(*b_begin, *candidate) < 0) {
-                    candidate = b_begin;
-                    candidate_batch_i = j;
+    // each pre-sorted batch is a run; pre-sorted batches may have been spilled while the query exceeded its temporary memory budget, so only the head batch of each run is pinned while merging
+    std::vector<Run> runs;
+    runs.reserve(batches.size());
+    bool spilled = false;
+    for (std::shared_ptr<Batch>& batch : batches) {
+        spilled |= batch->isSpillable();
+        runs.push_back(Run { { std::move(batch) } });
+    }
+    batches.clear();
+
+    // with spilled batches, bound the number of pinned batches by merging groups of runs into spillable runs first
+    while (spilled && runs.size() > merge_fan_in) {
+        std::vector<Run> merged_runs;
+        for (size_t i = 0; i < runs.size(); i += merge_fan_in) {
+            std::vector<Run> group(std::make_move_iterator(runs.begin() + i), std::make_move_iterator(runs.begin() + std::min(i + merge_fan_in, runs.size())));
+            Run merged;
+            merge(group, worker_id, [&](const Row& row) {
+                uint32_t row_id;
+                void* loc = merged.batches.empty() ? nullptr : merged.batches.back()->addRowIfPossible(row_id);
+                if (loc == nullptr) {
+                    if (!merged.batches.empty())
+                        merged.batches.back()->unpin();
+                    merged.batches.push_back(std::make_shared<Batch>(vmcache, row_size, worker_id, true));
+                    loc = merged.batches.back()->addRowIfPossible(row_id);
                 }
-            }
+                memcpy(loc, row.data, row_size);
+            });
+            if (!merged.batches.empty())
+                merged.batches.back()->unpin();
+            merged_runs.push_back(std::move(merged));
         }
-        // TODO: it could be more concise to just implement markInvalid() in Batch::Iterator
-        batches[candidate_batch_i]->markInvalid(candidate);
-        memcpy(loc, (*candidate).data, row_size);
+        runs.swap(merged_runs);
     }
+
+    IntermediateHelper intermediates(vmcache, row_size, next_operator, worker_id);
+    merge(runs, worker_id, [&](const Row& row) {
+        memcpy(intermediates.addRow(), row.data, row_size);
+    });
 }
\ No newline at end of file
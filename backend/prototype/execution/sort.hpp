@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 #include "pipeline_breaker.hpp"
 #include "pipeline_starter.hpp"
 
@@ -25,11 +27,15 @@ private:
     std::function<int(const Row&, const Row&)> comp;
 };
 
+// maximum number of sorted runs that are merged at once, more runs of spilled batches are first merged into fewer, longer runs
+#define SORT_MERGE_FAN_IN 64ul
+
 class SortOperator : public PipelineStarterBase {
 public:
     SortOperator(VMCache& vmcache, const std::shared_ptr<SortBreaker>& breaker)
     : vmcache(vmcache)
-    , breaker(breaker) { }
+    , breaker(breaker)
+    , merge_fan_in(SORT_MERGE_FAN_IN) { }
 
     void execute(size_t, size_t, uint32_t worker_id) override;
 
@@ -41,8 +47,31 @@ public:
         breaker->consumeBatches(batches, worker_id);
     }
 
+    void setMergeFanIn(size_t fan_in) { merge_fan_in = std::max<size_t>(fan_in, 2); }
+
 private:
+    // sorted sequence of batches, only its first non-empty batch is pinned while the run is merged
+    struct Run {
+        std::vector<std::shared_ptr<Batch>> batches;
+        size_t head = 0;
+
+        bool exhausted() const { return head == batches.size(); }
+        const std::shared_ptr<Batch>& getHead() const { return batches[head]; }
+        // drops the consumed batches and pins the next one for reading
+        void advance(uint32_t worker_id) {
+            while (!exhausted() && batches[head]->empty())
+                batches[head++] = nullptr;
+            if (!exhausted())
+                batches[head]->pin(worker_id, false);
+        }
+    };
+
+    // merges 'runs' and calls 'emit' for each row in sort order
+    template <typename F>
+    void merge(std::vector<Run>& runs, uint32_t worker_id, F&& emit);
+
     VMCache& vmcache;
     std::shared_ptr<SortBreaker> breaker;
     std::vector<std::shared_ptr<Batch>> batches;
-};
\ No newline at end of file
+    size_t merge_fan_in;
+};
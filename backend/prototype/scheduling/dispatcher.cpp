@@ -27,6 +27,7 @@ void Dispatcher::scheduleJob(const std::shared_ptr<Job>& job, const ExecutionCon
         // if the job is small, execute it immediately within the calling thread
         // NOTE: we still may need to execute on multiple morsels as the job may have been split up across sockets
         while (job->executeNextMorsel(job_size, context)) { }
+        context.getVMCache().completePrefetches(context.getWorkerId());
         job->finalize(context);
     } else {
         // schedule the job for execution using multiple worker threads
@@ -106,7 +107,10 @@ void Dispatcher::runNext(const ExecutionContext context, bool no_wait) {
             double throughput = state.T[min_pass_slot];
             size_t morsel_size = std::max(static_cast<size_t>(throughput * T_MAX), static_cast<size_t>(job->getMinMorselSize()));
             // TODO: implement a "shutdown phase" to try to achieve a "photo finish"?
-            if (!job->executeNextMorsel(morsel_size, context)) {
+            const bool has_more_morsels = job->executeNextMorsel(morsel_size, context);
+            // prefetched pages must not stay latched while the worker is idle or runs another job
+            context.getVMCache().completePrefetches(context.getWorkerId());
+            if (!has_more_morsels) {
                 // no more morsels to process, finalize the job
                 state.active_slots.set(min_pass_slot, false);
                 state.sum_priorities -= state.priorities[min_pass_slot];
@@ -9,6 +9,7 @@
 #include <vector>
 
 class ExecutionContext;
+class IndexBuildJobBase;
 class Job;
 
 const size_t JOB_SLOTS = 128; // TODO: need to figure out a way to avoid deadlocks in QEP::pipelineFinished() when all slots are being used -> just have a queue behind a mutex to keep track of pipelines that exceed the available slots?!
@@ -53,6 +54,7 @@ struct WorkerState {
 };
 
 struct Dispatcher {
+    friend class IndexBuildJobBase;
     friend class JobManager;
     friend class QEP;
 
@@ -10,7 +10,11 @@ public:
         , db(db)
         , socket(socket)
         , worker_id(worker_id)
-        , created_by_job_manager(created_by_job_manager) { }
+        , created_by_job_manager(created_by_job_manager) {
+        // contexts that are not created by the job manager are used by the thread creating them (e.g., the main thread)
+        if (!created_by_job_manager)
+            VMCache::setCurrentWorkerId(worker_id);
+    }
 
     JobManager& getJobManager() const { return job_manager; }
     Dispatcher& getDispatcher() const { return job_manager.getDispatcher(); }
@@ -20,6 +24,8 @@ public:
     uint32_t getSocket() const { return socket; }
     uint32_t getWorkerId() const { return worker_id; }
     bool isCreatedByJobManager() const { return created_by_job_manager; }
+    // budget of the query that the worker is currently executing for, or nullptr
+    TempMemoryBudget* getTempMemoryBudget() const { return db.vmcache.getTempMemoryBudget(worker_id); }
 
 private:
     JobManager& job_manager;
@@ -27,4 +33,23 @@ private:
     const uint32_t socket;
     const uint32_t worker_id;
     const bool created_by_job_manager;
+};
+
+// charges the temporary allocations of the context's worker to 'budget' while the scope is active
+class TempMemoryBudgetScope {
+public:
+    TempMemoryBudgetScope(const ExecutionContext& context, TempMemoryBudget* budget)
+        : vmcache(context.getVMCache())
+        , worker_id(context.getWorkerId())
+        , previous(vmcache.exchangeTempMemoryBudget(worker_id, budget)) { }
+
+    ~TempMemoryBudgetScope() { vmcache.exchangeTempMemoryBudget(worker_id, previous); }
+
+    TempMemoryBudgetScope(const TempMemoryBudgetScope& other) = delete;
+    TempMemoryBudgetScope& operator=(const TempMemoryBudgetScope& other) = delete;
+
+private:
+    VMCache& vmcache;
+    const uint32_t worker_id;
+    TempMemoryBudget* const previous;
 };
\ No newline at end of file
@@ -28,6 +28,7 @@ void JobManager::workerThread(const int tid, const ExecutionContext context) {
     if (sched_setaffinity(0, sizeof(cpu_set_t), &mask) == -1) {
         std::cerr << "Warning: Failed to set CPU affinity for worker thread " << tid << std::endl;
     }
+    VMCache::setCurrentWorkerId(context.getWorkerId());
 
     while (!context.getDispatcher().stop) {
         context.getDispatcher().runNext(context);
@@ -0,0 +1,142 @@
+#include "compressed_page_tier.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+
+#include "page.hpp"
+#include "../utils/lz_compression.hpp"
+
+static size_t getShardCapacity(size_t memory_budget) {
+    // the index is paid for out of the same budget as the compressed pages, see 'Shard::getIndexMemory()'
+    return memory_budget / COMPRESSED_TIER_NUM_SHARDS / PAGE_SIZE * PAGE_SIZE;
+}
+
+CompressedPageTier::CompressedPageTier(size_t memory_budget)
+    : shard_capacity(getShardCapacity(memory_budget))
+    , region(nullptr)
+    , num_hits(0)
+    , num_inserted(0)
+    , num_rejected(0) {
+    if (shard_capacity < 2 * COMPRESSED_TIER_MAX_PAGE_SIZE)
+        throw std::runtime_error("Memory budget of the compressed page tier is too small");
+    void* result = mmap(0, getCapacity(), PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0);
+    if (result == MAP_FAILED)
+        throw std::runtime_error("Failed to create anonymous memory mapping for the compressed page tier");
+    region = reinterpret_cast<char*>(result);
+}
+
+CompressedPageTier::~CompressedPageTier() {
+    munmap(region, getCapacity());
+}
+
+bool CompressedPageTier::insert(PageId pid, const char* page) {
+    char buffer[COMPRESSED_TIER_MAX_PAGE_SIZE];
+    const size_t len = lzCompress(page, PAGE_SIZE, buffer, COMPRESSED_TIER_MAX_PAGE_SIZE);
+    Shard& shard = getShard(pid);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    // a previous copy is outdated in any case, its log entry is skipped when it is dropped
+    shard.index.erase(pid);
+    if (len == 0) {
+        num_rejected++;
+        return false;
+    }
+    const size_t aligned_len = (len + COMPRESSED_TIER_ALIGNMENT - 1) / COMPRESSED_TIER_ALIGNMENT * COMPRESSED_TIER_ALIGNMENT;
+    uint64_t begin = shard.head;
+    if (begin % shard_capacity + aligned_len > shard_capacity)
+        begin += shard_capacity - begin % shard_capacity; // entries do not wrap around, skip the rest of the ring buffer
+    if (shard.log.empty())
+        shard.tail = begin;
+    // drop the oldest entries until the new one and its index entry fit into the shard's budget
+    while (!shard.log.empty() && begin + aligned_len - shard.tail + shard.getIndexMemory(1) > shard_capacity) {
+        const Entry oldest = shard.log.front();
+        shard.log.pop_front();
+        auto it = shard.index.find(oldest.pid);
+        if (it != shard.index.end() && it->second.begin == oldest.begin)
+            shard.index.erase(it);
+        shard.tail = shard.log.empty() ? begin : shard.log.front().begin;
+    }
+    releaseDropped(shard);
+    memcpy(getData(pid, begin), buffer, len);
+    const Entry entry { pid, begin, static_cast<uint32_t>(len) };
+    shard.log.push_back(entry);
+    shard.index[pid] = entry;
+    shard.head = begin + aligned_len;
+    num_inserted++;
+    return true;
+}
+
+bool CompressedPageTier::take(PageId pid, char* page) {
+    char buffer[COMPRESSED_TIER_MAX_PAGE_SIZE];
+    size_t len;
+    {
+        Shard& shard = getShard(pid);
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.index.find(pid);
+        if (it == shard.index.end())
+            return false;
+        // the entry's space may be reused as soon as the mutex is released
+        len = it->second.len;
+        memcpy(buffer, getData(pid, it->second.begin), len);
+        shard.index.erase(it);
+    }
+    if (!lzDecompress(buffer, len, page, PAGE_SIZE))
+        throw std::runtime_error("Failed to decompress page from the compressed page tier");
+    num_hits++;
+    return true;
+}
+
+void CompressedPageTier::erase(PageId pid) {
+    Shard& shard = getShard(pid);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.index.erase(pid);
+}
+
+void CompressedPageTier::clear() {
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        shard.index.clear();
+        shard.log.clear();
+        shard.tail = shard.head;
+        releaseDropped(shard, 0);
+    }
+}
+
+void CompressedPageTier::releaseDropped(Shard& shard, size_t min_len) {
+    // the memory is released while holding the mutex, otherwise an insertion could reuse it in the meantime
+    const uint64_t end = shard.tail / PAGE_SIZE * PAGE_SIZE;
+    if (end <= shard.released || end - shard.released < min_len)
+        return;
+    // at most the whole ring buffer, which may have to be released in two parts
+    const uint64_t begin = std::max(shard.released, end > shard_capacity ? end - shard_capacity : 0);
+    char* shard_region = getShardRegion(shard);
+    const uint64_t first_len = std::min(end - begin, shard_capacity - begin % shard_capacity);
+    madvise(shard_region + begin % shard_capacity, first_len, MADV_DONTNEED);
+    if (first_len < end - begin)
+        madvise(shard_region, end - begin - first_len, MADV_DONTNEED);
+    shard.released = end;
+}
+
+size_t CompressedPageTier::getNumStoredPages() const {
+    size_t result = 0;
+    for (const Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        result += shard.index.size();
+    }
+    return result;
+}
+
+size_t CompressedPageTier::getIndexMemory() const {
+    size_t result = 0;
+    for (const Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        result += shard.getIndexMemory();
+    }
+    return result;
+}
+
+void CompressedPageTier::printStats() const {
+    std::cout << "[vmcache] " << "Compressed page tier: " << num_inserted << " pages stored, " << num_rejected << " rejected (incompressible), " << num_hits << " faults served without I/O" << std::endl;
+}
\ No newline at end of file
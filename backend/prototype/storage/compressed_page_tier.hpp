@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "../core/units.hpp"
+
+#define COMPRESSED_TIER_NUM_SHARDS 16
+// compressed pages are stored at this granularity, which also bounds the number of pages the tier can hold
+#define COMPRESSED_TIER_ALIGNMENT 256ul
+// ring buffer memory behind the oldest entry is given back to the OS once at least this much of it can be released
+#define COMPRESSED_TIER_RELEASE_GRANULARITY (16ul * 1024ul)
+// pages that do not compress to at most half their size are not stored
+#define COMPRESSED_TIER_MAX_PAGE_SIZE (PAGE_SIZE / 2)
+
+/*
+Memory-resident tier holding compressed copies of recently evicted pages, so that faulting them again does not require
+I/O (see 'VMCache::fault()'). Pages are added when a cache partition evicts them after dirty pages have been written
+back, so the tier only holds clean copies and may drop entries at any time. A page is removed from the tier when it is
+faulted back in, i.e., there is at most one copy of a page in the buffer pool and the tier.
+The tier is split into shards by page id, each a log-structured ring buffer protected by a mutex: compressed pages are
+appended and the oldest entries are dropped when space is needed (FIFO); the space of entries that were removed early
+is reclaimed once the ring buffer wraps around. Each shard's budget covers the used part of its ring buffer and the
+current size of its index, the memory of the ring buffer behind the oldest entry is released. Pages are compressed
+and decompressed outside of the shard's mutex, only copying them into and out of the ring buffer happens under it.
+*/
+class CompressedPageTier {
+public:
+    // 'memory_budget': bytes available to the tier, including the cost of its index
+    explicit CompressedPageTier(size_t memory_budget);
+    ~CompressedPageTier();
+
+    CompressedPageTier(const CompressedPageTier& other) = delete;
+    CompressedPageTier& operator=(const CompressedPageTier& other) = delete;
+
+    // stores a compressed copy of the page, replacing a previous one; returns false if the page does not compress well enough
+    bool insert(PageId pid, const char* page);
+    // if the tier holds a copy of the page, decompresses it into 'page', removes it from the tier and returns true
+    bool take(PageId pid, char* page);
+    // removes the page's copy, if any (e.g., if the page's contents are no longer needed)
+    void erase(PageId pid);
+    void clear();
+
+    size_t getCapacity() const { return COMPRESSED_TIER_NUM_SHARDS * shard_capacity; }
+    size_t getNumStoredPages() const;
+    size_t getIndexMemory() const; // bytes currently used by the shards' indexes and logs
+    size_t getNumHits() const { return num_hits.load(); }
+    size_t getNumInsertedPages() const { return num_inserted.load(); }
+    size_t getNumRejectedPages() const { return num_rejected.load(); }
+    void printStats() const;
+
+private:
+    struct Entry {
+        PageId pid;
+        uint64_t begin; // position in the shard's ring buffer, increases monotonically
+        uint32_t len;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        uint64_t head = 0;
+        uint64_t tail = 0; // begin of the oldest entry in 'log', equal to 'head' if it is empty
+        uint64_t released = 0; // the ring buffer's memory before this position has been given back to the OS
+        std::deque<Entry> log;
+        std::unordered_map<PageId, Entry> index;
+
+        // hash table buckets and nodes (a next pointer and the key-value pair, the hash code is not cached for integer keys) and log entries
+        inline size_t getIndexMemory(size_t num_additional_entries = 0) const {
+            return index.bucket_count() * sizeof(void*) + (index.size() + num_additional_entries) * (sizeof(void*) + sizeof(std::pair<const PageId, Entry>)) + (log.size() + num_additional_entries) * sizeof(Entry);
+        }
+    };
+
+    inline Shard& getShard(PageId pid) { return shards[pid % COMPRESSED_TIER_NUM_SHARDS]; }
+    inline char* getShardRegion(const Shard& shard) const { return region + (&shard - shards) * shard_capacity; }
+    inline char* getData(PageId pid, uint64_t begin) const {
+        return region + (pid % COMPRESSED_TIER_NUM_SHARDS) * shard_capacity + begin % shard_capacity;
+    }
+    // gives the memory of the ring buffer up to the oldest entry back to the OS, must be called under the shard's mutex
+    void releaseDropped(Shard& shard, size_t min_len = COMPRESSED_TIER_RELEASE_GRANULARITY);
+
+    const size_t shard_capacity;
+    char* region;
+    Shard shards[COMPRESSED_TIER_NUM_SHARDS];
+    // stats
+    std::atomic_uint64_t num_hits;
+    std::atomic_uint64_t num_inserted;
+    std::atomic_uint64_t num_rejected;
+};
\ No newline at end of file
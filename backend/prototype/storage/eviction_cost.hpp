@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// per-page I/O latencies (in nanoseconds) assumed until the first measurements are available
+#define EVICTION_COST_DEFAULT_READ_NS 100000ul
+#define EVICTION_COST_DEFAULT_WRITE_NS 100000ul
+// new measurements are weighted with 1 / EVICTION_COST_SMOOTHING in the moving averages
+#define EVICTION_COST_SMOOTHING 16
+// at most 1 / EVICTION_COST_DIRTY_FRACTION of the buffer pool is left dirty if writes were free, the dirty page target scales this down by the clean / dirty page cost ratio
+#define EVICTION_COST_DIRTY_FRACTION 10
+
+/*
+Expected cost (in nanoseconds per page) of losing a page from the buffer pool: a clean data page has to be read again
+on its next access, a dirty page additionally has to be written before it can be evicted, and displaced temporary data
+has to be recomputed or spilled. Read and write latencies are measured by VMCache (amortized over batched requests);
+the cost of temporary data is hinted by the operators allocating it and defaults to that of spilling it (i.e., of a
+dirty page).
+With equal read and write latencies, the dirty page target for background write-back is 5% of the capacity.
+*/
+class alignas(64) EvictionCostModel {
+public:
+    EvictionCostModel()
+        : read_ns(EVICTION_COST_DEFAULT_READ_NS)
+        , write_ns(EVICTION_COST_DEFAULT_WRITE_NS)
+        , fixed(false) { }
+
+    inline void recordRead(size_t num_pages, uint64_t ns) {
+        if (num_pages > 0 && !fixed.load(std::memory_order_relaxed))
+            update(read_ns, ns / num_pages);
+    }
+
+    inline void recordWrite(size_t num_pages, uint64_t ns) {
+        if (num_pages > 0 && !fixed.load(std::memory_order_relaxed))
+            update(write_ns, ns / num_pages);
+    }
+
+    // replaces the measured latencies with the given ones, further measurements are ignored (e.g., when replaying cache traces against a scratch file, see 'simulateCache()')
+    //  note: measurements that are being recorded concurrently may still be applied once
+    void setFixedLatencies(uint64_t read_ns, uint64_t write_ns) {
+        fixed = true;
+        this->read_ns = std::max<uint64_t>(read_ns, 1);
+        this->write_ns = std::max<uint64_t>(write_ns, 1);
+    }
+
+    uint64_t getCleanPageCost() const { return read_ns.load(std::memory_order_relaxed); }
+    uint64_t getDirtyPageCost() const { return read_ns.load(std::memory_order_relaxed) + write_ns.load(std::memory_order_relaxed); }
+    // 'page_cost_ns': cost of recomputing a page of a temporary allocation as hinted by the allocating operator, zero if unknown
+    uint64_t getTempPageCost(uint64_t page_cost_ns) const { return page_cost_ns == 0 ? getDirtyPageCost() : page_cost_ns; }
+
+    // decides whether a dirty eviction candidate is selected; dirty pages are selected with a probability of clean / dirty cost, i.e., they survive correspondingly more clock rounds than clean pages
+    inline bool admitDirtyCandidate() const {
+        return nextRandom() % getDirtyPageCost() < getCleanPageCost();
+    }
+
+    // number of dirty pages that idle workers and page cleaners write back ahead of eviction and that eviction skips while flushing asynchronously; the more expensive writes are, the fewer
+    size_t getDirtyPageTarget(size_t max_physical_pages) const {
+        return max_physical_pages * getCleanPageCost() / getDirtyPageCost() / EVICTION_COST_DIRTY_FRACTION;
+    }
+
+private:
+    static inline void update(std::atomic_uint64_t& average, uint64_t sample) {
+        // note: concurrent updates may get lost, which is fine for a moving average
+        const uint64_t current = average.load(std::memory_order_relaxed);
+        average.store(std::max<uint64_t>(current - current / EVICTION_COST_SMOOTHING + sample / EVICTION_COST_SMOOTHING, 1), std::memory_order_relaxed);
+    }
+
+    static inline uint64_t nextRandom() {
+        // splitmix64
+        thread_local uint64_t state = reinterpret_cast<uint64_t>(&state);
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    std::atomic_uint64_t read_ns;
+    std::atomic_uint64_t write_ns;
+    std::atomic_bool fixed; // set while workers may be recording measurements
+};
\ No newline at end of file
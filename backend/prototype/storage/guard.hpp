@@ -19,11 +19,13 @@ struct OptimisticGuard {
         init();
     }
 
+    // lock coupling: the parent is validated before the child's pid is used and again after the child's version has been read, so that the child cannot have been freed and reused for another page in between
     template<class T2>
     OptimisticGuard(PageId pid, OptimisticGuard<T2>& parent) : vmcache(parent.vmcache), worker_id(parent.worker_id), pid(pid) {
         parent.checkVersionAndRestart();
         data = reinterpret_cast<T*>(vmcache.toPointer(pid));
         init();
+        parent.checkVersionAndRestart();
     }
 
     ~OptimisticGuard() noexcept(false) {
@@ -63,6 +65,7 @@ struct OptimisticGuard {
 
     void init() {
         assert(pid != MOVED);
+        vmcache.traceAccess(pid, CacheAction::Ref, worker_id);
         PageState& ps = vmcache.getPageState(pid);
         for (size_t repeat_counter = 0; ; repeat_counter++) {
             uint64_t state = ps.load();
@@ -81,7 +84,8 @@ struct OptimisticGuard {
                     uint64_t new_state = (state & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED;
                     if (ps.compare_exchange_strong(state, new_state)) {
                         vmcache.fault(pid, PAGE_MODIFIED(state), false, worker_id);
-                        ps.store((state & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED, std::memory_order_release);
+                        // the partitioning strategy may have updated the page state while the page was faulted
+                        ps.store((ps.load() & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED, std::memory_order_release);
                     }
                     break;
                 }
@@ -101,7 +105,7 @@ struct OptimisticGuard {
                 return;
             if (PAGE_VERSION(version) == PAGE_VERSION(state)) { // same version
                 uint64_t s = PAGE_STATE(state);
-                if (s <= PAGE_STATE_LOCKED_SHARED_MAX)
+                if (s >= PAGE_STATE_UNLOCKED && s <= PAGE_STATE_LOCKED_SHARED_MAX)
                     return; // ignore shared locks
                 if (s == PAGE_STATE_MARKED) {
                     uint64_t new_state = (state & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED;
@@ -208,15 +212,16 @@ struct ExclusiveGuard {
     VMCache& vmcache;
     PageId pid;
     T* data;
+    uint32_t worker_id; // the page is released on behalf of this worker, so that changes made within its transaction are logged (see 'VMCache::beginTransaction()')
     static const PageId MOVED = ~0ull;
 
-    ExclusiveGuard(VMCache& vmcache): vmcache(vmcache), pid(MOVED), data(nullptr) {}
+    ExclusiveGuard(VMCache& vmcache): vmcache(vmcache), pid(MOVED), data(nullptr), worker_id(0) {}
 
-    explicit ExclusiveGuard(VMCache& vmcache, PageId pid, uint32_t worker_id) : vmcache(vmcache), pid(pid) {
+    explicit ExclusiveGuard(VMCache& vmcache, PageId pid, uint32_t worker_id) : vmcache(vmcache), pid(pid), worker_id(worker_id) {
         data = reinterpret_cast<T*>(vmcache.fixExclusive(pid, worker_id));
     }
 
-    explicit ExclusiveGuard(OptimisticGuard<T>&& other) : vmcache(other.vmcache), pid(MOVED), data(nullptr) {
+    explicit ExclusiveGuard(OptimisticGuard<T>&& other) : vmcache(other.vmcache), pid(MOVED), data(nullptr), worker_id(other.worker_id) {
         assert(other.pid != MOVED);
         for (size_t repeat_counter = 0; ; repeat_counter++) {
             PageState& ps = vmcache.getPageState(other.pid);
@@ -227,6 +232,8 @@ struct ExclusiveGuard {
             if (s == PAGE_STATE_UNLOCKED || s == PAGE_STATE_MARKED) {
                 if (ps.compare_exchange_strong(state, (state & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED)) {
                     // note: there is no need to call VMCache::fault() here, as we are upgrading from an optimistic latch, which will have already faulted the page
+                    vmcache.logModification(other.pid, other.worker_id);
+                    vmcache.traceAccess(other.pid, CacheAction::Write, other.worker_id);
                     pid = other.pid;
                     data = other.data;
                     other.pid = MOVED;
@@ -242,10 +249,11 @@ struct ExclusiveGuard {
 
     ExclusiveGuard& operator=(ExclusiveGuard&& other) { // move
         if (pid != MOVED) {
-            vmcache.unfixExclusive(pid);
+            vmcache.unfixExclusive(pid, worker_id);
         }
         pid = other.pid;
         data = other.data;
+        worker_id = other.worker_id;
         other.pid = MOVED;
         other.data = nullptr;
         return *this;
@@ -254,13 +262,14 @@ struct ExclusiveGuard {
     ExclusiveGuard(ExclusiveGuard&& other) : vmcache(other.vmcache) { // move
         pid = other.pid;
         data = other.data;
+        worker_id = other.worker_id;
         other.pid = MOVED;
         other.data = nullptr;
     }
 
     ~ExclusiveGuard() {
         if (pid != MOVED)
-            vmcache.unfixExclusive(pid);
+            vmcache.unfixExclusive(pid, worker_id);
     }
 
     T* operator->() {
@@ -270,11 +279,19 @@ struct ExclusiveGuard {
 
     void release() {
         if (pid != MOVED) {
-            vmcache.unfixExclusive(pid);
+            vmcache.unfixExclusive(pid, worker_id);
             pid = MOVED;
         }
     }
 
+    // returns the page to the free page list of the cache and releases the guard; the page must no longer be referenced
+    void free(uint32_t worker_id) {
+        assert(pid != MOVED);
+        vmcache.freePage(pid, worker_id);
+        pid = MOVED;
+        data = nullptr;
+    }
+
     bool isReleased() const {
         return pid == MOVED;
     }
@@ -284,7 +301,8 @@ template<class T>
 struct AllocGuard : public ExclusiveGuard<T> {
     template <typename ...Params>
     AllocGuard(VMCache& vmcache, uint32_t worker_id, Params&&... params) : ExclusiveGuard<T>(vmcache) {
-        ExclusiveGuard<T>::pid = vmcache.allocatePage();
+        ExclusiveGuard<T>::worker_id = worker_id;
+        ExclusiveGuard<T>::pid = vmcache.allocatePage(worker_id);
         ExclusiveGuard<T>::data = reinterpret_cast<T*>(vmcache.fixExclusive(ExclusiveGuard<T>::pid, worker_id));
         new (ExclusiveGuard<T>::data) T(std::forward<Params>(params)...);
     }
@@ -0,0 +1,132 @@
+#include "io_uring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+IOUring::IOUring(unsigned entries)
+    : to_submit(0)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd < 0)
+        throw std::runtime_error("io_uring_setup failed");
+    sq_entries = params.sq_entries;
+
+    sq_ptr_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ptr_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_ptr_size = std::max(sq_ptr_size, cq_ptr_size);
+        cq_ptr_size = sq_ptr_size;
+    }
+    sq_ptr = mmap(0, sq_ptr_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+        close(ring_fd);
+        throw std::runtime_error("Failed to map io_uring submission queue");
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ptr = sq_ptr;
+    } else {
+        cq_ptr = mmap(0, cq_ptr_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) {
+            munmap(sq_ptr, sq_ptr_size);
+            close(ring_fd);
+            throw std::runtime_error("Failed to map io_uring completion queue");
+        }
+    }
+    sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = reinterpret_cast<io_uring_sqe*>(mmap(0, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+        if (cq_ptr != sq_ptr)
+            munmap(cq_ptr, cq_ptr_size);
+        munmap(sq_ptr, sq_ptr_size);
+        close(ring_fd);
+        throw std::runtime_error("Failed to map io_uring submission queue entries");
+    }
+
+    char* sq = reinterpret_cast<char*>(sq_ptr);
+    sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = reinterpret_cast<char*>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+IOUring::~IOUring() {
+    munmap(sqes, sqes_size);
+    if (cq_ptr != sq_ptr)
+        munmap(cq_ptr, cq_ptr_size);
+    munmap(sq_ptr, sq_ptr_size);
+    close(ring_fd);
+}
+
+bool IOUring::prepareRead(int fd, void* dest, uint32_t len, uint64_t offset, uint64_t user_data) {
+    return prepare(IORING_OP_READ, fd, dest, len, offset, user_data);
+}
+
+bool IOUring::prepareWrite(int fd, const void* src, uint32_t len, uint64_t offset, uint64_t user_data) {
+    return prepare(IORING_OP_WRITE, fd, src, len, offset, user_data);
+}
+
+bool IOUring::prepare(uint8_t opcode, int fd, const void* buffer, uint32_t len, uint64_t offset, uint64_t user_data) {
+    const unsigned tail = *sq_tail;
+    if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+        return false;
+    const unsigned index = tail & *sq_mask;
+    struct io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    to_submit++;
+    return true;
+}
+
+int IOUring::submitAndWait(unsigned wait_nr) {
+    const unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    unsigned submitted = 0;
+    while (true) {
+        const int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit - submitted, wait_nr, flags, nullptr, 0));
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            const int err = errno;
+            errno = 0;
+            // drop the requests that the kernel did not consume, so that they are not submitted with later ones (the kernel only consumes requests during 'io_uring_enter()')
+            __atomic_store_n(sq_tail, *sq_tail - (to_submit - submitted), __ATOMIC_RELEASE);
+            to_submit = 0;
+            return -err;
+        }
+        submitted += static_cast<unsigned>(ret);
+        if (submitted >= to_submit)
+            break;
+    }
+    to_submit = 0;
+    return static_cast<int>(submitted);
+}
+
+bool IOUring::popCompletion(uint64_t& user_data, int32_t& result) {
+    const unsigned head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        return false;
+    const struct io_uring_cqe* cqe = &cqes[head & *cq_mask];
+    user_data = cqe->user_data;
+    result = cqe->res;
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
\ No newline at end of file
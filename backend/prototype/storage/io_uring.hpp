@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/*
+Minimal io_uring submission/completion ring built directly on top of the io_uring system calls (no liburing dependency).
+A ring is not thread-safe, VMCache keeps one ring per worker.
+*/
+class IOUring {
+public:
+    explicit IOUring(unsigned entries);
+    ~IOUring();
+
+    IOUring(const IOUring& other) = delete;
+    IOUring(IOUring&& other) = delete;
+    IOUring& operator=(const IOUring& other) = delete;
+    IOUring& operator=(IOUring&& other) = delete;
+
+    unsigned getCapacity() const { return sq_entries; }
+
+    // queues a read request without submitting it; returns false if the submission queue is full
+    bool prepareRead(int fd, void* dest, uint32_t len, uint64_t offset, uint64_t user_data);
+    // queues a write request without submitting it; returns false if the submission queue is full
+    bool prepareWrite(int fd, const void* src, uint32_t len, uint64_t offset, uint64_t user_data);
+    // submits all queued requests and waits until at least 'wait_nr' completions are available; returns the number of submitted requests or -errno, queued requests are dropped on errors
+    int submitAndWait(unsigned wait_nr);
+    // reaps a single completion; returns false if no completion is available
+    bool popCompletion(uint64_t& user_data, int32_t& result);
+
+private:
+    bool prepare(uint8_t opcode, int fd, const void* buffer, uint32_t len, uint64_t offset, uint64_t user_data);
+
+    int ring_fd;
+    unsigned sq_entries;
+    unsigned to_submit;
+    // submission queue
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    io_uring_sqe* sqes;
+    // completion queue
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    io_uring_cqe* cqes;
+    // mappings shared with the kernel
+    void* sq_ptr;
+    size_t sq_ptr_size;
+    void* cq_ptr;
+    size_t cq_ptr_size;
+    size_t sqes_size;
+};
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <atomic>
 
 #define PAGE_SIZE (4ull * 1024ull)
+// number of consecutive pages that make up an extent, the larger page class used for column data (see 'VMCache::allocateExtent()')
+#define EXTENT_NUM_PAGES 16ull
+#define EXTENT_SIZE (EXTENT_NUM_PAGES * PAGE_SIZE)
 
 typedef std::atomic_uint64_t PageState;
 #define PAGE_STATE_MASK 255ull
@@ -10,13 +13,26 @@ typedef std::atomic_uint64_t PageState;
 #define PAGE_MODIFIED_BIT 0b1000000000ull
 #define PAGE_MODIFIED(state) ((state & PAGE_MODIFIED_BIT) != 0)
 #define PAGE_STATE(state) (state & PAGE_STATE_MASK)
-#define PAGE_VERSION_OFFSET 10
+// set in the page state of the first page of an extent, the states of the extent's other pages are unused
+#define PAGE_EXTENT_BIT 0b10000000000ull
+#define PAGE_IS_EXTENT(state) ((state & PAGE_EXTENT_BIT) != 0)
+#define PAGE_NUM_PAGES(state) (PAGE_IS_EXTENT(state) ? EXTENT_NUM_PAGES : 1ull)
+// NUMA node of the cache partition that tracks a resident page (see 'NUMAPartitioningStrategy'), only valid while the page is not evicted
+#define PAGE_NODE_OFFSET 11
+#define PAGE_NODE_MASK (63ull << PAGE_NODE_OFFSET)
+#define PAGE_NODE(state) ((state & PAGE_NODE_MASK) >> PAGE_NODE_OFFSET)
+#define PAGE_MAX_NODES 64ul
+// set while the page has been modified by transactions that have not committed yet, such pages are never written to the database file (see 'VMCache::commitTransaction()')
+#define PAGE_UNCOMMITTED_BIT (1ull << 17)
+#define PAGE_UNCOMMITTED(state) ((state & PAGE_UNCOMMITTED_BIT) != 0)
+#define PAGE_VERSION_OFFSET 18
 #define PAGE_VERSION(state) (state >> PAGE_VERSION_OFFSET)
 
-#define PAGE_STATE_UNLOCKED 0
-#define PAGE_STATE_LOCKED_SHARED_MIN 1
-#define PAGE_STATE_LOCKED_SHARED_MAX 251
-#define PAGE_STATE_FAULTED 252 // this is for temporary pages that are currently unused but have not been returned to the OS yet using 'madvise(MADV_DONTNEED)'
-#define PAGE_STATE_LOCKED 253
-#define PAGE_STATE_MARKED 254
-#define PAGE_STATE_EVICTED 255
\ No newline at end of file
+// note: zero-filled memory encodes an evicted page with version zero, so the page state array does not need to be initialized
+#define PAGE_STATE_EVICTED 0
+#define PAGE_STATE_UNLOCKED 1
+#define PAGE_STATE_LOCKED_SHARED_MIN 2 // releasing the last shared latch decrements the state to PAGE_STATE_UNLOCKED
+#define PAGE_STATE_LOCKED_SHARED_MAX 252
+#define PAGE_STATE_FAULTED 253 // this is for temporary pages that are currently unused but have not been returned to the OS yet using 'madvise(MADV_DONTNEED)'
+#define PAGE_STATE_LOCKED 254
+#define PAGE_STATE_MARKED 255
\ No newline at end of file
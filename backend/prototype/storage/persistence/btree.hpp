@@ -1,10 +1,50 @@
 #pragma once
 
+#include <algorithm>
 #include <optional>
+#include <queue>
+#include <vector>
 
+#include "../../core/types.hpp"
 #include "../../storage/guard.hpp"
 #include "../../storage/page.hpp"
 #include "../../storage/vmcache.hpp"
+#include "simd_key_search.hpp"
+
+template <typename KeyType>
+size_t lowerBound(const KeyType array[], size_t size, KeyType key) {
+    if constexpr (SIMDKeySearch<KeyType>::supported) {
+        // binary search down to a window of keys that are then compared using vector instructions
+        size_t l = 0;
+        size_t h = size;
+        while (h - l > SIMDKeySearch<KeyType>::window) {
+            size_t m = (l + h) / 2;
+            if (array[m] < key) {
+                l = m + 1;
+            } else {
+                h = m;
+            }
+        }
+        return l + SIMDKeySearch<KeyType>::countLess(array + l, h - l, key);
+    }
+
+    if (size == 0)
+        return 0;
+
+    size_t l = 0;
+    size_t h = size;
+    while (l < h) {
+        size_t m = (l + h) / 2;
+        if (array[m] == key) {
+            return m;
+        } else if (array[m] > key) {
+            h = m;
+        } else {
+            l = m + 1;
+        }
+    }
+    return l;
+}
 
 /**
  * B+-Tree implementation on top of 'VMCache' pages; requires key values to be unique
@@ -15,15 +55,76 @@ struct BTreeNodeHeader {
     size_t level;
 };
 
+/*
+Nodes are accessed by 'BTree' through the following interface, which allows specializing the node layout per key type.
+'capacity' is the number of keys a node can hold at least, the current capacity of a node may be larger if its layout
+compresses keys. The fences passed to 'init()' bound the keys that a node can hold (lower fence inclusive, upper fence
+exclusive), they are the separators of the node in its parent and are only used by layouts that truncate key prefixes.
+*/
 template <typename KeyType, size_t size>
 struct BTreeInnerNode : BTreeNodeHeader<KeyType> {
     static_assert(sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId) < size);
-    static const size_t capacity = (size - sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId)) / (sizeof(KeyType) + sizeof(PageId));
+    static constexpr size_t capacity = (size - sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId)) / (sizeof(KeyType) + sizeof(PageId));
     static_assert(capacity >= 1);
 
     PageId children[capacity + 1];
     KeyType keys[capacity];
 
+    inline void init(size_t level, const KeyType* = nullptr, const KeyType* = nullptr) {
+        this->n_keys = 0;
+        this->level = level;
+    }
+
+    inline size_t getCapacity() const { return capacity; }
+    inline bool isFull() const { return this->n_keys >= capacity; }
+    inline KeyType getKey(size_t i) const { return keys[std::min(i, capacity - 1)]; }
+    inline PageId getChild(size_t i) const { return children[std::min(i, capacity)]; }
+    inline void setChild(size_t i, PageId child) { children[i] = child; }
+
+    // returns the index of the child whose subtree contains 'key'
+    // note: optimistic readers may see a node whose page has been freed and reused concurrently, so the key count is clamped to the capacity to stay within the page until the reader validates
+    inline size_t findChild(KeyType key) const {
+        const size_t n_keys = std::min(this->n_keys, capacity);
+        size_t l = lowerBound<KeyType>(keys, n_keys, key);
+        if (l < n_keys && keys[l] == key)
+            l++;
+        return l;
+    }
+
+    // inserts the separator 'key' with 'child' as its right child
+    inline void insert(KeyType key, PageId child) {
+        assert(this->n_keys < capacity);
+        size_t l = lowerBound<KeyType>(keys, this->n_keys, key);
+        for (size_t i = this->n_keys; i > l; i--) {
+            keys[i] = keys[i - 1];
+        }
+        for (size_t i = this->n_keys + 1; i > l + 1; i--) {
+            children[i] = children[i - 1];
+        }
+        keys[l] = key;
+        children[l + 1] = child;
+        this->n_keys++;
+    }
+
+    inline void append(KeyType key, PageId child) {
+        assert(this->n_keys < capacity);
+        keys[this->n_keys] = key;
+        children[this->n_keys + 1] = child;
+        this->n_keys++;
+    }
+
+    // moves the upper half of the keys and children to 'right', returns the separator between both nodes
+    inline KeyType split(BTreeInnerNode* right) {
+        const size_t l_n_keys = (this->n_keys + 1) / 2;
+        // after split: this = left node, right = right node
+        right->n_keys = this->n_keys - l_n_keys - 1;
+        right->level = this->level;
+        memcpy(right->keys, keys + l_n_keys + 1, right->n_keys * sizeof(KeyType));
+        memcpy(right->children, children + l_n_keys + 1, (right->n_keys + 1) * sizeof(PageId));
+        this->n_keys = l_n_keys;
+        return keys[l_n_keys];
+    }
+
     inline void remove(size_t i) {
         assert(i <= this->n_keys);
         if (i != 0)
@@ -36,13 +137,26 @@ struct BTreeInnerNode : BTreeNodeHeader<KeyType> {
 template <typename KeyType, typename ValueType, size_t size>
 struct BTreeLeafNode : BTreeNodeHeader<KeyType> {
     static_assert(sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId) < size);
-    static const size_t capacity = (size - sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId)) / (sizeof(KeyType) + sizeof(ValueType));
+    static constexpr size_t capacity = (size - sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId)) / (sizeof(KeyType) + sizeof(ValueType));
     static_assert(capacity >= 1);
 
     PageId next;
     KeyType keys[capacity];
     ValueType values[capacity];
 
+    inline void init(const KeyType* = nullptr, const KeyType* = nullptr) {
+        this->n_keys = 0;
+        this->level = 0;
+        next = INVALID_PAGE_ID;
+    }
+
+    inline void setUpperFence(KeyType) { }
+
+    inline size_t getCapacity() const { return capacity; }
+    inline bool isFull() const { return this->n_keys >= capacity; }
+    inline KeyType getKey(size_t i) const { return keys[std::min(i, capacity - 1)]; }
+    inline size_t lowerBound(KeyType key) const { return ::lowerBound<KeyType>(keys, std::min(this->n_keys, capacity), key); } // clamped for optimistic readers, see 'BTreeInnerNode::findChild()'
+
     inline KeyType split(ExclusiveGuard<BTreeLeafNode>& new_leaf) {
         size_t l_n_keys = (this->n_keys + 1) / 2;
         // after split: this = left node, new_leaf = right node
@@ -53,6 +167,7 @@ struct BTreeLeafNode : BTreeNodeHeader<KeyType> {
         return new_leaf->keys[0];
     }
 
+
     inline void insert(size_t i, KeyType key, ValueType value) {
         for (size_t j = this->n_keys; j > i; j--) {
             this->keys[j] = this->keys[j - 1];
@@ -63,8 +178,19 @@ struct BTreeLeafNode : BTreeNodeHeader<KeyType> {
         this->n_keys++;
     }
 
+    inline void append(KeyType key, ValueType value) {
+        assert(this->n_keys < capacity);
+        this->keys[this->n_keys] = key;
+        this->values[this->n_keys] = value;
+        this->n_keys++;
+    }
+
     inline ValueType get(size_t i) const {
-        return this->values[i];
+        return this->values[std::min(i, capacity - 1)];
+    }
+
+    inline void update(size_t i, ValueType value) {
+        this->values[i] = value;
     }
 
     inline void remove(size_t i) {
@@ -93,13 +219,26 @@ struct BTreeLeafNode : BTreeNodeHeader<KeyType> {
 template <typename KeyType, size_t size>
 struct BTreeLeafNode<KeyType, bool, size> : BTreeNodeHeader<KeyType> {
     static_assert(sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId) < size);
-    static const size_t capacity = (size - sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId)) * 8 / (sizeof(KeyType) * 8 + 1);
+    static constexpr size_t capacity = (size - sizeof(BTreeNodeHeader<KeyType>) - sizeof(PageId)) * 8 / (sizeof(KeyType) * 8 + 1);
     static_assert(capacity >= 1);
 
     PageId next;
     KeyType keys[capacity];
     uint8_t values[(capacity + 7) / 8];
 
+    inline void init(const KeyType* = nullptr, const KeyType* = nullptr) {
+        this->n_keys = 0;
+        this->level = 0;
+        next = INVALID_PAGE_ID;
+    }
+
+    inline void setUpperFence(KeyType) { }
+
+    inline size_t getCapacity() const { return capacity; }
+    inline bool isFull() const { return this->n_keys >= capacity; }
+    inline KeyType getKey(size_t i) const { return keys[std::min(i, capacity - 1)]; }
+    inline size_t lowerBound(KeyType key) const { return ::lowerBound<KeyType>(keys, std::min(this->n_keys, capacity), key); } // clamped for optimistic readers, see 'BTreeInnerNode::findChild()'
+
     inline KeyType split(ExclusiveGuard<BTreeLeafNode>& new_leaf) {
         size_t l_n_keys = (this->n_keys + 7) / 16 * 8; // split at a multiple of 8 to simplify copying values
         // after split: this = left node, new_leaf = right node
@@ -134,7 +273,15 @@ struct BTreeLeafNode<KeyType, bool, size> : BTreeNodeHeader<KeyType> {
         this->n_keys++;
     }
 
+    inline void append(KeyType key, bool value) {
+        assert(this->n_keys < capacity);
+        this->keys[this->n_keys] = key;
+        update(this->n_keys, value);
+        this->n_keys++;
+    }
+
     inline bool get(size_t i) const {
+        i = std::min(i, capacity - 1);
         return (this->values[i / 8] >> (i % 8)) & 0x1;
     }
 
@@ -155,25 +302,394 @@ struct BTreeLeafNode<KeyType, bool, size> : BTreeNodeHeader<KeyType> {
     }
 };
 
-template <typename KeyType>
-size_t lowerBound(const KeyType array[], size_t size, KeyType key) {
-    if (size == 0)
-        return 0;
+/*
+Node layout for 'CompositeKey's: keys are stored as normalized, i.e., big-endian byte strings that compare like the
+keys themselves when using memcmp(). All keys of a node lie between its fences and thus share the common prefix of both
+fences, which is stored only once (as part of the lower fence). E.g., the leading warehouse and district ids of the
+TPC-C indexes are truncated from most nodes, which increases the fanout of inner nodes and the capacity of leaves.
+Nodes without a lower or upper fence (i.e., on the left- or rightmost path of the tree) are not truncated.
+*/
+template <size_t n>
+struct BTreeKeyPrefix {
+    static constexpr size_t key_length = n * sizeof(Identifier);
+
+    uint8_t lower_fence[key_length];
+    uint8_t upper_fence[key_length];
+    uint16_t length;
+    bool has_lower_fence;
+    bool has_upper_fence;
+
+    static inline void normalize(const CompositeKey<n>& key, uint8_t* out) {
+        for (size_t i = 0; i < n; i++) {
+            const Identifier component = __builtin_bswap32(key.keys[i]);
+            memcpy(out + i * sizeof(Identifier), &component, sizeof(Identifier));
+        }
+    }
 
-    size_t l = 0;
-    size_t h = size;
-    while (l < h) {
-        size_t m = (l + h) / 2;
-        if (array[m] == key) {
-            return m;
-        } else if (array[m] > key) {
-            h = m;
-        } else {
-            l = m + 1;
+    static inline CompositeKey<n> denormalize(const uint8_t* in) {
+        CompositeKey<n> key;
+        for (size_t i = 0; i < n; i++) {
+            Identifier component;
+            memcpy(&component, in + i * sizeof(Identifier), sizeof(Identifier));
+            key.keys[i] = __builtin_bswap32(component);
         }
+        return key;
+    }
+
+    // returns the length of the prefix shared by all keys between the given (normalized) fences
+    static inline size_t commonLength(const uint8_t* lower, const uint8_t* upper) {
+        if (lower == nullptr || upper == nullptr)
+            return 0;
+        size_t common = 0;
+        while (common < key_length && lower[common] == upper[common])
+            common++;
+        return common;
+    }
+
+    inline void set(const uint8_t* lower, const uint8_t* upper) {
+        length = commonLength(lower, upper);
+        has_lower_fence = lower != nullptr;
+        has_upper_fence = upper != nullptr;
+        if (has_lower_fence)
+            memmove(lower_fence, lower, key_length);
+        if (has_upper_fence)
+            memmove(upper_fence, upper, key_length);
+    }
+
+    inline const uint8_t* getLowerFence() const { return has_lower_fence ? lower_fence : nullptr; }
+    inline const uint8_t* getUpperFence() const { return has_upper_fence ? upper_fence : nullptr; }
+    // the length is read optimistically and may be torn by a concurrent writer (the read is validated afterwards), so it is clamped to the key length like the nodes' key count
+    inline size_t prefixLength() const { return std::min<size_t>(length, key_length); }
+    inline size_t suffixLength() const { return key_length - prefixLength(); }
+
+    // reads a suffix of up to eight bytes as a big-endian integer, so that suffixes compare like their integers
+    static inline uint64_t loadSuffix(const uint8_t* suffix, size_t suffix_length) {
+        uint64_t result = 0;
+        memcpy(reinterpret_cast<uint8_t*>(&result) + sizeof(uint64_t) - suffix_length, suffix, suffix_length);
+        return __builtin_bswap64(result);
+    }
+
+    // returns the number of the 'count' suffixes that are less than (or, with 'or_equal', equal to) the normalized 'key'
+    inline size_t search(const uint8_t* suffixes, size_t count, const uint8_t* key, bool or_equal) const {
+        // keys outside of the node's fences can only be found when scanning, they are ordered by their prefix alone
+        const size_t prefix_length = prefixLength();
+        const int prefix_cmp = memcmp(key, lower_fence, prefix_length);
+        if (prefix_cmp != 0)
+            return prefix_cmp < 0 ? 0 : count;
+        const size_t suffix_length = key_length - prefix_length;
+        key += prefix_length;
+        size_t l = 0;
+        size_t h = count;
+        if constexpr (SIMDKeySearch<uint64_t>::supported) {
+            // short suffixes (e.g., the order and line numbers of TPC-C order lines below a truncated warehouse and district) are compared as integers
+            if (suffix_length <= sizeof(uint64_t)) {
+                const uint64_t k = loadSuffix(key, suffix_length);
+                while (h - l > SIMDKeySearch<uint64_t>::window) {
+                    size_t m = (l + h) / 2;
+                    const uint64_t suffix = loadSuffix(suffixes + m * suffix_length, suffix_length);
+                    if (suffix < k || (or_equal && suffix == k)) {
+                        l = m + 1;
+                    } else {
+                        h = m;
+                    }
+                }
+                // no suffix is greater than the largest possible one
+                if (or_equal && k == UINT64_MAX)
+                    return h;
+                uint64_t window[SIMDKeySearch<uint64_t>::window];
+                for (size_t i = l; i < h; i++)
+                    window[i - l] = loadSuffix(suffixes + i * suffix_length, suffix_length);
+                return l + SIMDKeySearch<uint64_t>::countLess(window, h - l, or_equal ? k + 1 : k);
+            }
+        }
+        while (l < h) {
+            size_t m = (l + h) / 2;
+            const int cmp = memcmp(suffixes + m * suffix_length, key, suffix_length);
+            if (cmp < 0 || (or_equal && cmp == 0)) {
+                l = m + 1;
+            } else {
+                h = m;
+            }
+        }
+        return l;
+    }
+};
+
+// note: the offsets of the children/values and the keys depend on the prefix length, which is why they are computed from the (optimistically read) prefix length on every access and the key count is clamped to the resulting capacity
+template <size_t n, size_t size>
+struct BTreeInnerNode<CompositeKey<n>, size> : BTreeNodeHeader<CompositeKey<n>> {
+    typedef CompositeKey<n> KeyType;
+    typedef BTreeKeyPrefix<n> Prefix;
+    static constexpr size_t area_offset = (sizeof(BTreeNodeHeader<KeyType>) + sizeof(Prefix) + 7) / 8 * 8;
+    static_assert(area_offset + sizeof(PageId) < size);
+    static constexpr size_t capacityFor(size_t suffix_length) { return (size - area_offset - sizeof(PageId)) / (suffix_length + sizeof(PageId)); }
+    static constexpr size_t capacity = capacityFor(Prefix::key_length);
+    static_assert(capacity >= 1);
+
+    Prefix prefix;
+    alignas(PageId) uint8_t area[size - area_offset];
+
+    inline void init(size_t level, const KeyType* lower_fence = nullptr, const KeyType* upper_fence = nullptr) {
+        uint8_t lower[Prefix::key_length];
+        uint8_t upper[Prefix::key_length];
+        if (lower_fence)
+            Prefix::normalize(*lower_fence, lower);
+        if (upper_fence)
+            Prefix::normalize(*upper_fence, upper);
+        this->n_keys = 0;
+        this->level = level;
+        prefix.set(lower_fence ? lower : nullptr, upper_fence ? upper : nullptr);
+    }
+
+    inline size_t getCapacity() const { return capacityFor(prefix.suffixLength()); }
+    inline bool isFull() const { return this->n_keys >= getCapacity(); }
+    inline KeyType getKey(size_t i) const {
+        uint8_t key[Prefix::key_length];
+        getNormalizedKey(i, key);
+        return Prefix::denormalize(key);
+    }
+    inline PageId getChild(size_t i) const { return children()[std::min(i, getCapacity())]; }
+    inline void setChild(size_t i, PageId child) { children()[i] = child; }
+
+    inline size_t findChild(KeyType key) const {
+        uint8_t normalized[Prefix::key_length];
+        Prefix::normalize(key, normalized);
+        return prefix.search(suffixes(), std::min(this->n_keys, getCapacity()), normalized, true);
+    }
+
+    inline void insert(KeyType key, PageId child) {
+        assert(!isFull());
+        uint8_t normalized[Prefix::key_length];
+        Prefix::normalize(key, normalized);
+        assert(memcmp(normalized, prefix.lower_fence, prefix.prefixLength()) == 0);
+        const size_t suffix_length = prefix.suffixLength();
+        const size_t l = prefix.search(suffixes(), this->n_keys, normalized, false);
+        memmove(suffix(l + 1), suffix(l), (this->n_keys - l) * suffix_length);
+        memmove(children() + l + 2, children() + l + 1, (this->n_keys - l) * sizeof(PageId));
+        memcpy(suffix(l), normalized + prefix.prefixLength(), suffix_length);
+        children()[l + 1] = child;
+        this->n_keys++;
     }
-    return l;
-}
+
+    inline void append(KeyType key, PageId child) {
+        uint8_t normalized[Prefix::key_length];
+        Prefix::normalize(key, normalized);
+        appendNormalized(normalized, child);
+    }
+
+    inline KeyType split(BTreeInnerNode* right) {
+        const size_t l_n_keys = (this->n_keys + 1) / 2;
+        uint8_t separator[Prefix::key_length];
+        getNormalizedKey(l_n_keys, separator);
+        // after split: this = left node, right = right node
+        right->n_keys = 0;
+        right->level = this->level;
+        right->prefix.set(separator, prefix.getUpperFence());
+        right->setChild(0, getChild(l_n_keys + 1));
+        uint8_t key[Prefix::key_length];
+        for (size_t i = l_n_keys + 1; i < this->n_keys; i++) {
+            getNormalizedKey(i, key);
+            right->appendNormalized(key, getChild(i + 1));
+        }
+        rebuild(l_n_keys, separator);
+        return Prefix::denormalize(separator);
+    }
+
+    inline void remove(size_t i) {
+        assert(i <= this->n_keys);
+        if (i != 0)
+            memmove(suffix(i - 1), suffix(i), prefix.suffixLength() * (this->n_keys - i));
+        memmove(children() + i, children() + i + 1, sizeof(PageId) * (this->n_keys - i));
+        this->n_keys--;
+    }
+
+private:
+    inline PageId* children() { return reinterpret_cast<PageId*>(area); }
+    inline const PageId* children() const { return reinterpret_cast<const PageId*>(area); }
+    inline uint8_t* suffixes() { return area + (getCapacity() + 1) * sizeof(PageId); }
+    inline const uint8_t* suffixes() const { return area + (getCapacity() + 1) * sizeof(PageId); }
+    inline uint8_t* suffix(size_t i) { return suffixes() + i * prefix.suffixLength(); }
+    inline const uint8_t* suffix(size_t i) const { return suffixes() + std::min(i, getCapacity() - 1) * prefix.suffixLength(); }
+
+    inline void getNormalizedKey(size_t i, uint8_t* out) const {
+        memcpy(out, prefix.lower_fence, prefix.prefixLength());
+        memcpy(out + prefix.prefixLength(), suffix(i), prefix.suffixLength());
+    }
+
+    inline void appendNormalized(const uint8_t* key, PageId child) {
+        assert(!isFull());
+        memcpy(suffix(this->n_keys), key + prefix.prefixLength(), prefix.suffixLength());
+        children()[this->n_keys + 1] = child;
+        this->n_keys++;
+    }
+
+    // keeps the first 'count' keys and re-encodes them for the new upper fence, which may lengthen the common prefix
+    inline void rebuild(size_t count, const uint8_t* upper_fence) {
+        BTreeInnerNode copy;
+        memcpy(&copy, this, sizeof(BTreeInnerNode));
+        this->n_keys = 0;
+        prefix.set(copy.prefix.getLowerFence(), upper_fence);
+        setChild(0, copy.getChild(0));
+        uint8_t key[Prefix::key_length];
+        for (size_t i = 0; i < count; i++) {
+            copy.getNormalizedKey(i, key);
+            appendNormalized(key, copy.getChild(i + 1));
+        }
+    }
+};
+
+template <size_t n, typename ValueType, size_t size>
+struct BTreeLeafNode<CompositeKey<n>, ValueType, size> : BTreeNodeHeader<CompositeKey<n>> {
+    typedef CompositeKey<n> KeyType;
+    typedef BTreeKeyPrefix<n> Prefix;
+    static_assert(alignof(ValueType) <= alignof(PageId));
+    static constexpr size_t area_offset = (sizeof(BTreeNodeHeader<KeyType>) + sizeof(PageId) + sizeof(Prefix) + 7) / 8 * 8;
+    static_assert(area_offset < size);
+    static constexpr size_t capacityFor(size_t suffix_length) { return (size - area_offset) / (suffix_length + sizeof(ValueType)); }
+    static constexpr size_t capacity = capacityFor(Prefix::key_length);
+    static_assert(capacity >= 1);
+
+    PageId next;
+    Prefix prefix;
+    alignas(PageId) uint8_t area[size - area_offset];
+
+    inline void init(const KeyType* lower_fence = nullptr, const KeyType* upper_fence = nullptr) {
+        uint8_t lower[Prefix::key_length];
+        uint8_t upper[Prefix::key_length];
+        if (lower_fence)
+            Prefix::normalize(*lower_fence, lower);
+        if (upper_fence)
+            Prefix::normalize(*upper_fence, upper);
+        this->n_keys = 0;
+        this->level = 0;
+        next = INVALID_PAGE_ID;
+        prefix.set(lower_fence ? lower : nullptr, upper_fence ? upper : nullptr);
+    }
+
+    // narrows the key range of the node to the keys below 'upper_fence' (e.g., after bulk loading it), which may lengthen the common prefix
+    inline void setUpperFence(KeyType upper_fence) {
+        uint8_t upper[Prefix::key_length];
+        Prefix::normalize(upper_fence, upper);
+        rebuild(upper);
+    }
+
+    inline size_t getCapacity() const { return capacityFor(prefix.suffixLength()); }
+    inline bool isFull() const { return this->n_keys >= getCapacity(); }
+    inline KeyType getKey(size_t i) const {
+        uint8_t key[Prefix::key_length];
+        getNormalizedKey(i, key);
+        return Prefix::denormalize(key);
+    }
+
+    inline size_t lowerBound(KeyType key) const {
+        uint8_t normalized[Prefix::key_length];
+        Prefix::normalize(key, normalized);
+        return prefix.search(suffixes(), std::min(this->n_keys, getCapacity()), normalized, false);
+    }
+
+    inline KeyType split(ExclusiveGuard<BTreeLeafNode>& new_leaf) {
+        const size_t l_n_keys = (this->n_keys + 1) / 2;
+        uint8_t separator[Prefix::key_length];
+        getNormalizedKey(l_n_keys, separator);
+        // after split: this = left node, new_leaf = right node
+        new_leaf->n_keys = 0;
+        new_leaf->prefix.set(separator, prefix.getUpperFence());
+        uint8_t key[Prefix::key_length];
+        for (size_t i = l_n_keys; i < this->n_keys; i++) {
+            getNormalizedKey(i, key);
+            new_leaf->appendNormalized(key, get(i));
+        }
+        this->n_keys = l_n_keys;
+        rebuild(separator);
+        return Prefix::denormalize(separator);
+    }
+
+    inline void insert(size_t i, KeyType key, ValueType value) {
+        assert(!isFull());
+        uint8_t normalized[Prefix::key_length];
+        Prefix::normalize(key, normalized);
+        assert(memcmp(normalized, prefix.lower_fence, prefix.prefixLength()) == 0);
+        const size_t suffix_length = prefix.suffixLength();
+        memmove(suffix(i + 1), suffix(i), (this->n_keys - i) * suffix_length);
+        memmove(values() + i + 1, values() + i, (this->n_keys - i) * sizeof(ValueType));
+        memcpy(suffix(i), normalized + prefix.prefixLength(), suffix_length);
+        values()[i] = value;
+        this->n_keys++;
+    }
+
+    inline void append(KeyType key, ValueType value) {
+        uint8_t normalized[Prefix::key_length];
+        Prefix::normalize(key, normalized);
+        appendNormalized(normalized, value);
+    }
+
+    inline ValueType get(size_t i) const {
+        return values()[std::min(i, getCapacity() - 1)];
+    }
+
+    inline void update(size_t i, ValueType value) {
+        values()[i] = value;
+    }
+
+    inline void remove(size_t i) {
+        assert(i < this->n_keys);
+        memmove(suffix(i), suffix(i + 1), prefix.suffixLength() * (this->n_keys - i - 1));
+        memmove(values() + i, values() + i + 1, sizeof(ValueType) * (this->n_keys - i - 1));
+        this->n_keys--;
+    }
+
+    // merge 'right' into this
+    inline bool merge(size_t i, BTreeInnerNode<KeyType, size>* parent, BTreeLeafNode* right) {
+        const uint8_t* upper_fence = right->prefix.getUpperFence();
+        if (this->n_keys + right->n_keys > capacityFor(Prefix::key_length - Prefix::commonLength(prefix.getLowerFence(), upper_fence)))
+            return false;
+
+        // merge leaf data
+        rebuild(upper_fence);
+        uint8_t key[Prefix::key_length];
+        for (size_t j = 0; j < right->n_keys; j++) {
+            right->getNormalizedKey(j, key);
+            appendNormalized(key, right->get(j));
+        }
+        this->next = right->next;
+        // update parent node
+        parent->remove(i + 1);
+        return true;
+    }
+
+private:
+    inline ValueType* values() { return reinterpret_cast<ValueType*>(area); }
+    inline const ValueType* values() const { return reinterpret_cast<const ValueType*>(area); }
+    inline uint8_t* suffixes() { return area + getCapacity() * sizeof(ValueType); }
+    inline const uint8_t* suffixes() const { return area + getCapacity() * sizeof(ValueType); }
+    inline uint8_t* suffix(size_t i) { return suffixes() + i * prefix.suffixLength(); }
+    inline const uint8_t* suffix(size_t i) const { return suffixes() + std::min(i, getCapacity() - 1) * prefix.suffixLength(); }
+
+    inline void getNormalizedKey(size_t i, uint8_t* out) const {
+        memcpy(out, prefix.lower_fence, prefix.prefixLength());
+        memcpy(out + prefix.prefixLength(), suffix(i), prefix.suffixLength());
+    }
+
+    inline void appendNormalized(const uint8_t* key, ValueType value) {
+        assert(!isFull());
+        memcpy(suffix(this->n_keys), key + prefix.prefixLength(), prefix.suffixLength());
+        values()[this->n_keys] = value;
+        this->n_keys++;
+    }
+
+    // re-encodes the keys for the new upper fence, which may lengthen the common prefix
+    inline void rebuild(const uint8_t* upper_fence) {
+        BTreeLeafNode copy;
+        memcpy(&copy, this, sizeof(BTreeLeafNode));
+        this->n_keys = 0;
+        prefix.set(copy.prefix.getLowerFence(), upper_fence);
+        uint8_t key[Prefix::key_length];
+        for (size_t i = 0; i < copy.n_keys; i++) {
+            copy.getNormalizedKey(i, key);
+            appendNormalized(key, copy.get(i));
+        }
+    }
+};
 
 template <typename KeyType, typename ValueType, size_t node_size = PAGE_SIZE>
 class BTree {
@@ -195,6 +711,7 @@ public:
         : tree(tree)
         , page(std::move(page))
         , last_pid(0)
+        , last_version(0)
         , i(i)
         , worker_id(worker_id) { }
 
@@ -202,12 +719,13 @@ public:
         : tree(tree)
         , page(vmcache, worker_id)
         , last_pid(0)
+        , last_version(0)
         , i(END_I)
         , worker_id(worker_id) { }
 
         value_type operator*() {
             ensurePageLoaded();
-            return std::make_pair(page->keys[i], page->get(i));
+            return std::make_pair(page->getKey(i), page->get(i));
         }
 
         Iterator& operator++() {
@@ -235,7 +753,7 @@ public:
                 ensurePageLoaded();
                 if (i == 0) {
                     // find previous leaf
-                    KeyType key = page->keys[0] - 1;
+                    KeyType key = page->getKey(0) - 1;
                     PageId prev_pid = page.pid;
                     for (size_t repeat_counter = 0; ; repeat_counter++) {
                         try {
@@ -259,6 +777,9 @@ public:
         void release() {
             if (!page.isReleased()) {
                 last_pid = page.pid;
+                last_version = PAGE_VERSION(page.vmcache.getPageState(page.pid).load());
+                if (i < page->n_keys)
+                    last_key = page->getKey(i);
                 page.release();
             }
         }
@@ -271,6 +792,33 @@ public:
             if (page.isReleased()) {
                 assert(last_pid != 0);
                 page = SharedGuard<LeafNode>(page.vmcache, last_pid, worker_id);
+                // the leaf has been modified since it was released, it may even have been merged into its left sibling and reused for another page
+                if (PAGE_VERSION(page.vmcache.getPageState(last_pid).load()) != last_version)
+                    seek(last_key);
+            }
+        }
+
+        // positions the iterator at the first key not less than 'key'
+        void seek(KeyType key) {
+            page.release();
+            for (size_t repeat_counter = 0; ; repeat_counter++) {
+                try {
+                    OptimisticGuard<InnerNode> parent_o(page.vmcache, tree->root_pid, worker_id);
+                    SharedGuard<LeafNode> leaf(page.vmcache, tree->traverse(key, parent_o), worker_id);
+                    parent_o.release();
+                    page = std::move(leaf);
+                    break;
+                } catch (const OLRestartException&) { }
+            }
+            i = page->lowerBound(key);
+            if (i >= page->n_keys) {
+                i = 0;
+                if (page->next != INVALID_PAGE_ID) {
+                    page = SharedGuard<LeafNode>(page.vmcache, page->next, worker_id);
+                } else {
+                    i = END_I;
+                    page.release();
+                }
             }
         }
 
@@ -279,14 +827,17 @@ public:
         const BTree* tree;
         SharedGuard<LeafNode> page;
         size_t last_pid;
+        uint64_t last_version; // version of the leaf when it was released
+        KeyType last_key; // key at position 'i' when the leaf was released
         size_t i;
         uint32_t worker_id;
     };
 
     struct InsertGuard : public ExclusiveGuard<LeafNode> {
         const KeyType key;
+        const size_t count; // number of consecutive keys starting at 'key' that were inserted
 
-        InsertGuard(ExclusiveGuard<LeafNode>&& guard, KeyType key) : ExclusiveGuard<LeafNode>(std::forward<ExclusiveGuard<LeafNode>>(guard)), key(key) { }
+        InsertGuard(ExclusiveGuard<LeafNode>&& guard, KeyType key, size_t count = 1) : ExclusiveGuard<LeafNode>(std::forward<ExclusiveGuard<LeafNode>>(guard)), key(key), count(count) { }
     };
 
     struct UpdateGuard : public ExclusiveGuard<LeafNode> {
@@ -304,13 +855,10 @@ public:
     BTree(VMCache& vmcache, const uint32_t worker_id) : vmcache(vmcache), worker_id(worker_id) {
         AllocGuard<InnerNode> root(vmcache, worker_id);
         root_pid = root.pid;
-        root->n_keys = 0;
-        root->level = 1;
+        root->init(1);
         AllocGuard<LeafNode> leaf(vmcache, worker_id);
-        root->children[0] = leaf.pid;
-        leaf->n_keys = 0;
-        leaf->next = INVALID_PAGE_ID;
-        leaf->level = 0;
+        root->setChild(0, leaf.pid);
+        leaf->init();
     }
 
     Iterator begin() const {
@@ -342,27 +890,26 @@ public:
             return std::make_pair<KeyType, KeyType>({}, {});
         } else {
             SharedGuard<LeafNode> last_leaf(vmcache, getLastLeaf(), worker_id);
-            return std::make_pair((*this->begin()).first, last_leaf->keys[last_leaf->n_keys - 1] + 1);
+            return std::make_pair((*this->begin()).first, last_leaf->getKey(last_leaf->n_keys - 1) + 1);
         }
     }
 
     PageId traverse(KeyType key, OptimisticGuard<InnerNode>& parent) const {
         // find the correct leaf node
         while (true) {
-            assert(parent->n_keys <= InnerNode::capacity);
-            size_t l = lowerBound<KeyType>(parent->keys, parent->n_keys, key);
-            if (l < parent->n_keys && parent->keys[l] == key)
-                l++;
+            assert(parent->n_keys <= parent->getCapacity());
+            size_t l = parent->findChild(key);
             assert(l <= parent->n_keys);
             if (parent->level == 1) {
-                return parent->children[l];
+                const PageId leaf_pid = parent->getChild(l);
+                // the leaf pid must not be used before it is known to be read from a node of this tree
+                parent.checkVersionAndRestart();
+                return leaf_pid;
             } else {
 #ifndef NDEBUG
                 auto prev_level = parent->level;
 #endif
-                PageId pid = parent->children[l];
-                parent.checkVersionAndRestart();
-                parent = OptimisticGuard<InnerNode>(vmcache, pid, worker_id);
+                parent = OptimisticGuard<InnerNode>(parent->getChild(l), parent);
                 assert(parent->level == prev_level - 1);
             }
         }
@@ -370,7 +917,7 @@ public:
 
     void trySplit(ExclusiveGuard<LeafNode>&& leaf, ExclusiveGuard<InnerNode>&& parent, KeyType key) {
         assert(parent->level == 1);
-        if (parent->n_keys >= InnerNode::capacity) {
+        if (parent->isFull()) {
             // have to split parent, restart from root
             PageId parent_pid = parent.pid;
             leaf.release();
@@ -378,8 +925,8 @@ public:
             ensureSpace(parent_pid, key);
         } else {
             // split leaf node
-            ExclusiveGuard<LeafNode> new_leaf(vmcache, vmcache.allocatePage(), worker_id);
-            new_leaf->level = 0;
+            ExclusiveGuard<LeafNode> new_leaf(vmcache, vmcache.allocatePage(worker_id), worker_id);
+            new_leaf->init();
             new_leaf->next = leaf->next;
             leaf->next = new_leaf.pid;
             auto separator = leaf->split(new_leaf);
@@ -389,16 +936,15 @@ public:
 
     void trySplit(ExclusiveGuard<InnerNode>&& inner, ExclusiveGuard<InnerNode>&& parent, KeyType key) {
         if (inner.pid == root_pid) {
-            ExclusiveGuard<InnerNode> new_inner(vmcache, vmcache.allocatePage(), worker_id);
+            ExclusiveGuard<InnerNode> new_inner(vmcache, vmcache.allocatePage(worker_id), worker_id);
             memcpy(new_inner.data, inner.data, PAGE_SIZE);
-            inner->children[0] = new_inner.pid;
-            inner->n_keys = 0;
-            inner->level = new_inner->level + 1;
+            inner->init(new_inner->level + 1);
+            inner->setChild(0, new_inner.pid);
             parent = std::move(inner); // new root page with 'new_inner' as the only child
             inner = std::move(new_inner);
         }
 
-        if (parent->n_keys >= InnerNode::capacity) {
+        if (parent->isFull()) {
             // have to split parent, restart from root
             PageId parent_pid = parent.pid;
             inner.release();
@@ -406,15 +952,8 @@ public:
             ensureSpace(parent_pid, key);
         } else {
             // split inner node
-            inner->n_keys = (InnerNode::capacity + 1) / 2;
-            // inner = left node; new_inner = right node
-            ExclusiveGuard<InnerNode> new_inner(vmcache, vmcache.allocatePage(), worker_id);
-            new_inner->n_keys = InnerNode::capacity / 2 - 1;
-            new_inner->level = inner->level;
-            assert(inner->n_keys + new_inner->n_keys == InnerNode::capacity - 1);
-            memcpy(new_inner->keys, inner->keys + inner->n_keys + 1, new_inner->n_keys * sizeof(KeyType));
-            memcpy(new_inner->children, inner->children + inner->n_keys + 1, (new_inner->n_keys + 1) * sizeof(PageId));
-            const KeyType split_key = inner->keys[inner->n_keys];
+            ExclusiveGuard<InnerNode> new_inner(vmcache, vmcache.allocatePage(worker_id), worker_id);
+            const KeyType split_key = inner->split(new_inner.data);
             insertIntoInner(parent, split_key, new_inner.pid);
         }
     }
@@ -425,17 +964,13 @@ public:
                 PageId parent_pid = ExclusiveGuard<InnerNode>::MOVED;
                 OptimisticGuard<InnerNode> current(vmcache, root_pid, worker_id);
                 while (current.pid != pid && current->level != 1) {
-                    size_t l = lowerBound<KeyType>(current->keys, current->n_keys, key);
-                    if (l < current->n_keys && current->keys[l] == key)
-                        l++;
+                    size_t l = current->findChild(key);
                     assert(l <= current->n_keys);
                     parent_pid = current.pid;
-                    PageId new_current_pid = current->children[l];
-                    current.checkVersionAndRestart();
-                    current = OptimisticGuard<InnerNode>(vmcache, new_current_pid, worker_id);
+                    current = OptimisticGuard<InnerNode>(current->getChild(l), current);
                 }
                 if (current.pid == pid) {
-                    if (current->n_keys < InnerNode::capacity)
+                    if (!current->isFull())
                         return; // split already happened concurrently
                     ExclusiveGuard<InnerNode> parent = parent_pid == ExclusiveGuard<InnerNode>::MOVED ? ExclusiveGuard<InnerNode>(vmcache) : ExclusiveGuard<InnerNode>(vmcache, parent_pid, worker_id);
                     ExclusiveGuard<InnerNode> node(std::move(current));
@@ -450,8 +985,8 @@ public:
         for (size_t repeat_counter = 0; ; repeat_counter++) {
             try {
                 OptimisticGuard<InnerNode> parent_o(vmcache, root_pid, worker_id);
-                OptimisticGuard<LeafNode> leaf_o(vmcache, traverse(key, parent_o), worker_id);
-                if (leaf_o->n_keys < LeafNode::capacity) {
+                OptimisticGuard<LeafNode> leaf_o(traverse(key, parent_o), parent_o);
+                if (!leaf_o->isFull()) {
                     ExclusiveGuard<LeafNode> leaf(std::move(leaf_o));
                     parent_o.release();
                     insertIntoLeaf(leaf, key, value);
@@ -465,14 +1000,79 @@ public:
         }
     }
 
+    // builds the (empty) tree bottom-up from runs of key/value pairs that are each sorted by key, e.g., as produced in parallel by morsel workers
+    // a run is any random access container of std::pair<KeyType, ValueType> with 'size()' and 'empty()', e.g., a std::vector or an 'IndexBuildJob::Run' in temporary pages
+    // all leaves but the last are filled completely and inner nodes are packed as densely as possible (nodes that truncate key prefixes are filled up to their untruncated capacity); the tree must not be accessed concurrently while it is being loaded
+    template <typename RunType>
+    void bulkLoad(const std::vector<RunType>& runs) {
+        ExclusiveGuard<InnerNode> root(vmcache, root_pid, worker_id);
+        if (root->level != 1 || root->n_keys != 0)
+            throw std::runtime_error("Bulk loading requires an empty B+-Tree!");
+        ExclusiveGuard<LeafNode> leaf(vmcache, root->getChild(0), worker_id);
+        if (leaf->n_keys != 0)
+            throw std::runtime_error("Bulk loading requires an empty B+-Tree!");
+
+        // merge the runs into the leaf level, keeping track of the first key and pid of each node on the level built last
+        std::vector<std::pair<KeyType, PageId>> nodes;
+        nodes.emplace_back(KeyType {}, leaf.pid);
+        typedef std::pair<size_t, size_t> RunPosition;
+        auto greater = [&runs](const RunPosition& a, const RunPosition& b) { return runs[b.first][b.second].first < runs[a.first][a.second].first; };
+        std::priority_queue<RunPosition, std::vector<RunPosition>, decltype(greater)> heads(greater);
+        for (size_t r = 0; r < runs.size(); r++) {
+            if (!runs[r].empty())
+                heads.emplace(r, 0);
+        }
+        while (!heads.empty()) {
+            const auto [r, i] = heads.top();
+            heads.pop();
+            const auto& entry = runs[r][i];
+            assert(i == 0 || runs[r][i - 1].first < entry.first);
+            if (i + 1 < runs[r].size())
+                heads.emplace(r, i + 1);
+            if (leaf->n_keys > 0 && leaf->getKey(leaf->n_keys - 1) == entry.first)
+                throw std::runtime_error("Key already exists!");
+            if (leaf->isFull()) {
+                ExclusiveGuard<LeafNode> new_leaf(vmcache, vmcache.allocatePage(worker_id), worker_id);
+                new_leaf->init(&entry.first);
+                leaf->setUpperFence(entry.first);
+                leaf->next = new_leaf.pid;
+                nodes.emplace_back(entry.first, new_leaf.pid);
+                leaf = std::move(new_leaf);
+            }
+            leaf->append(entry.first, entry.second);
+        }
+        leaf.release();
+
+        // build the inner levels until the remaining nodes fit into the root, the children are spread evenly across the fewest possible nodes per level
+        size_t level = 1;
+        while (nodes.size() > InnerNode::capacity + 1) {
+            const size_t num_inner = (nodes.size() + InnerNode::capacity) / (InnerNode::capacity + 1);
+            std::vector<std::pair<KeyType, PageId>> parents;
+            parents.reserve(num_inner);
+            size_t c = 0;
+            for (size_t j = 0; j < num_inner; j++) {
+                const size_t num_children = (nodes.size() - c) / (num_inner - j);
+                ExclusiveGuard<InnerNode> inner(vmcache, vmcache.allocatePage(worker_id), worker_id);
+                fillInner(inner, level, nodes, c, num_children);
+                parents.emplace_back(nodes[c].first, inner.pid);
+                c += num_children;
+            }
+            assert(c == nodes.size());
+            nodes = std::move(parents);
+            level++;
+        }
+        // the root keeps its pid as it is referenced from the table's basepage
+        fillInner(root, level, nodes, 0, nodes.size());
+    }
+
     std::optional<UpdateGuard> latchForUpdate(KeyType key) {
         for (size_t repeat_counter = 0; ; repeat_counter++) {
             try {
                 OptimisticGuard<InnerNode> parent_o(vmcache, root_pid, worker_id);
                 ExclusiveGuard<LeafNode> leaf(vmcache, traverse(key, parent_o), worker_id);
                 parent_o.release();
-                size_t l = lowerBound<KeyType>(leaf->keys, leaf->n_keys, key);
-                if (l < leaf->n_keys && leaf->keys[l] == key)
+                size_t l = leaf->lowerBound(key);
+                if (l < leaf->n_keys && leaf->getKey(l) == key)
                     return std::optional<UpdateGuard>(std::in_place, std::move(leaf), leaf->get(l), l);
                 else
                     return std::nullopt;
@@ -483,21 +1083,32 @@ public:
     // performs an insert at the next possible key value
     // returns the inserted key and an exclusive guard for the leaf page that the key was inserted into (this is to be used for insert operation synchronization)
     InsertGuard insertNext(ValueType value) {
+        return insertNext(value, 1);
+    }
+
+    // inserts up to 'max_count' consecutive keys with the same value at the next possible key values, all into the rightmost leaf page so that only a single latch has to be acquired (e.g., to append a whole chunk of imported rows)
+    // the returned guard holds at least one key ('count'), callers loop until all their keys are inserted
+    InsertGuard insertNext(ValueType value, size_t max_count) {
+        assert(max_count > 0);
         for (size_t repeat_counter = 0; ; repeat_counter++) {
             try {
                 KeyType key = std::numeric_limits<KeyType>::max();
                 OptimisticGuard<InnerNode> parent_o(vmcache, root_pid, worker_id);
-                OptimisticGuard<LeafNode> leaf_o(vmcache, traverse(key, parent_o), worker_id);
+                OptimisticGuard<LeafNode> leaf_o(traverse(key, parent_o), parent_o);
                 if (leaf_o->n_keys == 0) {
                     key = {};
                 } else {
-                    key = leaf_o->keys[leaf_o->n_keys - 1] + 1;
+                    key = leaf_o->getKey(leaf_o->n_keys - 1) + 1;
                 }
-                if (leaf_o->n_keys < LeafNode::capacity) {
+                if (!leaf_o->isFull()) {
                     ExclusiveGuard<LeafNode> leaf(std::move(leaf_o));
                     parent_o.release();
                     insertIntoLeaf(leaf, key, value);
-                    return InsertGuard(std::move(leaf), key); // done
+                    // the remaining keys are larger than all keys in the leaf
+                    const size_t count = std::min(max_count, leaf->getCapacity() - leaf->n_keys + 1);
+                    for (size_t i = 1; i < count; i++)
+                        leaf->append(key + i, value);
+                    return InsertGuard(std::move(leaf), key, count); // done
                 }
                 ExclusiveGuard<InnerNode> parent(std::move(parent_o));
                 ExclusiveGuard<LeafNode> leaf(std::move(leaf_o));
@@ -514,32 +1125,33 @@ public:
                 size_t leaf_pos;
                 PageId leaf_pid;
                 while (true) {
-                    size_t l = lowerBound<KeyType>(parent->keys, parent->n_keys, key);
-                    if (l < parent->n_keys && parent->keys[l] == key)
-                        l++;
+                    size_t l = parent->findChild(key);
                     assert(l <= parent->n_keys);
                     if (parent->level == 1) {
                         leaf_pos = l;
-                        leaf_pid = parent->children[l];
+                        leaf_pid = parent->getChild(l);
                         break;
                     } else {
-                        parent = OptimisticGuard<InnerNode>(vmcache, parent->children[l], worker_id);
+                        parent = OptimisticGuard<InnerNode>(parent->getChild(l), parent);
                     }
                 }
 
-                OptimisticGuard<LeafNode> leaf(vmcache, leaf_pid, worker_id);
+                OptimisticGuard<LeafNode> leaf(leaf_pid, parent);
                 // search the key within the leaf node
-                size_t l = lowerBound<KeyType>(leaf->keys, leaf->n_keys, key);
-                if (l >= leaf->n_keys || leaf->keys[l] != key)
+                size_t l = leaf->lowerBound(key);
+                if (l >= leaf->n_keys || leaf->getKey(l) != key)
                     return false;
-                if (leaf->n_keys - 1 <= LeafNode::capacity / 4 && parent->n_keys >= 1 && (leaf_pos + 1) <= parent->n_keys) {
+                if (leaf->n_keys - 1 <= leaf->getCapacity() / 4 && parent->n_keys >= 1 && (leaf_pos + 1) <= parent->n_keys) {
                     // underfull, attempt merge with next node
                     ExclusiveGuard<InnerNode> parent_x(std::move(parent));
                     ExclusiveGuard<LeafNode> leaf_x(std::move(leaf));
-                    ExclusiveGuard<LeafNode> right_x(vmcache, parent_x->children[leaf_pos + 1], worker_id);
+                    ExclusiveGuard<LeafNode> right_x(vmcache, parent_x->getChild(leaf_pos + 1), worker_id);
                     leaf_x->remove(l);
                     if (leaf_x->merge(leaf_pos, parent_x.data, right_x.data)) {
-                        // TODO: actually free up the page taken up by the right node
+                        // the right node is no longer reachable, return its page to the cache
+                        // note: descents couple their latches, i.e., validate the parent again after the child's version has been read, so a reader that still holds the right node's pid fails validation of either 'parent_x' or the right node itself, whose version is bumped on release
+                        //  released iterators compare the version when latching the node again and search their key from the root instead
+                        right_x.free(worker_id);
                     }
                 } else {
                     ExclusiveGuard<LeafNode> leaf_x(std::move(leaf));
@@ -557,10 +1169,15 @@ public:
                 OptimisticGuard<InnerNode> parent_o(vmcache, root_pid, worker_id);
                 SharedGuard<LeafNode> leaf(vmcache, traverse(key, parent_o), worker_id);
                 parent_o.release();
-                if ((leaf->n_keys == 0 || key > leaf->keys[leaf->n_keys - 1]) && leaf->next == INVALID_PAGE_ID)
+                if ((leaf->n_keys == 0 || key > leaf->getKey(leaf->n_keys - 1)) && leaf->next == INVALID_PAGE_ID)
                     return end();
                 // search the key within the leaf node
-                size_t l = lowerBound<KeyType>(leaf->keys, leaf->n_keys, key);
+                size_t l = leaf->lowerBound(key);
+                if (l >= leaf->n_keys) {
+                    // all keys of the leaf are smaller, continue with the first key of the next leaf
+                    leaf = SharedGuard<LeafNode>(vmcache, leaf->next, worker_id);
+                    l = 0;
+                }
                 return Iterator(this, std::move(leaf), l, worker_id);
             } catch (const OLRestartException&) { }
         }
@@ -579,13 +1196,13 @@ public:
         for (size_t repeat_counter = 0; ; repeat_counter++) {
             try {
                 OptimisticGuard<InnerNode> parent_o(vmcache, root_pid, worker_id);
-                OptimisticGuard<LeafNode> leaf(vmcache, traverse(key, parent_o), worker_id);
+                OptimisticGuard<LeafNode> leaf(traverse(key, parent_o), parent_o);
                 parent_o.release();
-                if ((leaf->n_keys == 0 || key > leaf->keys[leaf->n_keys - 1]) && leaf->next == INVALID_PAGE_ID)
+                if ((leaf->n_keys == 0 || key > leaf->getKey(leaf->n_keys - 1)) && leaf->next == INVALID_PAGE_ID)
                     return std::nullopt;
                 // search the key within the leaf node
-                size_t l = lowerBound<KeyType>(leaf->keys, leaf->n_keys, key);
-                if (leaf->keys[l] != key)
+                size_t l = leaf->lowerBound(key);
+                if (l >= leaf->n_keys || leaf->getKey(l) != key)
                     return std::nullopt;
                 return leaf->get(l);
             } catch (const OLRestartException&) { }
@@ -598,10 +1215,10 @@ public:
 
 private:
     void insertIntoLeaf(ExclusiveGuard<LeafNode>& leaf, KeyType key, ValueType value) {
-        assert(leaf->n_keys < LeafNode::capacity);
+        assert(!leaf->isFull());
         // search the key within the leaf node
-        size_t l = lowerBound<KeyType>(leaf->keys, leaf->n_keys, key);
-        if (l < leaf->n_keys && leaf->keys[l] == key) {
+        size_t l = leaf->lowerBound(key);
+        if (l < leaf->n_keys && leaf->getKey(l) == key) {
             throw std::runtime_error("Key already exists!");
         } else {
             // actual insert
@@ -610,18 +1227,19 @@ private:
     }
 
     void insertIntoInner(ExclusiveGuard<InnerNode>& inner, KeyType key, PageId child) {
-        assert(inner->n_keys < InnerNode::capacity);
-        size_t l = lowerBound(inner->keys, inner->n_keys, key);
-        // insert 'key' into inner node
-        for (size_t i = inner->n_keys; i > l; i--) {
-            inner->keys[i] = inner->keys[i - 1];
-        }
-        for (size_t i = inner->n_keys + 1; i > l + 1; i--) {
-            inner->children[i] = inner->children[i - 1];
-        }
-        inner->keys[l] = key;
-        inner->children[l + 1] = child;
-        inner->n_keys++;
+        assert(!inner->isFull());
+        inner->insert(key, child);
+    }
+
+    void fillInner(ExclusiveGuard<InnerNode>& inner, size_t level, const std::vector<std::pair<KeyType, PageId>>& nodes, size_t first, size_t count) {
+        assert(count >= 1 && count <= InnerNode::capacity + 1);
+        // the first key of the level is not a separator, the node of the last one has no upper fence
+        const KeyType* lower_fence = first > 0 ? &nodes[first].first : nullptr;
+        const KeyType* upper_fence = first + count < nodes.size() ? &nodes[first + count].first : nullptr;
+        inner->init(level, lower_fence, upper_fence);
+        inner->setChild(0, nodes[first].second);
+        for (size_t k = 1; k < count; k++)
+            inner->append(nodes[first + k].first, nodes[first + k].second);
     }
 
     PageId getFirstLeaf() const {
@@ -630,9 +1248,9 @@ private:
                 OptimisticGuard<InnerNode> current(vmcache, root_pid, worker_id);
                 while (true) {
                     if (current->level == 1) {
-                        return current->children[0];
+                        return current->getChild(0);
                     } else {
-                        current = OptimisticGuard<InnerNode>(vmcache, current->children[0], worker_id);
+                        current = OptimisticGuard<InnerNode>(current->getChild(0), current);
                     }
                 }
             } catch (const OLRestartException&) { }
@@ -645,9 +1263,9 @@ private:
                 OptimisticGuard<InnerNode> current(vmcache, root_pid, worker_id);
                 while (true) {
                     if (current->level == 1) {
-                        return current->children[current->n_keys];
+                        return current->getChild(current->n_keys);
                     } else {
-                        current = OptimisticGuard<InnerNode>(vmcache, current->children[current->n_keys], worker_id);
+                        current = OptimisticGuard<InnerNode>(current->getChild(current->n_keys), current);
                     }
                 }
             } catch (const OLRestartException&) { }
@@ -1,12 +1,24 @@
 #pragma once
 
+#include <stdexcept>
+
 #include "../../core/units.hpp"
+#include "../page.hpp"
 
 struct ColumnBasepage {
     PageId next; // can point to another ColumnBasepage if a single page is too small to hold all data_pages
+    uint64_t data_page_size; // number of pages per data page, EXTENT_NUM_PAGES if the column's data is stored in extents (see 'DB::setColumnExtents()'); only set in the column's first basepage
     PageId data_pages[];
 };
 
+// declared with the size of a single page, the data of extents continues in the pages that follow it (see 'ColumnBasepage::data_page_size')
 struct ColumnDataPage {
     char data[PAGE_SIZE];
+
+    // returns 'count' values of 'value_len' bytes starting at the 'first'-th value of a data page that spans 'num_pages' pages (see 'VMCache::getPageCount()')
+    inline char* getValues(size_t num_pages, size_t first, size_t count, size_t value_len) {
+        if ((first + count) * value_len > num_pages * PAGE_SIZE)
+            throw std::runtime_error("Values exceed the column data page");
+        return reinterpret_cast<char*>(this) + first * value_len;
+    }
 };
\ No newline at end of file
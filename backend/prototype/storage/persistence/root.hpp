@@ -3,9 +3,10 @@
 #include <stdint.h>
 
 #include "../../core/units.hpp"
+#include "../vmcache.hpp"
 
 #define ROOTPAGE_MAGIC 0xfedcba9876543210ull
-#define PERSISTENCE_VERSION 4ull
+#define PERSISTENCE_VERSION 8ull
 
 struct RootPage {
     uint64_t magic;
@@ -13,4 +14,6 @@ struct RootPage {
     PageId schema_catalog_basepage;
     PageId table_catalog_basepage;
     PageId column_catalog_basepage;
+    // head of the list of free pages, kept up to date by the cache (see 'VMCache::openFreePageList()')
+    FreePageListAnchor free_pages;
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+/*
+Kernels that count the keys of a sorted node that are less than a search key, selected at compile time per key type.
+'lowerBound()' narrows its binary search down to 'window' keys and counts the remaining ones with the kernel, which
+replaces the hard to predict branches of the last binary search steps with a few vector comparisons.
+AVX2 only provides signed integer comparisons, so the kernels flip the sign bits to compare unsigned keys.
+There is no kernel for 'CompositeKey's: B+-Tree nodes store them prefix-truncated as byte strings whose length depends
+on the node (see 'BTreeKeyPrefix'), suffixes of up to eight bytes are searched with the uint64_t kernel instead.
+*/
+template <typename KeyType>
+struct SIMDKeySearch {
+    static constexpr bool supported = false;
+};
+
+#ifdef __AVX2__
+template <>
+struct SIMDKeySearch<uint32_t> {
+    static constexpr bool supported = true;
+    static constexpr size_t window = 32;
+
+    static inline size_t countLess(const uint32_t array[], size_t size, uint32_t key) {
+        const __m256i sign = _mm256_set1_epi32(INT_MIN);
+        const __m256i k = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(key)), sign);
+        size_t count = 0;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(array + i)), sign);
+            count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v))));
+        }
+        for (; i < size; i++)
+            count += array[i] < key;
+        return count;
+    }
+};
+
+template <>
+struct SIMDKeySearch<uint64_t> {
+    static constexpr bool supported = true;
+    static constexpr size_t window = 16;
+
+    static inline size_t countLess(const uint64_t array[], size_t size, uint64_t key) {
+        const __m256i sign = _mm256_set1_epi64x(LLONG_MIN);
+        const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(key)), sign);
+        size_t count = 0;
+        size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(array + i)), sign);
+            count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v))));
+        }
+        for (; i < size; i++)
+            count += array[i] < key;
+        return count;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "../../storage/guard.hpp"
+#include "../../storage/page.hpp"
+#include "../../storage/vmcache.hpp"
+#include "table.hpp"
+
+struct VisibilityBitmapPage {
+    static constexpr size_t num_words = PAGE_SIZE / sizeof(uint64_t) - 1;
+    static constexpr size_t capacity = num_words * 64;
+
+    uint64_t num_rows; // number of rows allocated in this page, only the last page of a bitmap is not full
+    uint64_t words[num_words]; // bit 'i % 64' of word 'i / 64' is set iff row 'i' (relative to the page's first row) is visible
+
+    inline bool get(size_t i) const { return (words[i / 64] >> (i % 64)) & 0x1; }
+
+    inline void update(size_t i, bool value) {
+        if (value)
+            words[i / 64] |= 1ull << (i % 64);
+        else
+            words[i / 64] &= ~(1ull << (i % 64));
+    }
+};
+static_assert(sizeof(VisibilityBitmapPage) == PAGE_SIZE);
+
+struct VisibilityDirectoryPage {
+    static constexpr size_t capacity = PAGE_SIZE / sizeof(PageId);
+
+    PageId pages[capacity];
+};
+static_assert(sizeof(VisibilityDirectoryPage) == PAGE_SIZE);
+
+struct VisibilityRootPage {
+    static constexpr size_t capacity = PAGE_SIZE / sizeof(PageId) - 1;
+
+    uint64_t num_pages; // number of bitmap pages, at least one
+    PageId directory_pages[capacity];
+};
+static_assert(sizeof(VisibilityRootPage) == PAGE_SIZE);
+
+/*
+Visibility information of a relation: one bit per row, rows are numbered densely in insertion order. The bits are
+stored in bitmap pages of VisibilityBitmapPage::capacity rows each, which are found through a two-level directory (the
+root page points to directory pages, which point to the bitmap pages), so the bitmap page of a row is located with two
+optimistic page accesses and without any key comparisons.
+Inserts keep the row's bitmap page latched exclusively until the row's column values have been appended. Readers copy
+a bitmap page's bits under a shared latch, so they never observe rows whose insert has not completed.
+Bulk inserts append to the last bitmap page. Workers that insert concurrently instead reserve blocks of consecutive rows
+(see 'reserveBlock()') and fill them on their own (see 'DB::reserveRowId()'), so they mostly append to column data pages
+of their own. Reserved rows that are never inserted stay invisible.
+*/
+class VisibilityBitmap {
+public:
+    typedef VisibilityBitmapPage Page;
+
+    struct InsertGuard : public ExclusiveGuard<Page> {
+        const RowId rid;
+        const size_t count; // number of consecutive rows starting at 'rid' that were inserted
+
+        InsertGuard(ExclusiveGuard<Page>&& guard, RowId rid, size_t count) : ExclusiveGuard<Page>(std::forward<ExclusiveGuard<Page>>(guard)), rid(rid), count(count) { }
+
+        // makes the rows visible that were inserted invisible, e.g., once their index entries have been inserted
+        void setVisible() {
+            for (size_t i = 0; i < count; i++)
+                this->data->update((rid + i) % Page::capacity, true);
+        }
+    };
+
+    struct UpdateGuard : public ExclusiveGuard<Page> {
+        const bool prev_value;
+        size_t index;
+
+        UpdateGuard(ExclusiveGuard<Page>&& guard, bool prev_value, size_t index) : ExclusiveGuard<Page>(std::forward<ExclusiveGuard<Page>>(guard)), prev_value(prev_value), index(index) { }
+
+        void update(bool new_value) {
+            this->data->update(index, new_value);
+        }
+    };
+
+    VisibilityBitmap(VMCache& vmcache, PageId root_pid, const uint32_t worker_id) : vmcache(vmcache), root_pid(root_pid), worker_id(worker_id) { }
+    VisibilityBitmap(VMCache& vmcache, const uint32_t worker_id) : vmcache(vmcache), worker_id(worker_id) {
+        AllocGuard<VisibilityRootPage> root(vmcache, worker_id);
+        root_pid = root.pid;
+        AllocGuard<VisibilityDirectoryPage> directory(vmcache, worker_id);
+        AllocGuard<Page> page(vmcache, worker_id);
+        root->num_pages = 1;
+        root->directory_pages[0] = directory.pid;
+        directory->pages[0] = page.pid;
+    }
+
+    PageId getRootPid() const {
+        return root_pid;
+    }
+
+    // returns the number of rows inserted so far (visible or not), i.e., the row id of the next inserted row
+    RowId getNumRows() const {
+        for (size_t repeat_counter = 0; ; repeat_counter++) {
+            try {
+                size_t num_pages;
+                const PageId pid = getLastPage(num_pages);
+                SharedGuard<Page> page(vmcache, pid, worker_id);
+                return (num_pages - 1) * Page::capacity + page->num_rows;
+            } catch (const OLRestartException&) { }
+        }
+    }
+
+    size_t countVisible() const {
+        size_t result = 0;
+        for (size_t page_i = 0; ; page_i++) {
+            const PageId pid = getPage(page_i);
+            if (pid == INVALID_PAGE_ID)
+                return result;
+            SharedGuard<Page> page(vmcache, pid, worker_id);
+            for (size_t w = 0; w < (page->num_rows + 63) / 64; w++)
+                result += __builtin_popcountll(page->words[w]);
+        }
+    }
+
+    bool isVisible(RowId rid) const {
+        const PageId pid = getPage(rid / Page::capacity);
+        if (pid == INVALID_PAGE_ID)
+            return false;
+        SharedGuard<Page> page(vmcache, pid, worker_id);
+        const size_t i = rid % Page::capacity;
+        return i < page->num_rows && page->get(i);
+    }
+
+    // calls 'f(rid)' for the visible rows in [from, to) in ascending order until it returns false
+    // the visibility bits of a bitmap page are copied while the page is latched shared, 'f' is called after releasing the latch
+    // 'f' may keep column pages latched across rows, but must release them in 'page_end()', which is called after the rows of each bitmap page before the next one is latched (inserts latch column and index pages while holding their bitmap page)
+    template <typename F, typename E>
+    void forEachVisible(RowId from, RowId to, F&& f, E&& page_end) const {
+        uint64_t words[Page::num_words];
+        while (from < to) {
+            const size_t page_i = from / Page::capacity;
+            const PageId pid = getPage(page_i);
+            if (pid == INVALID_PAGE_ID)
+                return;
+            const RowId page_begin = page_i * Page::capacity;
+            const size_t begin = from - page_begin;
+            size_t end = std::min<RowId>(to - page_begin, Page::capacity);
+            from = page_begin + end;
+            {
+                SharedGuard<Page> page(vmcache, pid, worker_id);
+                // rows beyond the page's last one have not been inserted (yet)
+                end = std::min<size_t>(end, page->num_rows);
+                if (begin >= end)
+                    continue;
+                // note: the bits of rows that have not been inserted yet are never set
+                std::copy(page->words + begin / 64, page->words + (end + 63) / 64, words + begin / 64);
+            }
+            words[begin / 64] &= ~0ull << (begin % 64);
+            if (end % 64 != 0)
+                words[end / 64] &= (1ull << (end % 64)) - 1;
+            for (size_t w = begin / 64; w < (end + 63) / 64; w++) {
+                for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                    if (!f(page_begin + w * 64 + __builtin_ctzll(word))) {
+                        page_end();
+                        return;
+                    }
+                }
+            }
+            page_end();
+        }
+    }
+
+    template <typename F>
+    void forEachVisible(RowId from, RowId to, F&& f) const {
+        forEachVisible(from, to, std::forward<F>(f), [] { });
+    }
+
+    // checks whether row 'rid' exists and latches its bitmap page exclusively, so that the row can be updated (or deleted by updating its visibility to false)
+    std::optional<UpdateGuard> latchForUpdate(RowId rid) {
+        const PageId pid = getPage(rid / Page::capacity);
+        if (pid == INVALID_PAGE_ID)
+            return std::nullopt;
+        ExclusiveGuard<Page> page(vmcache, pid, worker_id);
+        const size_t i = rid % Page::capacity;
+        if (i >= page->num_rows)
+            return std::nullopt;
+        return std::optional<UpdateGuard>(std::in_place, std::move(page), page->get(i), i);
+    }
+
+    // inserts up to 'max_count' consecutive rows (at least one, see 'count' of the returned guard) with the given visibility at the next row ids, all into the last bitmap page
+    // returns the first inserted row id and an exclusive guard for the bitmap page, which is to be held until the rows' column values have been appended
+    InsertGuard insertNext(bool value, size_t max_count = 1) {
+        assert(max_count > 0);
+        for (size_t repeat_counter = 0; ; repeat_counter++) {
+            try {
+                size_t num_pages;
+                const PageId pid = getLastPage(num_pages);
+                ExclusiveGuard<Page> page(vmcache, pid, worker_id);
+                if (page->num_rows < Page::capacity) {
+                    const size_t first = page->num_rows;
+                    const size_t count = std::min(max_count, Page::capacity - first);
+                    if (value) {
+                        for (size_t i = first; i < first + count; i++)
+                            page->update(i, true);
+                    }
+                    page->num_rows += count;
+                    return InsertGuard(std::move(page), (num_pages - 1) * Page::capacity + first, count);
+                }
+                page.release();
+                appendPage(num_pages);
+                // restart after appending a page
+            } catch (const OLRestartException&) { }
+        }
+    }
+
+    // number of rows reserved at once, a whole number of bitmap words, so that workers filling neighbouring blocks do not update the same words
+    static constexpr size_t reserved_block_size = Page::num_words / 8 * 64;
+
+    // reserves a block of up to 'reserved_block_size' consecutive rows in the last bitmap page for the calling worker and returns their row id range [first, end), the rows are invisible until they are inserted with 'insertReserved()'
+    // note: reserved rows that are not inserted before shutdown remain invisible gaps, blocks are kept small to bound them
+    std::pair<RowId, RowId> reserveBlock() {
+        const InsertGuard guard = insertNext(false, reserved_block_size);
+        return { guard.rid, guard.rid + guard.count };
+    }
+
+    // inserts the reserved row 'rid' (see 'reserveBlock()') with the given visibility
+    // returns an exclusive guard for the bitmap page, which is to be held until the row's column values have been appended and its index entries have been inserted
+    InsertGuard insertReserved(RowId rid, bool value) {
+        const PageId pid = getPage(rid / Page::capacity);
+        assert(pid != INVALID_PAGE_ID);
+        ExclusiveGuard<Page> page(vmcache, pid, worker_id);
+        assert(rid % Page::capacity < page->num_rows && !page->get(rid % Page::capacity));
+        if (value)
+            page->update(rid % Page::capacity, true);
+        return InsertGuard(std::move(page), rid, 1);
+    }
+
+private:
+    // returns the pid of the 'page_i'-th bitmap page, INVALID_PAGE_ID if it does not exist (yet)
+    PageId getPage(size_t page_i) const {
+        for (size_t repeat_counter = 0; ; repeat_counter++) {
+            try {
+                OptimisticGuard<VisibilityRootPage> root(vmcache, root_pid, worker_id);
+                if (page_i >= root->num_pages) {
+                    root.checkVersionAndRestart();
+                    return INVALID_PAGE_ID;
+                }
+                OptimisticGuard<VisibilityDirectoryPage> directory(root->directory_pages[page_i / VisibilityDirectoryPage::capacity], root);
+                const PageId pid = directory->pages[page_i % VisibilityDirectoryPage::capacity];
+                directory.checkVersionAndRestart();
+                return pid;
+            } catch (const OLRestartException&) { }
+        }
+    }
+
+    PageId getLastPage(size_t& num_pages) const {
+        OptimisticGuard<VisibilityRootPage> root(vmcache, root_pid, worker_id);
+        num_pages = root->num_pages;
+        OptimisticGuard<VisibilityDirectoryPage> directory(root->directory_pages[(num_pages - 1) / VisibilityDirectoryPage::capacity], root);
+        const PageId pid = directory->pages[(num_pages - 1) % VisibilityDirectoryPage::capacity];
+        directory.checkVersionAndRestart();
+        return pid;
+    }
+
+    // appends a bitmap page unless another one has been appended concurrently since the bitmap consisted of 'num_pages' pages
+    void appendPage(size_t num_pages) {
+        AllocGuard<Page> page(vmcache, worker_id);
+        if (linkPage(page.pid, num_pages) == 0)
+            page.free(worker_id);
+    }
+
+    // makes the allocated bitmap page 'pid' the last one and returns its index, or 0 if 'expected_num_pages' is given and the bitmap consists of a different number of pages
+    // pages (including a new directory page) are allocated before the root is latched, the root is only latched exclusively to link them
+    size_t linkPage(PageId pid, size_t expected_num_pages = 0) {
+        std::optional<AllocGuard<VisibilityDirectoryPage>> directory;
+        for (size_t repeat_counter = 0; ; repeat_counter++) {
+            ExclusiveGuard<VisibilityRootPage> root(vmcache, root_pid, worker_id);
+            const size_t num_pages = root->num_pages;
+            const size_t directory_i = num_pages / VisibilityDirectoryPage::capacity;
+            const bool needs_directory = num_pages % VisibilityDirectoryPage::capacity == 0;
+            if ((expected_num_pages != 0 && num_pages != expected_num_pages) || (needs_directory && directory_i >= VisibilityRootPage::capacity)) {
+                if (directory)
+                    directory->free(worker_id);
+                if (expected_num_pages != 0 && num_pages != expected_num_pages)
+                    return 0;
+                throw std::runtime_error("Visibility bitmap exceeds the maximum number of rows");
+            }
+            if (needs_directory) {
+                if (!directory) {
+                    root.release();
+                    directory.emplace(vmcache, worker_id);
+                    continue; // pages may have been appended while the root was not latched
+                }
+                (*directory)->pages[0] = pid;
+                root->directory_pages[directory_i] = directory->pid;
+                directory.reset();
+            } else {
+                ExclusiveGuard<VisibilityDirectoryPage>(vmcache, root->directory_pages[directory_i], worker_id)->pages[num_pages % VisibilityDirectoryPage::capacity] = pid;
+                if (directory)
+                    directory->free(worker_id); // another worker has appended the directory page meanwhile
+            }
+            root->num_pages++;
+            return num_pages;
+        }
+    }
+
+    VMCache& vmcache;
+    PageId root_pid;
+    const uint32_t worker_id;
+};
\ No newline at end of file
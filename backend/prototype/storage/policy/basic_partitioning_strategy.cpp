@@ -17,7 +17,7 @@ void BasicPartitioningStrategy<PartitionType>::setVMCache(VMCache* vmcache, cons
 }
 
 template <class PartitionType>
-void BasicPartitioningStrategy<PartitionType>::prepareTempAllocation(size_t num_pages, uint32_t worker_id) {
+void BasicPartitioningStrategy<PartitionType>::prepareTempAllocation(size_t num_pages, uint32_t worker_id, uint64_t) {
     partition->prepareTempAllocation(num_pages, worker_id);
 }
 
@@ -37,7 +37,12 @@ void BasicPartitioningStrategy<PartitionType>::notifyDropped(const PageId pid, u
 }
 
 template <class PartitionType>
-void BasicPartitioningStrategy<PartitionType>::notifyTempDropped(size_t num_pages) {
+void BasicPartitioningStrategy<PartitionType>::traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) {
+    partition->traceAccess(pid, action, worker_id);
+}
+
+template <class PartitionType>
+void BasicPartitioningStrategy<PartitionType>::notifyTempDropped(size_t num_pages, uint32_t) {
     partition->notifyTempDropped(num_pages);
 }
 
@@ -46,6 +51,11 @@ bool BasicPartitioningStrategy<PartitionType>::performIdleMaintenance(uint32_t w
     return partition->performIdleMaintenance(worker_id);
 }
 
+template <class PartitionType>
+bool BasicPartitioningStrategy<PartitionType>::performCleaning(uint32_t worker_id, size_t free_pages) {
+    return partition->clean(worker_id, free_pages);
+}
+
 template <class PartitionType>
 size_t BasicPartitioningStrategy<PartitionType>::getPerPageMemoryCost() const {
     // space required in the cached_pages hash table (assumed to be sizeof(PageId) * 3 / 2 to get a load factor of ~66%)
@@ -57,6 +67,11 @@ size_t BasicPartitioningStrategy<PartitionType>::getConstantMemoryCost(const siz
     return sizeof(BasicPartitioningStrategy<PartitionType>) + PartitionType::getConstantMemoryCost(num_workers);
 }
 
+template <class PartitionType>
+size_t BasicPartitioningStrategy<PartitionType>::getPageStateMemoryCost(const size_t num_page_states) const {
+    return PartitionType::getPageStateMemoryCost(num_page_states);
+}
+
 template <class PartitionType>
 size_t BasicPartitioningStrategy<PartitionType>::getNumLatchedPages(PageId max_pid) const {
     return partition->getNumLatchedPages(max_pid);
@@ -11,14 +11,17 @@ public:
     BasicPartitioningStrategy();
 
     void setVMCache(VMCache* vmcache, const size_t num_workers) override;
-    void prepareTempAllocation(size_t num_pages, uint32_t worker_id) override;
+    void prepareTempAllocation(size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns) override;
     void preFault(const PageId pid, bool scan, uint32_t worker_id) override;
     void ref(const PageId pid, bool scan, uint32_t worker_id) override;
     void notifyDropped(const PageId pid, uint32_t worker_id) override;
-    void notifyTempDropped(size_t num_pages) override;
+    void traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) override;
+    void notifyTempDropped(size_t num_pages, uint32_t worker_id) override;
     bool performIdleMaintenance(uint32_t worker_id) override;
+    bool performCleaning(uint32_t worker_id, size_t free_pages) override;
     size_t getPerPageMemoryCost() const override;
     size_t getConstantMemoryCost(const size_t num_workers) const override;
+    size_t getPageStateMemoryCost(const size_t num_page_states) const override;
     size_t getNumLatchedPages(PageId max_pid) const override;
     void printMemoryUsage() const override;
     void printStats() const override;
@@ -2,11 +2,13 @@
 
 #include <atomic>
 #include <iomanip>
+#include <limits>
+#include <mutex>
 #include <random>
 
 #include "../../core/units.hpp"
 #include "../../utils/crtp.hpp"
-#include "../../utils/hashset.hpp"
+#include "../../utils/sharded_hashset.hpp"
 #include "../vmcache.hpp"
 #include "cache_trace.hpp"
 
@@ -19,33 +21,51 @@ are required to implement the following members:
     void notifyDroppedImpl(const PageId pid) - called when VMCache itself has dropped a page and it does not reside in memory anymore
     bool performIdleMaintenance(uint32_t worker_id) - called by idle worker threads to asynchronously perform evictions and possibly write back dirty pages (if enabled); returns true if the buffer pool would benefit from another call to this method (worker threads use this as a hint to skip idling)
     size_t getNumLatchedPages(PageId max_pid) const - currently just used for statistics collection purposes
+    bool isCached(const PageId pid) const - returns whether the page is currently tracked by this partition (used for routing pages to their partition when there are several data partitions)
     static size_t getPerPageMemoryCost()
     static size_t getConstantMemoryCost(const size_t num_workers)
+Partitions with data structures over the whole page id range can override 'getPageStateMemoryCost()', which accounts them per page state entry.
+Partitions evicting pages in batches can implement 'evict()' and 'performIdleMaintenance()' using 'evictBatch()' and 'performBatchedIdleMaintenance()',
+selected candidates that are not evicted after all are passed to 'notifyNotEvicted()'.
 */
+// how eviction candidate selection treats dirty pages, whose eviction requires writing them back
+enum class DirtySelection {
+    Any, // dirty pages are selected like clean pages
+    Weighed, // dirty pages are selected according to their higher eviction cost (see 'EvictionCostModel::admitDirtyCandidate()')
+    None // dirty pages are skipped
+};
+
 template <class T>
 class CachePartition : public CRTP<T, CachePartition> {
 public:
+    // memory of the partition's data structures that scale with the number of entries of VMCache's page state array instead of the number of frames
+    static size_t getPageStateMemoryCost(const size_t) {
+        return 0;
+    }
+
     inline void prepareTempAllocation(size_t num_pages, uint32_t worker_id) {
         physical_temp_pages += num_pages;
         physical_pages_target += num_pages; // signal that we are targeting to allocate new physical pages
         if (num_pages > LARGE_ALLOCATION_THRESHOLD && vmcache.isUsingEvictionTarget()) { // "large" (> 4MiB) temp allocations should take care to make space for themselves, smaller ones rely on passive evictions
             while (physical_pages_target > max_physical_pages) {
-                this->actual().evict(worker_id);
+                relievePressure(worker_id);
             }
         }
         physical_pages += num_pages; // we are allocating new physical pages
         while (physical_pages > max_physical_pages) {
-            this->actual().evict(worker_id);
+            relievePressure(worker_id);
         }
     }
 
+    // the faulting thread holds the page's exclusive latch, extents are accounted with all of their pages
     inline void handleFault(const PageId pid, bool scan, uint32_t worker_id) {
-        physical_data_pages++;
-        physical_pages_target++;
-        physical_pages++; // we are allocating a new physical page
+        const size_t num_pages = vmcache.getPageCount(pid);
+        getPhysicalPageCounter(pid) += num_pages;
+        physical_pages_target += num_pages;
+        physical_pages += num_pages; // we are allocating new physical pages
         this->actual().fault(pid, scan);
         while (physical_pages > max_physical_pages) {
-            this->actual().evict(worker_id);
+            relievePressure(worker_id);
         }
 #ifdef COLLECT_CACHE_TRACES
         tracer.trace(CacheAction::Fault, pid, worker_id);
@@ -53,15 +73,22 @@ public:
     }
 
     inline void notifyDropped(const PageId pid, __attribute__((unused)) uint32_t worker_id) {
-        physical_data_pages--;
+        const size_t num_pages = vmcache.getPageCount(pid);
+        getPhysicalPageCounter(pid) -= num_pages;
         this->actual().notifyDroppedImpl(pid);
-        physical_pages--;
-        physical_pages_target--;
+        physical_pages -= num_pages;
+        physical_pages_target -= num_pages;
 #ifdef COLLECT_CACHE_TRACES
         tracer.trace(CacheAction::Evict, pid, worker_id);
 #endif
     }
 
+    inline void traceAccess(__attribute__((unused)) const PageId pid, __attribute__((unused)) CacheAction action, __attribute__((unused)) uint32_t worker_id) {
+#ifdef COLLECT_CACHE_TRACES
+        tracer.trace(action, pid, worker_id);
+#endif
+    }
+
     inline void notifyTempDropped(size_t num_pages) {
         physical_temp_pages -= num_pages;
         physical_pages -= num_pages;
@@ -69,7 +96,7 @@ public:
     }
 
     void printMemoryUsage() const {
-        std::cout << physical_pages.load() * PAGE_SIZE / 1024 / 1024 << " MiB / " << max_physical_pages * PAGE_SIZE / 1024 / 1024 << " MiB" << std::endl;
+        std::cout << physical_pages.load() * PAGE_SIZE / 1024 / 1024 << " MiB / " << max_physical_pages.load() * PAGE_SIZE / 1024 / 1024 << " MiB" << std::endl;
     }
 
     void printEvictionStats() const {
@@ -83,9 +110,44 @@ public:
     size_t getTotalEvictedPageCount() const { return total_evicted_pages.load(); }
     size_t getTotalDirtyWritePageCount() const { return total_dirty_pages_written.load(); }
 
+    size_t getMaxPhysicalPages() const { return max_physical_pages.load(); }
+    size_t getPhysicalPageCount() const { return physical_pages.load(); }
+    size_t getPhysicalPageTarget() const { return physical_pages_target.load(); }
+
+    // changes the partition's memory limit; note that the partition's data structures remain sized for the limit passed to the constructor, so this may not exceed it
+    inline void setMaxPhysicalPages(size_t pages) {
+        max_physical_pages = pages;
+    }
+
+    // called by page cleaner threads: evicts a batch of pages if fewer than 'free_pages' frames are free and writes back dirty pages if asynchronous flushing is enabled; returns true if there is more work to do
+    inline bool clean(uint32_t worker_id, size_t free_pages) {
+        const size_t max_pages = max_physical_pages.load();
+        const size_t target_pages = max_pages > free_pages ? max_pages - free_pages : 0;
+        bool more_work = false;
+        if (physical_pages_target > target_pages) {
+            const size_t evicted_pages = total_evicted_pages.load();
+            this->actual().evict(worker_id);
+            // stop if no page could be evicted (e.g., because all frames are used by latched or temporary pages)
+            more_work = total_evicted_pages.load() != evicted_pages && physical_pages_target > target_pages;
+        }
+        if (vmcache.isUsingAsyncFlushing())
+            more_work |= this->actual().performIdleMaintenance(worker_id);
+        return more_work;
+    }
+
+    // evicts pages until the partition complies with its (possibly lowered) memory limit; gives up once a round evicts nothing (e.g., because the remaining pages are latched), the partition's fault path then evicts the excess pages later
+    inline void shrink(uint32_t worker_id) {
+        while (physical_pages > max_physical_pages) {
+            const size_t evicted_pages = total_evicted_pages.load();
+            this->actual().evict(worker_id);
+            if (total_evicted_pages.load() == evicted_pages)
+                break;
+        }
+    }
+
 protected:
     VMCache& vmcache;
-    const size_t max_physical_pages;
+    std::atomic_uint64_t max_physical_pages;
     const size_t num_workers;
     std::atomic_uint64_t physical_pages;
     std::atomic_uint64_t physical_pages_target;
@@ -113,24 +175,68 @@ protected:
 #endif
     { }
 
+    // number of entries in VMCache's page state array, including the spill area
+    inline size_t getNumPageStates() const {
+        return vmcache.virtual_pages + vmcache.spill_pages;
+    }
+
+    // first page id of the spill area
+    inline PageId getSpillAreaBegin() const {
+        return vmcache.virtual_pages;
+    }
+
+    // resident spillable pages are managed like data pages, but accounted as temporary pages
+    inline std::atomic_int64_t& getPhysicalPageCounter(const PageId pid) {
+        return vmcache.isSpillablePage(pid) ? physical_temp_pages : physical_data_pages;
+    }
+
+    // called while the partition exceeds its memory limit: recycled temporary pages are given up before any data page is evicted
+    inline void relievePressure(uint32_t worker_id) {
+        if (vmcache.getNumPooledTemporaryPages() > 0)
+            vmcache.releaseTemporaryPagePools(); // the caller checks again whether the partition still exceeds its limit
+        else
+            this->actual().evict(worker_id);
+    }
+
+    // returns whether a dirty eviction candidate may be selected
+    inline bool admitDirty(DirtySelection dirty_selection) const {
+        switch (dirty_selection) {
+            case DirtySelection::Any:
+                return true;
+            case DirtySelection::Weighed:
+                return vmcache.getEvictionCosts().admitDirtyCandidate();
+            default:
+                return false;
+        }
+    }
+
     inline bool tryMark(const PageId pid, uint64_t& s) {
         return vmcache.page_states[pid].compare_exchange_strong(s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_MARKED);
     }
 
-    inline void flushDirty(const PageId pid) {
-        vmcache.flushDirtyPage(pid);
+    // returns the number of written pages
+    inline size_t flushDirty(PageId* pids, size_t num_pids, uint32_t worker_id) {
+        return vmcache.flushDirtyPages(pids, num_pids, worker_id);
     }
 
     inline void pageOut(PageId* eviction_candidates, size_t num_eviction_candidates, uint64_t locked_pages, uint32_t worker_id) {
         if (!vmcache.dirty_writeback)
             return;
+        if (vmcache.compressed_tier) {
+            // dirty pages have been written back before (pages whose write failed are not locked)
+            for (size_t i = 0; i < num_eviction_candidates; i++) {
+                const uint64_t s = vmcache.page_states[eviction_candidates[i]].load();
+                if ((locked_pages >> i) & 1ull && (s & (PAGE_DIRTY_BIT | PAGE_EXTENT_BIT)) == 0)
+                    vmcache.compressed_tier->insert(eviction_candidates[i], vmcache.toPointer(eviction_candidates[i]));
+            }
+        }
         if (vmcache.use_exmap) {
             size_t j = 0;
             for (size_t i = 0; i < num_eviction_candidates; i++) {
                 if ((locked_pages >> i) & 1ull) {
                     const PageId pid = eviction_candidates[i];
                     vmcache.exmap_interface[worker_id]->iov[j].page = pid;
-                    vmcache.exmap_interface[worker_id]->iov[j].len = 1;
+                    vmcache.exmap_interface[worker_id]->iov[j].len = vmcache.getPageCount(pid);
                     j++;
                 }
             }
@@ -140,7 +246,7 @@ protected:
             for (size_t i = 0; i < num_eviction_candidates; i++) {
                 if ((locked_pages >> i) & 1ull) {
                     const PageId pid = eviction_candidates[i];
-                    madvise(vmcache.memory + pid * PAGE_SIZE, PAGE_SIZE, MADV_DONTNEED);
+                    madvise(vmcache.memory + pid * PAGE_SIZE, vmcache.getPageCount(pid) * PAGE_SIZE, MADV_DONTNEED);
                 }
             }
         }
@@ -153,158 +259,243 @@ protected:
 #endif
     }
 
-    inline uint64_t loadState(const PageId pid) const {
-        return vmcache.page_states[pid].load();
-    }
-
-    inline bool tryCAS(const PageId pid, uint64_t& s, uint64_t new_s) {
-        return vmcache.page_states[pid].compare_exchange_strong(s, new_s);
-    }
-};
-
-/*
-Base class for cache partitions implementing eviction policies that use a hash set to track faulted pages
-*/
-template <class T>
-class HashSetCachePartition : public CachePartition<T> {
-public:
-    HashSetCachePartition(VMCache& vmcache, const size_t max_physical_pages, std::atomic_int64_t& physical_data_pages, std::atomic_int64_t& physical_temp_pages, const size_t num_workers)
-    : CachePartition<T>(vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers)
-    , cached_pages(max_physical_pages * 3 / 2)
-    , flush_clock(0) { }
-
-    inline void fault(const PageId pid, bool) {
-        cached_pages.insert(pid);
-    }
-
-    inline void ref(const PageId, bool, uint32_t) { }
+    // called by 'evictBatch()' for each selected candidate that is not evicted after all, e.g., because it is latched, modified by an uncommitted transaction or could not be written
+    inline void notifyNotEvicted(const PageId, uint32_t) { }
 
-    inline void evict(uint32_t worker_id) {
+    // evicts a batch of pages selected by the derived class' 'getEvictionCandidates()', evicted pages are passed to its 'removeEvicted()'
+    inline void evictBatch(uint32_t worker_id) {
         // evict some pages
         const size_t EVICTION_BATCH_SIZE = 64; // NOTE: Do not increase this above 64! dirty_pages & locked_pages will break otherwise!
         PageId eviction_candidates[EVICTION_BATCH_SIZE];
         uint64_t dirty_pages = 0;
-        // get eviction candidates (note: we do not select dirty pages for eviction if we are writing those back asynchronously anyways)
-        bool skip_dirty = this->vmcache.isUsingAsyncFlushing();
-        // if the number of dirty pages in the buffer pool exceeds 10% of the memory limit, allow selecting dirty pages for eviction
-        // TODO: as of now, the 10% limit was chosen arbitrarily; can we run some experiments to figure out an optimal value?
-        if (this->vmcache.getDirtyPageCount() > this->vmcache.getMaxPhysicalPages() / 10)
-            skip_dirty = false;
-        size_t num_eviction_candidates = this->actual().getEvictionCandidates(EVICTION_BATCH_SIZE, eviction_candidates, skip_dirty, dirty_pages, worker_id);
-        if (num_eviction_candidates == 0) // retry, allow dirty page eviction
-            num_eviction_candidates = this->actual().getEvictionCandidates(EVICTION_BATCH_SIZE, eviction_candidates, false, dirty_pages, worker_id);
+        // get eviction candidates, dirty pages are selected according to their higher eviction cost if they have to be written back (see 'admitDirty()')
+        //  note: we do not select dirty pages for eviction if we are writing those back asynchronously anyways, unless the buffer pool holds more dirty pages than the cost-based target
+        DirtySelection dirty_selection = this->vmcache.isUsingDirtyWriteback() ? DirtySelection::Weighed : DirtySelection::Any;
+        if (this->vmcache.isUsingAsyncFlushing() && this->vmcache.getDirtyPageCount() <= this->vmcache.getEvictionCosts().getDirtyPageTarget(this->vmcache.getMaxPhysicalPages()))
+            dirty_selection = DirtySelection::None;
+        size_t num_eviction_candidates = this->actual().getEvictionCandidates(EVICTION_BATCH_SIZE, eviction_candidates, dirty_selection, dirty_pages, worker_id);
+        if (num_eviction_candidates == 0 && dirty_selection != DirtySelection::Any) // retry, the first round may only have marked the pages
+            num_eviction_candidates = this->actual().getEvictionCandidates(EVICTION_BATCH_SIZE, eviction_candidates, dirty_selection, dirty_pages, worker_id);
+        if (num_eviction_candidates == 0 && dirty_selection != DirtySelection::Any) // retry, select any dirty page
+            num_eviction_candidates = this->actual().getEvictionCandidates(EVICTION_BATCH_SIZE, eviction_candidates, DirtySelection::Any, dirty_pages, worker_id);
         if (num_eviction_candidates == 0)
             return;
-        // write out dirty pages
-        for (size_t i = 0; i < num_eviction_candidates; i++) {
-            PageId pid = eviction_candidates[i];
-            if ((dirty_pages >> i) & 1ull) {
-                this->flushDirty(pid);
-                this->total_dirty_pages_written++;
+        // pages modified by uncommitted transactions are not written back (no-steal, see 'VMCache::commitTransaction()'); the selected dirty pages are latched in shared mode, so their flag cannot change
+        //  note: selected clean pages are checked when they are latched below
+        if (this->vmcache.isUsingWAL() && dirty_pages != 0) {
+            size_t num_remaining = 0;
+            uint64_t remaining_dirty_pages = 0;
+            for (size_t i = 0; i < num_eviction_candidates; i++) {
+                const PageId pid = eviction_candidates[i];
+                const bool dirty = (dirty_pages >> i) & 1ull;
+                if (dirty && PAGE_UNCOMMITTED(this->loadState(pid))) {
+                    this->vmcache.unfixShared(pid);
+                    this->actual().notifyNotEvicted(pid, worker_id);
+                    continue;
+                }
+                remaining_dirty_pages |= static_cast<uint64_t>(dirty) << num_remaining;
+                eviction_candidates[num_remaining++] = pid;
             }
+            num_eviction_candidates = num_remaining;
+            dirty_pages = remaining_dirty_pages;
         }
+        // write out dirty pages in a single batch
+        PageId dirty_pids[EVICTION_BATCH_SIZE];
+        size_t num_dirty_pids = 0;
+        for (size_t i = 0; i < num_eviction_candidates; i++) {
+            if ((dirty_pages >> i) & 1ull)
+                dirty_pids[num_dirty_pids++] = eviction_candidates[i];
+        }
+        if (num_dirty_pids > 0)
+            this->total_dirty_pages_written += this->flushDirty(dirty_pids, num_dirty_pids, worker_id);
         // obtain exclusive locks
         uint64_t locked_pages = 0;
         for (size_t i = 0; i < num_eviction_candidates; i++) {
             PageId pid = eviction_candidates[i];
             uint64_t s = this->loadState(pid);
             uint64_t new_s = (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED;
-            if ((dirty_pages >> i) & 1ull) { // lock upgrade from shared to exclusive
-                if (PAGE_STATE(s) == PAGE_STATE_LOCKED_SHARED_MIN && this->tryCAS(pid, s, new_s)) {
+            if ((dirty_pages >> i) & 1ull) { // lock upgrade from shared to exclusive (pages that could not be written remain dirty and are not evicted)
+                if (PAGE_STATE(s) == PAGE_STATE_LOCKED_SHARED_MIN && (s & PAGE_DIRTY_BIT) == 0 && this->tryCAS(pid, s, new_s)) {
                     locked_pages |= 1ull << i;
                 } else {
                     this->vmcache.unfixShared(pid);
                 }
-            } else { // lock exclusively
-                if ((PAGE_STATE(s) == PAGE_STATE_MARKED || PAGE_STATE(s) == PAGE_STATE_UNLOCKED || PAGE_STATE(s) == PAGE_STATE_FAULTED) && this->tryCAS(pid, s, new_s)) {
+            } else { // lock exclusively (unless a transaction has modified the page since it was selected)
+                if ((PAGE_STATE(s) == PAGE_STATE_MARKED || PAGE_STATE(s) == PAGE_STATE_UNLOCKED || PAGE_STATE(s) == PAGE_STATE_FAULTED) && !PAGE_UNCOMMITTED(s) && this->tryCAS(pid, s, new_s)) {
                     locked_pages |= 1ull << i;
                 }
             }
         }
-        // remove locked pages from page table & remove locked pages from eviction hash table, unlock
+        // remove locked pages from page table
         this->pageOut(eviction_candidates, num_eviction_candidates, locked_pages, worker_id);
-        // remove from eviction hash table, unlock
-        size_t evicted_data_pages = 0;
+        // remove from the partition's bookkeeping, unlock
+        size_t evicted_pages = 0;
         for (size_t i = 0; i < num_eviction_candidates; i++) {
             if ((locked_pages >> i) & 1ull) {
                 const PageId pid = eviction_candidates[i];
-                cached_pages.erase(pid);
+                this->actual().removeEvicted(pid);
+                const size_t num_pages = this->vmcache.getPageCount(pid);
+                this->getPhysicalPageCounter(pid) -= num_pages;
+                evicted_pages += num_pages;
                 this->markEvicted(pid, worker_id);
-                evicted_data_pages++;
+            } else {
+                this->actual().notifyNotEvicted(eviction_candidates[i], worker_id);
             }
         }
 
-        this->physical_pages -= evicted_data_pages;
-        this->physical_pages_target -= evicted_data_pages;
-        this->total_evicted_pages += evicted_data_pages;
-        this->physical_data_pages -= evicted_data_pages;
+        this->physical_pages -= evicted_pages;
+        this->physical_pages_target -= evicted_pages;
+        this->total_evicted_pages += evicted_pages;
     }
 
-    inline bool performIdleMaintenance(uint32_t worker_id) {
+    // evicts pages if the partition exceeds its eviction target and writes back a batch of dirty pages selected by the derived class' 'getFlushCandidates()'
+    inline bool performBatchedIdleMaintenance(uint32_t worker_id) {
         // if both flags are disabled, idle threads do not participate in buffer pool maintenance
         if (!this->vmcache.isUsingAsyncFlushing() && !this->vmcache.isUsingEvictionTarget())
             return false;
 
         // idle eviction
         if (this->physical_pages_target > this->max_physical_pages) {
-            evict(worker_id);
+            this->actual().evict(worker_id);
         }
 
         if (!this->vmcache.isUsingAsyncFlushing())
             return this->physical_pages_target > this->max_physical_pages;
 
-        // idle flushing
-        size_t num_flushed = 0;
+        // idle flushing: latch dirty pages in shared mode first, then write them out in a single batch
         const size_t batch_size = 64;
+        PageId latched_pids[batch_size];
+        const size_t num_flushed = this->actual().getFlushCandidates(batch_size, latched_pids, worker_id);
+        if (num_flushed > 0)
+            this->total_dirty_pages_written += this->flushDirty(latched_pids, num_flushed, worker_id);
+        // release latches
+        for (size_t i = 0; i < num_flushed; ++i) {
+            const PageId pid = latched_pids[i];
+            uint64_t s = this->loadState(pid);
+            while (true) {
+                assert(PAGE_STATE(s) >= PAGE_STATE_LOCKED_SHARED_MIN && PAGE_STATE(s) <= PAGE_STATE_LOCKED_SHARED_MAX);
+                if (this->tryCAS(pid, s, s - 1)) {
+                    break;
+                }
+            }
+        }
+
+        return this->physical_pages_target > this->max_physical_pages || this->vmcache.getDirtyPageCount() > this->vmcache.getEvictionCosts().getDirtyPageTarget(this->vmcache.getMaxPhysicalPages()); // keep writing back dirty pages using idle threads until the cost-based target is reached
+    }
+
+    // latches 'pid' in shared mode and adds it to 'latched_pids' if it is a marked dirty page, marks it if it is an unlatched dirty page; pages modified by uncommitted transactions are skipped
+    inline void tryLatchForFlush(const PageId pid, PageId* latched_pids, size_t& num_latched) {
+        uint64_t s = this->loadState(pid);
+        uint64_t state = PAGE_STATE(s);
+        if (state != PAGE_STATE_EVICTED && state != PAGE_STATE_LOCKED && (s & PAGE_DIRTY_BIT) > 0 && !PAGE_UNCOMMITTED(s)) {
+            if (state == PAGE_STATE_MARKED) {
+                if (this->tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
+                    latched_pids[num_latched++] = pid;
+                }
+            } else if (state == PAGE_STATE_UNLOCKED) {
+                // mark unlatched page
+                const uint64_t new_s = (s & ~PAGE_STATE_MASK) | PAGE_STATE_MARKED;
+                this->tryCAS(pid, s, new_s);
+            }
+        }
+    }
+
+    // adds 'pid' to the eviction candidates if it is marked, marks it otherwise; returns whether the page was selected
+    inline bool selectClockCandidate(const PageId pid, PageId* eviction_candidates, size_t& num_eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages) {
+        uint64_t s = loadState(pid);
+        if (PAGE_STATE(s) == PAGE_STATE_MARKED || PAGE_STATE(s) == PAGE_STATE_FAULTED) {
+            if ((s & PAGE_DIRTY_BIT) > 0) {
+                if (this->admitDirty(dirty_selection) && tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
+                    dirty_pages |= 1ull << num_eviction_candidates;
+                    eviction_candidates[num_eviction_candidates++] = pid;
+                    return true;
+                }
+            } else {
+                eviction_candidates[num_eviction_candidates++] = pid;
+                return true;
+            }
+        }
+        // mark pages that are currently unlocked for eviction in the next round
+        if (PAGE_STATE(s) == PAGE_STATE_UNLOCKED)
+            tryMark(pid, s);
+        return false;
+    }
+
+    inline uint64_t loadState(const PageId pid) const {
+        return vmcache.page_states[pid].load();
+    }
+
+    inline bool tryCAS(const PageId pid, uint64_t& s, uint64_t new_s) {
+        return vmcache.page_states[pid].compare_exchange_strong(s, new_s);
+    }
+};
+
+/*
+Base class for cache partitions implementing eviction policies that use a hash set to track faulted pages; the hash set is
+sharded, and clock-based policies advance one clock hand per shard (see 'sweepClock()') so that concurrent evictions are
+spread over the shards instead of contending on a single clock hand
+*/
+template <class T>
+class HashSetCachePartition : public CachePartition<T> {
+public:
+    HashSetCachePartition(VMCache& vmcache, const size_t max_physical_pages, std::atomic_int64_t& physical_data_pages, std::atomic_int64_t& physical_temp_pages, const size_t num_workers)
+    : CachePartition<T>(vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers)
+    , cached_pages(max_physical_pages * 3 / 2)
+    , flush_clock(0) { }
+
+    inline void fault(const PageId pid, bool) {
+        // note: 'cached_pages' has headroom for the partition's pages, a page that does not fit anyways is not tracked and therefore not evicted
+        __attribute__((unused)) const bool inserted = cached_pages.insert(pid);
+        assert(inserted);
+    }
+
+    inline void ref(const PageId, bool, uint32_t) { }
+
+    inline void evict(uint32_t worker_id) {
+        this->evictBatch(worker_id);
+    }
+
+    inline bool performIdleMaintenance(uint32_t worker_id) {
+        return this->performBatchedIdleMaintenance(worker_id);
+    }
+
+    // called by 'evictBatch()' for each evicted page
+    inline void removeEvicted(const PageId pid) {
+        cached_pages.erase(pid);
+        this->actual().notifyEvictedImpl(pid);
+    }
+
+    // latches up to 'batch_size' dirty pages for idle flushing (see 'performBatchedIdleMaintenance()')
+    inline size_t getFlushCandidates(const size_t batch_size, PageId* latched_pids, uint32_t) {
         size_t current_clock = flush_clock.load();
         if (!flush_clock.compare_exchange_weak(current_clock, (current_clock + batch_size) % cached_pages.bucketCount()))
             return 0;
-
+        size_t num_latched = 0;
         for (size_t i = 0; i < batch_size; ++i) {
             PageId pid = cached_pages.getBucket((current_clock + i) % cached_pages.bucketCount());
-            if (pid == HashSet<PageId>::tombstone_bucket || pid == HashSet<PageId>::empty_bucket)
+            if (pid == decltype(cached_pages)::tombstone_bucket || pid == decltype(cached_pages)::empty_bucket)
                 continue;
-            uint64_t s = this->loadState(pid);
-            uint64_t state = PAGE_STATE(s);
-            if (state != PAGE_STATE_EVICTED && state != PAGE_STATE_LOCKED && (s & PAGE_DIRTY_BIT) > 0) {
-                bool latched = false;
-                if (state == PAGE_STATE_MARKED) {
-                    if (this->tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
-                        latched = true;
-                    }
-                } else if (state == PAGE_STATE_UNLOCKED) {
-                    // mark unlatched page
-                    const uint64_t new_s = (s & ~PAGE_STATE_MASK) | PAGE_STATE_MARKED;
-                    this->tryCAS(pid, s, new_s);
-                }
-                if (latched) { // flush the page
-                    this->flushDirty(pid);
-                    num_flushed++;
-                    // release latch
-                    s = this->loadState(pid);
-                    while (true) {
-                        assert(PAGE_STATE(s) >= PAGE_STATE_LOCKED_SHARED_MIN && PAGE_STATE(s) <= PAGE_STATE_LOCKED_SHARED_MAX);
-                        if (this->tryCAS(pid, s, s - 1)) {
-                            break;
-                        }
-                    }
-                }
-            }
+            this->tryLatchForFlush(pid, latched_pids, num_latched);
         }
-
-        this->total_dirty_pages_written += num_flushed;
-        return this->physical_pages_target > this->max_physical_pages || this->vmcache.getDirtyPageCount() > this->vmcache.getMaxPhysicalPages() / 20; // keep evicting dirty pages using idle threads unless only less than 5% of capacity are dirty
+        return num_latched;
     }
 
     inline void notifyDroppedImpl(const PageId pid) {
         cached_pages.erase(pid);
     }
 
+    // called for every page evicted by 'evict()', derived classes may use this to update policy-specific state
+    inline void notifyEvictedImpl(const PageId) { }
+
+    inline bool isCached(const PageId pid) const {
+        return cached_pages.contains(pid);
+    }
+
     size_t getNumLatchedPages(PageId max_pid) const {
         size_t result = 0;
         for (size_t i = 0; i < cached_pages.bucketCount(); i++) {
             PageId pid = cached_pages.getBucket(i);
-            if (pid == HashSet<PageId>::tombstone_bucket || pid == HashSet<PageId>::empty_bucket || pid > max_pid)
+            if (pid == decltype(cached_pages)::tombstone_bucket || pid == decltype(cached_pages)::empty_bucket || pid > max_pid)
                 continue;
             const uint8_t state = PAGE_STATE(this->loadState(pid));
             if ((state >= PAGE_STATE_LOCKED_SHARED_MIN && state <= PAGE_STATE_LOCKED_SHARED_MAX) || state == PAGE_STATE_LOCKED)
@@ -318,7 +509,27 @@ public:
     }
 
 protected:
-    HashSet<PageId> cached_pages;
+    // batched clock over 'cached_pages': starting at a worker-specific shard, advances the shards' clock hands in turn until 'batch_size' candidates are found or each bucket has been visited once
+    inline size_t sweepClock(const size_t batch_size, PageId* eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages, uint32_t worker_id) {
+        size_t num_eviction_candidates = 0;
+        size_t total_clock_steps = 0;
+        size_t shard = worker_id % cached_pages.shardCount();
+        while (num_eviction_candidates < batch_size && total_clock_steps < cached_pages.bucketCount()) {
+            const size_t clock_step = std::min((batch_size - num_eviction_candidates) * 8, cached_pages.shardBucketCount());
+            const size_t current_clock = cached_pages.advanceClock(shard, clock_step);
+            for (size_t i = 0; i < clock_step && num_eviction_candidates < batch_size; ++i) {
+                PageId pid = cached_pages.getShardBucket(shard, current_clock + i);
+                if (pid == decltype(cached_pages)::tombstone_bucket || pid == decltype(cached_pages)::empty_bucket)
+                    continue;
+                this->selectClockCandidate(pid, eviction_candidates, num_eviction_candidates, dirty_selection, dirty_pages);
+            }
+            total_clock_steps += clock_step;
+            shard = (shard + 1) % cached_pages.shardCount();
+        }
+        return num_eviction_candidates;
+    }
+
+    ShardedHashSet<PageId> cached_pages;
     std::atomic_uint64_t flush_clock;
 };
 
@@ -328,51 +539,15 @@ This implements the batched clock eviction policy described in "Virtual-Memory A
 class alignas(64) ClockEvictionCachePartition : public HashSetCachePartition<ClockEvictionCachePartition> {
 public:
     ClockEvictionCachePartition(VMCache& vmcache, const size_t max_physical_pages, std::atomic_int64_t& physical_data_pages, std::atomic_int64_t& physical_temp_pages, const size_t num_workers)
-    : HashSetCachePartition<ClockEvictionCachePartition>(vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers)
-    , clock(0) { }
+    : HashSetCachePartition<ClockEvictionCachePartition>(vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers) { }
 
-    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, bool skip_dirty, uint64_t& dirty_pages, uint32_t) {
-        size_t num_eviction_candidates = 0;
-        size_t total_clock_steps = 0;
-        while (num_eviction_candidates < batch_size) {
-            const size_t clock_step = (batch_size - num_eviction_candidates) * 8;
-            size_t current_clock = clock.load();
-            const size_t next_clock = (current_clock + clock_step) % cached_pages.bucketCount();
-            if (!clock.compare_exchange_weak(current_clock, next_clock))
-                continue;
-            for (size_t i = 0; i < clock_step && num_eviction_candidates < batch_size; ++i) {
-                if (total_clock_steps + i >= cached_pages.bucketCount())
-                    return num_eviction_candidates;
-                PageId pid = cached_pages.getBucket((current_clock + i) % cached_pages.bucketCount());
-                if (pid == HashSet<PageId>::tombstone_bucket || pid == HashSet<PageId>::empty_bucket)
-                    continue;
-
-                uint64_t s = loadState(pid);
-                if (PAGE_STATE(s) == PAGE_STATE_MARKED || PAGE_STATE(s) == PAGE_STATE_FAULTED) {
-                    if ((s & PAGE_DIRTY_BIT) > 0) {
-                        if (!skip_dirty && tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
-                            dirty_pages |= 1ull << num_eviction_candidates;
-                            eviction_candidates[num_eviction_candidates++] = pid;
-                        }
-                    } else {
-                        eviction_candidates[num_eviction_candidates++] = pid;
-                    }
-                }
-                // mark pages that are currently unlocked for eviction in the next round
-                if (PAGE_STATE(s) == PAGE_STATE_UNLOCKED)
-                    tryMark(pid, s);
-            }
-            total_clock_steps += clock_step;
-        }
-        return num_eviction_candidates;
+    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages, uint32_t worker_id) {
+        return sweepClock(batch_size, eviction_candidates, dirty_selection, dirty_pages, worker_id);
     }
 
     static size_t getConstantMemoryCost(const size_t) {
         return sizeof(ClockEvictionCachePartition);
     }
-
-private:
-    std::atomic_uint64_t clock;
 };
 
 /*
@@ -390,9 +565,10 @@ public:
         }
     }
 
-    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, bool skip_dirty, uint64_t& dirty_pages, uint32_t worker_id) {
+    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages, uint32_t worker_id) {
         size_t num_eviction_candidates = 0;
-        while (num_eviction_candidates < batch_size) {
+        // like the clock policies' sweep, give up after as many probes as there are buckets and return a partial batch, e.g. if only dirty pages are left that 'admitDirty()' rejects
+        for (size_t num_probes = 0; num_eviction_candidates < batch_size && num_probes < cached_pages.bucketCount(); num_probes++) {
             size_t i = distributions[worker_id](generators[worker_id]); // select a random bucket from 'cached_pages'
             PageId pid = cached_pages.getBucket(i);
             if (pid == decltype(cached_pages)::tombstone_bucket || pid == decltype(cached_pages)::empty_bucket)
@@ -401,7 +577,7 @@ public:
             uint64_t s = loadState(pid);
             if (PAGE_STATE(s) == PAGE_STATE_MARKED || PAGE_STATE(s) == PAGE_STATE_FAULTED || PAGE_STATE(s) == PAGE_STATE_UNLOCKED) {
                 if ((s & PAGE_DIRTY_BIT) > 0) {
-                    if (!skip_dirty && tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
+                    if (this->admitDirty(dirty_selection) && tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
                         dirty_pages |= 1ull << num_eviction_candidates;
                         eviction_candidates[num_eviction_candidates++] = pid;
                     }
@@ -454,7 +630,7 @@ public:
             appendMRU(pid);
     }
 
-    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, bool skip_dirty, uint64_t& dirty_pages, uint32_t) {
+    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages, uint32_t) {
         if (!mru_mutex.try_lock())
             return 0;
         size_t num_eviction_candidates = 0;
@@ -471,7 +647,7 @@ public:
                         continue;
                 }
                 if ((s & PAGE_DIRTY_BIT) > 0) {
-                    if (!skip_dirty && tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
+                    if (this->admitDirty(dirty_selection) && tryCAS(pid, s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN)) {
                         dirty_pages |= 1ull << num_eviction_candidates;
                         eviction_candidates[num_eviction_candidates++] = pid;
                     }
@@ -494,7 +670,7 @@ public:
                     return num_eviction_candidates;
                 }
                 PageId pid = cached_pages.getBucket(i);
-                if (pid == HashSet<PageId>::tombstone_bucket || pid == HashSet<PageId>::empty_bucket)
+                if (pid == decltype(cached_pages)::tombstone_bucket || pid == decltype(cached_pages)::empty_bucket)
                     continue;
 
                 uint64_t s = loadState(pid);
@@ -540,6 +716,334 @@ private:
     std::mutex mru_mutex;
 };
 
+/*
+This implements a scan-resistant eviction policy in the spirit of 2Q and ARC (Johnson & Shasha, Megiddo & Modha) on top of clock:
+Pages faulted by scans are admitted to a probationary FIFO queue and are evicted from there first, so that a large
+scan cannot flush the pages of the main clock. Pages faulted or referenced again by non-scan accesses belong to the
+main clock. Evicted pages are remembered in a small ghost table; a scan fault of a page that was recently evicted
+from the probationary queue admits the page to the main clock instead and lets the probationary queue grow, while
+faults of pages recently evicted from the main clock shrink it again.
+*/
+class alignas(64) TwoQueueEvictionCachePartition : public HashSetCachePartition<TwoQueueEvictionCachePartition> {
+public:
+    TwoQueueEvictionCachePartition(VMCache& vmcache, const size_t max_physical_pages, std::atomic_int64_t& physical_data_pages, std::atomic_int64_t& physical_temp_pages, const size_t num_workers)
+    : HashSetCachePartition<TwoQueueEvictionCachePartition>(vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers)
+    , fifo_size(getMaxProbationSize(max_physical_pages) + 1)
+    , fifo_head(0)
+    , fifo_tail(0)
+    , probation_pages(fifo_size * 3 / 2)
+    , probation_size(0)
+    , probation_target(getMaxProbationSize(max_physical_pages) / 2)
+    , selected_probation(num_workers, false)
+    , ghost_size(std::max<size_t>(max_physical_pages, 1)) {
+        fifo = new PageId[fifo_size];
+        ghost = new std::atomic<PageId>[ghost_size];
+        for (size_t i = 0; i < ghost_size; i++)
+            ghost[i].store(GHOST_EMPTY, std::memory_order_relaxed);
+    }
+
+    ~TwoQueueEvictionCachePartition() {
+        delete[] fifo;
+        delete[] ghost;
+    }
+
+    TwoQueueEvictionCachePartition(const TwoQueueEvictionCachePartition& other) = delete;
+    TwoQueueEvictionCachePartition& operator=(const TwoQueueEvictionCachePartition& other) = delete;
+
+    inline void fault(const PageId pid, bool scan) {
+        HashSetCachePartition<TwoQueueEvictionCachePartition>::fault(pid, scan);
+        const size_t slot = getGhostSlot(pid);
+        PageId ghost_entry = ghost[slot].load();
+        if ((ghost_entry & ~GHOST_PROBATION_BIT) == pid && ghost[slot].compare_exchange_strong(ghost_entry, GHOST_EMPTY)) {
+            // the page has been evicted recently, adapt the size of the probationary queue towards the queue that would have kept it
+            uint64_t target = probation_target.load();
+            if ((ghost_entry & GHOST_PROBATION_BIT) != 0) {
+                while (target < getMaxProbationSize(max_physical_pages) && !probation_target.compare_exchange_weak(target, target + 1)) { }
+                return; // re-scanned pages are admitted to the main clock
+            }
+            while (target > 0 && !probation_target.compare_exchange_weak(target, target - 1)) { }
+        }
+        if (scan)
+            admitProbation(pid);
+    }
+
+    inline void ref(const PageId pid, bool scan, uint32_t) {
+        // promote probationary pages that are accessed by something other than a scan
+        if (!scan && probation_pages.erase(pid))
+            probation_size--;
+    }
+
+    inline void notifyEvictedImpl(const PageId pid) {
+        if (probation_pages.erase(pid)) {
+            probation_size--;
+            ghost[getGhostSlot(pid)].store(pid | GHOST_PROBATION_BIT);
+        } else {
+            ghost[getGhostSlot(pid)].store(pid);
+        }
+    }
+
+    inline void notifyDroppedImpl(const PageId pid) {
+        HashSetCachePartition<TwoQueueEvictionCachePartition>::notifyDroppedImpl(pid);
+        if (probation_pages.erase(pid))
+            probation_size--;
+    }
+
+    inline void notifyNotEvicted(const PageId pid, uint32_t worker_id) {
+        // candidates are taken off the probationary queue when they are selected, the ones that are still probationary return to its tail
+        //  note: clock candidates are still queued, re-queueing them would duplicate their entries
+        if (selected_probation[worker_id] && probation_pages.contains(pid)) {
+            std::lock_guard<std::mutex> guard(fifo_mutex);
+            appendProbation(pid);
+        }
+    }
+
+    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages, uint32_t worker_id) {
+        size_t num_eviction_candidates = 0;
+        if (probation_size.load() > static_cast<int64_t>(probation_target.load()))
+            num_eviction_candidates = getProbationCandidates(batch_size, eviction_candidates, dirty_selection, dirty_pages);
+        selected_probation[worker_id] = num_eviction_candidates > 0;
+        if (num_eviction_candidates > 0)
+            return num_eviction_candidates;
+        // the probationary queue is within its target size (or does not contain any evictable pages), fall back to clock eviction
+        return sweepClock(batch_size, eviction_candidates, dirty_selection, dirty_pages, worker_id);
+    }
+
+    int64_t getProbationSize() const { return probation_size.load(); }
+    size_t getProbationTarget() const { return probation_target.load(); }
+
+    static size_t getPerPageMemoryCost() {
+        // 'cached_pages' + probationary queue (up to half of the pages) and its hash set + ghost table
+        return HashSetCachePartition<TwoQueueEvictionCachePartition>::getPerPageMemoryCost() + sizeof(PageId) / 2 + sizeof(PageId) * 3 / 4 + sizeof(PageId);
+    }
+
+    static size_t getConstantMemoryCost(const size_t) {
+        return sizeof(TwoQueueEvictionCachePartition);
+    }
+
+private:
+    static constexpr PageId GHOST_EMPTY = std::numeric_limits<PageId>::max();
+    static constexpr PageId GHOST_PROBATION_BIT = 1ull << 63;
+
+    static size_t getMaxProbationSize(const size_t max_physical_pages) { return max_physical_pages / 2; }
+
+    inline size_t getGhostSlot(const PageId pid) const {
+        uint32_t hash = 0;
+        MurmurHash3_x86_32(&pid, sizeof(PageId), 1, &hash);
+        return hash % ghost_size;
+    }
+
+    inline void admitProbation(const PageId pid) {
+        std::lock_guard<std::mutex> guard(fifo_mutex);
+        if (!probation_pages.insert(pid))
+            return; // the page is managed by the main clock instead
+        probation_size++;
+        appendProbation(pid);
+    }
+
+    // appends the probationary page 'pid' to the queue, the caller has to hold 'fifo_mutex'
+    inline void appendProbation(const PageId pid) {
+        if ((fifo_tail + 1) % fifo_size == fifo_head) {
+            // the queue is full, the oldest page is handed over to the main clock
+            if (fifo[fifo_head] != pid && probation_pages.erase(fifo[fifo_head]))
+                probation_size--;
+            fifo_head = (fifo_head + 1) % fifo_size;
+        }
+        fifo[fifo_tail] = pid;
+        fifo_tail = (fifo_tail + 1) % fifo_size;
+    }
+
+    inline size_t getProbationCandidates(const size_t batch_size, PageId* eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages) {
+        if (!fifo_mutex.try_lock())
+            return 0;
+        size_t num_eviction_candidates = 0;
+        // pages that are not selected get a second chance at the end of the queue, so two rounds suffice to mark and then select all unlatched pages
+        const size_t max_steps = 2 * ((fifo_tail + fifo_size - fifo_head) % fifo_size);
+        for (size_t step = 0; step < max_steps && num_eviction_candidates < batch_size && fifo_head != fifo_tail; step++) {
+            const PageId pid = fifo[fifo_head];
+            fifo_head = (fifo_head + 1) % fifo_size;
+            if (!probation_pages.contains(pid))
+                continue; // the page has been promoted, evicted or dropped
+            if (!selectClockCandidate(pid, eviction_candidates, num_eviction_candidates, dirty_selection, dirty_pages)) {
+                fifo[fifo_tail] = pid;
+                fifo_tail = (fifo_tail + 1) % fifo_size;
+            }
+        }
+        fifo_mutex.unlock();
+        return num_eviction_candidates;
+    }
+
+    // probationary FIFO queue, entries of pages that are not contained in 'probation_pages' anymore are skipped lazily
+    const size_t fifo_size;
+    PageId* fifo;
+    size_t fifo_head;
+    size_t fifo_tail;
+    std::mutex fifo_mutex;
+    ShardedHashSet<PageId> probation_pages;
+    std::atomic_int64_t probation_size; // note: this may temporarily be off by the number of concurrent admissions
+    std::atomic_uint64_t probation_target;
+    std::vector<uint8_t> selected_probation; // per worker, whether its current eviction candidates were taken off the probationary queue (not a std::vector<bool>, so that workers write separate bytes)
+    // direct-mapped table of recently evicted pages, approximating the ghost queues of 2Q/ARC
+    const size_t ghost_size;
+    std::atomic<PageId>* ghost;
+};
+
+/*
+This implements the batched clock eviction policy directly over VMCache's page state array, as originally proposed for vmcache:
+instead of a hash set of resident pages, the partition keeps a residency bitmap with one bit per page state entry. Faults and
+evictions only set or clear a bit, so there is no hashing and no per-frame memory overhead; the clock hand advances over the
+bitmap words of the allocated page range (and of the used part of the spill area) and skips words without resident pages.
+The bitmap costs 1/8 B per page state entry (see 'getPageStateMemoryCost()'), but only its words covering used page ranges are
+ever touched.
+Note: as the allocated page range grows, the hand's position is mapped onto the new range, so the sweep order is only approximately
+cyclic.
+*/
+class alignas(64) PageStateClockCachePartition : public CachePartition<PageStateClockCachePartition> {
+public:
+    PageStateClockCachePartition(VMCache& vmcache, const size_t max_physical_pages, std::atomic_int64_t& physical_data_pages, std::atomic_int64_t& physical_temp_pages, const size_t num_workers)
+    : CachePartition<PageStateClockCachePartition>(vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers)
+    , num_words((getNumPageStates() + 63) / 64)
+    , spill_begin_word(getSpillAreaBegin() / 64)
+    , spill_end_word(spill_begin_word)
+    , clock(0)
+    , flush_clock(0) {
+        // anonymous memory is zero-filled, bitmap words of unused page ranges are never touched
+        void* result = mmap(0, num_words * sizeof(std::atomic_uint64_t), PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0);
+        if (result == MAP_FAILED)
+            throw std::runtime_error("Failed to create anonymous memory mapping for the residency bitmap");
+        residency = reinterpret_cast<std::atomic_uint64_t*>(result);
+    }
+
+    ~PageStateClockCachePartition() {
+        munmap(residency, num_words * sizeof(std::atomic_uint64_t));
+    }
+
+    inline void fault(const PageId pid, bool) {
+        residency[pid / 64].fetch_or(1ull << (pid % 64));
+        if (pid >= getSpillAreaBegin()) {
+            size_t end = spill_end_word.load();
+            while (pid / 64 + 1 > end && !spill_end_word.compare_exchange_weak(end, pid / 64 + 1)) { }
+        }
+    }
+
+    inline void ref(const PageId, bool, uint32_t) { }
+
+    inline void evict(uint32_t worker_id) {
+        evictBatch(worker_id);
+    }
+
+    inline bool performIdleMaintenance(uint32_t worker_id) {
+        return performBatchedIdleMaintenance(worker_id);
+    }
+
+    inline size_t getEvictionCandidates(const size_t batch_size, PageId* eviction_candidates, DirtySelection dirty_selection, uint64_t& dirty_pages, uint32_t) {
+        const size_t regular_words = getNumRegularWords();
+        const size_t num_clock_words = regular_words + (spill_end_word.load() - spill_begin_word);
+        size_t num_eviction_candidates = 0;
+        size_t total_clock_steps = 0;
+        while (num_eviction_candidates < batch_size && total_clock_steps < num_clock_words) {
+            const size_t clock_step = std::min(PAGE_STATE_CLOCK_STEP_WORDS, num_clock_words);
+            const size_t current_clock = clock.fetch_add(clock_step);
+            for (size_t i = 0; i < clock_step && num_eviction_candidates < batch_size; ++i) {
+                const size_t word = getWord((current_clock + i) % num_clock_words, regular_words);
+                uint64_t bits = residency[word].load(std::memory_order_relaxed);
+                while (bits != 0 && num_eviction_candidates < batch_size) {
+                    const PageId pid = word * 64 + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    selectClockCandidate(pid, eviction_candidates, num_eviction_candidates, dirty_selection, dirty_pages);
+                }
+            }
+            total_clock_steps += clock_step;
+        }
+        return num_eviction_candidates;
+    }
+
+    inline void removeEvicted(const PageId pid) {
+        residency[pid / 64].fetch_and(~(1ull << (pid % 64)));
+    }
+
+    inline size_t getFlushCandidates(const size_t batch_size, PageId* latched_pids, uint32_t) {
+        const size_t regular_words = getNumRegularWords();
+        const size_t num_clock_words = regular_words + (spill_end_word.load() - spill_begin_word);
+        if (num_clock_words == 0)
+            return 0;
+        // visit at most 'batch_size' resident pages, like the flush clock of 'HashSetCachePartition' visits 'batch_size' buckets
+        size_t num_latched = 0;
+        size_t num_visited = 0;
+        for (size_t i = 0; i < num_clock_words && num_visited < batch_size; i++) {
+            const size_t word = getWord(flush_clock.fetch_add(1) % num_clock_words, regular_words);
+            uint64_t bits = residency[word].load(std::memory_order_relaxed);
+            while (bits != 0 && num_latched < batch_size) {
+                const PageId pid = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                num_visited++;
+                tryLatchForFlush(pid, latched_pids, num_latched);
+            }
+        }
+        return num_latched;
+    }
+
+    inline void notifyDroppedImpl(const PageId pid) {
+        removeEvicted(pid);
+    }
+
+    inline bool isCached(const PageId pid) const {
+        return (residency[pid / 64].load() >> (pid % 64)) & 1ull;
+    }
+
+    size_t getNumLatchedPages(PageId max_pid) const {
+        const size_t regular_words = getNumRegularWords();
+        const size_t num_clock_words = regular_words + (spill_end_word.load() - spill_begin_word);
+        size_t result = 0;
+        for (size_t i = 0; i < num_clock_words; i++) {
+            const size_t word = getWord(i, regular_words);
+            uint64_t bits = residency[word].load();
+            while (bits != 0) {
+                const PageId pid = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (pid > max_pid)
+                    continue;
+                const uint8_t state = PAGE_STATE(loadState(pid));
+                if ((state >= PAGE_STATE_LOCKED_SHARED_MIN && state <= PAGE_STATE_LOCKED_SHARED_MAX) || state == PAGE_STATE_LOCKED)
+                    result++;
+            }
+        }
+        return result;
+    }
+
+    // the residency bitmap has one bit per page state entry rather than per frame, so it is accounted by 'getPageStateMemoryCost()'
+    static size_t getPerPageMemoryCost() {
+        return 0;
+    }
+
+    static size_t getPageStateMemoryCost(const size_t num_page_states) {
+        return (num_page_states + 63) / 64 * sizeof(std::atomic_uint64_t);
+    }
+
+    static size_t getConstantMemoryCost(const size_t) {
+        return sizeof(PageStateClockCachePartition);
+    }
+
+private:
+    // number of bitmap words the clock hand advances at once (i.e., up to 256 pages)
+    static constexpr size_t PAGE_STATE_CLOCK_STEP_WORDS = 4;
+
+    inline size_t getNumRegularWords() const {
+        return (vmcache.getNumAllocatedPages() + 63) / 64;
+    }
+
+    // maps a clock position onto a bitmap word, positions behind the regular page range address the spill area
+    inline size_t getWord(size_t position, size_t regular_words) const {
+        return position < regular_words ? position : spill_begin_word + (position - regular_words);
+    }
+
+    const size_t num_words;
+    const size_t spill_begin_word;
+    std::atomic_uint64_t spill_end_word;
+    std::atomic_uint64_t clock;
+    std::atomic_uint64_t flush_clock;
+    std::atomic_uint64_t* residency;
+};
+
 
 template <template <class T> class Strategy, typename... Arguments>
 std::unique_ptr<PartitioningStrategy> createPartitioningStrategy(const std::string& eviction_policy, Arguments... args) {
@@ -549,6 +1053,10 @@ std::unique_ptr<PartitioningStrategy> createPartitioningStrategy(const std::stri
         return std::make_unique<Strategy<RandomEvictionCachePartition>>(args...);
     } else if (eviction_policy == "mru") {
         return std::make_unique<Strategy<MRUEvictionCachePartition>>(args...);
+    } else if (eviction_policy == "2q") {
+        return std::make_unique<Strategy<TwoQueueEvictionCachePartition>>(args...);
+    } else if (eviction_policy == "state_clock") {
+        return std::make_unique<Strategy<PageStateClockCachePartition>>(args...);
     }
     return nullptr;
 }
@@ -556,4 +1064,6 @@ std::unique_ptr<PartitioningStrategy> createPartitioningStrategy(const std::stri
 #define INSTANTIATE_PARTITIONING_STRATEGY(strategy) \
 template class strategy<ClockEvictionCachePartition>; \
 template class strategy<RandomEvictionCachePartition>; \
-template class strategy<MRUEvictionCachePartition>;
+template class strategy<MRUEvictionCachePartition>; \
+template class strategy<TwoQueueEvictionCachePartition>; \
+template class strategy<PageStateClockCachePartition>;
@@ -0,0 +1,123 @@
+#include "cache_simulator.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../vmcache.hpp"
+#include "basic_partitioning_strategy.hpp"
+#include "cache_partition.hpp"
+
+static inline bool isAccess(const CacheAction action) {
+    return action == CacheAction::Ref || action == CacheAction::Write || action == CacheAction::ScanRef;
+}
+
+std::vector<CacheTraceEntry> readCacheTraces(const std::vector<std::string>& paths) {
+    std::vector<CacheTraceEntry> result;
+    for (const std::string& path : paths) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw std::runtime_error("Failed to open cache trace file " + path);
+        struct stat st;
+        fstat(fd, &st);
+        const size_t num_entries = st.st_size / sizeof(CacheTraceEntry);
+        const size_t offset = result.size();
+        result.resize(offset + num_entries, CacheTraceEntry(0.0, CacheAction::Ref, 0));
+        const ssize_t len = num_entries * sizeof(CacheTraceEntry);
+        if (pread(fd, result.data() + offset, len, 0) != len) {
+            close(fd);
+            throw std::runtime_error("Failed to read cache trace file " + path);
+        }
+        close(fd);
+    }
+    // workers write their trace entries in batches, so the entries of the file(s) are only partially ordered
+    std::stable_sort(result.begin(), result.end(), [](const CacheTraceEntry& a, const CacheTraceEntry& b) { return a.timestamp < b.timestamp; });
+    return result;
+}
+
+size_t getCacheTraceFootprint(const std::vector<CacheTraceEntry>& trace) {
+    std::unordered_set<PageId> pids;
+    for (const CacheTraceEntry& entry : trace) {
+        if (isAccess(entry.getAction()))
+            pids.insert(entry.getPid());
+    }
+    return pids.size();
+}
+
+CacheSimulationResult simulateCache(const std::vector<CacheTraceEntry>& trace, const std::string& eviction_policy, size_t num_frames, const std::string& db_path, uint64_t read_ns, uint64_t write_ns) {
+    PageId max_pid = 0;
+    for (const CacheTraceEntry& entry : trace) {
+        if (isAccess(entry.getAction()))
+            max_pid = std::max(max_pid, entry.getPid());
+    }
+    // spillable pages are simulated as regular data pages
+    const size_t virtual_pages = max_pid + 1;
+
+    std::unique_ptr<PartitioningStrategy> partitioning_strategy = createPartitioningStrategy<BasicPartitioningStrategy>(eviction_policy);
+    if (!partitioning_strategy)
+        throw std::runtime_error("Unknown eviction policy " + eviction_policy);
+    // inverse of the computation of the number of physical pages in VMCache's constructor
+    const size_t max_size = sizeof(VMCache) + sizeof(VMCacheStats) + partitioning_strategy->getConstantMemoryCost(1) + (virtual_pages + SPILL_AREA_PAGES(virtual_pages)) * sizeof(PageState) + partitioning_strategy->getPageStateMemoryCost(virtual_pages + SPILL_AREA_PAGES(virtual_pages)) + num_frames * (PAGE_SIZE + partitioning_strategy->getPerPageMemoryCost());
+
+    // all traced pages exist (but are never actually written to) in the sparse scratch file
+    unlink(db_path.c_str());
+    const int fd = open(db_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1 || ftruncate(fd, virtual_pages * PAGE_SIZE) != 0)
+        throw std::runtime_error("Failed to create cache simulation scratch file " + db_path);
+    close(fd);
+
+    CacheSimulationResult result { eviction_policy, num_frames, 0, 0, 0, 0 };
+    {
+        VMCacheConfig config;
+        config.max_size = max_size;
+        config.virtual_pages = virtual_pages;
+        config.path = db_path;
+        VMCache vmcache(config, std::move(partitioning_strategy));
+        vmcache.getEvictionCosts().setFixedLatencies(read_ns, write_ns);
+        // live temporary allocations by their number of pages, a drop releases any allocation of the same size
+        std::unordered_map<size_t, std::vector<char*>> temp_allocations;
+        for (const CacheTraceEntry& entry : trace) {
+            const CacheAction action = entry.getAction();
+            if (action == CacheAction::TempAllocate) {
+                temp_allocations[entry.getPid()].push_back(vmcache.allocateTemporaryHugePage(entry.getPid(), 0));
+                continue;
+            }
+            if (action == CacheAction::TempDrop) {
+                // the trace may begin after the allocation was made
+                auto it = temp_allocations.find(entry.getPid());
+                if (it != temp_allocations.end() && !it->second.empty()) {
+                    vmcache.dropTemporaryHugePage(it->second.back(), entry.getPid(), 0);
+                    it->second.pop_back();
+                }
+                continue;
+            }
+            if (!isAccess(action))
+                continue;
+            const PageId pid = entry.getPid();
+            result.num_accesses++;
+            if (PAGE_STATE(vmcache.getPageState(pid).load()) == PAGE_STATE_EVICTED)
+                result.num_faults++;
+            if (action == CacheAction::Write) {
+                vmcache.fixExclusive(pid, 0);
+                vmcache.unfixExclusive(pid);
+            } else {
+                vmcache.fixShared(pid, 0, action == CacheAction::ScanRef);
+                vmcache.unfixShared(pid);
+            }
+        }
+        result.num_dirty_writes = vmcache.getPartitions().getTotalDirtyWritePageCount();
+        for (auto& [num_pages, pages] : temp_allocations) {
+            for (char* page : pages)
+                vmcache.dropTemporaryHugePage(page, num_pages, 0);
+        }
+    }
+    unlink(db_path.c_str());
+    unlink((db_path + ".shadow").c_str());
+
+    result.simulated_io_ns = result.num_faults * read_ns + result.num_dirty_writes * write_ns;
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cache_trace.hpp"
+
+struct CacheSimulationResult {
+    std::string eviction_policy;
+    size_t num_frames;
+    size_t num_accesses; // number of replayed page accesses (Ref, ScanRef and Write entries)
+    size_t num_faults;
+    size_t num_dirty_writes;
+    uint64_t simulated_io_ns; // faults and dirty writes weighted with the read and write latencies passed to 'simulateCache()'
+
+    double getHitRatio() const { return num_accesses == 0 ? 0.0 : 1.0 - static_cast<double>(num_faults) / num_accesses; }
+};
+
+// reads the entries of one or more trace files written by 'CacheTracer' (e.g., one per partition) and orders them by their timestamps
+std::vector<CacheTraceEntry> readCacheTraces(const std::vector<std::string>& paths);
+
+// number of distinct pages accessed in the trace
+size_t getCacheTraceFootprint(const std::vector<CacheTraceEntry>& trace);
+
+/*
+Replays the page accesses of a cache trace against a VMCache instance with a single partition of 'num_frames' frames
+that uses the given eviction policy (see 'createPartitioningStrategy()'), using a single worker. The Evict and Fault
+entries of the trace record the decisions of the traced policy and are skipped. Temporary allocations are replayed as
+well, so that they take frames away from the data pages as they did in the traced run. Pages are read from and written to a
+sparse scratch file at 'db_path', which is removed afterwards; its actual I/O latencies are not representative, so the
+eviction cost model is fixed to 'read_ns' and 'write_ns' per page instead.
+*/
+CacheSimulationResult simulateCache(const std::vector<CacheTraceEntry>& trace, const std::string& eviction_policy, size_t num_frames, const std::string& db_path, uint64_t read_ns, uint64_t write_ns);
\ No newline at end of file
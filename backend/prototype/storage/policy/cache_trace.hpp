@@ -1,5 +1,14 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
 #include <fcntl.h>
+#include <stdexcept>
 #include <stdint.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 
 #include "../../core/units.hpp"
 
@@ -8,7 +17,11 @@
 enum class CacheAction : uint8_t {
     Evict = 1,
     Fault = 2,
-    Ref = 3 // note: for now we do not actually trace page references, but this may be implemented later on
+    Ref = 3, // every shared or optimistic latch of a page (whether it was resident or not), see 'VMCache::traceAccess()'
+    Write = 4, // every exclusive latch of a page
+    ScanRef = 5, // shared latch by a scan
+    TempAllocate = 6, // allocation of temporary pages, the entry's pid holds the number of pages (see 'VMCache::allocateTemporaryPages()')
+    TempDrop = 7 // temporary pages were dropped, the entry's pid holds the number of pages
 };
 
 struct CacheTraceEntry {
@@ -30,26 +43,42 @@ public:
     : page_traces(num_workers)
     , begin(std::chrono::system_clock::now())
     , trace_offset(0)
-    , trace_fd(open("cache.trc", O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) {
+    , trace_fd(open(getTraceFileName().c_str(), O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) {
         for (auto& trace : page_traces)
             trace.reserve(THREAD_LOCAL_TRACE_SIZE);
         if (trace_fd == -1)
             throw std::runtime_error("Failed to open cache trace file");
     }
 
+    ~CacheTracer() {
+        for (auto& trace : page_traces)
+            flush(trace);
+        close(trace_fd);
+    }
+
     void trace(const CacheAction action, const PageId pid, uint32_t worker_id) {
         double timestamp = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::system_clock::now() - begin).count();
         auto& trace = page_traces[worker_id];
         trace.emplace_back(timestamp, action, pid);
-        if (trace.size() == THREAD_LOCAL_TRACE_SIZE) {
-            const size_t sz = THREAD_LOCAL_TRACE_SIZE * sizeof(CacheTraceEntry);
-            size_t offset = trace_offset.fetch_add(sz, std::memory_order_relaxed);
-            pwrite(trace_fd, trace.data(), sz, offset);
-            trace.clear();
-        }
+        if (trace.size() == THREAD_LOCAL_TRACE_SIZE)
+            flush(trace);
     }
 
 private:
+    // each partition traces into its own file: the first one into "cache.trc", further ones into "cache_<n>.trc"
+    static std::string getTraceFileName() {
+        static std::atomic_size_t num_tracers(0);
+        const size_t n = num_tracers++;
+        return n == 0 ? "cache.trc" : "cache_" + std::to_string(n) + ".trc";
+    }
+
+    void flush(std::vector<CacheTraceEntry>& trace) {
+        const size_t sz = trace.size() * sizeof(CacheTraceEntry);
+        size_t offset = trace_offset.fetch_add(sz, std::memory_order_relaxed);
+        pwrite(trace_fd, trace.data(), sz, offset);
+        trace.clear();
+    }
+
     std::vector<std::vector<CacheTraceEntry>> page_traces;
     std::chrono::time_point<std::chrono::system_clock> begin;
     std::atomic_size_t trace_offset;
@@ -1,52 +1,170 @@
 #include "data_temp_partitioning_strategy.hpp"
 
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 
 #include "cache_partition.hpp"
 
+static int64_t getCurrentTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 template <class PartitionType>
-DataTempPartitioningStrategy<PartitionType>::DataTempPartitioningStrategy(const size_t temporary_page_reservation)
-    : max_temp_physical_pages(temporary_page_reservation) {}
+DataTempPartitioningStrategy<PartitionType>::DataTempPartitioningStrategy(const size_t temporary_page_reservation, const bool adaptive)
+    : initial_temp_physical_pages(temporary_page_reservation)
+    , adaptive(adaptive)
+    , last_adaptation_us(0)
+    , temp_allocation_wait_us(0)
+    , temp_allocation_wait_cost_ns(0)
+    , last_data_evictions(0)
+    , last_data_dirty_writes(0)
+    , num_resizes(0)
+    , max_overshoot_pages(0) {}
 
 template <class PartitionType>
 void DataTempPartitioningStrategy<PartitionType>::setVMCache(VMCache* vmcache, const size_t num_workers) {
     PartitioningStrategy::setVMCache(vmcache, num_workers);
-    if (vmcache->getMaxPhysicalPages() <= max_temp_physical_pages)
+    const size_t max_physical_pages = vmcache->getMaxPhysicalPages();
+    if (max_physical_pages <= initial_temp_physical_pages)
         throw std::runtime_error("Invalid partitioned eviction policy configuration: Temporary page reservation exceeds VMCache's maximum physical page count!");
     // ~66% load factor at peak for both hash sets
-    partitions[0] = std::make_unique<PartitionType>(*vmcache, vmcache->getMaxPhysicalPages() - max_temp_physical_pages, physical_data_pages, physical_temp_pages, num_workers);
-    partitions[1] = std::make_unique<PartitionType>(*vmcache, max_temp_physical_pages, physical_data_pages, physical_temp_pages, num_workers);
+    if (adaptive) {
+        // either partition may grow to (almost) the entire cache, so size their data structures accordingly
+        partitions[0] = std::make_unique<PartitionType>(*vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers);
+        partitions[1] = std::make_unique<PartitionType>(*vmcache, max_physical_pages, physical_data_pages, physical_temp_pages, num_workers);
+        partitions[0]->setMaxPhysicalPages(max_physical_pages - initial_temp_physical_pages);
+        partitions[1]->setMaxPhysicalPages(initial_temp_physical_pages);
+        last_adaptation_us = getCurrentTimeUs();
+    } else {
+        partitions[0] = std::make_unique<PartitionType>(*vmcache, max_physical_pages - initial_temp_physical_pages, physical_data_pages, physical_temp_pages, num_workers);
+        partitions[1] = std::make_unique<PartitionType>(*vmcache, initial_temp_physical_pages, physical_data_pages, physical_temp_pages, num_workers);
+    }
 }
 
 template <class PartitionType>
-void DataTempPartitioningStrategy<PartitionType>::prepareTempAllocation(size_t num_pages, uint32_t worker_id) {
+void DataTempPartitioningStrategy<PartitionType>::prepareTempAllocation(size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns) {
+    if (!adaptive) {
+        partitions[1]->prepareTempAllocation(num_pages, worker_id);
+        return;
+    }
+    if (partitions[1]->getPhysicalPageTarget() + num_pages <= partitions[1]->getMaxPhysicalPages()) {
+        partitions[1]->prepareTempAllocation(num_pages, worker_id);
+        return;
+    }
+    // make room for allocations that do not fit into the temporary partition instead of waiting for other workers to release memory
+    const int64_t begin = getCurrentTimeUs();
+    const size_t grown_pages = growTempPartition(num_pages, worker_id);
     partitions[1]->prepareTempAllocation(num_pages, worker_id);
+    // the data partition is shrunk outside of the resize mutex, so the total may exceed the cache's capacity until its evictions catch up
+    const int64_t overshoot = physical_data_pages.load() + physical_temp_pages.load() - static_cast<int64_t>(vmcache->getMaxPhysicalPages());
+    uint64_t max_overshoot = max_overshoot_pages.load();
+    while (overshoot > static_cast<int64_t>(max_overshoot) && !max_overshoot_pages.compare_exchange_weak(max_overshoot, overshoot)) { }
+    temp_allocation_wait_us += std::max<int64_t>(getCurrentTimeUs() - begin, 1); // note: any allocation that did not fit counts as waiting
+    // without the memory given to the temporary partition, temporary data would have had to be recomputed or spilled
+    temp_allocation_wait_cost_ns += grown_pages * vmcache->getEvictionCosts().getTempPageCost(page_cost_ns);
+}
+
+template <class PartitionType>
+size_t DataTempPartitioningStrategy<PartitionType>::growTempPartition(size_t num_pages, uint32_t worker_id) {
+    size_t grown_pages;
+    {
+        std::lock_guard<std::mutex> guard(resize_mutex);
+        const size_t max_physical_pages = vmcache->getMaxPhysicalPages();
+        const size_t min_data_physical_pages = max_physical_pages / 10; // always leave some memory to the data partition to avoid thrashing
+        const size_t demand = partitions[1]->getPhysicalPageTarget() + num_pages;
+        const size_t temp_max = partitions[1]->getMaxPhysicalPages();
+        if (demand <= temp_max)
+            return 0; // another worker has already grown the partition
+        // grow in steps of at least 1/64 of the cache to amortize resizing
+        const size_t new_temp_max = std::min(std::max(demand, temp_max + max_physical_pages / 64), max_physical_pages - min_data_physical_pages);
+        if (new_temp_max <= temp_max)
+            return 0;
+        partitions[0]->setMaxPhysicalPages(max_physical_pages - new_temp_max);
+        partitions[1]->setMaxPhysicalPages(new_temp_max);
+        num_resizes++;
+        grown_pages = new_temp_max - temp_max;
+    }
+    // shrink the data partition before the temporary allocation, but without blocking other resizes; if data pages cannot be evicted right now, the total memory limit is exceeded until the data partition's fault path has evicted them
+    partitions[0]->shrink(worker_id);
+    return grown_pages;
+}
+
+template <class PartitionType>
+void DataTempPartitioningStrategy<PartitionType>::adaptPeriodically() {
+    const int64_t now = getCurrentTimeUs();
+    int64_t last = last_adaptation_us.load();
+    if (now - last < PARTITION_ADAPTATION_INTERVAL_US || !last_adaptation_us.compare_exchange_strong(last, now))
+        return;
+    adapt();
+}
+
+template <class PartitionType>
+void DataTempPartitioningStrategy<PartitionType>::adapt() {
+    if (!adaptive)
+        return;
+    std::unique_lock<std::mutex> guard(resize_mutex, std::try_to_lock);
+    if (!guard.owns_lock())
+        return;
+    const size_t data_evictions = partitions[0]->getTotalEvictedPageCount();
+    const size_t new_data_evictions = data_evictions - last_data_evictions;
+    last_data_evictions = data_evictions;
+    const size_t data_dirty_writes = partitions[0]->getTotalDirtyWritePageCount();
+    const size_t new_data_dirty_writes = data_dirty_writes - last_data_dirty_writes;
+    last_data_dirty_writes = data_dirty_writes;
+    const uint64_t wait_cost_ns = temp_allocation_wait_us.exchange(0) * 1000 + temp_allocation_wait_cost_ns.exchange(0);
+    // the dirty pages are the write-back queue: the longer it is, the more of the next data evictions have to write pages, even if page cleaners or
+    //  asynchronous flushing kept the writes of the last interval low
+    const double dirty_fraction = std::min(1.0, static_cast<double>(vmcache->getDirtyPageCount()) / std::max<int64_t>(physical_data_pages.load(), 1));
+    const size_t expected_dirty_writes = std::max(new_data_dirty_writes, static_cast<size_t>(new_data_evictions * dirty_fraction));
+    // only shrink the temporary partition if losing data pages (re-reading evicted pages, writing dirty ones) was more expensive than making temporary allocations fit
+    const EvictionCostModel& costs = vmcache->getEvictionCosts();
+    const uint64_t data_cost_ns = new_data_evictions * costs.getCleanPageCost() + expected_dirty_writes * (costs.getDirtyPageCost() - costs.getCleanPageCost());
+    if (data_cost_ns <= wait_cost_ns)
+        return;
+    const size_t max_physical_pages = vmcache->getMaxPhysicalPages();
+    const size_t temp_max = partitions[1]->getMaxPhysicalPages();
+    const size_t temp_used = std::max(partitions[1]->getPhysicalPageTarget(), partitions[1]->getPhysicalPageCount());
+    if (temp_used >= temp_max || temp_max - temp_used < max_physical_pages / 64)
+        return;
+    // hand back half of the unused temporary memory at a time
+    const size_t new_temp_max = temp_max - (temp_max - temp_used) / 2;
+    partitions[1]->setMaxPhysicalPages(new_temp_max);
+    partitions[0]->setMaxPhysicalPages(max_physical_pages - new_temp_max);
+    num_resizes++;
 }
 
 template <class PartitionType>
 void DataTempPartitioningStrategy<PartitionType>::preFault(const PageId pid, bool scan, uint32_t worker_id) {
-    partitions[0]->handleFault(pid, scan, worker_id);
+    // data faults also adapt the partitions, so that unused temporary memory is handed back even if no worker is idle (checking the interval is cheap compared to the fault's I/O)
+    if (adaptive && !vmcache->isSpillablePage(pid))
+        adaptPeriodically();
+    getPartition(pid).handleFault(pid, scan, worker_id);
 }
 
 template <class PartitionType>
 void DataTempPartitioningStrategy<PartitionType>::ref(const PageId pid, bool scan, uint32_t worker_id) {
-    partitions[0]->ref(pid, scan, worker_id);
+    getPartition(pid).ref(pid, scan, worker_id);
 }
 
 template <class PartitionType>
 void DataTempPartitioningStrategy<PartitionType>::notifyDropped(const PageId pid, uint32_t worker_id) {
-    partitions[0]->notifyDropped(pid, worker_id);
+    getPartition(pid).notifyDropped(pid, worker_id);
 }
 
 template <class PartitionType>
-void DataTempPartitioningStrategy<PartitionType>::notifyTempDropped(size_t num_pages) {
+void DataTempPartitioningStrategy<PartitionType>::traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) {
+    getPartition(pid).traceAccess(pid, action, worker_id);
+}
+
+template <class PartitionType>
+void DataTempPartitioningStrategy<PartitionType>::notifyTempDropped(size_t num_pages, uint32_t) {
     partitions[1]->notifyTempDropped(num_pages);
 }
 
 template <class PartitionType>
 size_t DataTempPartitioningStrategy<PartitionType>::getPerPageMemoryCost() const {
-    return PartitionType::getPerPageMemoryCost();
+    return adaptive ? 2 * PartitionType::getPerPageMemoryCost() : PartitionType::getPerPageMemoryCost();
 }
 
 template <class PartitionType>
@@ -54,6 +172,11 @@ size_t DataTempPartitioningStrategy<PartitionType>::getConstantMemoryCost(const
     return sizeof(DataTempPartitioningStrategy) + 2 * PartitionType::getConstantMemoryCost(num_workers);
 }
 
+template <class PartitionType>
+size_t DataTempPartitioningStrategy<PartitionType>::getPageStateMemoryCost(const size_t num_page_states) const {
+    return 2 * PartitionType::getPageStateMemoryCost(num_page_states);
+}
+
 template <class PartitionType>
 size_t DataTempPartitioningStrategy<PartitionType>::getNumLatchedPages(PageId max_pid) const {
     return partitions[0]->getNumLatchedPages(max_pid) + partitions[1]->getNumLatchedPages(max_pid);
@@ -61,9 +184,19 @@ size_t DataTempPartitioningStrategy<PartitionType>::getNumLatchedPages(PageId ma
 
 template <class PartitionType>
 bool DataTempPartitioningStrategy<PartitionType>::performIdleMaintenance(uint32_t worker_id) {
+    if (adaptive)
+        adaptPeriodically();
     return partitions[0]->performIdleMaintenance(worker_id);
 }
 
+template <class PartitionType>
+bool DataTempPartitioningStrategy<PartitionType>::performCleaning(uint32_t worker_id, size_t free_pages) {
+    if (adaptive)
+        adaptPeriodically();
+    // only data pages are cleaned, the temporary partition's frames are freed by dropping temporary pages (its spillable pages are spilled on demand)
+    return partitions[0]->clean(worker_id, free_pages);
+}
+
 template <class PartitionType>
 void DataTempPartitioningStrategy<PartitionType>::printMemoryUsage() const {
     std::cout << "[vmcache] " << "Data: ";
@@ -83,6 +216,8 @@ void DataTempPartitioningStrategy<PartitionType>::printStats() const {
     partitions[1]->printEvictionStats();
     std::cout << "[vmcache] " << "Temp dirty w: ";
     partitions[1]->printDirtyWriteStats();
+    if (adaptive)
+        std::cout << "[vmcache] " << "Partition resizes: " << num_resizes.load() << " (capacity exceeded by up to " << max_overshoot_pages.load() << " pages)" << std::endl;
 }
 
 template <class PartitionType>
@@ -95,5 +230,10 @@ size_t DataTempPartitioningStrategy<PartitionType>::getTotalDirtyWritePageCount(
     return partitions[0]->getTotalDirtyWritePageCount() + partitions[1]->getTotalDirtyWritePageCount();
 }
 
+template <class PartitionType>
+size_t DataTempPartitioningStrategy<PartitionType>::getMaxTempPhysicalPages() const {
+    return partitions[1]->getMaxPhysicalPages();
+}
+
 
 INSTANTIATE_PARTITIONING_STRATEGY(DataTempPartitioningStrategy)
\ No newline at end of file
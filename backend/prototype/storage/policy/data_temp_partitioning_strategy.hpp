@@ -1,32 +1,76 @@
 #pragma once
 
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 #include "../vmcache.hpp"
 
+// interval in which the split between the data and the temporary partition is re-evaluated when resizing adaptively
+#define PARTITION_ADAPTATION_INTERVAL_US 10000
+
+/*
+Partitioning strategy that uses separate partitions for data pages and temporary pages.
+If 'adaptive' is set, 'temporary_page_reservation' is only the initial size of the temporary partition: temporary
+allocations that do not fit into it grow it on demand (evicting data pages), while unused temporary memory is periodically
+handed back to the data partition if losing data pages was more costly than growing the temporary partition during the
+last interval (by idle workers, page cleaners and data page faults, so that a saturated system adapts as well); both
+costs are estimated using VMCache's 'EvictionCostModel' (temporary pages are valued at the recomputation cost hinted by
+their allocations, data pages at the measured I/O latencies, taking the backlog of dirty pages into account).
+Spillable temporary pages belong to the temporary partition, which spills them when temporary allocations need their frames.
+*/
 template <class PartitionType>
 class DataTempPartitioningStrategy : public PartitioningStrategy {
 public:
-    DataTempPartitioningStrategy(const size_t temporary_page_reservation);
+    DataTempPartitioningStrategy(const size_t temporary_page_reservation, const bool adaptive = false);
 
     void setVMCache(VMCache* vmcache, const size_t num_workers) override;
-    void prepareTempAllocation(size_t num_pages, uint32_t worker_id);
+    void prepareTempAllocation(size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns) override;
     void preFault(const PageId pid, bool scan, uint32_t worker_id) override;
     void ref(const PageId pid, bool scan, uint32_t worker_id) override;
     void notifyDropped(const PageId pid, uint32_t worker_id) override;
-    void notifyTempDropped(size_t num_pages) override;
+    void traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) override;
+    void notifyTempDropped(size_t num_pages, uint32_t worker_id) override;
     bool performIdleMaintenance(uint32_t worker_id) override;
+    bool performCleaning(uint32_t worker_id, size_t free_pages) override;
     size_t getPerPageMemoryCost() const override;
     size_t getConstantMemoryCost(const size_t num_workers) const override;
+    size_t getPageStateMemoryCost(const size_t num_page_states) const override;
     size_t getNumLatchedPages(PageId max_pid) const override;
     void printMemoryUsage() const override;
     void printStats() const override;
     size_t getTotalEvictedPageCount() const override;
     size_t getTotalDirtyWritePageCount() const override;
 
+    size_t getMaxTempPhysicalPages() const;
+    size_t getNumResizes() const { return num_resizes.load(); }
+    // largest number of pages by which both partitions together exceeded the cache's capacity after growing the temporary partition (see 'growTempPartition()')
+    size_t getMaxOvershootPages() const { return max_overshoot_pages.load(); }
+    // ends the current adaptation interval and hands unused temporary memory back to the data partition if that is expected to pay off; called every PARTITION_ADAPTATION_INTERVAL_US (see 'adaptPeriodically()')
+    void adapt();
+
 private:
+    // data pages are managed by the first partition, spillable temporary pages by the second one
+    inline PartitionType& getPartition(const PageId pid) {
+        return *partitions[vmcache->isSpillablePage(pid) ? 1 : 0];
+    }
+
+    // returns the number of pages the temporary partition has grown by
+    size_t growTempPartition(size_t num_pages, uint32_t worker_id);
+    void adaptPeriodically();
+
     std::unique_ptr<PartitionType> partitions[2];
-    const size_t max_temp_physical_pages;
+    const size_t initial_temp_physical_pages;
+    const bool adaptive;
+    std::mutex resize_mutex;
+    // statistics of the current adaptation interval
+    std::atomic_int64_t last_adaptation_us;
+    std::atomic_uint64_t temp_allocation_wait_us;
+    std::atomic_uint64_t temp_allocation_wait_cost_ns;
+    size_t last_data_evictions;
+    size_t last_data_dirty_writes;
+    std::atomic_uint64_t num_resizes;
+    std::atomic_uint64_t max_overshoot_pages;
 };
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "numa_partitioning_strategy.hpp"
+
+#include <cassert>
+#include <iomanip>
+#include <iostream>
+#include <numa.h>
+#include <sched.h>
+#include <string>
+
+#include "../vmcache.hpp"
+#include "cache_partition.hpp"
+
+static size_t getSystemNUMANodeCount() {
+    if (numa_available() < 0)
+        return 1;
+    return static_cast<size_t>(numa_max_node()) + 1;
+}
+
+template <class PartitionType>
+NUMAPartitioningStrategy<PartitionType>::NUMAPartitioningStrategy(const size_t num_nodes)
+    : num_nodes(num_nodes == 0 ? getSystemNUMANodeCount() : num_nodes) {
+    if (this->num_nodes > PAGE_MAX_NODES)
+        throw std::runtime_error("Invalid NUMA partitioning strategy configuration: the node of a page is recorded in its page state, which supports at most " + std::to_string(PAGE_MAX_NODES) + " nodes!");
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::setVMCache(VMCache* vmcache, const size_t num_workers) {
+    PartitioningStrategy::setVMCache(vmcache, num_workers);
+    if (vmcache->getMaxPhysicalPages() < num_nodes)
+        throw std::runtime_error("Invalid NUMA partitioning strategy configuration: VMCache's maximum physical page count is smaller than the number of NUMA nodes!");
+    // split the buffer pool evenly, the first partition gets the remainder
+    const size_t pages_per_node = vmcache->getMaxPhysicalPages() / num_nodes;
+    partitions.reserve(num_nodes);
+    for (size_t i = 0; i < num_nodes; i++) {
+        const size_t partition_pages = i == 0 ? vmcache->getMaxPhysicalPages() - pages_per_node * (num_nodes - 1) : pages_per_node;
+        partitions.push_back(std::make_unique<PartitionType>(*vmcache, partition_pages, physical_data_pages, physical_temp_pages, num_workers));
+    }
+    worker_nodes = std::make_unique<std::atomic_int[]>(num_workers);
+    for (size_t i = 0; i < num_workers; i++)
+        worker_nodes[i] = -1;
+    std::cout << "[vmcache] " << "Using " << num_nodes << " NUMA partitions with " << pages_per_node << " pages each" << std::endl;
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getNode(uint32_t worker_id) {
+    int node = worker_nodes[worker_id].load(std::memory_order_relaxed);
+    if (__builtin_expect(node < 0, false)) {
+        const int cpu = sched_getcpu();
+        node = (cpu >= 0 && numa_available() >= 0) ? numa_node_of_cpu(cpu) : 0;
+        if (node < 0)
+            node = 0;
+        node %= static_cast<int>(num_nodes);
+        worker_nodes[worker_id].store(node, std::memory_order_relaxed);
+    }
+    return static_cast<size_t>(node);
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::setNode(uint32_t worker_id, size_t node) {
+    assert(node < num_nodes);
+    worker_nodes[worker_id].store(static_cast<int>(node), std::memory_order_relaxed);
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getOwningNode(const PageId pid) const {
+    const uint64_t s = vmcache->getPageState(pid).load();
+    return PAGE_STATE(s) == PAGE_STATE_EVICTED ? num_nodes : PAGE_NODE(s);
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::prepareTempAllocation(size_t num_pages, uint32_t worker_id, uint64_t) {
+    partitions[getNode(worker_id)]->prepareTempAllocation(num_pages, worker_id);
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::preFault(const PageId pid, bool scan, uint32_t worker_id) {
+    const size_t node = getNode(worker_id);
+    // record the partition in the page state, which is latched exclusively by the faulting worker
+    PageState& state = vmcache->getPageState(pid);
+    uint64_t s = state.load();
+    while (!state.compare_exchange_weak(s, (s & ~PAGE_NODE_MASK) | (static_cast<uint64_t>(node) << PAGE_NODE_OFFSET))) { }
+    partitions[node]->handleFault(pid, scan, worker_id);
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::ref(const PageId pid, bool scan, uint32_t worker_id) {
+    if (num_nodes == 1) {
+        partitions[0]->ref(pid, scan, worker_id);
+        return;
+    }
+    partitions[PAGE_NODE(vmcache->getPageState(pid).load())]->ref(pid, scan, worker_id);
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::notifyDropped(const PageId pid, uint32_t worker_id) {
+    // dropped pages are latched exclusively and still resident
+    partitions[PAGE_NODE(vmcache->getPageState(pid).load())]->notifyDropped(pid, worker_id);
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) {
+    // accesses are traced by the partition that faults pages for the worker (see 'preFault()'), so that each trace file is consistent in itself
+    partitions[getNode(worker_id)]->traceAccess(pid, action, worker_id);
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::notifyTempDropped(size_t num_pages, uint32_t worker_id) {
+    partitions[getNode(worker_id)]->notifyTempDropped(num_pages);
+}
+
+template <class PartitionType>
+bool NUMAPartitioningStrategy<PartitionType>::performIdleMaintenance(uint32_t worker_id) {
+    // idle workers only maintain their local partition
+    return partitions[getNode(worker_id)]->performIdleMaintenance(worker_id);
+}
+
+template <class PartitionType>
+bool NUMAPartitioningStrategy<PartitionType>::performCleaning(uint32_t worker_id, size_t free_pages) {
+    // cleaners are not pinned to a node, so they maintain all partitions, each keeping its share of the free frames
+    bool more_work = false;
+    for (auto& partition : partitions)
+        more_work |= partition->clean(worker_id, free_pages / num_nodes);
+    return more_work;
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getPerPageMemoryCost() const {
+    return PartitionType::getPerPageMemoryCost();
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getConstantMemoryCost(const size_t num_workers) const {
+    return sizeof(NUMAPartitioningStrategy) + num_nodes * PartitionType::getConstantMemoryCost(num_workers) + num_workers * sizeof(std::atomic_int);
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getPageStateMemoryCost(const size_t num_page_states) const {
+    return num_nodes * PartitionType::getPageStateMemoryCost(num_page_states);
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getNumLatchedPages(PageId max_pid) const {
+    size_t result = 0;
+    for (const auto& partition : partitions)
+        result += partition->getNumLatchedPages(max_pid);
+    return result;
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::printMemoryUsage() const {
+    for (size_t i = 0; i < num_nodes; i++) {
+        std::cout << "[vmcache] " << "Node " << i << ": ";
+        partitions[i]->printMemoryUsage();
+    }
+}
+
+template <class PartitionType>
+void NUMAPartitioningStrategy<PartitionType>::printStats() const {
+    printMemoryUsage();
+    for (size_t i = 0; i < num_nodes; i++) {
+        std::cout << "[vmcache] " << "Node " << i << " evicted: ";
+        partitions[i]->printEvictionStats();
+        std::cout << "[vmcache] " << "Node " << i << " dirty w: ";
+        partitions[i]->printDirtyWriteStats();
+    }
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getTotalEvictedPageCount() const {
+    size_t result = 0;
+    for (const auto& partition : partitions)
+        result += partition->getTotalEvictedPageCount();
+    return result;
+}
+
+template <class PartitionType>
+size_t NUMAPartitioningStrategy<PartitionType>::getTotalDirtyWritePageCount() const {
+    size_t result = 0;
+    for (const auto& partition : partitions)
+        result += partition->getTotalDirtyWritePageCount();
+    return result;
+}
+
+INSTANTIATE_PARTITIONING_STRATEGY(NUMAPartitioningStrategy)
\ No newline at end of file
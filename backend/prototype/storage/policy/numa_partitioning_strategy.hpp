@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "partitioning_strategy.hpp"
+
+/*
+Partitioning strategy that uses one cache partition per NUMA node, each managing an equal share of the buffer pool.
+Pages are faulted into the partition of the node that the faulting worker runs on, which is recorded in the page state (see 'PAGE_NODE()'), so
+that references and drops are routed to that partition without a lookup.
+Frames are placed by first touch rather than by binding them with mbind(): evicted frames are released to the kernel, so every fault allocates a
+fresh frame, and the faulting worker touches it first (by reading the page into it, see 'VMCache::touchFrames()' for io_uring), which places it on
+the worker's node without an additional system call per fault. A frame thereby always resides on the node of the partition that accounts it, even
+as the set of pages a node accesses changes. With exmap, frames are provided by the kernel module and their placement is not controlled.
+As evictions only happen within a partition, each node's share of the buffer pool is kept in its local memory.
+Temporary allocations are accounted to the partition of the worker they are allocated for, also when another worker drops them (see 'TempBlockHeader').
+*/
+template <class PartitionType>
+class NUMAPartitioningStrategy : public PartitioningStrategy {
+public:
+    NUMAPartitioningStrategy(const size_t num_nodes = 0); // 0: use the number of NUMA nodes of the system
+
+    void setVMCache(VMCache* vmcache, const size_t num_workers) override;
+    void prepareTempAllocation(size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns) override;
+    void preFault(const PageId pid, bool scan, uint32_t worker_id) override;
+    void ref(const PageId pid, bool scan, uint32_t worker_id) override;
+    void notifyDropped(const PageId pid, uint32_t worker_id) override;
+    void traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) override;
+    void notifyTempDropped(size_t num_pages, uint32_t worker_id) override;
+    bool performIdleMaintenance(uint32_t worker_id) override;
+    bool performCleaning(uint32_t worker_id, size_t free_pages) override;
+    size_t getPerPageMemoryCost() const override;
+    size_t getConstantMemoryCost(const size_t num_workers) const override;
+    size_t getPageStateMemoryCost(const size_t num_page_states) const override;
+    size_t getNumLatchedPages(PageId max_pid) const override;
+    void printMemoryUsage() const override;
+    void printStats() const override;
+    size_t getTotalEvictedPageCount() const override;
+    size_t getTotalDirtyWritePageCount() const override;
+
+    size_t getNumNodes() const { return num_nodes; }
+    size_t getNode(uint32_t worker_id);
+    // assigns the worker to 'node' instead of the node it runs on
+    void setNode(uint32_t worker_id, size_t node);
+    // returns the node of the partition currently tracking the page, or 'getNumNodes()' if the page is evicted
+    size_t getOwningNode(const PageId pid) const;
+
+private:
+    const size_t num_nodes;
+    std::vector<std::unique_ptr<PartitionType>> partitions;
+    std::unique_ptr<std::atomic_int[]> worker_nodes; // NUMA node per worker, determined lazily from the CPU the worker runs on (workers are pinned by the JobManager)
+};
\ No newline at end of file
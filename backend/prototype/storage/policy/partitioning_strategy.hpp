@@ -4,6 +4,7 @@
 #include <cstddef>
 
 #include "../../core/units.hpp"
+#include "cache_trace.hpp"
 
 class VMCache;
 
@@ -14,14 +15,18 @@ public:
     , physical_temp_pages(0) { }
     virtual ~PartitioningStrategy() { };
 
-    virtual void prepareTempAllocation(size_t num_pages, uint32_t worker_id) = 0;
+    virtual void prepareTempAllocation(size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns) = 0; // 'page_cost_ns': the allocating operator's estimate of the cost of recomputing a page of the allocation, zero if unknown
+    //  note: only 'DataTempPartitioningStrategy' uses 'page_cost_ns', to account for the cost of temporary allocations that had to grow its temporary partition; the other strategies do not weigh temporary pages by their cost and ignore it
     virtual void preFault(const PageId pid, bool scan, uint32_t worker_id) = 0;
     virtual void ref(const PageId pid, bool scan, uint32_t worker_id) = 0;
     virtual void notifyDropped(const PageId pid, uint32_t worker_id) = 0;
-    virtual void notifyTempDropped(size_t num_pages) = 0;
+    virtual void traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) = 0; // only called if cache traces are collected (see 'VMCache::traceAccess()')
+    virtual void notifyTempDropped(size_t num_pages, uint32_t worker_id) = 0; // 'worker_id' identifies the worker that the temporary pages were allocated for
     virtual bool performIdleMaintenance(uint32_t worker_id) = 0;
+    virtual bool performCleaning(uint32_t worker_id, size_t free_pages) = 0; // called by page cleaner threads to keep 'free_pages' frames free, returns true if there is more work to do
     virtual size_t getPerPageMemoryCost() const = 0;
     virtual size_t getConstantMemoryCost(const size_t num_workers) const = 0;
+    virtual size_t getPageStateMemoryCost(const size_t num_page_states) const = 0; // memory that scales with the number of entries of VMCache's page state array (including the spill area)
     virtual void setVMCache(VMCache* vmcache, const size_t) { this->vmcache = vmcache; }
     virtual void printMemoryUsage() const = 0;
     virtual void printStats() const = 0;
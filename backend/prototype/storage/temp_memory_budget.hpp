@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/*
+Budget for the temporary memory of a single query (QEP). VMCache charges temporary allocations of workers that are
+executing on behalf of the query to its budget (see 'VMCache::exchangeTempMemoryBudget()'); each block remembers the
+budget it was charged to and uncharges it when it is dropped, no matter which worker drops it (see 'TempBlockHeader').
+The budget is not enforced by VMCache itself: the QEP delays starting further pipelines while it is exceeded, and
+breakers that materialize large intermediates move them into spillable batches (see 'Batch::spillIfOverBudget()').
+Note: pages allocated by spillable batches are not charged, as they can be evicted like regular data pages.
+Note: blocks may outlive the query (e.g., its result), so the budget is deleted once it has been released by its
+creator and no block is charged to it anymore.
+*/
+class alignas(64) TempMemoryBudget {
+public:
+    struct Releaser {
+        void operator()(TempMemoryBudget* budget) const { budget->release(); }
+    };
+
+    static std::unique_ptr<TempMemoryBudget, Releaser> create(size_t max_pages) {
+        return std::unique_ptr<TempMemoryBudget, Releaser>(new TempMemoryBudget(max_pages));
+    }
+
+    TempMemoryBudget(const TempMemoryBudget& other) = delete;
+    TempMemoryBudget& operator=(const TempMemoryBudget& other) = delete;
+
+    // called for each allocated block
+    inline void charge(size_t num_pages) {
+        num_references++;
+        const int64_t used = used_pages.fetch_add(static_cast<int64_t>(num_pages)) + static_cast<int64_t>(num_pages);
+        int64_t peak = peak_used_pages.load();
+        while (used > peak && !peak_used_pages.compare_exchange_weak(peak, used)) { }
+    }
+
+    // called for each dropped block that was charged to this budget, may delete the budget
+    inline void uncharge(size_t num_pages) {
+        used_pages -= static_cast<int64_t>(num_pages);
+        release();
+    }
+
+    inline bool isExceeded() const { return used_pages.load() > static_cast<int64_t>(max_pages); }
+
+    size_t getMaxPages() const { return max_pages; }
+    int64_t getUsedPages() const { return used_pages.load(); }
+    int64_t getPeakUsedPages() const { return peak_used_pages.load(); }
+
+private:
+    explicit TempMemoryBudget(size_t max_pages)
+        : max_pages(max_pages)
+        , used_pages(0)
+        , peak_used_pages(0)
+        , num_references(1) { }
+
+    inline void release() {
+        if (num_references.fetch_sub(1) == 1)
+            delete this;
+    }
+
+    const size_t max_pages;
+    std::atomic_int64_t used_pages;
+    std::atomic_int64_t peak_used_pages;
+    std::atomic_uint64_t num_references; // the creator's reference and one per charged block
+};
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+#include "page.hpp"
+
+// blocks of up to TEMP_PAGE_POOL_MAX_BLOCK_PAGES pages are recycled, larger blocks are always returned to the allocator
+#define TEMP_PAGE_POOL_MAX_BLOCK_PAGES 64ul
+// maximum number of pages held by a single worker's pool
+#define TEMP_PAGE_POOL_CAPACITY 1024ul
+
+class TempMemoryBudget;
+
+// precedes each temporary block allocated by 'TempPagePool::allocateBlock()', the block itself begins at the following cache line
+struct alignas(64) TempBlockHeader {
+    uint32_t owner; // worker that the block was allocated for
+    TempMemoryBudget* budget; // budget that the block is currently charged to, or nullptr
+};
+
+/*
+Per-worker cache of temporary page blocks that were previously handed out by VMCache.
+Recycled blocks are already faulted in (and, due to first-touch, usually reside on the worker's NUMA node), so reusing them avoids both the allocator round-trip and the page faults for fresh memory.
+Blocks are kept in one stack per block size so that a block is only ever reused for an allocation of exactly the same size.
+Note: a block may be dropped by a different thread than the one that allocated it (e.g., batches passed between pipelines); it is returned to the pool of the worker it was allocated for (see 'TempBlockHeader'), so each pool is protected by a latch.
+*/
+class alignas(64) TempPagePool {
+public:
+    static char* allocateBlock(size_t num_pages, uint32_t owner) {
+        // the header is allocated at a cache line boundary, so the block that follows it is cache line aligned as well
+        char* memory = reinterpret_cast<char*>(aligned_alloc(alignof(TempBlockHeader), sizeof(TempBlockHeader) + num_pages * PAGE_SIZE));
+        if (memory == nullptr)
+            throw std::runtime_error("Failed to allocate temporary memory");
+        reinterpret_cast<TempBlockHeader*>(memory)->owner = owner;
+        reinterpret_cast<TempBlockHeader*>(memory)->budget = nullptr;
+        return memory + sizeof(TempBlockHeader);
+    }
+
+    static void freeBlock(char* block) { free(block - sizeof(TempBlockHeader)); }
+
+    static TempBlockHeader* getHeader(char* block) { return reinterpret_cast<TempBlockHeader*>(block - sizeof(TempBlockHeader)); }
+
+    static uint32_t getOwner(const char* block) { return reinterpret_cast<const TempBlockHeader*>(block - sizeof(TempBlockHeader))->owner; }
+
+    TempPagePool()
+        : free_blocks(TEMP_PAGE_POOL_MAX_BLOCK_PAGES + 1)
+        , num_pooled_pages(0) { }
+
+    ~TempPagePool() { clear(); }
+
+    TempPagePool(const TempPagePool& other) = delete;
+    TempPagePool& operator=(const TempPagePool& other) = delete;
+
+    // returns a pooled block of exactly 'num_pages' pages, or nullptr if there is none
+    char* pop(size_t num_pages) {
+        if (num_pages > TEMP_PAGE_POOL_MAX_BLOCK_PAGES)
+            return nullptr;
+        std::lock_guard<std::mutex> guard(latch);
+        std::vector<char*>& blocks = free_blocks[num_pages];
+        if (blocks.empty())
+            return nullptr;
+        char* block = blocks.back();
+        blocks.pop_back();
+        num_pooled_pages -= num_pages;
+        return block;
+    }
+
+    // returns false if the block cannot be pooled because it is too large or the pool is full
+    bool push(char* block, size_t num_pages) {
+        if (num_pages > TEMP_PAGE_POOL_MAX_BLOCK_PAGES)
+            return false;
+        std::lock_guard<std::mutex> guard(latch);
+        if (num_pooled_pages + num_pages > TEMP_PAGE_POOL_CAPACITY)
+            return false;
+        free_blocks[num_pages].push_back(block);
+        num_pooled_pages += num_pages;
+        return true;
+    }
+
+    // frees all pooled blocks, returns the number of released pages
+    size_t clear() {
+        std::lock_guard<std::mutex> guard(latch);
+        for (std::vector<char*>& blocks : free_blocks) {
+            for (char* block : blocks)
+                freeBlock(block);
+            blocks.clear();
+        }
+        return num_pooled_pages.exchange(0);
+    }
+
+    size_t getNumPooledPages() const { return num_pooled_pages.load(); }
+
+private:
+    std::mutex latch;
+    std::vector<std::vector<char*>> free_blocks; // indexed by block size in pages
+    std::atomic_uint64_t num_pooled_pages;
+};
+
+/*
+Cache of the huge page backed regions of large temporary allocations (see 'VMCache::allocateTemporaryHugePage()'), shared by all workers.
+Reusing a region saves the mmap() and madvise(MADV_HUGEPAGE) calls of a new region as well as the munmap() and TLB shootdown of an old one, and its huge pages are already faulted in.
+Regions are only reused for allocations of the same number of pages; like the blocks of a TempPagePool, they remain accounted as physical temporary pages while pooled.
+*/
+class HugePageRegionPool {
+public:
+    explicit HugePageRegionPool(size_t capacity) : capacity(capacity), num_pooled_pages(0) { }
+
+    HugePageRegionPool(const HugePageRegionPool& other) = delete;
+    HugePageRegionPool& operator=(const HugePageRegionPool& other) = delete;
+
+    // returns a pooled region of exactly 'num_pages' pages, or nullptr if there is none
+    char* pop(size_t num_pages) {
+        std::lock_guard<std::mutex> guard(latch);
+        auto it = free_regions.find(num_pages);
+        if (it == free_regions.end() || it->second.empty())
+            return nullptr;
+        char* region = it->second.back();
+        it->second.pop_back();
+        num_pooled_pages -= num_pages;
+        return region;
+    }
+
+    // returns false if the pool cannot hold the region without exceeding its capacity
+    bool push(char* region, size_t num_pages) {
+        std::lock_guard<std::mutex> guard(latch);
+        if (num_pooled_pages + num_pages > capacity)
+            return false;
+        free_regions[num_pages].push_back(region);
+        num_pooled_pages += num_pages;
+        return true;
+    }
+
+    // removes all pooled regions and calls 'release(region, num_pages)' for each of them, returns the number of released pages
+    template <typename F>
+    size_t clear(F&& release) {
+        std::lock_guard<std::mutex> guard(latch);
+        for (auto& [num_pages, regions] : free_regions) {
+            for (char* region : regions)
+                release(region, num_pages);
+        }
+        free_regions.clear();
+        const size_t result = num_pooled_pages;
+        num_pooled_pages = 0;
+        return result;
+    }
+
+private:
+    const size_t capacity;
+    std::mutex latch;
+    std::map<size_t, std::vector<char*>> free_regions; // indexed by region size in pages
+    size_t num_pooled_pages;
+};
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "vmcache.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fcntl.h>
 #include <iomanip>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
@@ -16,56 +20,123 @@ int exmapAction(int exmapfd, exmap_opcode op, uint16_t len, uint32_t worker_id)
    return ioctl(exmapfd, EXMAP_IOCTL_ACTION, &params_free);
 }
 
-VMCache::VMCache(uint64_t max_size, uint64_t virtual_pages, const std::string& path, bool sandbox, bool no_dirty_writeback, bool flush_asynchronously, bool use_eviction_target, std::unique_ptr<PartitioningStrategy>&& partitioning_strategy, bool use_exmap, bool stats_on_shutdown, const size_t num_workers)
-    : use_exmap(use_exmap)
-    , stats_on_shutdown(stats_on_shutdown)
-    , max_size(max_size)
-    , virtual_pages(virtual_pages)
-    , max_physical_pages((max_size - sizeof(VMCache) - sizeof(VMCacheStats) * num_workers - partitioning_strategy->getConstantMemoryCost(num_workers) - virtual_pages * sizeof(PageState)) / (PAGE_SIZE + partitioning_strategy->getPerPageMemoryCost())) // memory cost per physical page is the page size itself + eviction policy overhead
+static PageState* allocatePageStates(size_t num_entries) {
+    // anonymous memory is zero-filled on first access, which encodes PAGE_STATE_EVICTED; entries of pages that are never used are thereby never touched
+    static_assert(PAGE_STATE_EVICTED == 0);
+    void* result = mmap(0, num_entries * sizeof(PageState), PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0);
+    if (result == MAP_FAILED)
+        throw std::runtime_error("Failed to create anonymous memory mapping for the page state array");
+    return reinterpret_cast<PageState*>(result);
+}
+
+// memory available for buffer frames and the compressed page tier: the memory limit minus the cost of VMCache's own data structures and the partitioning strategy's constant and per page state entry overhead
+static uint64_t getFrameMemory(uint64_t max_size, uint64_t virtual_pages, const PartitioningStrategy& partitioning_strategy, size_t num_threads) {
+    const size_t num_page_states = virtual_pages + SPILL_AREA_PAGES(virtual_pages);
+    return max_size - sizeof(VMCache) - sizeof(VMCacheStats) * num_threads - partitioning_strategy.getConstantMemoryCost(num_threads) - num_page_states * sizeof(PageState) - partitioning_strategy.getPageStateMemoryCost(num_page_states);
+}
+
+// memory cost per physical page is the page size itself + eviction policy overhead; the compressed page tier gets the memory of 'compressed_tier_fraction' of the frames
+static uint64_t getFrameCount(uint64_t frame_memory, const PartitioningStrategy& partitioning_strategy, double compressed_tier_fraction) {
+    const uint64_t num_frames = frame_memory / (PAGE_SIZE + partitioning_strategy.getPerPageMemoryCost());
+    return num_frames - static_cast<uint64_t>(num_frames * compressed_tier_fraction);
+}
+
+VMCache::VMCache(const VMCacheConfig& config, std::unique_ptr<PartitioningStrategy>&& partitioning_strategy)
+    : use_exmap(config.use_exmap)
+    , stats_on_shutdown(config.stats_on_shutdown)
+    , max_size(config.max_size)
+    , virtual_pages(config.virtual_pages)
+    , max_physical_pages(getFrameCount(getFrameMemory(config.max_size, config.virtual_pages, *partitioning_strategy, config.num_workers + config.num_page_cleaners), *partitioning_strategy, config.compressed_tier_fraction))
     , num_allocated_pages(0)
     , partitioning_strategy(std::move(partitioning_strategy))
     , num_temporary_pages_in_use(0)
     , peak_num_temporary_pages_in_use(0)
     , num_dirty_pages(0)
-    , page_states(new PageState[virtual_pages])
-    , sandbox(sandbox)
-    , dirty_writeback(!no_dirty_writeback)
-    , flush_asynchronously(flush_asynchronously)
-    , use_eviction_target(use_eviction_target)
-    , db_path(path)
-    , num_workers(num_workers)
+    , page_states(allocatePageStates(config.virtual_pages + SPILL_AREA_PAGES(config.virtual_pages)))
+    , sandbox(config.sandbox)
+    , dirty_writeback(!config.no_dirty_writeback)
+    , flush_asynchronously(config.flush_asynchronously)
+    , use_eviction_target(config.use_eviction_target)
+    , db_path(config.path)
+    , num_workers(config.num_workers)
+    , num_page_cleaners(config.num_page_cleaners)
+    , num_threads(config.num_workers + config.num_page_cleaners)
+    , use_io_uring(config.use_io_uring)
+    , shadow_file_size(0)
+    , temp_page_pools(num_threads)
+    , huge_page_regions(std::make_unique<HugePageRegionPool>(static_cast<size_t>(max_physical_pages * HUGE_PAGE_POOL_FRACTION)))
+    , num_pooled_temporary_pages(0)
+    , num_free_pages(0)
+    , free_list_anchor_pid(INVALID_PAGE_ID)
+    , free_list_anchor_offset(0)
+    , free_list_anchor_stale(false)
+    , extents_fd(-1)
+    , spill_pages(SPILL_AREA_PAGES(config.virtual_pages))
+    , num_allocated_spill_pages(0)
+    , num_spillable_pages_in_use(0)
+    , temp_memory_budgets(num_threads, nullptr)
+    , page_cleaner_free_pages(static_cast<size_t>(max_physical_pages * config.page_cleaner_watermark))
+    , stop_page_cleaners(false)
 {
+    if (config.compressed_tier_fraction < 0.0 || config.compressed_tier_fraction >= 1.0)
+        throw std::runtime_error("The fraction of memory used for the compressed page tier must be in [0, 1)");
     int flags = O_RDWR | O_DIRECT;
     struct stat st;
-    if (stat(path.c_str(), &st) != 0) {
+    if (stat(config.path.c_str(), &st) != 0) {
         flags |= O_CREAT;
     }
-    fd = open(path.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    fd = open(config.path.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
     if (fd == -1) {
         std::cout << "Error: Failed to open database file (errno " << errno << ", " << errnoStr() << ")" << std::endl;
         errno = 0;
         throw std::runtime_error("Failed to open database file");
     }
-    shadow_fd = open((path + ".shadow").c_str(), O_RDWR | O_DIRECT | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    shadow_fd = open((config.path + ".shadow").c_str(), O_RDWR | O_DIRECT | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
     if (shadow_fd == -1) {
         std::cout << "Error: Failed to create shadow file (errno " << errno << ", " << errnoStr() << ")" << std::endl;
         errno = 0;
         throw std::runtime_error("Failed to create shadow file");
     }
+    if (config.use_wal) {
+        if (sandbox || config.no_dirty_writeback)
+            throw std::runtime_error("Write-ahead logging requires dirty page write-back and cannot be used in sandbox mode");
+        wal = std::make_unique<WriteAheadLog>(config.path + ".wal");
+        const size_t recovered_pages = wal->recover(fd);
+        if (recovered_pages > 0)
+            std::cout << "[vmcache] " << "Recovered " << recovered_pages << " page images from the write-ahead log" << std::endl;
+        write_sets = std::vector<WALWriteSet>(num_threads);
+    }
 
     const size_t MB = 1000 * 1000;
     std::cout << "[vmcache] " << "Memory limit: " << max_size / MB << " MB" << std::endl;
     std::cout << "[vmcache] " << "Effective capacity: " << max_physical_pages * PAGE_SIZE / MB << " MB (" << max_physical_pages << " pages)" << std::endl;
-    std::cout << "[vmcache] " << "Page state array uses " << virtual_pages * sizeof(PageState) / MB << " MB (" << virtual_pages << " entries)" << std::endl;
-    const size_t ps_constant_cost = this->partitioning_strategy->getConstantMemoryCost(num_workers);
+    std::cout << "[vmcache] " << "Page state array uses " << (virtual_pages + spill_pages) * sizeof(PageState) / MB << " MB (" << virtual_pages << " entries + " << spill_pages << " for spilling)" << std::endl;
+    const size_t ps_constant_cost = this->partitioning_strategy->getConstantMemoryCost(num_threads);
     const size_t ps_pp_cost = this->partitioning_strategy->getPerPageMemoryCost();
-    std::cout << "[vmcache] " << "Partitioning strategy uses a constant " << ps_constant_cost / MB << " MB and " << ps_pp_cost << " B per page (" << (ps_constant_cost + ps_pp_cost * max_physical_pages) / MB << " MB total)" << std::endl;
+    const size_t ps_page_state_cost = this->partitioning_strategy->getPageStateMemoryCost(virtual_pages + spill_pages);
+    std::cout << "[vmcache] " << "Partitioning strategy uses a constant " << ps_constant_cost / MB << " MB, " << ps_pp_cost << " B per page and " << ps_page_state_cost / MB << " MB for the page state range (" << (ps_constant_cost + ps_pp_cost * max_physical_pages + ps_page_state_cost) / MB << " MB total)" << std::endl;
+    if (config.compressed_tier_fraction > 0.0) {
+        if (!dirty_writeback) {
+            // evicted pages are neither written back nor removed from memory in this mode (see 'CachePartition::pageOut()')
+            std::cout << "[vmcache] " << "Warning: The compressed page tier requires dirty page write-back and is disabled" << std::endl;
+        } else {
+            const size_t tier_budget = getFrameMemory(max_size, virtual_pages, *this->partitioning_strategy, num_threads) - max_physical_pages * (PAGE_SIZE + ps_pp_cost);
+            compressed_tier = std::make_unique<CompressedPageTier>(tier_budget);
+            std::cout << "[vmcache] " << "Compressed page tier uses up to " << compressed_tier->getCapacity() / MB << " MB for compressed pages and their index" << std::endl;
+        }
+    }
 
-    for (size_t i = 0; i < virtual_pages; i++)
-        page_states[i] = PAGE_STATE_EVICTED;
+    db_file_size = lseek(fd, 0, SEEK_END) / PAGE_SIZE * PAGE_SIZE;
+    num_allocated_pages = db_file_size / PAGE_SIZE;
+    restoreExtents((flags & O_CREAT) != 0);
 
-    size_t file_size = lseek(fd, 0, SEEK_END);
-    num_allocated_pages = file_size / PAGE_SIZE;
+    if (use_io_uring) {
+        io_rings.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; i++)
+            io_rings.push_back(std::make_unique<IOUring>(PREFETCH_BATCH_SIZE));
+        in_flight_prefetches = std::vector<InFlightPrefetch>(num_threads);
+        std::cout << "[vmcache] " << "Using io_uring for page faults (" << num_threads << " rings)" << std::endl;
+    }
 
     if (use_exmap) {
         exmap_fd = open("/dev/exmap", O_RDWR);
@@ -74,40 +145,61 @@ VMCache::VMCache(uint64_t max_size, uint64_t virtual_pages, const std::string& p
 
         struct exmap_ioctl_setup buffer;
         buffer.fd = -1;
-        buffer.max_interfaces = num_workers;
+        buffer.max_interfaces = num_threads;
         buffer.buffer_size = max_physical_pages;
         buffer.flags = 0;
         if (ioctl(exmap_fd, EXMAP_IOCTL_SETUP, &buffer) < 0)
             throw std::runtime_error("EXMAP_SETUP failed");
 
-        for (size_t i = 0; i < num_workers; i++) {
+        for (size_t i = 0; i < num_threads; i++) {
             exmap_interface.push_back(reinterpret_cast<struct exmap_user_interface*>(mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, exmap_fd, EXMAP_OFF_INTERFACE(i))));
             if (exmap_interface.back() == MAP_FAILED)
                 throw std::runtime_error("exmap interface setup failed");
         }
 
-        memory = reinterpret_cast<char*>(mmap(0, virtual_pages * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, exmap_fd, 0));
+        memory = reinterpret_cast<char*>(mmap(0, (virtual_pages + spill_pages) * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, exmap_fd, 0));
     } else {
-        memory = reinterpret_cast<char*>(mmap(0, virtual_pages * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0));
+        memory = reinterpret_cast<char*>(mmap(0, (virtual_pages + spill_pages) * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0));
         if (memory == MAP_FAILED)
             throw std::runtime_error("Failed to create anonymous memory mapping for vmcache");
-        madvise(memory, virtual_pages * PAGE_SIZE, MADV_DONTNEED | MADV_NOHUGEPAGE);
+        madvise(memory, (virtual_pages + spill_pages) * PAGE_SIZE, MADV_DONTNEED | MADV_NOHUGEPAGE);
     }
-    this->partitioning_strategy->setVMCache(this, num_workers);
+    this->partitioning_strategy->setVMCache(this, num_threads);
 
     // initialize stat counters
-    stats = new VMCacheStats[num_workers];
-    for (size_t i = 0; i < num_workers; ++i) {
+    stats = new VMCacheStats[num_threads];
+    for (size_t i = 0; i < num_threads; ++i) {
         stats[i].total_accessed_pages = 0;
         stats[i].total_faulted_pages = 0;
     }
+
+    if (num_page_cleaners > 0) {
+        std::cout << "[vmcache] " << "Using " << num_page_cleaners << " page cleaner threads to keep " << page_cleaner_free_pages << " frames free" << std::endl;
+        for (size_t i = 0; i < num_page_cleaners; i++)
+            page_cleaners.emplace_back(&VMCache::runPageCleaner, this, static_cast<uint32_t>(num_workers + i));
+    }
 }
 
 VMCache::~VMCache() {
+    stop_page_cleaners = true;
+    for (auto& page_cleaner : page_cleaners)
+        page_cleaner.join();
+    for (size_t i = 0; i < num_threads && use_io_uring; i++)
+        completePrefetches(i);
+    huge_page_regions->clear([&](char* region, size_t huge_page_backed_pages) { unmapHugePageBacked(region, huge_page_backed_pages); });
+
+    // the anchor of the free page list is written lazily, so bring it up to date before the dirty pages are written
+    if (free_list_anchor_pid != INVALID_PAGE_ID && free_list_anchor_stale) {
+        storeFreePageListAnchor(fixExclusive(free_list_anchor_pid, 0));
+        unfixExclusive(free_list_anchor_pid);
+    }
+
     // write out dirty pages from memory
+    //  note: pages that were never allocated are never faulted, so it suffices to check the allocated pages here
+    const PageId end_pid = num_allocated_pages.load();
     int64_t warnings_to_show = 5;
     size_t pages_written = 0;
-    for (PageId pid = 0; pid < virtual_pages; pid++) {
+    for (PageId pid = 0; pid < end_pid; pid++) {
         uint64_t s = page_states[pid].load();
         uint64_t state = PAGE_STATE(s);
         if (state != PAGE_STATE_UNLOCKED && state != PAGE_STATE_MARKED && state != PAGE_STATE_EVICTED && state != PAGE_STATE_FAULTED) {
@@ -117,34 +209,43 @@ VMCache::~VMCache() {
         }
         if ((s & PAGE_DIRTY_BIT) > 0 && !(sandbox && (s & PAGE_MODIFIED_BIT) > 0)) {
             // write out the page
-            flushDirtyPage(pid);
-            pages_written++;
+            if (flushDirtyPage(pid))
+                pages_written += PAGE_NUM_PAGES(s);
         }
     }
     if (warnings_to_show < 0)
         std::cout << "[vmcache] " << -warnings_to_show << " warnings not shown" << std::endl;
 
-    // copy shadow pages from the shadow file to the database file
-    if (!sandbox) {
+    if (wal != nullptr) {
+        // dirty pages were written to the database file directly, so the log is no longer needed after they are synced
+        if (fdatasync(fd) != 0)
+            std::cout << "[vmcache] " << "Warning: Failed to sync (errno " << errno << ", " << errnoStr() << ") the database file on shutdown" << std::endl;
+        else
+            wal->checkpoint(wal->getCurrentLSN());
+    } else if (!sandbox) {
+        // copy shadow pages from the shadow file to the database file
         size_t shadow_pages_copied = 0;
         warnings_to_show = 4;
-        for (PageId pid = 0; pid < virtual_pages; pid++) {
-            if (PAGE_MODIFIED(page_states[pid].load())) {
-                // copy the page from the shadow file to the database file
+        for (PageId pid = 0; pid < end_pid; pid++) {
+            const uint64_t s = page_states[pid].load();
+            if (PAGE_MODIFIED(s)) {
+                // copy the page (or all pages of the extent) from the shadow file to the database file
                 // note: we just reuse the first page of 'memory' here as a buffer for copying
                 //  this is safe as all changes were previously flushed to the shadow file
-                const size_t offset = pid * PAGE_SIZE;
-                if (pread(shadow_fd, memory, PAGE_SIZE, offset) != PAGE_SIZE) {
-                    if (warnings_to_show > 0)
-                        std::cout << "[vmcache] Warning: Failed to read (errno " << errno << ", " << errnoStr() << ") from shadow file on shutdown" << std::endl;
-                    warnings_to_show--;
-                }
-                if (pwrite(fd, memory, PAGE_SIZE, offset) != PAGE_SIZE) {
-                    if (warnings_to_show > 0)
-                        std::cout << "[vmcache] Warning: Failed to copy (errno " << errno << ", " << errnoStr() << ") from shadow file to database file on shutdown" << std::endl;
-                    warnings_to_show--;
+                for (size_t i = 0; i < PAGE_NUM_PAGES(s); i++) {
+                    const size_t offset = (pid + i) * PAGE_SIZE;
+                    if (pread(shadow_fd, memory, PAGE_SIZE, offset) != PAGE_SIZE) {
+                        if (warnings_to_show > 0)
+                            std::cout << "[vmcache] Warning: Failed to read (errno " << errno << ", " << errnoStr() << ") from shadow file on shutdown" << std::endl;
+                        warnings_to_show--;
+                    }
+                    if (pwrite(fd, memory, PAGE_SIZE, offset) != PAGE_SIZE) {
+                        if (warnings_to_show > 0)
+                            std::cout << "[vmcache] Warning: Failed to copy (errno " << errno << ", " << errnoStr() << ") from shadow file to database file on shutdown" << std::endl;
+                        warnings_to_show--;
+                    }
+                    shadow_pages_copied++;
                 }
-                shadow_pages_copied++;
             }
         }
         std::cout << "[vmcache] " << "Copied " << shadow_pages_copied << " shadow pages to the database file on shutdown" << std::endl;
@@ -152,81 +253,649 @@ VMCache::~VMCache() {
     if (warnings_to_show < 0)
         std::cout << "[vmcache] " << -warnings_to_show << " warnings not shown" << std::endl;
 
+    if (extents_fd != -1)
+        close(extents_fd);
     close(shadow_fd);
     if (unlink((db_path + ".shadow").c_str()) != 0)
         std::cerr << "Warning: Failed to delete database shadow file" << std::endl;
     close(fd);
-    munmap(memory, virtual_pages * PAGE_SIZE);
+    munmap(memory, (virtual_pages + spill_pages) * PAGE_SIZE);
     if (stats_on_shutdown) {
         std::cout << "[vmcache] " << "Wrote " << pages_written << " of " << num_allocated_pages << " pages to disk on shutdown" << std::endl;
         std::cout << "[vmcache] " << "At peak, " << peak_num_temporary_pages_in_use << " pages (" << std::setprecision(2) << peak_num_temporary_pages_in_use * PAGE_SIZE / 1024.0 / 1024.0 / 1024.0 << " GiB) were used for temporary data" << std::endl;
         // print general stats
         partitioning_strategy->printStats();
+        if (compressed_tier)
+            compressed_tier->printStats();
         std::cout << "[vmcache] " << "Total faulted: " << getTotalFaultedPageCount();
         std::cout << " (" << std::setiosflags(std::ios::fixed) << std::setprecision(2) << getTotalFaultedPageCount() * PAGE_SIZE / 1024.0 / 1024.0 / 1024.0 << " GiB)" << std::endl;
     }
-    delete[] page_states;
+    munmap(page_states, (virtual_pages + spill_pages) * sizeof(PageState));
     delete[] stats;
 }
 
-PageId VMCache::allocatePage() {
-    if (num_allocated_pages > virtual_pages)
+void VMCache::runPageCleaner(uint32_t worker_id) {
+    while (!stop_page_cleaners.load()) {
+        if (!partitioning_strategy->performCleaning(worker_id, page_cleaner_free_pages))
+            std::this_thread::sleep_for(std::chrono::microseconds(PAGE_CLEANER_IDLE_US));
+    }
+}
+
+PageId VMCache::allocatePage(uint32_t worker_id) {
+    if (num_free_pages.load() > 0) {
+        // the anchor is not written here, so allocating does not latch any page other than the popped one (see 'writeFreePageListAnchor()')
+        PageId pid = INVALID_PAGE_ID;
+        {
+            std::lock_guard<std::mutex> guard(free_pages_mutex);
+            if (!free_pids.empty()) {
+                pid = free_pids.back();
+                free_pids.pop_back();
+                num_free_pages--;
+                free_list_anchor_stale = true;
+            }
+        }
+        if (pid != INVALID_PAGE_ID) {
+            markFreePageListChanged(worker_id);
+            memset(fixExclusive(pid, worker_id), 0, PAGE_SIZE);
+            unfixExclusive(pid, worker_id);
+            return pid;
+        }
+    }
+    if (num_allocated_pages >= virtual_pages)
         throw std::runtime_error("Page limit reached");
-    return num_allocated_pages++; // TODO: consider free pages here - could, e.g., make free pages form a linked list
+    return num_allocated_pages++;
+}
+
+PageId VMCache::allocateExtent(uint32_t) {
+    if (wal != nullptr)
+        throw std::runtime_error("Extents cannot be used with write-ahead logging");
+    PageId pid = num_allocated_pages.load();
+    do {
+        if (pid + EXTENT_NUM_PAGES > virtual_pages)
+            throw std::runtime_error("Page limit reached");
+    } while (!num_allocated_pages.compare_exchange_weak(pid, pid + EXTENT_NUM_PAGES));
+    declareExtent(pid);
+    // record the extent before any of its pages can be written, so that it is faulted as a unit after a restart
+    std::lock_guard<std::mutex> guard(extents_mutex);
+    if (extents_fd == -1)
+        extents_fd = open((db_path + ".extents").c_str(), O_RDWR | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR);
+    if (extents_fd == -1 || write(extents_fd, &pid, sizeof(PageId)) != sizeof(PageId)) {
+        std::cout << "[vmcache] " << "Error: Failed to record extent in the extent file (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        throw std::runtime_error("Failed to record extent");
+    }
+    return pid;
+}
+
+void VMCache::restoreExtents(bool new_database) {
+    const std::string extents_path = db_path + ".extents";
+    if (new_database) {
+        // an extent file left behind by a deleted database does not belong to this one
+        unlink(extents_path.c_str());
+        errno = 0;
+        return;
+    }
+    extents_fd = open(extents_path.c_str(), O_RDWR | O_APPEND);
+    if (extents_fd == -1) { // no extents have been allocated
+        errno = 0;
+        return;
+    }
+    std::vector<PageId> extents(lseek(extents_fd, 0, SEEK_END) / sizeof(PageId));
+    const ssize_t len = extents.size() * sizeof(PageId);
+    if (pread(extents_fd, extents.data(), len, 0) != len) {
+        std::cout << "[vmcache] " << "Error: Failed to read extent file (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        throw std::runtime_error("Failed to read extent file");
+    }
+    const size_t num_recorded = extents.size();
+    const uint64_t num_database_pages = num_allocated_pages.load();
+    extents.erase(std::remove_if(extents.begin(), extents.end(), [&](PageId pid) { return pid >= num_database_pages; }), extents.end());
+    if (!extents.empty() && wal != nullptr)
+        throw std::runtime_error("Extents cannot be used with write-ahead logging");
+    for (const PageId pid : extents) {
+        declareExtent(pid);
+        // the last pages of an extent may not have been written
+        if (pid + EXTENT_NUM_PAGES > num_allocated_pages)
+            num_allocated_pages = pid + EXTENT_NUM_PAGES;
+    }
+    if (extents.size() != num_recorded) {
+        // the page ids of dropped extents are allocated again, possibly as single pages
+        const ssize_t new_len = extents.size() * sizeof(PageId);
+        if (ftruncate(extents_fd, 0) != 0 || write(extents_fd, extents.data(), new_len) != new_len) {
+            std::cout << "[vmcache] " << "Error: Failed to rewrite extent file (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+            errno = 0;
+            throw std::runtime_error("Failed to rewrite extent file");
+        }
+    }
+    if (!extents.empty())
+        std::cout << "[vmcache] " << "Restored " << extents.size() << " extents from the extent file" << std::endl;
+}
+
+void VMCache::freePage(PageId pid, uint32_t worker_id) {
+    assert(!PAGE_IS_EXTENT(page_states[pid].load()));
+    {
+        std::lock_guard<std::mutex> guard(free_pages_mutex);
+        reinterpret_cast<FreePage*>(toPointer(pid))->next = free_pids.empty() ? INVALID_PAGE_ID : free_pids.back();
+        free_pids.push_back(pid);
+        num_free_pages++;
+        free_list_anchor_stale = true;
+    }
+    markFreePageListChanged(worker_id);
+    unfixExclusive(pid, worker_id);
+}
+
+void VMCache::storeFreePageListAnchor(char* anchor_page) {
+    std::lock_guard<std::mutex> guard(free_pages_mutex);
+    *reinterpret_cast<FreePageListAnchor*>(anchor_page + free_list_anchor_offset) = { free_pids.empty() ? INVALID_PAGE_ID : free_pids.back(), free_pids.size() };
+    free_list_anchor_stale = false;
+}
+
+void VMCache::writeFreePageListAnchor(uint32_t worker_id) {
+    storeFreePageListAnchor(fixExclusive(free_list_anchor_pid, worker_id));
+    unfixExclusive(free_list_anchor_pid, worker_id);
+}
+
+bool VMCache::checkpointFreePageListAnchor() {
+    {
+        std::lock_guard<std::mutex> guard(free_pages_mutex);
+        if (!free_list_anchor_stale)
+            return true;
+    }
+    // the checkpoint does not fault pages, so an evicted or latched anchor is retried later
+    uint64_t s = page_states[free_list_anchor_pid].load();
+    const uint64_t state = PAGE_STATE(s);
+    if ((state != PAGE_STATE_UNLOCKED && state != PAGE_STATE_MARKED && state != PAGE_STATE_FAULTED) || PAGE_UNCOMMITTED(s))
+        return false;
+    if (!page_states[free_list_anchor_pid].compare_exchange_strong(s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED))
+        return false;
+    storeFreePageListAnchor(toPointer(free_list_anchor_pid));
+    unlatchExclusive(free_list_anchor_pid, s);
+    return true;
+}
+
+void VMCache::openFreePageList(PageId anchor_pid, size_t anchor_offset, uint32_t worker_id) {
+    const FreePageListAnchor anchor = *reinterpret_cast<const FreePageListAnchor*>(fixShared(anchor_pid, worker_id) + anchor_offset);
+    unfixShared(anchor_pid);
+    std::vector<PageId> pids;
+    pids.reserve(anchor.num_pages);
+    for (PageId pid = anchor.head; pid != INVALID_PAGE_ID && pids.size() <= anchor.num_pages; ) {
+        pids.push_back(pid);
+        const PageId next = reinterpret_cast<const FreePage*>(fixShared(pid, worker_id))->next;
+        unfixShared(pid);
+        pid = next;
+    }
+    if (pids.size() != anchor.num_pages)
+        throw std::runtime_error("The free page list does not match its anchor");
+    std::reverse(pids.begin(), pids.end());
+    std::lock_guard<std::mutex> guard(free_pages_mutex);
+    free_pids = std::move(pids);
+    num_free_pages = free_pids.size();
+    free_list_anchor_pid = anchor_pid;
+    free_list_anchor_offset = anchor_offset;
+    free_list_anchor_stale = false;
+}
+
+PageId VMCache::getFreePageListHead() const {
+    std::lock_guard<std::mutex> guard(free_pages_mutex);
+    return free_pids.empty() ? INVALID_PAGE_ID : free_pids.back();
+}
+
+char* VMCache::allocateTemporaryPages(const size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns) {
+    char* result = nullptr;
+    if (num_pages > LARGE_ALLOCATION_THRESHOLD) {
+        // large allocations are backed by transparent huge pages, their memory is accounted at huge page granularity
+        const size_t huge_page_backed_pages = getHugePageBackedPageCount(num_pages);
+        result = huge_page_regions->pop(huge_page_backed_pages);
+        if (result != nullptr) {
+            num_pooled_temporary_pages -= static_cast<int64_t>(huge_page_backed_pages);
+            const uint32_t previous_owner = TempPagePool::getOwner(result);
+            if (previous_owner != worker_id) {
+                // move the region's accounting to the new owner
+                partitioning_strategy->notifyTempDropped(huge_page_backed_pages, previous_owner);
+                partitioning_strategy->prepareTempAllocation(huge_page_backed_pages, worker_id, page_cost_ns);
+                reinterpret_cast<TempBlockHeader*>(result - sizeof(TempBlockHeader))->owner = worker_id;
+            }
+        } else {
+            partitioning_strategy->prepareTempAllocation(huge_page_backed_pages, worker_id, page_cost_ns);
+            result = allocateHugePageBacked(num_pages, worker_id);
+        }
+    } else {
+        result = temp_page_pools[worker_id].pop(num_pages);
+        if (result != nullptr) {
+            num_pooled_temporary_pages -= static_cast<int64_t>(num_pages);
+        } else {
+            partitioning_strategy->prepareTempAllocation(num_pages, worker_id, page_cost_ns);
+            result = TempPagePool::allocateBlock(num_pages, worker_id);
+        }
+    }
+    // note: recycled pages are still accounted as physical temporary pages, so there is no need to call 'prepareTempAllocation()' for them
+    addToTemporaryPagesInUse(num_pages);
+    // the block is uncharged from the same budget when it is dropped, even if a worker that executes for another query (or none) drops it
+    TempMemoryBudget* budget = temp_memory_budgets[worker_id];
+    TempPagePool::getHeader(result)->budget = budget;
+    if (budget != nullptr)
+        budget->charge(num_pages);
+    traceAccess(num_pages, CacheAction::TempAllocate, worker_id);
+    return result;
 }
 
 char* VMCache::allocateTemporaryPage(uint32_t worker_id) {
-    partitioning_strategy->prepareTempAllocation(1, worker_id);
-    addToTemporaryPagesInUse(1);
-    return reinterpret_cast<char*>(malloc(PAGE_SIZE));
+    return allocateTemporaryPages(1, worker_id, 0);
 }
 
-char* VMCache::allocateTemporaryHugePage(const size_t num_pages, uint32_t worker_id) {
+char* VMCache::allocateTemporaryHugePage(const size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns) {
     char* result = nullptr;
+    if (num_pages > LARGE_ALLOCATION_THRESHOLD) {
+        // "large" allocations make space for themselves, so give up the memory held by this worker's pool first
+        releaseTemporaryPagePool(worker_id);
+    }
     if (num_pages > LARGE_ALLOCATION_THRESHOLD && log_allocation_latency && *log_allocation_latency) {
         // log latency of "large" allocations
         auto begin = std::chrono::steady_clock::now();
-        partitioning_strategy->prepareTempAllocation(num_pages, worker_id);
-        addToTemporaryPagesInUse(num_pages);
-        result = reinterpret_cast<char*>(malloc(num_pages * PAGE_SIZE));
+        result = allocateTemporaryPages(num_pages, worker_id, page_cost_ns);
         (*log_allocation_latency)(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
     } else {
-        partitioning_strategy->prepareTempAllocation(num_pages, worker_id);
-        addToTemporaryPagesInUse(num_pages);
-        result = reinterpret_cast<char*>(malloc(num_pages * PAGE_SIZE));
+        result = allocateTemporaryPages(num_pages, worker_id, page_cost_ns);
     }
     return result;
 }
 
-void VMCache::dropTemporaryPage(char* page, __attribute__((unused)) uint32_t worker_id) {
-    partitioning_strategy->notifyTempDropped(1);
-    free(page);
-    num_temporary_pages_in_use--;
+void VMCache::dropTemporaryPage(char* page, uint32_t worker_id) {
+    dropTemporaryHugePage(page, 1, worker_id);
 }
 
-void VMCache::dropTemporaryHugePage(char* page, const size_t num_pages, __attribute__((unused)) uint32_t worker_id) {
-    partitioning_strategy->notifyTempDropped(num_pages);
-    free(page);
+void VMCache::dropTemporaryHugePage(char* page, const size_t num_pages, uint32_t worker_id) {
+    traceAccess(num_pages, CacheAction::TempDrop, worker_id);
+    TempBlockHeader* header = TempPagePool::getHeader(page);
+    if (header->budget != nullptr) {
+        header->budget->uncharge(num_pages);
+        header->budget = nullptr;
+    }
+    if (num_pages > LARGE_ALLOCATION_THRESHOLD) {
+        const size_t huge_page_backed_pages = getHugePageBackedPageCount(num_pages);
+        if (huge_page_regions->push(page, huge_page_backed_pages)) {
+            num_pooled_temporary_pages += static_cast<int64_t>(huge_page_backed_pages);
+        } else {
+            partitioning_strategy->notifyTempDropped(huge_page_backed_pages, TempPagePool::getOwner(page));
+            unmapHugePageBacked(page, huge_page_backed_pages);
+        }
+    } else {
+        // the block goes back to the pool of the worker it was allocated for, which it is accounted to
+        const uint32_t owner = TempPagePool::getOwner(page);
+        if (temp_page_pools[owner].push(page, num_pages)) {
+            num_pooled_temporary_pages += static_cast<int64_t>(num_pages);
+        } else {
+            partitioning_strategy->notifyTempDropped(num_pages, owner);
+            TempPagePool::freeBlock(page);
+        }
+    }
     num_temporary_pages_in_use -= static_cast<int64_t>(num_pages);
 }
 
+char* VMCache::allocateHugePageBacked(const size_t num_pages, uint32_t owner) {
+    const size_t size = getHugePageBackedPageCount(num_pages) * PAGE_SIZE;
+    // over-allocate to be able to align the region to the huge page size while keeping the header page in front of it, then trim the excess
+    char* mapping = reinterpret_cast<char*>(mmap(0, size + HUGE_PAGE_SIZE + PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0));
+    if (mapping == MAP_FAILED) {
+        std::cout << "[vmcache] " << "Error: Failed to map " << size << " bytes of temporary memory (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        throw std::runtime_error("Failed to allocate temporary memory");
+    }
+    const uintptr_t mapping_begin = reinterpret_cast<uintptr_t>(mapping) + PAGE_SIZE;
+    const size_t head = (HUGE_PAGE_SIZE - mapping_begin % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+    char* result = mapping + PAGE_SIZE + head;
+    if (head > 0)
+        munmap(mapping, head);
+    munmap(result + size, HUGE_PAGE_SIZE - head);
+    // note: this is only a hint, if transparent huge pages are disabled the region is simply backed by regular pages
+    madvise(result, size, MADV_HUGEPAGE);
+    reinterpret_cast<TempBlockHeader*>(result - sizeof(TempBlockHeader))->owner = owner;
+    reinterpret_cast<TempBlockHeader*>(result - sizeof(TempBlockHeader))->budget = nullptr;
+    return result;
+}
+
+void VMCache::unmapHugePageBacked(char* region, const size_t huge_page_backed_pages) {
+    munmap(region - PAGE_SIZE, (huge_page_backed_pages + 1) * PAGE_SIZE);
+}
+
+void VMCache::releaseTemporaryPagePool(uint32_t worker_id) {
+    const size_t released_pages = temp_page_pools[worker_id].clear();
+    if (released_pages > 0) {
+        num_pooled_temporary_pages -= static_cast<int64_t>(released_pages);
+        partitioning_strategy->notifyTempDropped(released_pages, worker_id);
+    }
+}
+
+void VMCache::releaseTemporaryPagePools() {
+    for (uint32_t worker_id = 0; worker_id < temp_page_pools.size(); worker_id++)
+        releaseTemporaryPagePool(worker_id);
+    const size_t released_pages = huge_page_regions->clear([&](char* region, size_t huge_page_backed_pages) {
+        partitioning_strategy->notifyTempDropped(huge_page_backed_pages, TempPagePool::getOwner(region));
+        unmapHugePageBacked(region, huge_page_backed_pages);
+    });
+    num_pooled_temporary_pages -= static_cast<int64_t>(released_pages);
+}
+
+PageId VMCache::allocateSpillablePage(uint32_t worker_id) {
+    PageId pid;
+    {
+        std::lock_guard<std::mutex> guard(spill_pages_mutex);
+        if (!free_spill_pages.empty()) {
+            pid = free_spill_pages.back();
+            free_spill_pages.pop_back();
+        } else {
+            if (num_allocated_spill_pages >= spill_pages)
+                throw std::runtime_error("Spill area exhausted");
+            pid = virtual_pages + num_allocated_spill_pages++;
+        }
+    }
+    // note: the page is not modified (see 'dropSpillablePage()'), so this fault does not read anything and the page is zeroed
+    fixExclusive(pid, worker_id);
+    num_spillable_pages_in_use++;
+    addToTemporaryPagesInUse(1);
+    return pid;
+}
+
+void VMCache::dropSpillablePage(PageId pid, uint32_t worker_id) {
+    assert(isSpillablePage(pid));
+    // latch the page without faulting it in, its contents are no longer needed
+    uint64_t s = page_states[pid].load();
+    while (true) {
+        const uint64_t state = PAGE_STATE(s);
+        if (state == PAGE_STATE_EVICTED || state == PAGE_STATE_MARKED || state == PAGE_STATE_FAULTED || state == PAGE_STATE_UNLOCKED) {
+            if (page_states[pid].compare_exchange_weak(s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED))
+                break;
+        } else {
+            s = page_states[pid].load();
+        }
+    }
+    if (PAGE_STATE(s) == PAGE_STATE_EVICTED) {
+        if (compressed_tier)
+            compressed_tier->erase(pid);
+    } else {
+        if ((s & PAGE_DIRTY_BIT) > 0)
+            num_dirty_pages--;
+        if (use_exmap) {
+            exmap_interface[worker_id]->iov[0].page = pid;
+            exmap_interface[worker_id]->iov[0].len = 1;
+            if (exmapAction(exmap_fd, EXMAP_OP_FREE, 1, worker_id) < 0)
+                throw std::runtime_error("ioctl: EXMAP_OP_FREE");
+        } else {
+            madvise(toPointer(pid), PAGE_SIZE, MADV_DONTNEED);
+        }
+        partitioning_strategy->notifyDropped(pid, worker_id);
+    }
+    // clearing the modified bit makes the next fault of this page skip reading the stale spilled version
+    page_states[pid].store(((s & ~(PAGE_STATE_MASK | PAGE_DIRTY_BIT | PAGE_MODIFIED_BIT)) + (1ull << PAGE_VERSION_OFFSET)) | PAGE_STATE_EVICTED, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> guard(spill_pages_mutex);
+        free_spill_pages.push_back(pid);
+    }
+    num_spillable_pages_in_use--;
+    num_temporary_pages_in_use--;
+}
+
+size_t VMCache::getReadableBytes(const PageId first_pid, size_t num_pages, bool is_modified) const {
+    const uint64_t file_size = isInShadowFile(first_pid, is_modified) ? shadow_file_size.load(std::memory_order_acquire) : db_file_size.load(std::memory_order_acquire);
+    const uint64_t offset = first_pid * PAGE_SIZE;
+    if (offset >= file_size)
+        return 0;
+    return std::min<uint64_t>(num_pages * PAGE_SIZE, file_size - offset);
+}
+
+bool VMCache::readPages(const PageId first_pid, size_t num_pages, bool is_modified, uint32_t worker_id) {
+    const size_t len = getReadableBytes(first_pid, num_pages, is_modified);
+    if (len == 0)
+        return true; // the pages do not exist in the file yet, this is fine
+    const int read_fd = isInShadowFile(first_pid, is_modified) ? shadow_fd : fd;
+    const uint64_t offset = first_pid * PAGE_SIZE;
+    touchFrames(first_pid, len);
+    const auto begin = std::chrono::steady_clock::now();
+    ssize_t result = -EIO;
+    if (use_io_uring) {
+        // the request is not tagged, so its completion is told apart from those of prefetch reads that are still in flight
+        io_rings[worker_id]->prepareRead(read_fd, toPointer(first_pid), len, offset, 0);
+        if (!completeRequests(worker_id, 1, [&](uint64_t, int32_t request_result) { result = request_result; }))
+            result = -EIO;
+    } else {
+        result = pread(read_fd, toPointer(first_pid), len, offset);
+        if (result < 0)
+            result = -errno;
+    }
+    eviction_costs.recordRead(len / PAGE_SIZE, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+    if (result != static_cast<ssize_t>(len)) {
+        errno = result < 0 ? -result : 0;
+        std::cout << "[vmcache] " << "Error: Failed to read " << len / PAGE_SIZE << " pages at PID " << first_pid << " (read " << result << " of " << len << " bytes, errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        return false;
+    }
+    stats[worker_id].total_faulted_pages += len / PAGE_SIZE;
+    return true;
+}
+
+void VMCache::abortFault(const PageId pid, uint32_t worker_id) {
+    const size_t num_pages = getPageCount(pid);
+    if (use_exmap) {
+        exmap_interface[worker_id]->iov[0].page = pid;
+        exmap_interface[worker_id]->iov[0].len = num_pages;
+        if (exmapAction(exmap_fd, EXMAP_OP_FREE, 1, worker_id) < 0)
+            throw std::runtime_error("ioctl: EXMAP_OP_FREE");
+    } else {
+        madvise(toPointer(pid), num_pages * PAGE_SIZE, MADV_DONTNEED);
+    }
+    partitioning_strategy->notifyDropped(pid, worker_id);
+    page_states[pid].store(((page_states[pid].load() & ~PAGE_STATE_MASK) + (1ull << PAGE_VERSION_OFFSET)) | PAGE_STATE_EVICTED, std::memory_order_release);
+}
+
+template <typename F>
+bool VMCache::completeRequests(uint32_t worker_id, size_t num_requests, F&& f) {
+    IOUring& ring = *io_rings[worker_id];
+    const int submitted = ring.submitAndWait(0);
+    if (submitted < 0) {
+        std::cout << "[vmcache] " << "Error: Failed to submit I/O requests (errno " << -submitted << ")" << std::endl;
+        return false;
+    }
+    size_t num_completed = 0;
+    while (num_completed < num_requests) {
+        uint64_t user_data;
+        int32_t result;
+        if (!ring.popCompletion(user_data, result)) {
+            ring.submitAndWait(1);
+            continue;
+        }
+        if ((user_data & PREFETCH_REQUEST_TAG) != 0) {
+            finishPrefetchRequest(worker_id, user_data & ~PREFETCH_REQUEST_TAG, result);
+        } else {
+            f(user_data, result);
+            num_completed++;
+        }
+    }
+    return true;
+}
+
+void VMCache::reapPrefetches(uint32_t worker_id, bool wait) {
+    IOUring& ring = *io_rings[worker_id];
+    while (in_flight_prefetches[worker_id].num_pending > 0) {
+        uint64_t user_data;
+        int32_t result;
+        if (ring.popCompletion(user_data, result)) {
+            // other requests are waited for by the worker before it continues, so only prefetch reads complete asynchronously
+            assert((user_data & PREFETCH_REQUEST_TAG) != 0);
+            finishPrefetchRequest(worker_id, user_data & ~PREFETCH_REQUEST_TAG, result);
+            wait = false;
+        } else if (wait) {
+            ring.submitAndWait(1);
+        } else {
+            return;
+        }
+    }
+}
+
+void VMCache::completePrefetches(uint32_t worker_id) {
+    if (!use_io_uring)
+        return;
+    while (in_flight_prefetches[worker_id].num_pending > 0)
+        reapPrefetches(worker_id, true);
+}
+
+void VMCache::finishPrefetchRequest(uint32_t worker_id, size_t request, int32_t result) {
+    InFlightPrefetch& in_flight = in_flight_prefetches[worker_id];
+    const InFlightPrefetch::Request& r = in_flight.requests[request];
+    if (result == static_cast<int32_t>(r.len)) {
+        stats[worker_id].total_faulted_pages += r.len / PAGE_SIZE;
+        // the partitioning strategy may have updated the page states while the pages were faulted
+        for (size_t i = r.begin; i < r.end; i++) {
+            const uint64_t s = page_states[in_flight.latched[i].first].load();
+            page_states[in_flight.latched[i].first].store((s & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED, std::memory_order_release);
+        }
+    } else {
+        // prefetching is only a hint, the pages' next accesses retry the read and report the error
+        errno = result < 0 ? -result : 0;
+        std::cout << "[vmcache] " << "Error: Failed to prefetch " << r.len / PAGE_SIZE << " pages at PID " << in_flight.latched[r.begin].first << " (read " << result << " of " << r.len << " bytes, errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        for (size_t i = r.begin; i < r.end; i++)
+            abortFault(in_flight.latched[i].first, worker_id);
+    }
+    // the requests are processed concurrently, so the batch's latency is amortized over all of its pages
+    if (--in_flight.num_pending == 0)
+        eviction_costs.recordRead(in_flight.num_read_pages, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - in_flight.begin).count());
+}
+
+void VMCache::prefetch(const PageId* pids, size_t num_pids, bool scan, uint32_t worker_id) {
+    for (size_t batch_begin = 0; batch_begin < num_pids; batch_begin += PREFETCH_BATCH_SIZE) {
+        // the ring has an entry for each page of a batch, so the reads of the previous batch have to complete first
+        completePrefetches(worker_id);
+        const size_t batch_end = std::min(num_pids, batch_begin + PREFETCH_BATCH_SIZE);
+        // latch all evicted pages of the batch exclusively, pages that are resident or currently being faulted by another thread are skipped
+        std::pair<PageId, uint64_t> latched[PREFETCH_BATCH_SIZE];
+        size_t num_latched = 0;
+        for (size_t i = batch_begin; i < batch_end; i++) {
+            const PageId pid = pids[i];
+            checkPid(pid);
+            uint64_t s = page_states[pid].load();
+            if (PAGE_STATE(s) != PAGE_STATE_EVICTED)
+                continue;
+            if (page_states[pid].compare_exchange_strong(s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED)) {
+                stats[worker_id].total_accessed_pages++;
+                latched[num_latched++] = std::make_pair(pid, s);
+            }
+        }
+        if (num_latched == 0)
+            continue;
+        std::sort(latched, latched + num_latched);
+        for (size_t i = 0; i < num_latched; i++) {
+            partitioning_strategy->preFault(latched[i].first, scan, worker_id);
+            allocateFrame(latched[i].first, PAGE_NUM_PAGES(latched[i].second), PAGE_MODIFIED(latched[i].second), worker_id);
+        }
+
+        // coalesce adjacent pages (and extents) residing in the same file into runs, each run is read with a single request
+        struct Run {
+            size_t begin; // range of 'latched' covered by the run
+            size_t end;
+            size_t num_pages;
+        };
+        size_t num_runs = 0;
+        Run runs[PREFETCH_BATCH_SIZE];
+        for (size_t i = 0; i < num_latched; i++) {
+            const bool is_modified = PAGE_MODIFIED(latched[i].second);
+            const size_t num_pages = PAGE_NUM_PAGES(latched[i].second);
+            if (!dirty_writeback && is_modified) {
+                simulateRead(worker_id);
+                continue;
+            }
+            if (num_pages == 1 && compressed_tier && compressed_tier->take(latched[i].first, toPointer(latched[i].first)))
+                continue;
+            if (num_runs > 0 && runs[num_runs - 1].end == i) {
+                Run& run = runs[num_runs - 1];
+                const auto& first = latched[run.begin];
+                if (first.first + run.num_pages == latched[i].first && PAGE_MODIFIED(first.second) == is_modified && latched[i].first != virtual_pages) {
+                    run.num_pages += num_pages;
+                    run.end = i + 1;
+                    continue;
+                }
+            }
+            runs[num_runs++] = Run { i, i + 1, num_pages };
+        }
+
+        // pages that are read asynchronously stay latched until their read has completed (see 'finishPrefetchRequest()'), pages whose fault was aborted have been released already
+        bool skip_unlatch[PREFETCH_BATCH_SIZE] = { };
+        if (use_io_uring) {
+            IOUring& ring = *io_rings[worker_id];
+            InFlightPrefetch& batch = in_flight_prefetches[worker_id];
+            std::copy(latched, latched + num_latched, batch.latched);
+            size_t num_requests = 0;
+            batch.num_read_pages = 0;
+            for (size_t r = 0; r < num_runs; r++) {
+                const auto& first = latched[runs[r].begin];
+                const bool is_modified = PAGE_MODIFIED(first.second);
+                const size_t len = getReadableBytes(first.first, runs[r].num_pages, is_modified);
+                if (len == 0)
+                    continue;
+                touchFrames(first.first, len);
+                ring.prepareRead(isInShadowFile(first.first, is_modified) ? shadow_fd : fd, toPointer(first.first), len, first.first * PAGE_SIZE, PREFETCH_REQUEST_TAG | num_requests);
+                batch.requests[num_requests++] = InFlightPrefetch::Request { runs[r].begin, runs[r].end, static_cast<uint32_t>(len) };
+                batch.num_read_pages += len / PAGE_SIZE;
+                std::fill(skip_unlatch + runs[r].begin, skip_unlatch + runs[r].end, true);
+            }
+            if (num_requests > 0) {
+                batch.begin = std::chrono::steady_clock::now();
+                const int submitted = ring.submitAndWait(0);
+                if (submitted < 0) {
+                    std::cout << "[vmcache] " << "Error: Failed to submit prefetch requests (errno " << -submitted << ")" << std::endl;
+                    for (size_t i = 0; i < num_latched; i++) {
+                        if (skip_unlatch[i])
+                            abortFault(latched[i].first, worker_id);
+                    }
+                } else {
+                    batch.num_pending = num_requests;
+                }
+            }
+        } else {
+            for (size_t r = 0; r < num_runs; r++) {
+                const auto& first = latched[runs[r].begin];
+                if (!readPages(first.first, runs[r].num_pages, PAGE_MODIFIED(first.second), worker_id)) {
+                    // prefetching is only a hint, the pages' next accesses retry the read and report the error
+                    for (size_t i = runs[r].begin; i < runs[r].end; i++) {
+                        abortFault(latched[i].first, worker_id);
+                        skip_unlatch[i] = true;
+                    }
+                }
+            }
+        }
+
+        // unlatch the pages that have been faulted already (the partitioning strategy may have updated their page states while they were faulted)
+        for (size_t i = 0; i < num_latched; i++) {
+            if (skip_unlatch[i])
+                continue;
+            const uint64_t s = page_states[latched[i].first].load();
+            page_states[latched[i].first].store((s & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED, std::memory_order_release);
+        }
+    }
+}
+
 // TODO: this should probably be part of the 'PartitioningStrategy'?
 void VMCache::evictAll(bool check_residency, uint32_t worker_id) {
+    // pages with reads in flight are latched until their reads have completed
+    completePrefetches(worker_id);
     size_t evicted_pages = 0;
-    for (PageId pid = 0; pid < virtual_pages; pid++) {
+    const PageId end_pid = num_allocated_pages.load();
+    for (PageId pid = 0; pid < end_pid; pid++) {
         uint64_t s = page_states[pid].load();
-        if (PAGE_STATE(s) == PAGE_STATE_MARKED || PAGE_STATE(s) == PAGE_STATE_FAULTED || PAGE_STATE(s) == PAGE_STATE_UNLOCKED) {
+        // pages modified by uncommitted transactions are not written back (see 'commitTransaction()')
+        if ((PAGE_STATE(s) == PAGE_STATE_MARKED || PAGE_STATE(s) == PAGE_STATE_FAULTED || PAGE_STATE(s) == PAGE_STATE_UNLOCKED) && !PAGE_UNCOMMITTED(s)) {
             if (page_states[pid].compare_exchange_strong(s, (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED)) {
-                if ((s & PAGE_DIRTY_BIT) > 0) {
-                    flushDirtyPage(pid);
+                if ((s & PAGE_DIRTY_BIT) > 0 && !flushDirtyPage(pid)) {
+                    // pages that could not be written are kept in memory
+                    page_states[pid].store((page_states[pid].load() & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED, std::memory_order_release);
+                    continue;
                 }
                 if (use_exmap) {
                     exmap_interface[worker_id]->iov[0].page = pid;
-                    exmap_interface[worker_id]->iov[0].len = 1;
+                    exmap_interface[worker_id]->iov[0].len = PAGE_NUM_PAGES(s);
                     if (exmapAction(exmap_fd, EXMAP_OP_FREE, 1, worker_id) < 0)
                         throw std::runtime_error("ioctl: EXMAP_OP_FREE");
                 } else {
-                    madvise(toPointer(pid), PAGE_SIZE, MADV_DONTNEED);
+                    madvise(toPointer(pid), PAGE_NUM_PAGES(s) * PAGE_SIZE, MADV_DONTNEED);
                 }
                 partitioning_strategy->notifyDropped(pid, worker_id);
                 page_states[pid].store(((page_states[pid].load() & ~PAGE_STATE_MASK) + (1ull << PAGE_VERSION_OFFSET)) | PAGE_STATE_EVICTED, std::memory_order_release);
@@ -235,12 +904,16 @@ void VMCache::evictAll(bool check_residency, uint32_t worker_id) {
         }
     }
 
+    // the cache should be cold afterwards
+    if (compressed_tier)
+        compressed_tier->clear();
+
     if (check_residency) {
-        unsigned char* vec = reinterpret_cast<unsigned char*>(malloc(virtual_pages));
-        mincore(memory, virtual_pages * PAGE_SIZE, vec);
+        unsigned char* vec = reinterpret_cast<unsigned char*>(malloc(end_pid));
+        mincore(memory, end_pid * PAGE_SIZE, vec);
         size_t still_resident_count = 0;
         size_t expected_resident_count = 0;
-        for (size_t i = 0; i < virtual_pages; i++) {
+        for (size_t i = 0; i < end_pid; i++) {
             if ((vec[i] & 0x1) == 0x1) {
                 still_resident_count++;
                 std::cout << "[vmcache] " << "Page " << i << " is resident in memory (" << std::hex << page_states[i].load() << std::dec << ")" << std::endl;
@@ -258,23 +931,244 @@ void VMCache::printMemoryUsage() const {
     partitioning_strategy->printMemoryUsage();
 }
 
-void VMCache::flushDirtyPage(const PageId pid) {
+bool VMCache::flushDirtyPage(const PageId pid) {
     uint64_t offset = PAGE_SIZE * pid;
+    const ssize_t len = getPageCount(pid) * PAGE_SIZE;
     // note: we write all dirty pages to the shadow file first, modified pages are only copied to the database file on shutdown if we are not in sandbox mode
-    auto written = pwrite(shadow_fd, toPointer(pid), PAGE_SIZE, offset);
-    if (written != PAGE_SIZE) {
-        std::cout << "[vmcache] " << "Error: Failed to write page (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+    //  spilled temporary pages are located behind the database's pages in the shadow file and are never copied (see 'isSpillablePage()')
+    //  when using the write-ahead log, data pages are written to the database file directly (see 'isInShadowFile()')
+    auto written = pwrite(isInShadowFile(pid, true) ? shadow_fd : fd, toPointer(pid), len, offset);
+    if (written != len) {
+        std::cout << "[vmcache] " << "Error: Failed to write page " << pid << " (errno " << errno << ", " << errnoStr() << ")" << std::endl;
         errno = 0;
-        // TODO: proper error handling (but what should we even do if this write fails???)
+        return false;
     }
+    markFlushed(pid, offset + len);
+    return true;
+}
+
+size_t VMCache::flushDirtyPages(PageId* pids, size_t num_pids, uint32_t worker_id) {
+    std::sort(pids, pids + num_pids);
+    // pages with adjacent PIDs are adjacent both in memory and in the shadow file, so each run can be written from a single buffer
+    std::pair<size_t, size_t> runs[PREFETCH_BATCH_SIZE]; // (index into 'pids', number of pids)
+    size_t run_pages[PREFETCH_BATCH_SIZE]; // number of pages of each run, extents count with all of their pages
+    bool written[PREFETCH_BATCH_SIZE];
+    size_t total_pages = 0;
+    size_t i = 0;
+    while (i < num_pids) {
+        size_t num_runs = 0;
+        size_t batch_pages = 0;
+        while (i < num_pids && num_runs < PREFETCH_BATCH_SIZE) {
+            size_t run_length = 1;
+            size_t num_pages = getPageCount(pids[i]);
+            while (i + run_length < num_pids && pids[i + run_length] == pids[i] + num_pages && pids[i + run_length] != virtual_pages) {
+                num_pages += getPageCount(pids[i + run_length]);
+                run_length++;
+            }
+            run_pages[num_runs] = num_pages;
+            runs[num_runs++] = std::make_pair(i, run_length);
+            batch_pages += num_pages;
+            i += run_length;
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        if (use_io_uring) {
+            IOUring& ring = *io_rings[worker_id];
+            for (size_t r = 0; r < num_runs; r++) {
+                const PageId first_pid = pids[runs[r].first];
+                ring.prepareWrite(isInShadowFile(first_pid, true) ? shadow_fd : fd, toPointer(first_pid), run_pages[r] * PAGE_SIZE, first_pid * PAGE_SIZE, r);
+                written[r] = false;
+            }
+            // if submitting fails, none of the runs has been written
+            completeRequests(worker_id, num_runs, [&](uint64_t r, int32_t result) {
+                written[r] = result == static_cast<int32_t>(run_pages[r] * PAGE_SIZE);
+                if (!written[r])
+                    errno = result < 0 ? -result : 0;
+            });
+        } else {
+            for (size_t r = 0; r < num_runs; r++) {
+                const PageId first_pid = pids[runs[r].first];
+                const size_t len = run_pages[r] * PAGE_SIZE;
+                written[r] = pwrite(isInShadowFile(first_pid, true) ? shadow_fd : fd, toPointer(first_pid), len, first_pid * PAGE_SIZE) == static_cast<ssize_t>(len);
+            }
+        }
+        eviction_costs.recordWrite(batch_pages, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+
+        for (size_t r = 0; r < num_runs; r++) {
+            if (!written[r]) {
+                // the run's pages remain dirty, so they are not evicted and written again by a later flush
+                std::cout << "[vmcache] " << "Error: Failed to write " << run_pages[r] << " pages at PID " << pids[runs[r].first] << " (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+                errno = 0;
+                continue;
+            }
+            const uint64_t end_offset = (pids[runs[r].first] + run_pages[r]) * PAGE_SIZE;
+            for (size_t j = runs[r].first; j < runs[r].first + runs[r].second; j++)
+                markFlushed(pids[j], end_offset);
+            total_pages += run_pages[r];
+        }
+    }
+    return total_pages;
+}
+
+void VMCache::markFlushed(const PageId pid, uint64_t end_offset) {
+    // make the page readable for faults before marking it as modified below
+    std::atomic_uint64_t& file_size = isInShadowFile(pid, true) ? shadow_file_size : db_file_size;
+    uint64_t current_size = file_size.load();
+    while (current_size < end_offset && !file_size.compare_exchange_weak(current_size, end_offset)) { }
     // clear dirty bit, set modified bit
     uint64_t s = page_states[pid].load();
     uint64_t new_s;
     do {
         new_s = (s & ~PAGE_DIRTY_BIT) | PAGE_MODIFIED_BIT;
     } while(!page_states[pid].compare_exchange_weak(s, new_s));
-    // update statistics
-    num_dirty_pages--;
+    // update statistics (the page may have been flushed concurrently by a checkpoint)
+    if ((s & PAGE_DIRTY_BIT) > 0)
+        num_dirty_pages--;
+}
+
+void VMCache::beginTransaction(uint32_t worker_id) {
+    if (wal == nullptr)
+        return;
+    assert(!write_sets[worker_id].active);
+    write_sets[worker_id].active = true;
+}
+
+void VMCache::captureImage(PageId pid, uint32_t worker_id) {
+    WALWriteSet& write_set = write_sets[worker_id];
+    auto it = write_set.image_offsets.find(pid);
+    if (it == write_set.image_offsets.end()) {
+        // the first image of the page in this transaction, the page remains uncommitted until all transactions that modified it have committed
+        std::lock_guard<std::mutex> guard(uncommitted_pages_mutex);
+        if (write_set.image_offsets.empty())
+            write_set.first_capture_lsn = wal->getCurrentLSN();
+        it = write_set.image_offsets.emplace(pid, WALImage { write_set.images.size(), 0 }).first;
+        write_set.images.resize(write_set.images.size() + PAGE_SIZE);
+        uncommitted_pages[pid]++;
+    }
+    // the page is latched exclusively and its version is incremented when the latch is released, so images captured later have higher versions
+    it->second.version = PAGE_VERSION(page_states[pid].load());
+    memcpy(write_set.images.data() + it->second.offset, toPointer(pid), PAGE_SIZE);
+}
+
+void VMCache::commitTransaction(uint32_t worker_id) {
+    if (wal == nullptr)
+        return;
+    WALWriteSet& write_set = write_sets[worker_id];
+    if (write_set.free_list_changed && free_list_anchor_pid != INVALID_PAGE_ID) {
+        // the anchor is logged together with the pages the transaction allocated or freed; it is latched only here, where the transaction holds no other latches
+        //  note: the anchor is written even if another transaction has written it since, as that transaction's records may not be durable yet
+        writeFreePageListAnchor(worker_id);
+    }
+    write_set.free_list_changed = false;
+    write_set.active = false;
+    for (const PageId pid : write_set.pids) {
+        if (write_set.image_offsets.count(pid) == 0)
+            throw std::runtime_error("Page " + std::to_string(pid) + " was latched exclusively by a transaction, but released without capturing its image");
+    }
+    write_set.pids.clear();
+    if (write_set.image_offsets.empty())
+        return;
+    // note: there is no rollback, so the captured state of the pages is what needs to be redone after a crash
+    uint64_t lsn = 0;
+    for (const auto& [pid, image] : write_set.image_offsets)
+        lsn = wal->append(pid, image.version, write_set.images.data() + image.offset);
+    {
+        std::lock_guard<std::mutex> guard(uncommitted_pages_mutex);
+        write_set.first_capture_lsn = std::numeric_limits<uint64_t>::max();
+    }
+    wal->flush(lsn);
+    // the changes are durable, so the pages may be written to the database file once no other active transaction has modified them
+    for (const auto& [pid, image] : write_set.image_offsets) {
+        fixExclusive(pid, worker_id);
+        uint64_t s = page_states[pid].load();
+        {
+            std::lock_guard<std::mutex> guard(uncommitted_pages_mutex);
+            auto it = uncommitted_pages.find(pid);
+            if (--it->second == 0) {
+                uncommitted_pages.erase(it);
+                s &= ~PAGE_UNCOMMITTED_BIT;
+            }
+        }
+        unlatchExclusive(pid, s);
+    }
+    write_set.image_offsets.clear();
+    write_set.images.clear();
+}
+
+bool VMCache::checkpointPage(PageId pid, size_t& pages_written) {
+    uint64_t s = page_states[pid].load();
+    while ((s & PAGE_DIRTY_BIT) > 0) {
+        // latch the page in shared mode to write it out, evicted pages are never dirty; exclusively latched and uncommitted pages are retried later
+        const uint64_t state = PAGE_STATE(s);
+        uint64_t new_s;
+        if (PAGE_UNCOMMITTED(s)) {
+            return false;
+        } else if (state == PAGE_STATE_UNLOCKED || state == PAGE_STATE_MARKED || state == PAGE_STATE_FAULTED) {
+            new_s = (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN;
+        } else if (state >= PAGE_STATE_LOCKED_SHARED_MIN && state < PAGE_STATE_LOCKED_SHARED_MAX) {
+            new_s = (s & ~PAGE_STATE_MASK) | (state + 1);
+        } else {
+            return false;
+        }
+        if (page_states[pid].compare_exchange_weak(s, new_s)) {
+            // pages that could not be written remain dirty and keep the log from being released
+            const bool written = flushDirtyPage(pid);
+            unfixShared(pid);
+            if (!written)
+                return false;
+            pages_written += PAGE_NUM_PAGES(s);
+            break;
+        }
+    }
+    return true;
+}
+
+size_t VMCache::checkpoint() {
+    if (wal == nullptr)
+        return 0;
+    // all transactions that appended their records before this point have modified the pages written below
+    //  the log is kept from the first capture of each transaction that has not appended its records yet: its images may be older than those that other
+    //  transactions appended before this point, which are written below, so recovery has to see the newer records as well to keep the newest image of each page
+    uint64_t checkpoint_lsn;
+    {
+        std::lock_guard<std::mutex> guard(uncommitted_pages_mutex);
+        checkpoint_lsn = wal->getCurrentLSN();
+        for (const WALWriteSet& write_set : write_sets)
+            checkpoint_lsn = std::min(checkpoint_lsn, write_set.first_capture_lsn);
+    }
+    size_t pages_written = 0;
+    std::vector<PageId> skipped_pids;
+    // allocations and frees outside of transactions are only persisted through the anchor written here (see 'writeFreePageListAnchor()')
+    bool anchor_written = free_list_anchor_pid == INVALID_PAGE_ID || checkpointFreePageListAnchor();
+    const PageId end_pid = num_allocated_pages.load();
+    for (PageId pid = 0; pid < end_pid; pid++) {
+        if (!checkpointPage(pid, pages_written))
+            skipped_pids.push_back(pid);
+    }
+    // retry pages that were latched exclusively or modified by uncommitted transactions a bounded number of times instead of waiting for them
+    for (size_t round = 1; round < CHECKPOINT_MAX_ROUNDS && (!skipped_pids.empty() || !anchor_written); round++) {
+        std::this_thread::yield();
+        if (!anchor_written && checkpointFreePageListAnchor()) {
+            anchor_written = true;
+            skipped_pids.push_back(free_list_anchor_pid);
+        }
+        size_t num_skipped = 0;
+        for (const PageId pid : skipped_pids) {
+            if (!checkpointPage(pid, pages_written))
+                skipped_pids[num_skipped++] = pid;
+        }
+        skipped_pids.resize(num_skipped);
+    }
+    // evictions only write pages without syncing, so sync the database file as a whole before releasing the log
+    if (fdatasync(fd) != 0) {
+        std::cout << "[vmcache] " << "Error: Failed to sync database file for checkpoint (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        return pages_written;
+    }
+    // the log still contains changes of the skipped pages that are not in the database file, so it is only released by a later checkpoint
+    if (skipped_pids.empty() && anchor_written)
+        wal->checkpoint(checkpoint_lsn);
+    return pages_written;
 }
 
 size_t VMCache::getNumLatchedDataPages() const {
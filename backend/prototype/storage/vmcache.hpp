@@ -2,25 +2,78 @@
 
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <stdint.h>
+#include <string>
 #include <sys/mman.h>
+#include <thread>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 #include "../core/units.hpp"
 #include "../utils/errno.hpp"
+#include "compressed_page_tier.hpp"
+#include "eviction_cost.hpp"
 #include "policy/partitioning_strategy.hpp"
+#include "io_uring.hpp"
 #include "page.hpp"
+#include "temp_memory_budget.hpp"
+#include "temp_page_pool.hpp"
+#include "wal.hpp"
 #include "linux/exmap.h"
 
 // threshold for considering temporary allocations as "large" (and thereby use the eviction target mechanism if enabled)
 //  (in pages)
 #define LARGE_ALLOCATION_THRESHOLD (4ul * 1024ul * 1024ul / PAGE_SIZE)
+// "large" temporary allocations are backed by transparent huge pages of this size
+#define HUGE_PAGE_SIZE (2ul * 1024ul * 1024ul)
+// fraction of the capacity that dropped huge page backed regions may occupy while they are kept for reuse (see 'HugePageRegionPool')
+#define HUGE_PAGE_POOL_FRACTION 0.125
+// maximum number of pages that are faulted in a single batch by 'VMCache::prefetch()' (this is also the number of entries in each worker's io_uring)
+#define PREFETCH_BATCH_SIZE 64ul
+// set in the user data of prefetch reads, which may still be in flight while a worker issues other requests on its io_uring (see 'VMCache::reapPrefetches()')
+#define PREFETCH_REQUEST_TAG (1ull << 63)
+// spillable temporary pages use the page ids following the database's page range, the spill area is sized relative to the number of virtual pages
+#define SPILL_AREA_PAGES(virtual_pages) ((virtual_pages) / 4ul)
+// default fraction of the capacity that page cleaner threads keep free
+#define PAGE_CLEANER_DEFAULT_WATERMARK 0.02
+// time that page cleaner threads sleep when there is nothing to clean (in microseconds)
+#define PAGE_CLEANER_IDLE_US 100
+// number of passes a checkpoint makes over the pages it could not latch (see 'VMCache::checkpoint()')
+#define CHECKPOINT_MAX_ROUNDS 8
+
+// layout of pages on the free page list; the list is threaded through the free pages themselves
+struct FreePage {
+    PageId next;
+};
+
+// persistent head of the free page list, embedded into a page of the cache's owner (see 'VMCache::openFreePageList()')
+struct FreePageListAnchor {
+    PageId head;
+    uint64_t num_pages;
+};
+
+// prefetch batch whose reads are in flight on a worker's io_uring, its pages stay latched exclusively until their read has completed
+struct InFlightPrefetch {
+    struct Request {
+        size_t begin; // range of 'latched' read by the request
+        size_t end;
+        uint32_t len;
+    };
+
+    std::pair<PageId, uint64_t> latched[PREFETCH_BATCH_SIZE]; // latched pages and their states before latching
+    Request requests[PREFETCH_BATCH_SIZE];
+    size_t num_pending = 0;
+    size_t num_read_pages = 0;
+    std::chrono::steady_clock::time_point begin;
+};
 
 struct alignas(64) VMCacheStats {
     std::atomic_uint64_t total_accessed_pages;
@@ -30,12 +83,31 @@ struct alignas(64) VMCacheStats {
 
 int exmapAction(int exmapfd, exmap_opcode op, uint16_t len, uint32_t worker_id);
 
+// configuration of a VMCache instance, the defaults disable all optional features
+struct VMCacheConfig {
+    uint64_t max_size = 0; // memory limit in bytes, including VMCache's own data structures
+    uint64_t virtual_pages = 4ull * 1024ull * 1024ull; // maximum database size in pages
+    std::string path; // database file, the shadow file, the extent file and the write-ahead log are stored next to it
+    bool sandbox = false;
+    bool no_dirty_writeback = false;
+    bool flush_asynchronously = false;
+    bool use_eviction_target = false;
+    bool use_exmap = false;
+    bool use_io_uring = false;
+    bool use_wal = false; // cannot be combined with extents, 'VMCache::allocateExtent()' throws if the write-ahead log is enabled
+    bool stats_on_shutdown = false;
+    size_t num_workers = 1;
+    size_t num_page_cleaners = 0;
+    double page_cleaner_watermark = PAGE_CLEANER_DEFAULT_WATERMARK;
+    double compressed_tier_fraction = 0.0;
+};
+
 class alignas(64) VMCache {
     template<class T>
     friend struct OptimisticGuard;
 
 public:
-    VMCache(uint64_t max_size, uint64_t virtual_pages, const std::string& path, bool sandbox, bool no_dirty_writeback, bool flush_asynchronously, bool use_eviction_target, std::unique_ptr<PartitioningStrategy>&& partitioning_strategy, bool use_exmap, bool stats_on_shutdown, const size_t num_workers);
+    VMCache(const VMCacheConfig& config, std::unique_ptr<PartitioningStrategy>&& partitioning_strategy);
     ~VMCache();
 
     VMCache(const VMCache& other) = delete;
@@ -43,12 +115,46 @@ public:
     VMCache& operator=(const VMCache& other) = delete;
     VMCache& operator=(VMCache&& other) = delete;
 
-    PageId allocatePage();
+    PageId allocatePage(uint32_t worker_id); // reuses a page from the free page list if possible, returned pages are always zeroed
+    // adds a page that is no longer referenced to the free page list; the caller must hold the page's exclusive latch, which is released by this call
+    void freePage(PageId pid, uint32_t worker_id);
+    // allocates EXTENT_NUM_PAGES consecutive pages that are latched, faulted, evicted and written as a unit through the page state of the first one, which is returned
+    //  the first page ids of extents are recorded in the extent file, from which their page class is restored on startup
+    //  note: extents are never reused and cannot be combined with the write-ahead log, whose records hold single pages; throws if it is enabled
+    PageId allocateExtent(uint32_t worker_id);
+    // number of pages covered by the page state of 'pid'
+    inline size_t getPageCount(PageId pid) const { return PAGE_NUM_PAGES(page_states[pid].load()); }
     inline bool isEmpty() const { return num_allocated_pages == 0; }
+    size_t getNumAllocatedPages() const { return num_allocated_pages.load(); }
+    // loads the free page list whose head is stored at 'anchor_offset' in page 'anchor_pid' (see 'FreePageListAnchor', initialized by the owner to an empty list) by following the links of all free pages once
+    //  afterwards, the list is served from memory and the anchor is written lazily: by committing transactions that allocated or freed pages (so that the
+    //  anchor is logged together with these pages), by checkpoints and on shutdown; without an anchor, the list is not persisted
+    void openFreePageList(PageId anchor_pid, size_t anchor_offset, uint32_t worker_id);
+    PageId getFreePageListHead() const;
+    size_t getNumFreePages() const { return num_free_pages.load(); }
     char* allocateTemporaryPage(uint32_t worker_id); // allocates a page for temporary use and latches it exclusively
-    char* allocateTemporaryHugePage(const size_t num_pages, uint32_t worker_id);
+    // allocations above LARGE_ALLOCATION_THRESHOLD are aligned to and backed by transparent huge pages, their contents are undefined (regions are reused); 'page_cost_ns' optionally hints the cost of recomputing a page of the allocation if it had to be given up (see 'EvictionCostModel')
+    char* allocateTemporaryHugePage(const size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns = 0);
     void dropTemporaryPage(char* page, uint32_t worker_id);
     void dropTemporaryHugePage(char* page, const size_t num_pages, uint32_t worker_id);
+    // returns all of the worker's pooled temporary pages to the allocator
+    void releaseTemporaryPagePool(uint32_t worker_id);
+    // returns the pooled temporary pages of all workers and the pooled huge page backed regions to the allocator, called at the end of each query and when a partition runs out of frames
+    void releaseTemporaryPagePools();
+    size_t getNumPooledTemporaryPages() const { return static_cast<size_t>(std::max(0l, num_pooled_temporary_pages.load())); }
+    // allocates a zeroed temporary page that is latched exclusively; unlike other temporary pages, a spillable page can be evicted to disk while it is not latched and is faulted back in on its next fix
+    PageId allocateSpillablePage(uint32_t worker_id);
+    // the page must not be latched by the caller
+    void dropSpillablePage(PageId pid, uint32_t worker_id);
+    inline bool isSpillablePage(PageId pid) const { return pid >= virtual_pages; }
+    size_t getNumSpillablePagesInUse() const { return num_spillable_pages_in_use.load(); }
+    TempMemoryBudget* getTempMemoryBudget(uint32_t worker_id) const { return temp_memory_budgets[worker_id]; }
+    // sets the budget that the worker's temporary allocations are charged to (nullptr: none), returns the previous one
+    TempMemoryBudget* exchangeTempMemoryBudget(uint32_t worker_id, TempMemoryBudget* budget) {
+        TempMemoryBudget* previous = temp_memory_budgets[worker_id];
+        temp_memory_budgets[worker_id] = budget;
+        return previous;
+    }
 
     size_t getMaxPhysicalPages() const { return max_physical_pages; }
     const PartitioningStrategy& getPartitions() const { return *partitioning_strategy; }
@@ -68,6 +174,8 @@ public:
     inline char* fixExclusive(PageId pid, uint32_t worker_id) {
         stats[worker_id].total_accessed_pages++;
         checkPid(pid);
+        traceAccess(pid, CacheAction::Write, worker_id);
+        logModification(pid, worker_id);
         uint64_t s = page_states[pid].load();
         while (true) {
             const uint64_t state = PAGE_STATE(s);
@@ -84,26 +192,40 @@ public:
                     return toPointer(pid);
                 }
             } else {
+                waitForLatch(worker_id);
                 s = page_states[pid].load();
             }
         }
     }
 
     inline void unfixExclusive(PageId pid) {
+        checkPid(pid);
+        unlatchExclusive(pid, page_states[pid].load());
+    }
+
+    // releases an exclusive latch on a page that was only read while latched, its dirty state is left unchanged (so that, e.g., a clean spilled page is not written again on eviction)
+    inline void unfixExclusiveUnmodified(PageId pid) {
         checkPid(pid);
         const uint64_t s = page_states[pid].load();
-        const uint64_t dirty_bit = dirty_writeback ? PAGE_DIRTY_BIT : PAGE_MODIFIED_BIT;
-        const uint64_t new_s = ((s + (1ull << PAGE_VERSION_OFFSET)) & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED | dirty_bit;
-        assert(PAGE_STATE(new_s) == PAGE_STATE_UNLOCKED);
-        page_states[pid].store(new_s, std::memory_order_release);
-        // update statistics
-        if (dirty_writeback && (s & PAGE_DIRTY_BIT) == 0) // page was not already dirty
-            num_dirty_pages++;
+        assert(PAGE_STATE(s) == PAGE_STATE_LOCKED);
+        page_states[pid].store((s & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED, std::memory_order_release);
+    }
+
+    // releases a page that may have been modified by a transaction of 'worker_id' (see 'beginTransaction()'), pages latched exclusively within a transaction have to be released this way
+    inline void unfixExclusive(PageId pid, uint32_t worker_id) {
+        checkPid(pid);
+        if (wal != nullptr && write_sets[worker_id].active && pid < virtual_pages) {
+            captureImage(pid, worker_id);
+            unlatchExclusive(pid, page_states[pid].load() | PAGE_UNCOMMITTED_BIT);
+        } else {
+            unlatchExclusive(pid, page_states[pid].load());
+        }
     }
 
     inline char* fixShared(PageId pid, uint32_t worker_id, bool scan = false) {
         stats[worker_id].total_accessed_pages++;
         checkPid(pid);
+        traceAccess(pid, scan ? CacheAction::ScanRef : CacheAction::Ref, worker_id);
         uint64_t s = page_states[pid].load();
         while (true) {
             const uint64_t state = PAGE_STATE(s);
@@ -112,8 +234,8 @@ public:
                 const uint64_t new_s = (s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED;
                 if (page_states[pid].compare_exchange_weak(s, new_s)) {
                     fault(pid, PAGE_MODIFIED(s), scan, worker_id);
-                    // downgrade to shared latch
-                    page_states[pid].store((new_s & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN);
+                    // downgrade to shared latch (the partitioning strategy may have updated the page state while the page was faulted)
+                    page_states[pid].store((page_states[pid].load() & ~PAGE_STATE_MASK) | PAGE_STATE_LOCKED_SHARED_MIN);
                     return toPointer(pid);
                 }
             } else if (state == PAGE_STATE_MARKED || state == PAGE_STATE_UNLOCKED) {
@@ -131,6 +253,7 @@ public:
                     return toPointer(pid);
                 }
             } else {
+                waitForLatch(worker_id);
                 s = page_states[pid].load();
             }
         }
@@ -147,42 +270,101 @@ public:
         }
     }
 
+    // records a page access in the cache trace (see 'CacheTracer'), used for replaying the accesses against other eviction policies offline
+#ifdef COLLECT_CACHE_TRACES
+    inline void traceAccess(const PageId pid, CacheAction action, uint32_t worker_id) {
+        partitioning_strategy->traceAccess(pid, action, worker_id);
+    }
+#else
+    inline void traceAccess(const PageId, CacheAction, uint32_t) { }
+#endif
+
+    // write-ahead logging: images of all pages that a worker latches exclusively between 'beginTransaction()' and 'commitTransaction()' are logged on commit
+    //  the image of a page is captured whenever the transaction releases its exclusive latch, so it does not contain changes made by later transactions; until the commit, the page is marked as uncommitted and is neither evicted nor written back (no-steal)
+    //  note: there is no concurrency control, so an image may still contain uncommitted changes of another transaction that released the page before
+    //  note: images are logged with the page's version at capture, so recovery restores the image captured last even if the transactions committed in a different order
+    //  note: small jobs are executed by the scheduling worker itself (see 'Dispatcher::scheduleJob()'), so this covers all changes made by OLTP queries
+    bool isUsingWAL() const { return wal != nullptr; }
+    void beginTransaction(uint32_t worker_id);
+    void commitTransaction(uint32_t worker_id); // returns once the transaction's changes are durable
+    inline void logModification(PageId pid, uint32_t worker_id) {
+        if (wal != nullptr && write_sets[worker_id].active && pid < virtual_pages)
+            write_sets[worker_id].pids.push_back(pid);
+    }
+    // fuzzy checkpoint: writes all dirty pages to the database file while transactions keep running, afterwards the log preceding the checkpoint is no longer needed; returns the number of written pages
+    //  pages that remain latched exclusively or uncommitted after CHECKPOINT_MAX_ROUNDS rounds are skipped, the log is then kept until a later checkpoint writes them
+    size_t checkpoint();
+
+    // faults all currently evicted pages out of 'pids' in batches, adjacent pages are read using a single I/O request; faulted pages are left unlatched, pages that could not be read are left evicted
+    //  with io_uring, the reads of the last batch are only submitted and remain in flight while the worker continues, its pages stay latched until the worker reaps their
+    //  completions, i.e., on its next I/O request, while it waits for one of their latches, or in 'completePrefetches()'
+    //  note: demand faults in 'fixShared()' and 'fixExclusive()' still wait for their read, as the faulting worker cannot continue without the page; scans overlap their reads by prefetching ahead (see 'GeneralPagedVectorIterator')
+    void prefetch(const PageId* pids, size_t num_pids, bool scan, uint32_t worker_id);
+    // waits for the worker's prefetch reads that are still in flight and unlatches their pages; workers call this after each morsel, so that prefetched pages do not stay latched while they execute other work
+    void completePrefetches(uint32_t worker_id);
+
     void printMemoryUsage() const;
     void evictAll(bool check_residency, uint32_t worker_id); // evicts all pages that are not currently locked
 
+    size_t getNumThreads() const { return num_threads; } // workers and page cleaners, i.e., the number of valid worker ids
     size_t getTotalAccessedPageCount() const {
         size_t result = 0;
-        for (size_t i = 0; i < num_workers; ++i)
+        for (size_t i = 0; i < num_threads; ++i)
             result += stats[i].total_accessed_pages.load();
         return result;
     }
     size_t getTotalFaultedPageCount() const {
         size_t result = 0;
-        for (size_t i = 0; i < num_workers; ++i)
+        for (size_t i = 0; i < num_threads; ++i)
             result += stats[i].total_faulted_pages.load();
         return result;
     }
     size_t getTotalEvictedPageCount() const { return partitioning_strategy->getTotalEvictedPageCount(); }
     size_t getTotalDirtyWritePageCount() const { return partitioning_strategy->getTotalDirtyWritePageCount(); }
     size_t getDirtyPageCount() const { return static_cast<size_t>(std::max(0l, num_dirty_pages.load())); }
+    const EvictionCostModel& getEvictionCosts() const { return eviction_costs; }
+    EvictionCostModel& getEvictionCosts() { return eviction_costs; }
+    const CompressedPageTier* getCompressedTier() const { return compressed_tier.get(); }
 
 
     bool performIdleMaintenance(uint32_t worker_id) {
         return partitioning_strategy->performIdleMaintenance(worker_id);
     }
+    // number of free frames that page cleaner threads maintain (zero if there are none)
+    size_t getPageCleanerFreePages() const { return page_cleaners.empty() ? 0 : page_cleaner_free_pages; }
+    bool isUsingDirtyWriteback() const { return dirty_writeback; }
     bool isUsingAsyncFlushing() const { return flush_asynchronously; }
     bool isUsingEvictionTarget() const { return use_eviction_target; }
+    bool isUsingIOUring() const { return use_io_uring; }
+
+    // id of the worker running on the calling thread, or 'fallback' for threads that are not registered as workers (see 'ExecutionContext')
+    //  this is used where resources are released without a context, e.g., by destructors that may run on another worker than the one that allocated the resource
+    static uint32_t getCurrentWorkerId(uint32_t fallback) { return current_worker_id != std::numeric_limits<uint32_t>::max() ? current_worker_id : fallback; }
+    static void setCurrentWorkerId(uint32_t worker_id) { current_worker_id = worker_id; }
 
 private:
+    inline static thread_local uint32_t current_worker_id = std::numeric_limits<uint32_t>::max();
+
 #ifdef DEBUG
     inline void checkPid(const PageId pid) {
-        if (pid > num_allocated_pages)
+        if (pid >= virtual_pages ? pid >= virtual_pages + spill_pages : pid > num_allocated_pages)
             throw std::runtime_error("Invalid PID");
     }
 #else
     inline void checkPid(const PageId) { }
 #endif
 
+    char* allocateTemporaryPages(const size_t num_pages, uint32_t worker_id, uint64_t page_cost_ns);
+    // the region is preceded by a regular page holding the TempBlockHeader, so that the owner of every temporary allocation is found the same way
+    char* allocateHugePageBacked(const size_t num_pages, uint32_t owner);
+    void unmapHugePageBacked(char* region, const size_t huge_page_backed_pages);
+
+    // number of pages occupied by a huge page backed allocation of 'num_pages' pages
+    static inline size_t getHugePageBackedPageCount(const size_t num_pages) {
+        const size_t pages_per_huge_page = HUGE_PAGE_SIZE / PAGE_SIZE;
+        return (num_pages + pages_per_huge_page - 1) / pages_per_huge_page * pages_per_huge_page;
+    }
+
     inline void addToTemporaryPagesInUse(size_t num_pages) {
         int64_t n = num_pages;
         const int64_t temp_in_use = num_temporary_pages_in_use.fetch_add(n) + n;
@@ -190,44 +372,122 @@ private:
         while (peak_temp_in_use < temp_in_use && !peak_num_temporary_pages_in_use.compare_exchange_weak(peak_temp_in_use, temp_in_use, std::memory_order_relaxed)) { }
     }
 
+    // faults the page latched exclusively by the caller; if it cannot be read, it is left evicted (and unlatched) and an exception is thrown
     inline void fault(const PageId pid, bool is_modified, bool scan, uint32_t worker_id) {
+        const size_t num_pages = getPageCount(pid);
         partitioning_strategy->preFault(pid, scan, worker_id);
+        allocateFrame(pid, num_pages, is_modified, worker_id);
+        if (!dirty_writeback && is_modified) {
+            simulateRead(worker_id);
+            return;
+        }
+        if (num_pages == 1 && compressed_tier && compressed_tier->take(pid, toPointer(pid)))
+            return;
+        if (!readPages(pid, num_pages, is_modified, worker_id)) {
+            abortFault(pid, worker_id);
+            throw std::runtime_error("Failed to read page " + std::to_string(pid));
+        }
+    }
+
+    // gives up the frame of a page that is latched exclusively for faulting but could not be read and releases the latch, the page is left evicted so that its next access retries the read
+    void abortFault(const PageId pid, uint32_t worker_id);
+
+    // called while spinning on a latch, which may be held by one of the worker's own prefetch reads
+    inline void waitForLatch(uint32_t worker_id) {
+        if (use_io_uring && in_flight_prefetches[worker_id].num_pending > 0)
+            reapPrefetches(worker_id, true);
+    }
+    // processes the available completions of the worker's prefetch reads, waits for at least one of them if 'wait' is set
+    void reapPrefetches(uint32_t worker_id, bool wait);
+    // unlatches the pages of a completed prefetch read, or leaves them evicted if the read failed
+    void finishPrefetchRequest(uint32_t worker_id, size_t request, int32_t result);
+    // submits the requests queued on the worker's ring and calls 'f(user_data, result)' for each of their 'num_requests' completions, completions of prefetch reads that are reaped meanwhile are processed as well; returns false if the requests could not be submitted
+    template <typename F>
+    bool completeRequests(uint32_t worker_id, size_t num_requests, F&& f);
+
+    inline void allocateFrame(const PageId pid, size_t num_pages, bool is_modified, uint32_t worker_id) {
         // exmap allocation
         if (use_exmap && (dirty_writeback || !is_modified)) {
             exmap_interface[worker_id]->iov[0].page = pid;
-            exmap_interface[worker_id]->iov[0].len = 1;
+            exmap_interface[worker_id]->iov[0].len = num_pages;
             while (exmapAction(exmap_fd, EXMAP_OP_ALLOC, 1, worker_id) < 0) {
                 std::cerr << "fault errno: " << errno << " pid: " << pid << " worker_id: " << worker_id << std::endl;
             }
         }
-        // read the page from disk
-        if (!dirty_writeback && is_modified) {
-            // if we are not writing back dirty pages (but keeping them in memory) and the page was already faulted previously, do a dummy read here to simulate the latency of a real page fault
-            char DUMMY_READ_DEST[PAGE_SIZE];
-            stats[worker_id].total_faulted_pages++;
-            pread(fd, DUMMY_READ_DEST, PAGE_SIZE, 0);
-            return;
-        }
-        const size_t offset = pid * PAGE_SIZE;
-        int read_fd = is_modified ? shadow_fd : fd;
-        if (lseek(read_fd, 0, SEEK_END) >= static_cast<off_t>(offset + PAGE_SIZE)) {
-            if (pread(read_fd, toPointer(pid), PAGE_SIZE, offset) != PAGE_SIZE) {
-                if (errno != 0) { // if errno == 0, the page simply did not exist in the database file yet, this is fine
-                    std::cout << "[vmcache] " << "Error: Failed to read page (errno " << errno << ", " << errnoStr() << ")" << std::endl;
-                    errno = 0;
-                    // TODO: proper error handling
-                }
-            } else {
-                stats[worker_id].total_faulted_pages++;
-            }
+    }
+
+    inline void simulateRead(uint32_t worker_id) {
+        // if we are not writing back dirty pages (but keeping them in memory) and the page was already faulted previously, do a dummy read here to simulate the latency of a real page fault
+        char DUMMY_READ_DEST[PAGE_SIZE];
+        stats[worker_id].total_faulted_pages++;
+        pread(fd, DUMMY_READ_DEST, PAGE_SIZE, 0);
+    }
+
+    // when using the write-ahead log, dirty data pages are written to the database file directly, otherwise modified pages reside in the shadow file until shutdown
+    inline bool isInShadowFile(const PageId pid, bool is_modified) const {
+        return is_modified && (wal == nullptr || isSpillablePage(pid));
+    }
+
+    // with io_uring, the kernel may fill the frames from one of its own worker threads, which would place them on that thread's NUMA node under the
+    //  first-touch policy; touching the released frames first places them on the node of the faulting worker (exmap frames are placed by the module)
+    inline void touchFrames(const PageId first_pid, size_t len) {
+        if (use_io_uring && !use_exmap) {
+            for (size_t offset = 0; offset < len; offset += PAGE_SIZE)
+                reinterpret_cast<volatile char*>(toPointer(first_pid))[offset] = 0;
         }
     }
 
+    // reads 'num_pages' consecutive pages starting at 'first_pid' from the database or shadow file and waits for the read; pages that do not exist in the file yet are left zeroed
+    //  returns false if the pages could not be read completely, their frames then hold no valid data
+    bool readPages(const PageId first_pid, size_t num_pages, bool is_modified, uint32_t worker_id);
+    size_t getReadableBytes(const PageId first_pid, size_t num_pages, bool is_modified) const;
+
     inline void ref(const PageId pid, bool scan, uint32_t worker_id) {
         partitioning_strategy->ref(pid, scan, worker_id);
     }
 
-    void flushDirtyPage(const PageId pid);
+    bool flushDirtyPage(const PageId pid); // writes all pages of an extent; returns false if the write failed, the page then remains dirty
+
+    // releases an exclusive latch, 's' is the state to be released (only the latch holder modifies the page state)
+    inline void unlatchExclusive(PageId pid, uint64_t s) {
+        const uint64_t dirty_bit = dirty_writeback ? PAGE_DIRTY_BIT : PAGE_MODIFIED_BIT;
+        const uint64_t new_s = ((s + (1ull << PAGE_VERSION_OFFSET)) & ~PAGE_STATE_MASK) | PAGE_STATE_UNLOCKED | dirty_bit;
+        assert(PAGE_STATE(new_s) == PAGE_STATE_UNLOCKED);
+        page_states[pid].store(new_s, std::memory_order_release);
+        // update statistics
+        if (dirty_writeback && (s & PAGE_DIRTY_BIT) == 0) // page was not already dirty
+            num_dirty_pages++;
+    }
+
+    // copies the image of a page latched exclusively by the transaction of 'worker_id' into its write set
+    void captureImage(PageId pid, uint32_t worker_id);
+    // records that the transaction of 'worker_id' has allocated or freed pages, so that it logs the anchor of the free page list on commit
+    inline void markFreePageListChanged(uint32_t worker_id) {
+        if (wal != nullptr && write_sets[worker_id].active)
+            write_sets[worker_id].free_list_changed = true;
+    }
+    // writes the current head of the free page list to its anchor, which has to be latched exclusively by the caller
+    void storeFreePageListAnchor(char* anchor_page);
+    // latches the anchor of the free page list exclusively and writes it; the caller must not hold any other latches, as callers of 'allocatePage()' and 'freePage()' may latch the anchor's page
+    void writeFreePageListAnchor(uint32_t worker_id);
+    // writes the anchor of the free page list for a checkpoint if it has changed, returns false if the anchor is latched or evicted and has to be retried later
+    bool checkpointFreePageListAnchor();
+    // tries to latch a dirty page in shared mode for writing it out during a checkpoint, returns false if the page has to be retried later
+    bool checkpointPage(PageId pid, size_t& pages_written);
+    // main loop of the page cleaner threads; cleaners use the worker ids following those of the regular workers
+    void runPageCleaner(uint32_t worker_id);
+    // writes out dirty pages that are latched by the caller; 'pids' is sorted in place and runs of adjacent pages are written using a single request each; returns the number of written pages (extents count with all of their pages)
+    //  pages whose write failed remain dirty, so they are neither evicted nor considered clean, and are written again later
+    size_t flushDirtyPages(PageId* pids, size_t num_pids, uint32_t worker_id);
+    // clears the dirty bit of a written page
+    void markFlushed(const PageId pid, uint64_t end_offset);
+    // marks 'pid' as the first page of an extent
+    inline void declareExtent(PageId pid) {
+        uint64_t s = page_states[pid].load();
+        while (!PAGE_IS_EXTENT(s) && !page_states[pid].compare_exchange_weak(s, s | PAGE_EXTENT_BIT)) { }
+    }
+    // declares the extents recorded in the extent file that lie within the database file, records of extents whose pages were never written to it (sandbox mode or a crash) are dropped
+    void restoreExtents(bool new_database);
 
     int fd;
     int exmap_fd;
@@ -256,10 +516,55 @@ private:
     const bool flush_asynchronously;
     const bool use_eviction_target;
     const std::string db_path;
-    // stats per worker
+    // stats per thread
     VMCacheStats* stats;
     const size_t num_workers;
+    const size_t num_page_cleaners;
+    // workers followed by page cleaners, each thread has its own per-thread resources (stats, temporary page pools, io_uring rings, exmap interfaces, ...) and id
+    const size_t num_threads;
     std::shared_ptr<std::function<void(size_t)>> log_allocation_latency; // note: using a shared_ptr here since using std::function directly makes VMCache a "non-standard-layout" class, which breaks the alignment checks below
+    // for reading pages
+    const bool use_io_uring;
+    std::vector<std::unique_ptr<IOUring>> io_rings; // one ring per worker
+    std::vector<InFlightPrefetch> in_flight_prefetches; // one per worker, each worker has at most one prefetch batch in flight
+    std::atomic_uint64_t db_file_size; // without the write-ahead log, the database file is only written on shutdown and its size is fixed while the cache is running
+    std::atomic_uint64_t shadow_file_size; // tracked on writes to avoid an lseek() on every fault
+    // recycled temporary pages, these remain accounted as physical temporary pages in the partitioning strategy
+    std::vector<TempPagePool> temp_page_pools; // one pool per worker
+    std::unique_ptr<HugePageRegionPool> huge_page_regions; // held by pointer as its std::map would make VMCache non-standard-layout (see 'VMCacheAlignmentChecker')
+    std::atomic_int64_t num_pooled_temporary_pages; // pool updates are not atomic with this counter, so it may be off temporarily
+    // free page list, the links in the free pages and the anchor are only written, the list is served from 'free_pids'
+    mutable std::mutex free_pages_mutex;
+    std::vector<PageId> free_pids; // the last entry is the head of the list
+    std::atomic_uint64_t num_free_pages;
+    PageId free_list_anchor_pid;
+    size_t free_list_anchor_offset;
+    bool free_list_anchor_stale; // protected by 'free_pages_mutex', set if the list has changed since the anchor was last written
+    // extent file, an array of the first page ids of all extents; created by the first extent allocation, -1 until then
+    std::mutex extents_mutex;
+    int extents_fd;
+    // spill area, dirty spillable pages are written to the shadow file behind the database's pages and are never copied to the database file
+    const uint64_t spill_pages;
+    std::mutex spill_pages_mutex;
+    std::vector<PageId> free_spill_pages;
+    uint64_t num_allocated_spill_pages;
+    std::atomic_uint64_t num_spillable_pages_in_use;
+    // write-ahead logging
+    std::unique_ptr<WriteAheadLog> wal;
+    std::vector<WALWriteSet> write_sets; // one per worker
+    // number of active transactions that have modified each page marked as uncommitted, the mutex also protects 'WALWriteSet::first_capture_lsn'
+    std::mutex uncommitted_pages_mutex;
+    std::unordered_map<PageId, uint32_t> uncommitted_pages;
+    // budget of the query each worker is currently executing for
+    std::vector<TempMemoryBudget*> temp_memory_budgets;
+    // background eviction and write-back
+    const size_t page_cleaner_free_pages;
+    std::atomic_bool stop_page_cleaners;
+    std::vector<std::thread> page_cleaners;
+    // measured I/O costs for eviction decisions
+    EvictionCostModel eviction_costs;
+    // compressed copies of evicted pages, nullptr if disabled
+    std::unique_ptr<CompressedPageTier> compressed_tier;
 
     friend class VMCacheAlignmentChecker;
     template <class T> friend class CachePartition;
@@ -0,0 +1,173 @@
+#include "wal.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../utils/errno.hpp"
+#include "../utils/MurmurHash3.hpp"
+
+static uint32_t computeChecksum(PageId pid, uint64_t version, const char* page) {
+    uint32_t checksum = 0;
+    MurmurHash3_x86_32(page, PAGE_SIZE, static_cast<uint32_t>(pid ^ version ^ (version >> 32)), &checksum);
+    return checksum;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path)
+    : next_lsn(WAL_HEADER_SIZE)
+    , durable_lsn(WAL_HEADER_SIZE)
+    , flush_in_progress(false)
+    , failed(false)
+    , num_flushes(0)
+{
+    fd = open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        std::cout << "[vmcache] " << "Error: Failed to open write-ahead log (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        throw std::runtime_error("Failed to open write-ahead log");
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    close(fd);
+}
+
+size_t WriteAheadLog::recover(int db_fd) {
+    WALHeader header;
+    size_t num_records = 0;
+    if (pread(fd, &header, sizeof(WALHeader), 0) == sizeof(WALHeader) && header.magic == WAL_MAGIC) {
+        // note: the database file is opened with O_DIRECT, so page images have to be written from an aligned buffer
+        char* page = reinterpret_cast<char*>(aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+        // find the newest image of each page (version and LSN of its record), the records of a page are not ordered by version if transactions committed in a different order than they captured the page
+        std::unordered_map<PageId, std::pair<uint64_t, uint64_t>> newest_records;
+        uint64_t lsn = header.checkpoint_lsn;
+        WALRecordHeader record;
+        while (pread(fd, &record, sizeof(WALRecordHeader), lsn) == sizeof(WALRecordHeader)) {
+            // the log ends at the first incomplete or torn record
+            if (record.magic != WAL_MAGIC || record.lsn != lsn)
+                break;
+            if (pread(fd, page, PAGE_SIZE, lsn + sizeof(WALRecordHeader)) != PAGE_SIZE || computeChecksum(record.pid, record.version, page) != record.checksum)
+                break;
+            auto [it, inserted] = newest_records.emplace(record.pid, std::make_pair(record.version, lsn));
+            if (!inserted && it->second.first <= record.version)
+                it->second = std::make_pair(record.version, lsn);
+            lsn += sizeof(WALRecordHeader) + PAGE_SIZE;
+        }
+        for (const auto& [pid, newest] : newest_records) {
+            if (pread(fd, page, PAGE_SIZE, newest.second + sizeof(WALRecordHeader)) != PAGE_SIZE || pwrite(db_fd, page, PAGE_SIZE, pid * PAGE_SIZE) != PAGE_SIZE) {
+                std::cout << "[vmcache] " << "Error: Failed to replay page " << pid << " from the write-ahead log (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+                errno = 0;
+                free(page);
+                throw std::runtime_error("Failed to recover from write-ahead log");
+            }
+            num_records++;
+        }
+        free(page);
+        if (num_records > 0 && fdatasync(db_fd) != 0)
+            throw std::runtime_error("Failed to sync database file after recovery");
+    }
+    // all logged changes are in the database file now, start with an empty log
+    if (ftruncate(fd, WAL_HEADER_SIZE) != 0)
+        throw std::runtime_error("Failed to reset write-ahead log");
+    writeHeader(WAL_HEADER_SIZE);
+    next_lsn = WAL_HEADER_SIZE;
+    durable_lsn = WAL_HEADER_SIZE;
+    return num_records;
+}
+
+uint64_t WriteAheadLog::append(PageId pid, uint64_t version, const char* page) {
+    WALRecordHeader record;
+    record.magic = WAL_MAGIC;
+    record.pid = pid;
+    record.version = version;
+    record.checksum = computeChecksum(pid, version, page);
+    record.padding = 0;
+    std::lock_guard<std::mutex> guard(mutex);
+    record.lsn = next_lsn;
+    const size_t offset = buffer.size();
+    buffer.resize(offset + sizeof(WALRecordHeader) + PAGE_SIZE);
+    memcpy(buffer.data() + offset, &record, sizeof(WALRecordHeader));
+    memcpy(buffer.data() + offset + sizeof(WALRecordHeader), page, PAGE_SIZE);
+    next_lsn += sizeof(WALRecordHeader) + PAGE_SIZE;
+    return next_lsn;
+}
+
+void WriteAheadLog::flush(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (durable_lsn < lsn) {
+        if (failed)
+            throw std::runtime_error("Write-ahead log failed, records can no longer be made durable");
+        if (flush_in_progress) {
+            // another committer is flushing, our records are either part of that flush or will be written by the next one
+            flushed.wait(lock);
+            continue;
+        }
+        // write out all buffered records, including those of other committers
+        flush_in_progress = true;
+        std::vector<char> records;
+        records.swap(buffer);
+        const uint64_t begin_lsn = durable_lsn;
+        const uint64_t end_lsn = next_lsn;
+        lock.unlock();
+        try {
+            writeRecords(records, begin_lsn);
+        } catch (...) {
+            lock.lock();
+            // the records may have been written partially and a failed sync may have dropped written pages from the page cache, so neither they nor any later records can be made durable anymore
+            failed = true;
+            flush_in_progress = false;
+            flushed.notify_all();
+            throw;
+        }
+        num_flushes++;
+        lock.lock();
+        durable_lsn = end_lsn;
+        flush_in_progress = false;
+        flushed.notify_all();
+    }
+}
+
+void WriteAheadLog::writeRecords(const std::vector<char>& records, uint64_t begin_lsn) {
+    size_t written = 0;
+    while (written < records.size()) {
+        const ssize_t result = pwrite(fd, records.data() + written, records.size() - written, begin_lsn + written);
+        if (result < 0) {
+            std::cout << "[vmcache] " << "Error: Failed to write to write-ahead log (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+            errno = 0;
+            throw std::runtime_error("Failed to write to write-ahead log");
+        }
+        written += result;
+    }
+    if (fdatasync(fd) != 0) {
+        std::cout << "[vmcache] " << "Error: Failed to sync write-ahead log (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        throw std::runtime_error("Failed to sync write-ahead log");
+    }
+}
+
+void WriteAheadLog::checkpoint(uint64_t lsn) {
+    writeHeader(lsn);
+    // give the space of obsolete records back to the file system, LSNs remain valid file offsets
+    const uint64_t obsolete_end = lsn / WAL_HEADER_SIZE * WAL_HEADER_SIZE;
+    if (obsolete_end > WAL_HEADER_SIZE)
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, WAL_HEADER_SIZE, obsolete_end - WAL_HEADER_SIZE); // note: this is only an optimization, so we ignore file systems that do not support it
+}
+
+uint64_t WriteAheadLog::getCurrentLSN() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return next_lsn;
+}
+
+void WriteAheadLog::writeHeader(uint64_t checkpoint_lsn) {
+    WALHeader header;
+    header.magic = WAL_MAGIC;
+    header.checkpoint_lsn = checkpoint_lsn;
+    if (pwrite(fd, &header, sizeof(WALHeader), 0) != sizeof(WALHeader) || fdatasync(fd) != 0) {
+        std::cout << "[vmcache] " << "Error: Failed to write write-ahead log header (errno " << errno << ", " << errnoStr() << ")" << std::endl;
+        errno = 0;
+        throw std::runtime_error("Failed to write write-ahead log header");
+    }
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../core/units.hpp"
+#include "page.hpp"
+
+#define WAL_MAGIC 0x57414c5245444f31ull
+// the log file begins with a header block, records are appended behind it; LSNs are byte offsets into the log file
+#define WAL_HEADER_SIZE 4096ul
+
+struct WALHeader {
+    uint64_t magic;
+    // all changes logged before this LSN are contained in the database file
+    uint64_t checkpoint_lsn;
+};
+
+// each record is followed by a full image of the page
+struct WALRecordHeader {
+    uint64_t magic;
+    uint64_t lsn;
+    PageId pid;
+    // version of the page when its image was captured; records are appended on commit, which may not follow the order in which the images were captured
+    uint64_t version;
+    uint32_t checksum;
+    uint32_t padding;
+};
+
+// image of a page captured by a transaction
+struct WALImage {
+    size_t offset; // offset of the image in 'WALWriteSet::images'
+    uint64_t version;
+};
+
+// pages modified by a worker while it is executing a transaction
+struct alignas(64) WALWriteSet {
+    bool active = false;
+    bool free_list_changed = false; // the transaction allocated or freed pages, so it logs the anchor of the free page list on commit
+    std::vector<PageId> pids; // pages latched exclusively by the transaction
+    // images of the modified pages, captured whenever the transaction releases their exclusive latches
+    std::unordered_map<PageId, WALImage> image_offsets;
+    std::vector<char> images;
+    // LSN at the transaction's first capture until its records have been appended, protected by 'VMCache::uncommitted_pages_mutex' (see 'VMCache::checkpoint()')
+    uint64_t first_capture_lsn = std::numeric_limits<uint64_t>::max();
+};
+
+/*
+Redo log consisting of full page images. Committing transactions append the images of the pages they modified
+and wait for them to become durable in 'flush()'; while one committer writes and syncs the log, the records of
+concurrent committers accumulate in the buffer and are made durable together by the next flush (group commit).
+*/
+class WriteAheadLog {
+public:
+    explicit WriteAheadLog(const std::string& path);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog& other) = delete;
+    WriteAheadLog(WriteAheadLog&& other) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog& other) = delete;
+    WriteAheadLog& operator=(WriteAheadLog&& other) = delete;
+
+    // writes the newest image of each page logged after the last checkpoint to the database file and resets the log; returns the number of replayed records
+    size_t recover(int db_fd);
+    // appends a record containing an image of 'page' captured at page version 'version' to the log buffer, returns the LSN following the record
+    uint64_t append(PageId pid, uint64_t version, const char* page);
+    // returns once all records preceding 'lsn' are durable, throws if a flush failed (including one of another committer)
+    void flush(uint64_t lsn);
+    // releases the log space preceding 'lsn', the caller has to ensure that all changes logged before 'lsn' are durable in the database file
+    void checkpoint(uint64_t lsn);
+
+    uint64_t getCurrentLSN();
+    size_t getNumFlushes() const { return num_flushes.load(); }
+
+private:
+    void writeHeader(uint64_t checkpoint_lsn);
+    // writes 'records' at 'begin_lsn' and syncs the log file
+    void writeRecords(const std::vector<char>& records, uint64_t begin_lsn);
+
+    int fd;
+    std::mutex mutex;
+    std::condition_variable flushed;
+    std::vector<char> buffer; // records that have not been written yet, beginning at LSN 'durable_lsn' (or at the end of the ongoing flush)
+    uint64_t next_lsn;
+    uint64_t durable_lsn;
+    bool flush_in_progress;
+    bool failed; // a flush failed, the log does not report any further records as durable
+    std::atomic_uint64_t num_flushes;
+};
\ No newline at end of file
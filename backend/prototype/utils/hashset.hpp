@@ -55,6 +55,21 @@ public:
         return 0;
     }
 
+    bool contains(const T& key) const {
+        size_t hash = 0;
+        MurmurHash3_x86_32(&key, sizeof(T), 1, &hash);
+        size_t offset = 0;
+        while (offset != num_buckets) {
+            T bucket_val = buckets[(hash + offset) % num_buckets].load();
+            if (bucket_val == empty)
+                return false;
+            else if (bucket_val == key)
+                return true;
+            offset++;
+        }
+        return false;
+    }
+
     size_t bucketCount() const { return num_buckets; }
 
     inline T getBucket(size_t i) const { return buckets[i].load(); }
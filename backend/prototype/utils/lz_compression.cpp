@@ -0,0 +1,138 @@
+#include "lz_compression.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#define LZ_HASH_BITS 12
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t result;
+    memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline uint32_t hash32(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// appends a length exceeding the 15 that fit into the token's nibble, returns false if 'dst' is too small
+static inline bool writeLength(uint8_t*& op, const uint8_t* oend, size_t len) {
+    for (; len >= 255; len -= 255) {
+        if (op == oend)
+            return false;
+        *op++ = 255;
+    }
+    if (op == oend)
+        return false;
+    *op++ = static_cast<uint8_t>(len);
+    return true;
+}
+
+static inline bool writeSequence(uint8_t*& op, const uint8_t* oend, const uint8_t* literals, size_t num_literals, size_t offset, size_t match_len) {
+    if (op == oend)
+        return false;
+    const size_t match_code = match_len == 0 ? 0 : match_len - LZ_MIN_MATCH;
+    *op++ = static_cast<uint8_t>((num_literals < 15 ? num_literals : 15) << 4 | (match_code < 15 ? match_code : 15));
+    if (num_literals >= 15 && !writeLength(op, oend, num_literals - 15))
+        return false;
+    if (static_cast<size_t>(oend - op) < num_literals)
+        return false;
+    memcpy(op, literals, num_literals);
+    op += num_literals;
+    if (match_len == 0)
+        return true; // last sequence
+    if (oend - op < 2)
+        return false;
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    return match_code < 15 || writeLength(op, oend, match_code - 15);
+}
+
+size_t lzCompress(const char* src, size_t src_len, char* dst, size_t dst_capacity) {
+    assert(src_len <= LZ_MAX_INPUT_SIZE);
+    const uint8_t* const begin = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const end = begin + src_len;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* const oend = op + dst_capacity;
+    // positions of the last occurrence of each hashed 4-byte sequence, stale or colliding entries are detected by comparing the sequences
+    uint16_t table[1 << LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    const uint8_t* ip = begin;
+    const uint8_t* anchor = begin;
+    while (end - ip >= LZ_MIN_MATCH) {
+        const uint32_t sequence = read32(ip);
+        const uint32_t h = hash32(sequence);
+        const uint8_t* candidate = begin + table[h];
+        table[h] = static_cast<uint16_t>(ip - begin);
+        if (candidate >= ip || ip - candidate > 65535 || read32(candidate) != sequence) {
+            // skip ahead faster in incompressible regions
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+        size_t match_len = LZ_MIN_MATCH;
+        while (ip + match_len < end && candidate[match_len] == ip[match_len])
+            match_len++;
+        if (!writeSequence(op, oend, anchor, ip - anchor, ip - candidate, match_len))
+            return 0;
+        ip += match_len;
+        anchor = ip;
+    }
+    if (!writeSequence(op, oend, anchor, end - anchor, 0, 0))
+        return 0;
+    return op - reinterpret_cast<uint8_t*>(dst);
+}
+
+// reads a length following a nibble of 15, returns false if 'src' ends prematurely
+static inline bool readLength(const uint8_t*& ip, const uint8_t* iend, size_t& len) {
+    uint8_t b;
+    do {
+        if (ip == iend)
+            return false;
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+bool lzDecompress(const char* src, size_t src_len, char* dst, size_t dst_len) {
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const iend = ip + src_len;
+    uint8_t* const obegin = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* op = obegin;
+    uint8_t* const oend = obegin + dst_len;
+    while (ip != iend) {
+        const uint8_t token = *ip++;
+        size_t num_literals = token >> 4;
+        if (num_literals == 15 && !readLength(ip, iend, num_literals))
+            return false;
+        if (static_cast<size_t>(iend - ip) < num_literals || static_cast<size_t>(oend - op) < num_literals)
+            return false;
+        memcpy(op, ip, num_literals);
+        ip += num_literals;
+        op += num_literals;
+        if (ip == iend)
+            break; // last sequence
+        if (iend - ip < 2)
+            return false;
+        const size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !readLength(ip, iend, match_len))
+            return false;
+        match_len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(op - obegin) || static_cast<size_t>(oend - op) < match_len)
+            return false;
+        const uint8_t* match = op - offset;
+        if (offset >= match_len) {
+            memcpy(op, match, match_len);
+            op += match_len;
+        } else {
+            // overlapping match, e.g., a run of a repeated value
+            for (size_t i = 0; i < match_len; i++)
+                *op++ = match[i];
+        }
+    }
+    return op == oend;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+Byte-oriented LZ77 compression in the style of LZ4's block format: the output is a sequence of (literals, match) pairs,
+each starting with a token byte whose high and low nibble encode the literal length and the match length minus
+LZ_MIN_MATCH (a nibble of 15 is followed by further length bytes), followed by the literals and a 16-bit little-endian
+match offset. The last sequence consists of literals only. Matches are found using a single-entry hash table, trading
+compression ratio for speed; intended for compressing individual pages (inputs of up to 64 KiB).
+*/
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_INPUT_SIZE 65536ul
+
+// returns the compressed size, or 0 if the compressed data would not fit into 'dst_capacity' bytes
+size_t lzCompress(const char* src, size_t src_len, char* dst, size_t dst_capacity);
+// returns false if 'src' is malformed or does not decompress to exactly 'dst_len' bytes
+bool lzDecompress(const char* src, size_t src_len, char* dst, size_t dst_len);
\ No newline at end of file
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "MurmurHash3.hpp"
+
+// upper bound for the number of shards, the actual number is chosen such that each shard has at least SHARDED_HASHSET_MIN_SHARD_BUCKETS buckets
+#define SHARDED_HASHSET_MAX_SHARDS 64ul
+#define SHARDED_HASHSET_MIN_SHARD_BUCKETS 1024ul
+// additional buckets per shard, in standard deviations of the number of keys hashed to a shard (see 'getShardBucketCount()')
+#define SHARDED_HASHSET_SHARD_HEADROOM_SIGMAS 4
+
+/*
+Hash set with linear probing that is split into independent shards, each owning a contiguous, cache-line-aligned range of
+buckets and its own clock hand. The set is not lock-free: inserts and erases latch their shard in shared mode (a counter
+of ongoing operations) and modify its buckets using CAS, while reclaiming a shard's tombstones latches it exclusively,
+which happens once they make up a quarter of the shard's buckets (the shard is rehashed in place). Inserts and erases on a
+shard that is being reclaimed spin until the rehash has finished, and a reclamation waits for all ongoing inserts and
+erases, so a thread that is descheduled while holding the latch stalls the shard (but no other shard); latches are held
+for a single probe sequence only. Lookups do not latch the shard, they validate against the shard's version instead,
+which each reclamation increments before and after rehashing (as a seqlock), and retry if it has changed.
+As in 'HashSet', inserting a key that is already contained results in a duplicate entry. Keys are not moved to other
+shards, so each shard has headroom for hashing more than its even share of the keys; the set has to be sized for the
+maximum number of keys, a shard then only fills up if its share deviates by more than SHARDED_HASHSET_SHARD_HEADROOM_SIGMAS
+standard deviations, and inserting into a full shard fails.
+*/
+template <typename T, T empty = std::numeric_limits<T>::max(), T tombstone = std::numeric_limits<T>::max() - 1>
+class ShardedHashSet {
+public:
+    static const T empty_bucket = empty;
+    static const T tombstone_bucket = tombstone;
+
+    ShardedHashSet(size_t bucket_count)
+        : num_shards(getShardCount(bucket_count))
+        , shard_bucket_count(getShardBucketCount(bucket_count, num_shards))
+        , shards(new Shard[num_shards]) {
+        buckets = reinterpret_cast<std::atomic<T>*>(aligned_alloc(64, num_shards * shard_bucket_count * sizeof(std::atomic<T>)));
+        for (size_t i = 0; i < num_shards * shard_bucket_count; i++)
+            new (buckets + i) std::atomic<T>(empty);
+    }
+
+    ~ShardedHashSet() {
+        free(buckets);
+        delete[] shards;
+    }
+
+    ShardedHashSet(const ShardedHashSet& other) = delete;
+    ShardedHashSet& operator=(const ShardedHashSet& other) = delete;
+
+    // returns false if the key's shard is full
+    bool insert(const T& key) {
+        const uint32_t hash = getHash(key);
+        Shard& shard = shards[hash % num_shards];
+        std::atomic<T>* shard_buckets = buckets + (hash % num_shards) * shard_bucket_count;
+        shard.enter();
+        size_t i = (hash / num_shards) % shard_bucket_count;
+        bool inserted = false;
+        for (size_t offset = 0; offset != shard_bucket_count; ) {
+            T bucket_val = shard_buckets[i].load();
+            if (bucket_val == empty || bucket_val == tombstone) {
+                if (shard_buckets[i].compare_exchange_strong(bucket_val, key)) {
+                    if (bucket_val == tombstone)
+                        shard.num_tombstones--;
+                    inserted = true;
+                    break;
+                }
+                continue;
+            }
+            i = (i + 1) % shard_bucket_count;
+            offset++;
+        }
+        shard.leave();
+        return inserted;
+    }
+
+    size_t erase(const T& key) {
+        const uint32_t hash = getHash(key);
+        const size_t s = hash % num_shards;
+        Shard& shard = shards[s];
+        std::atomic<T>* shard_buckets = buckets + s * shard_bucket_count;
+        shard.enter();
+        size_t result = 0;
+        for (size_t offset = 0; offset != shard_bucket_count; offset++) {
+            const size_t i = (hash / num_shards + offset) % shard_bucket_count;
+            T bucket_val = shard_buckets[i].load();
+            if (bucket_val == empty) {
+                break;
+            } else if (bucket_val == key) {
+                if (shard_buckets[i].compare_exchange_strong(bucket_val, tombstone)) {
+                    result = 1;
+                    break;
+                }
+            }
+        }
+        const bool reclaim = result == 1 && ++shard.num_tombstones > shard_bucket_count / 4;
+        shard.leave();
+        if (reclaim)
+            reclaimTombstones(s);
+        return result;
+    }
+
+    bool contains(const T& key) const {
+        const uint32_t hash = getHash(key);
+        const Shard& shard = shards[hash % num_shards];
+        const std::atomic<T>* shard_buckets = buckets + (hash % num_shards) * shard_bucket_count;
+        while (true) {
+            const uint64_t version = shard.beginRead();
+            bool result = false;
+            for (size_t offset = 0; offset != shard_bucket_count; offset++) {
+                const T bucket_val = shard_buckets[(hash / num_shards + offset) % shard_bucket_count].load(std::memory_order_relaxed);
+                if (bucket_val == empty) {
+                    break;
+                } else if (bucket_val == key) {
+                    result = true;
+                    break;
+                }
+            }
+            if (shard.validateRead(version))
+                return result;
+        }
+    }
+
+    size_t bucketCount() const { return num_shards * shard_bucket_count; }
+    size_t shardCount() const { return num_shards; }
+    size_t shardBucketCount() const { return shard_bucket_count; }
+
+    // note: buckets are read without latching the shard, so a concurrent tombstone reclamation may cause keys to be missed or seen twice
+    inline T getBucket(size_t i) const { return buckets[i].load(); }
+    inline T getShardBucket(size_t shard, size_t i) const { return buckets[shard * shard_bucket_count + i % shard_bucket_count].load(); }
+
+    // advances the shard's clock hand by 'num_steps' buckets and returns its previous position; the caller owns the buckets in between (modulo the shard's bucket count)
+    inline size_t advanceClock(size_t shard, size_t num_steps) {
+        return shards[shard].clock.fetch_add(num_steps) % shard_bucket_count;
+    }
+
+    size_t getNumTombstones() const {
+        size_t result = 0;
+        for (size_t s = 0; s < num_shards; s++)
+            result += shards[s].num_tombstones.load();
+        return result;
+    }
+
+private:
+    struct alignas(64) Shard {
+        static const uint32_t RECLAIMING = 1u << 31;
+
+        // shared/exclusive latch: number of ongoing inserts and erases on the shard, the highest bit signals an ongoing tombstone reclamation
+        std::atomic_uint32_t latch { 0 };
+        std::atomic_uint64_t num_tombstones { 0 };
+        std::atomic_uint64_t clock { 0 };
+        // odd while the shard is being rehashed, lookups retry if it changes while they probe the shard
+        std::atomic_uint64_t version { 0 };
+
+        inline uint64_t beginRead() const {
+            uint64_t v = version.load(std::memory_order_acquire);
+            while ((v & 1) != 0)
+                v = version.load(std::memory_order_acquire);
+            return v;
+        }
+
+        inline bool validateRead(uint64_t v) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return version.load(std::memory_order_relaxed) == v;
+        }
+
+        inline void enter() {
+            uint32_t v = latch.load();
+            while (true) {
+                if ((v & RECLAIMING) != 0) {
+                    v = latch.load();
+                    continue;
+                }
+                if (latch.compare_exchange_weak(v, v + 1))
+                    return;
+            }
+        }
+
+        inline void leave() { latch--; }
+    };
+
+    static size_t getShardCount(size_t bucket_count) {
+        size_t result = 1;
+        while (result < SHARDED_HASHSET_MAX_SHARDS && bucket_count / (result * 2) >= SHARDED_HASHSET_MIN_SHARD_BUCKETS)
+            result *= 2;
+        return result;
+    }
+
+    static size_t getShardBucketCount(size_t bucket_count, size_t num_shards) {
+        const size_t share = std::max<size_t>((bucket_count + num_shards - 1) / num_shards, 1);
+        // the number of keys hashed to a shard is binomially distributed, with a standard deviation of less than the square root of the shard's even share
+        const size_t headroom = num_shards == 1 ? 0 : SHARDED_HASHSET_SHARD_HEADROOM_SIGMAS * static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(share))));
+        // round up to full cache lines, so that shards never share a cache line
+        const size_t buckets_per_line = 64 / sizeof(std::atomic<T>);
+        const size_t result = (share + headroom + buckets_per_line - 1) / buckets_per_line * buckets_per_line;
+        assert(result * num_shards >= bucket_count + headroom * num_shards);
+        return result;
+    }
+
+    static inline uint32_t getHash(const T& key) {
+        uint32_t hash = 0;
+        MurmurHash3_x86_32(&key, sizeof(T), 1, &hash);
+        return hash;
+    }
+
+    void reclaimTombstones(size_t s) {
+        Shard& shard = shards[s];
+        uint32_t v = shard.latch.load();
+        do {
+            if ((v & Shard::RECLAIMING) != 0)
+                return; // another thread is already reclaiming this shard's tombstones
+        } while (!shard.latch.compare_exchange_weak(v, v | Shard::RECLAIMING));
+        // wait for ongoing operations on the shard to finish
+        while ((shard.latch.load() & ~Shard::RECLAIMING) != 0) { }
+        if (shard.num_tombstones > shard_bucket_count / 4) {
+            // rehash the shard in place, lookups that overlap with it are retried
+            const uint64_t version = shard.version.load(std::memory_order_relaxed);
+            shard.version.store(version + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::atomic<T>* shard_buckets = buckets + s * shard_bucket_count;
+            std::vector<T> keys;
+            for (size_t i = 0; i < shard_bucket_count; i++) {
+                const T bucket_val = shard_buckets[i].load(std::memory_order_relaxed);
+                if (bucket_val != empty && bucket_val != tombstone)
+                    keys.push_back(bucket_val);
+                shard_buckets[i].store(empty, std::memory_order_relaxed);
+            }
+            for (const T& key : keys) {
+                size_t i = (getHash(key) / num_shards) % shard_bucket_count;
+                while (shard_buckets[i].load(std::memory_order_relaxed) != empty)
+                    i = (i + 1) % shard_bucket_count;
+                shard_buckets[i].store(key, std::memory_order_relaxed);
+            }
+            shard.version.store(version + 2, std::memory_order_release);
+            shard.num_tombstones = 0;
+        }
+        shard.latch.store(0, std::memory_order_release);
+    }
+
+    const size_t num_shards;
+    const size_t shard_bucket_count;
+    Shard* shards;
+    std::atomic<T>* buckets;
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "prototype/storage/eviction_cost.hpp"
+#include "prototype/storage/policy/cache_simulator.hpp"
+
+DEFINE_string(trace, "cache.trc", "Comma-separated list of cache trace files to replay (written by builds with COLLECT_CACHE_TRACES, one file per cache partition)");
+DEFINE_string(eviction_policies, "clock,random,mru,2q,state_clock", "Comma-separated list of eviction policies to simulate; options are 'clock', 'random', 'mru', '2q', and 'state_clock'");
+DEFINE_string(memory_fractions, "0.05,0.1,0.25,0.5,0.75,1.0", "Comma-separated list of simulated memory sizes as fractions of the number of distinct pages accessed in the trace");
+DEFINE_uint64(read_latency, EVICTION_COST_DEFAULT_READ_NS, "Simulated latency of reading a page from disk (in nanoseconds)");
+DEFINE_uint64(write_latency, EVICTION_COST_DEFAULT_WRITE_NS, "Simulated latency of writing a page to disk (in nanoseconds)");
+DEFINE_string(scratch_path, "cache_sim.db", "Path of the sparse scratch file that simulated page faults and write-backs are performed on");
+DEFINE_string(output, "cache_sim.csv", "File to write the simulation results to");
+
+static std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> result;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty())
+            result.push_back(item);
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    std::vector<double> memory_fractions;
+    for (const std::string& fraction : splitList(FLAGS_memory_fractions)) {
+        memory_fractions.push_back(std::stod(fraction));
+        if (memory_fractions.back() <= 0.0) {
+            std::cout << "Error: Memory fractions must be positive" << std::endl;
+            return -1;
+        }
+    }
+
+    const std::vector<CacheTraceEntry> trace = readCacheTraces(splitList(FLAGS_trace));
+    const size_t footprint = getCacheTraceFootprint(trace);
+    if (footprint == 0) {
+        std::cout << "Error: The trace does not contain any page accesses; note that only traces collected with page access tracing can be replayed" << std::endl;
+        return -1;
+    }
+    size_t num_recorded_faults = 0;
+    for (const CacheTraceEntry& entry : trace) {
+        if (entry.getAction() == CacheAction::Fault)
+            num_recorded_faults++;
+    }
+    std::cout << "Replaying " << trace.size() << " trace entries accessing " << footprint << " distinct pages (" << num_recorded_faults << " faults recorded)" << std::endl;
+
+    std::ofstream output(FLAGS_output);
+    output << "policy,frames,memory_fraction,accesses,hit_ratio,faults,dirty_writes,simulated_io_time" << std::endl;
+    std::vector<CacheSimulationResult> results;
+    for (const std::string& policy : splitList(FLAGS_eviction_policies)) {
+        for (const double fraction : memory_fractions) {
+            const size_t num_frames = std::max<size_t>(static_cast<size_t>(footprint * fraction), 1);
+            const CacheSimulationResult result = simulateCache(trace, policy, num_frames, FLAGS_scratch_path, FLAGS_read_latency, FLAGS_write_latency);
+            output << policy << "," << num_frames << "," << fraction << "," << result.num_accesses << "," << result.getHitRatio() << "," << result.num_faults << "," << result.num_dirty_writes << "," << result.simulated_io_ns / 1e9 << std::endl;
+            results.push_back(result);
+        }
+    }
+
+    std::cout << std::endl << std::left << std::setw(12) << "policy" << std::right << std::setw(12) << "frames" << std::setw(12) << "hit ratio" << std::setw(14) << "faults" << std::setw(14) << "writes" << std::setw(14) << "I/O time [s]" << std::endl;
+    for (const CacheSimulationResult& result : results) {
+        std::cout << std::left << std::setw(12) << result.eviction_policy << std::right << std::setw(12) << result.num_frames;
+        std::cout << std::setiosflags(std::ios::fixed) << std::setprecision(4) << std::setw(12) << result.getHitRatio();
+        std::cout << std::setw(14) << result.num_faults << std::setw(14) << result.num_dirty_writes << std::setprecision(3) << std::setw(14) << result.simulated_io_ns / 1e9 << std::endl;
+    }
+    std::cout << "Results written to " << FLAGS_output << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "prototype/core/types.hpp"
 #include "prototype/storage/persistence/btree.hpp"
 #include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 #include "prototype/utils/memcpy.hpp"
 #include "prototype/execution/index_scan.hpp"
 #include "prototype/execution/paged_vector_iterator.hpp"
@@ -24,7 +25,7 @@ public:
         assert(from == 0);
         assert(to == 1);
         BTree<CompositeKey<4>, size_t> index(db.vmcache, index_root_page, worker_id);
-        BTree<RowId, bool> visibility(db.vmcache, visibility_root_page, worker_id);
+        VisibilityBitmap visibility(db.vmcache, visibility_root_page, worker_id);
         auto it = --index.lookup(to_search_value);
         std::vector<GeneralPagedVectorIterator> worker_iterators;
         worker_iterators.reserve(basepages.size());
@@ -42,7 +43,7 @@ public:
             --it;
             it.release();
             // check if row is visible
-            if (!visibility.lookupValue(val.second).value_or(false))
+            if (!visibility.isVisible(val.second))
                 continue;
             // output result row
             for (size_t i = 0; i < basepages.size(); i++) {
@@ -5,6 +5,7 @@
 #include "prototype/core/types.hpp"
 #include "prototype/storage/persistence/btree.hpp"
 #include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 #include "prototype/utils/memcpy.hpp"
 #include "prototype/execution/index_scan.hpp"
 #include "prototype/execution/paged_vector_iterator.hpp"
@@ -27,7 +28,7 @@ public:
         assert(from == 0);
         assert(to == 1);
         BTree<CompositeKey<2>, size_t> index(db.vmcache, index_root_page, worker_id);
-        BTree<RowId, bool> visibility(db.vmcache, visibility_root_page, worker_id);
+        VisibilityBitmap visibility(db.vmcache, visibility_root_page, worker_id);
         GeneralPagedVectorIterator quantity_iterator(db.vmcache, quantity_basepage, GeneralPagedVectorIterator::UNLOAD, sizeof(int32_t), worker_id);
         IntermediateHelper intermediates(db.vmcache, sizeof(int32_t), next_operator, worker_id);
         uint32_t* const result_loc = reinterpret_cast<uint32_t*>(intermediates.addRow());
@@ -38,7 +39,7 @@ public:
                 auto val = *it;
                 it.release();
                 // check if row is visible
-                if (!visibility.lookupValue(val.second).value_or(false))
+                if (!visibility.isVisible(val.second))
                     continue;
                 // filter by 'quantity'
                 quantity_iterator.reposition(val.second);
@@ -22,9 +22,11 @@
 #include "prototype/scheduling/job_manager.hpp"
 #include "prototype/storage/persistence/btree.hpp"
 #include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 #include "prototype/storage/policy/basic_partitioning_strategy.hpp"
 #include "prototype/storage/policy/cache_partition.hpp"
 #include "prototype/storage/policy/data_temp_partitioning_strategy.hpp"
+#include "prototype/storage/policy/numa_partitioning_strategy.hpp"
 #include "prototype/storage/vmcache.hpp"
 #include "prototype/utils/errno.hpp"
 #include "prototype/utils/print_result.hpp"
@@ -53,6 +55,7 @@ DEFINE_uint64(olap_interval, 30, "Interval in seconds to run analytical queries
 DEFINE_uint64(olap_sim_duration, 5, "Duration in seconds for the simulated OLAP query; defaults to 5 seconds");
 DEFINE_uint64(olap_sim_size_pages, 227090, "Number of pages to allocate for the simulated OLAP query; the default value is 227090 pages, which is equal to roughly half of the total number of usable pages with a 2 GB memory limit");
 DEFINE_bool(olap_stdout, false, "Print OLAP query results to the standard output");
+DEFINE_uint64(olap_temp_memory_budget, 0, "Number of temporary pages an analytical query may use before the start of its further pipelines is delayed; 0 disables the budget");
 DEFINE_uint64(warmup, 10, "Warmup time in seconds");
 DEFINE_uint64(benchmark, 60, "Benchmark time in seconds");
 DEFINE_int64(oltp_pause, -1, "Time in seconds (including warmup) after which OLTP streams are paused for 10 seconds; negative values imply no pause, defaults to -1");
@@ -60,15 +63,23 @@ DEFINE_bool(sandbox, false, "Run in sandbox mode (any changes to the database wi
 DEFINE_bool(no_dirty_writeback, false, "Disable writing back dirty pages to disk; Warning: This will result in data loss!");
 DEFINE_bool(no_async_flush, false, "Disable asynchronous flushing of dirty pages using idle worker threads");
 DEFINE_bool(no_eviction_target, false, "Disable eviction target mechanism for avoiding interference between large temporary allocations and regular buffer pool traffic");
+DEFINE_uint64(page_cleaners, 0, "Number of dedicated threads that evict and write back pages in the background, so that faulting workers find free frames even when no worker is idle");
+DEFINE_double(page_cleaner_watermark, PAGE_CLEANER_DEFAULT_WATERMARK, "Fraction of the buffer pool capacity that page cleaner threads keep free");
+DEFINE_double(compressed_tier, 0.0, "Fraction of the memory limit's buffer frames to use for holding compressed copies of evicted pages, which can be faulted again without I/O; 0 disables the compressed page tier");
+DEFINE_bool(column_extents, false, "Store the data of newly loaded columns in extents of 16 consecutive pages (64 KiB) that are faulted and evicted as a unit, instead of in single pages");
 DEFINE_bool(exmap, false, "Use exmap (kernel module has to be loaded) to reduce vmcache overhead");
+DEFINE_bool(io_uring, false, "Use per-worker io_uring instances for reading and writing pages (write-back batches are submitted at once, prefetch reads overlap with the following work, demand faults still wait for their read)");
+DEFINE_bool(wal, false, "Log the changes of transactions to a write-ahead log with group commit instead of persisting them only on shutdown; cannot be combined with 'sandbox' or 'no_dirty_writeback'");
+DEFINE_uint64(checkpoint_interval, 30, "Interval in seconds between fuzzy checkpoints when using the write-ahead log; 0 disables periodic checkpoints");
 DEFINE_bool(import_only, false, "Only import input data, do not run query");
 DEFINE_bool(full_validation, false, "Perform full validation; without this flag, the cardinality of large indices is not validated");
 DEFINE_string(collect_stats, "", "Collect statistics while running the queries into the specified path in CSV format");
 DEFINE_string(latency_log, "", "Collect measured latencies for queries/transactions into the specified path in CSV format");
 DEFINE_bool(collect_latched_page_stat, false, "Include the number of latched data pages in the collected statistics; this has high overhead as it involves iterating over all cached pages at each collection interval");
-DEFINE_string(partitioning_strategy, "basic", "Partitioning strategy to use in vmcache; options are 'basic' and 'partitioned' (uses separate partitions for data and temporary pages)");
-DEFINE_string(eviction_policy, "clock", "Eviction policy to use within vmcache partitions; options are 'clock', 'random', and 'mru'");
+DEFINE_string(partitioning_strategy, "basic", "Partitioning strategy to use in vmcache; options are 'basic', 'partitioned' (uses separate partitions for data and temporary pages), and 'numa' (uses one partition per NUMA node)");
+DEFINE_string(eviction_policy, "clock", "Eviction policy to use within vmcache partitions; options are 'clock', 'random', 'mru', '2q', and 'state_clock' (clock over the page state array without a resident page hash set)");
 DEFINE_uint64(partitioned_num_temp_pages, 0, "Number of pages to allocate to temporary data if the cache is partitioned");
+DEFINE_bool(partitioned_adaptive, false, "Resize the data and temporary partitions online if the cache is partitioned; 'partitioned_num_temp_pages' then only specifies the initial size of the temporary partition");
 DEFINE_uint64(memory_limit, 16ull * 1024ull * 1024ull * 1024ull, "Memory limit");
 
 namespace tpcch {
@@ -157,6 +168,18 @@ void statsCollectorThread(const std::string& path, bool& stop, const DB& db, std
     close(statm_fd);
 }
 
+void checkpointThread(bool& stop, DB& db, size_t checkpoint_interval_s) {
+    auto last_checkpoint = std::chrono::steady_clock::now();
+    while (!stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (std::chrono::steady_clock::now() - last_checkpoint < std::chrono::seconds(checkpoint_interval_s))
+            continue;
+        const size_t pages_written = db.vmcache.checkpoint();
+        std::cout << "Checkpoint wrote " << pages_written << " dirty pages" << std::endl;
+        last_checkpoint = std::chrono::steady_clock::now();
+    }
+}
+
 class DataSource {
 public:
     DataSource(uint32_t num_warehouses, unsigned seed = 0) : num_warehouses(num_warehouses), generator(seed) { }
@@ -479,6 +502,8 @@ void OLAPStream(std::atomic<BenchmarkState>& state, std::atomic_size_t& active_s
             BatchDescription output_desc = BatchDescription(std::vector<NamedColumn>({ NamedColumn(std::string("revenue"), std::make_shared<UnencodedTemporaryColumn<Decimal<2>>>()) }));
             pipelines[0]->addBreaker(std::make_shared<Q06AggregationOperator>(db, output_desc));
             auto qep = std::make_shared<QEP>(std::move(pipelines));
+            if (FLAGS_olap_temp_memory_budget > 0)
+                qep->setTempMemoryBudget(FLAGS_olap_temp_memory_budget);
             qep->begin(context);
             qep->waitForExecution(context, db.vmcache, false);
             printQueryResult(qep->getResult(), context.getWorkerId(), FLAGS_olap_stdout ? std::cout : log);
@@ -573,6 +598,8 @@ void OLAPStream(std::atomic<BenchmarkState>& state, std::atomic_size_t& active_s
             pipelines.back()->addBreaker(std::make_shared<Q09AggregationOperator>(db, final_output_desc));
 
             auto qep = std::make_shared<QEP>(std::move(pipelines));
+            if (FLAGS_olap_temp_memory_budget > 0)
+                qep->setTempMemoryBudget(FLAGS_olap_temp_memory_budget);
             qep->begin(context);
             qep->waitForExecution(context, db.vmcache, false);
             printQueryResult(qep->getResult(), context.getWorkerId(), FLAGS_olap_stdout ? std::cout : log);
@@ -583,9 +610,11 @@ void OLAPStream(std::atomic<BenchmarkState>& state, std::atomic_size_t& active_s
             const size_t batch_size = num_pages;
             size_t allocated_pages = 0;
             std::vector<char*> pages;
+            // losing the pages means rerunning the query, whose duration is spread across all of its pages
+            const uint64_t page_cost_ns = std::max<uint64_t>(FLAGS_olap_sim_duration * 1000000000ull / std::max<size_t>(num_pages, 1), 1);
             // "analytical query": allocate a large number of temporary pages in vmcache
             while (state != BenchmarkState::Done && allocated_pages < num_pages) {
-                pages.push_back(db.vmcache.allocateTemporaryHugePage(batch_size, context.getWorkerId()));
+                pages.push_back(db.vmcache.allocateTemporaryHugePage(batch_size, context.getWorkerId(), page_cost_ns));
                 allocated_pages += batch_size;
             }
             // hold allocated pages
@@ -638,7 +667,7 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    const char* const supported_partitioning_strategies[] = { "basic", "partitioned" };
+    const char* const supported_partitioning_strategies[] = { "basic", "partitioned", "numa" };
     bool partitioning_strategy_valid = false;
     for (size_t i = 0; i < sizeof(supported_partitioning_strategies) / sizeof(supported_partitioning_strategies[0]); i++) {
         if (FLAGS_partitioning_strategy == supported_partitioning_strategies[i]) {
@@ -651,7 +680,7 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    const char* const supported_eviction_policies[] = { "clock", "random", "mru" };
+    const char* const supported_eviction_policies[] = { "clock", "random", "mru", "2q", "state_clock" };
     bool eviction_policy_valid = false;
     for (size_t i = 0; i < sizeof(supported_eviction_policies) / sizeof(supported_eviction_policies[0]); i++) {
         if (FLAGS_eviction_policy == supported_eviction_policies[i]) {
@@ -677,6 +706,11 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    if (FLAGS_column_extents && FLAGS_wal) {
+        std::cout << "Error: Column extents cannot be used with write-ahead logging" << std::endl;
+        return -1;
+    }
+
     // path to the database file
     std::string path(argv[1]);
 
@@ -689,13 +723,32 @@ int main(int argc, char** argv) {
             std::cout << "Error: Please specify a non-zero value for 'partitioned_num_temp_pages' for the partitioned strategy!" << std::endl;
             return -1;
         }
-        partitioning_strategy = createPartitioningStrategy<DataTempPartitioningStrategy>(FLAGS_eviction_policy, FLAGS_partitioned_num_temp_pages);
+        partitioning_strategy = createPartitioningStrategy<DataTempPartitioningStrategy>(FLAGS_eviction_policy, FLAGS_partitioned_num_temp_pages, FLAGS_partitioned_adaptive);
+    } else if (FLAGS_partitioning_strategy == "numa") {
+        partitioning_strategy = createPartitioningStrategy<NUMAPartitioningStrategy>(FLAGS_eviction_policy);
     }
 
     int ret = 0;
     {
         uint64_t num_threads = JobManager::configureNumThreads(FLAGS_parallel);
-        DB db(FLAGS_memory_limit, path, FLAGS_sandbox, FLAGS_no_dirty_writeback, !FLAGS_no_async_flush, !FLAGS_no_eviction_target, num_threads + 1, FLAGS_exmap, true, std::move(partitioning_strategy), 16ull * 1024ull * 1024ull); // 16M pages = 64 GiB max DB size
+        VMCacheConfig config;
+        config.max_size = FLAGS_memory_limit;
+        config.virtual_pages = 16ull * 1024ull * 1024ull; // 16M pages = 64 GiB max DB size
+        config.path = path;
+        config.sandbox = FLAGS_sandbox;
+        config.no_dirty_writeback = FLAGS_no_dirty_writeback;
+        config.flush_asynchronously = !FLAGS_no_async_flush;
+        config.use_eviction_target = !FLAGS_no_eviction_target;
+        config.use_exmap = FLAGS_exmap;
+        config.use_io_uring = FLAGS_io_uring;
+        config.use_wal = FLAGS_wal;
+        config.stats_on_shutdown = true;
+        config.num_workers = num_threads + 1;
+        config.num_page_cleaners = FLAGS_page_cleaners;
+        config.page_cleaner_watermark = FLAGS_page_cleaner_watermark;
+        config.compressed_tier_fraction = FLAGS_compressed_tier;
+        DB db(config, std::move(partitioning_strategy));
+        db.setColumnExtents(FLAGS_column_extents);
         JobManager job_manager(num_threads, db);
         ExecutionContext context(job_manager, db, 0, num_threads, false);
 
@@ -712,6 +765,9 @@ int main(int argc, char** argv) {
                 ret = -1;
             } else if (!tpcch::loadDatabase(db, context)) {
                 ret = -1;
+            } else if (FLAGS_wal) {
+                // the load itself is not logged, make it durable before running transactions
+                db.vmcache.checkpoint();
             }
 #ifdef VTUNE_PROFILING
             __itt_task_end(itt_domain);
@@ -729,6 +785,11 @@ int main(int argc, char** argv) {
             stats_collector_thread = std::make_unique<std::thread>(tpcch::statsCollectorThread, std::ref(FLAGS_collect_stats), std::ref(stop_stats_collection), std::ref(db), std::ref(no_success_count), collection_interval_ms);
         }
 
+        bool stop_checkpoints = false;
+        std::unique_ptr<std::thread> checkpoint_thread;
+        if (FLAGS_wal && FLAGS_checkpoint_interval != 0)
+            checkpoint_thread = std::make_unique<std::thread>(tpcch::checkpointThread, std::ref(stop_checkpoints), std::ref(db), FLAGS_checkpoint_interval);
+
         // run benchmark
         if (!FLAGS_import_only) {
             if (FLAGS_oltp != 0 && FLAGS_olap != "none" && FLAGS_oltp + 2 > job_manager.getWorkerCount()) {
@@ -740,7 +801,7 @@ int main(int argc, char** argv) {
 
                 PageId warehouse_basepage_id = db.getTableBasepageId("WAREHOUSE", context.getWorkerId());
                 PageId warehouse_visibility_basepage = SharedGuard<TableBasepage>(db.vmcache, warehouse_basepage_id, context.getWorkerId())->visibility_basepage;
-                const uint32_t num_warehouses = BTree<RowId, bool>(db.vmcache, warehouse_visibility_basepage, context.getWorkerId()).getCardinality();
+                const uint32_t num_warehouses = VisibilityBitmap(db.vmcache, warehouse_visibility_basepage, context.getWorkerId()).getNumRows();
                 std::cout << "Running benchmarks with " << num_warehouses << " warehouses and " << FLAGS_oltp << " OLTP streams" << std::endl;
                 tpcch::DataSource ds(num_warehouses);
                 std::ofstream log; // for now just suppress log output from streams, may change this later on
@@ -828,6 +889,10 @@ int main(int argc, char** argv) {
             stop_stats_collection = true;
             stats_collector_thread->join();
         }
+        if (checkpoint_thread) {
+            stop_checkpoints = true;
+            checkpoint_thread->join();
+        }
 
         job_manager.stop();
     }
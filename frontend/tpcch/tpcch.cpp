@@ -3,10 +3,12 @@
 #include <map>
 
 #include "prototype/execution/csv_import_pipeline.hpp"
+#include "prototype/execution/index_build_job.hpp"
 #include "prototype/execution/paged_vector_iterator.hpp"
 #include "prototype/execution/qep.hpp"
 #include "prototype/storage/persistence/btree.hpp"
 #include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 
 namespace tpcch {
 
@@ -42,23 +44,11 @@ void createIndexes(DB& db, const ExecutionContext context) {
     ExclusiveGuard<TableBasepage> order_basepage(db.vmcache, db.getTableBasepageId("ORDER", context.getWorkerId()), context.getWorkerId());
     BTree<CompositeKey<4>, size_t> index(db.vmcache, context.getWorkerId());
     order_basepage->additional_index_basepage = index.getRootPid();
-    BTree<RowId, bool> visibility(db.vmcache, order_basepage->visibility_basepage, context.getWorkerId());
-    std::vector<PagedVectorIterator<uint32_t>> key_its;
-    key_its.reserve(4);
-    for (size_t i = 0; i < 4; i++) {
-        key_its.emplace_back(db.vmcache, order_basepage->column_basepages[i], 0, context.getWorkerId());
-    }
+    const PageId visibility_basepage = order_basepage->visibility_basepage;
+    const std::array<PageId, 4> key_columns { order_basepage->column_basepages[0], order_basepage->column_basepages[1], order_basepage->column_basepages[3], order_basepage->column_basepages[2] };
     order_basepage.release();
 
-    for (auto vis_it = visibility.begin(); vis_it != visibility.end(); ++vis_it) {
-        auto vis = *vis_it;
-        if (!vis.second)
-            continue;
-        for (size_t i = 0; i < 4; i++)
-            key_its[i].reposition(vis.first);
-        CompositeKey<4> key { *key_its[0], *key_its[1], *key_its[3], *key_its[2] };
-        index.insert(key, vis.first);
-    }
+    buildCompositeKeyIndex<4>(index, db.vmcache, visibility_basepage, key_columns, context);
 }
 
 std::string joinPath(const std::string& a, const std::string& b) {
@@ -270,40 +260,40 @@ void importFromCSV(DB& db, const std::string& path, const ExecutionContext conte
     QEP qep(std::move(pipelines));
     qep.begin(context);
     qep.waitForExecution(context, db.vmcache);
-    const size_t num_warehouses = BTree<RowId, bool>(db.vmcache, warehouse_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t num_warehouses = VisibilityBitmap(db.vmcache, warehouse_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (num_warehouses == 0)
         throw std::runtime_error("The import data did not contain any warehouses");
-    const size_t district_cardinality = BTree<RowId, bool>(db.vmcache, district_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t district_cardinality = VisibilityBitmap(db.vmcache, district_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (district_cardinality != 10 * num_warehouses)
         throw UnexpectedCardinalityError("DISTRICT", district_cardinality, 10 * num_warehouses);
-    const size_t customer_cardinality = BTree<RowId, bool>(db.vmcache, customer_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t customer_cardinality = VisibilityBitmap(db.vmcache, customer_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (customer_cardinality != 30000 * num_warehouses)
         throw UnexpectedCardinalityError("CUSTOMER", customer_cardinality, 30000 * num_warehouses);
-    const size_t history_cardinality = BTree<RowId, bool>(db.vmcache, history_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t history_cardinality = VisibilityBitmap(db.vmcache, history_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (history_cardinality != 30000 * num_warehouses)
         throw UnexpectedCardinalityError("HISTORY", history_cardinality, 30000 * num_warehouses);
-    const size_t neworder_cardinality = BTree<RowId, bool>(db.vmcache, neworder_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t neworder_cardinality = VisibilityBitmap(db.vmcache, neworder_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (neworder_cardinality != 9000 * num_warehouses)
         throw UnexpectedCardinalityError("NEWORDER", neworder_cardinality, 9000 * num_warehouses);
-    const size_t order_cardinality = BTree<RowId, bool>(db.vmcache, order_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t order_cardinality = VisibilityBitmap(db.vmcache, order_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (order_cardinality != 30000 * num_warehouses)
         throw UnexpectedCardinalityError("ORDER", order_cardinality, 30000 * num_warehouses);
-    const size_t orderline_cardinality = BTree<RowId, bool>(db.vmcache, orderline_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t orderline_cardinality = VisibilityBitmap(db.vmcache, orderline_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (orderline_cardinality != 300000 * num_warehouses)
         throw UnexpectedCardinalityError("ORDERLINE", orderline_cardinality, 300000 * num_warehouses);
-    const size_t item_cardinality = BTree<RowId, bool>(db.vmcache, item_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t item_cardinality = VisibilityBitmap(db.vmcache, item_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (item_cardinality != 100000)
         throw UnexpectedCardinalityError("ITEM", item_cardinality, 100000);
-    const size_t stock_cardinality = BTree<RowId, bool>(db.vmcache, stock_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t stock_cardinality = VisibilityBitmap(db.vmcache, stock_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (stock_cardinality != 100000 * num_warehouses)
         throw UnexpectedCardinalityError("STOCK", stock_cardinality, 100000 * num_warehouses);
-    const size_t nation_cardinality = BTree<RowId, bool>(db.vmcache, nation_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t nation_cardinality = VisibilityBitmap(db.vmcache, nation_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (nation_cardinality != 62)
         throw UnexpectedCardinalityError("NATION", nation_cardinality, 62);
-    const size_t supplier_cardinality = BTree<RowId, bool>(db.vmcache, supplier_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t supplier_cardinality = VisibilityBitmap(db.vmcache, supplier_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (supplier_cardinality != 10000)
         throw UnexpectedCardinalityError("SUPPLIER", supplier_cardinality, 10000);
-    const size_t region_cardinality = BTree<RowId, bool>(db.vmcache, region_basepage->visibility_basepage, context.getWorkerId()).getCardinality();
+    const size_t region_cardinality = VisibilityBitmap(db.vmcache, region_basepage->visibility_basepage, context.getWorkerId()).getNumRows();
     if (region_cardinality != 5)
         throw UnexpectedCardinalityError("REGION", region_cardinality, 5);
 }
@@ -326,7 +316,7 @@ bool validateDatabase(DB& db, bool full) {
 
     PageId warehouse_basepage_id = db.getTableBasepageId("WAREHOUSE", worker_id);
     PageId warehouse_visibility_basepage = SharedGuard<TableBasepage>(db.vmcache, warehouse_basepage_id, worker_id)->visibility_basepage;
-    const uint32_t num_warehouses = BTree<RowId, bool>(db.vmcache, warehouse_visibility_basepage, worker_id).getCardinality();
+    const uint32_t num_warehouses = VisibilityBitmap(db.vmcache, warehouse_visibility_basepage, worker_id).getNumRows();
     if (num_warehouses == 0) {
         std::cerr << "The database does not contain any warehouses" << std::endl;
         return false;
@@ -14,6 +14,22 @@ namespace tpcch {
 
 const auto COUNT = NamedColumn(std::string("COUNT(*)"), std::make_shared<UnencodedTemporaryColumn<Integer>>());
 
+// logs the changes of a transaction when it goes out of scope (if the write-ahead log is enabled); there is no rollback, so early exits commit as well
+class TransactionScope {
+public:
+    TransactionScope(DB& db, const ExecutionContext context) : vmcache(db.vmcache), worker_id(context.getWorkerId()) {
+        vmcache.beginTransaction(worker_id);
+    }
+
+    ~TransactionScope() {
+        vmcache.commitTransaction(worker_id);
+    }
+
+private:
+    VMCache& vmcache;
+    const uint32_t worker_id;
+};
+
 std::shared_ptr<DefaultBreaker> executeSynchronouslyWithDefaultBreaker(DB& db, std::vector<std::unique_ptr<ExecutablePipeline>>&& pipelines, const ExecutionContext context) {
     pipelines.back()->addDefaultBreaker(context);
     auto qep = std::make_shared<QEP>(std::move(pipelines));
@@ -79,34 +95,38 @@ void runNOCustomerSelect(DB& db, Identifier w_id, Identifier d_id, Identifier c_
 void runNOOrderInsert(DB& db, Identifier o_d_id, Identifier o_w_id, Identifier o_id, Identifier o_c_id, DateTime o_entry_d, Integer o_ol_cnt, bool o_all_local, const ExecutionContext context) {
     // insert into \"ORDER\" values (?,?,?,?,?,NULL,?,?)
     SharedGuard<TableBasepage> table(db.vmcache, db.getTableBasepageId("ORDER", context.getWorkerId()), context.getWorkerId());
-    auto insert_guard = BTree<RowId, bool>(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertNext(true);
+    // each worker inserts into its own block of reserved rows, so concurrent inserts do not contend for the same bitmap and data pages
+    auto insert_guard = VisibilityBitmap(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertReserved(db.reserveRowId(table->visibility_basepage, context.getWorkerId()), false);
     assert(table->primary_key_index_basepage != INVALID_PAGE_ID);
-    BTree<CompositeKey<3>, size_t> pkey(db.vmcache, table->primary_key_index_basepage, context.getWorkerId());
-    pkey.insert(CompositeKey<3> { o_d_id, o_w_id, o_id }, insert_guard.key);
-    BTree<CompositeKey<4>, size_t> wdc(db.vmcache, table->additional_index_basepage, context.getWorkerId());
-    wdc.insert(CompositeKey<4> { o_d_id, o_w_id, o_c_id, o_id }, insert_guard.key);
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_D_ID_CID], &o_d_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_W_ID_CID], &o_w_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_ID_CID], &o_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_C_ID_CID], &o_c_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_ENTRY_D_CID], &o_entry_d, sizeof(DateTime), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_D_ID_CID], &o_d_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_W_ID_CID], &o_w_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_ID_CID], &o_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_C_ID_CID], &o_c_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_ENTRY_D_CID], &o_entry_d, sizeof(DateTime), context.getWorkerId());
     Identifier null = 0;
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_CARRIER_ID_CID], &null, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_OL_CNT_CID], &o_ol_cnt, sizeof(Integer), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_CARRIER_ID_CID], &null, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_OL_CNT_CID], &o_ol_cnt, sizeof(Integer), context.getWorkerId());
     Integer all_local = o_all_local ? 1 : 0;
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[O_ALL_LOCAL_CID], &all_local, sizeof(Integer), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[O_ALL_LOCAL_CID], &all_local, sizeof(Integer), context.getWorkerId());
+    BTree<CompositeKey<3>, size_t> pkey(db.vmcache, table->primary_key_index_basepage, context.getWorkerId());
+    pkey.insert(CompositeKey<3> { o_d_id, o_w_id, o_id }, insert_guard.rid);
+    BTree<CompositeKey<4>, size_t> wdc(db.vmcache, table->additional_index_basepage, context.getWorkerId());
+    wdc.insert(CompositeKey<4> { o_d_id, o_w_id, o_c_id, o_id }, insert_guard.rid);
+    // the row only becomes visible once all its index entries exist, if an insert fails it remains an invisible gap
+    insert_guard.setVisible();
 }
 
 void runNONewOrderInsert(DB& db, Identifier no_o_id, Identifier no_d_id, Identifier no_w_id, const ExecutionContext context) {
     // insert into NEWORDER values(?,?,?)
     SharedGuard<TableBasepage> table(db.vmcache, db.getTableBasepageId("NEWORDER", context.getWorkerId()), context.getWorkerId());
-    auto insert_guard = BTree<RowId, bool>(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertNext(true);
+    auto insert_guard = VisibilityBitmap(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertReserved(db.reserveRowId(table->visibility_basepage, context.getWorkerId()), false);
     assert(table->primary_key_index_basepage != INVALID_PAGE_ID);
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[NO_D_ID_CID], &no_d_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[NO_W_ID_CID], &no_w_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[NO_O_ID_CID], &no_o_id, sizeof(Identifier), context.getWorkerId());
     BTree<CompositeKey<3>, size_t> pkey(db.vmcache, table->primary_key_index_basepage, context.getWorkerId());
-    pkey.insert(CompositeKey<3> { no_d_id, no_w_id, no_o_id }, insert_guard.key);
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[NO_D_ID_CID], &no_d_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[NO_W_ID_CID], &no_w_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[NO_O_ID_CID], &no_o_id, sizeof(Identifier), context.getWorkerId());
+    pkey.insert(CompositeKey<3> { no_d_id, no_w_id, no_o_id }, insert_guard.rid);
+    insert_guard.setVisible();
 }
 
 bool runNOItemSelect(DB& db, Identifier i_id, uint64_t& i_price, const ExecutionContext context) {
@@ -170,27 +190,29 @@ size_t runNOStockUpdate(DB& db, Identifier i_id, Identifier w_id, bool is_remote
 void runNOOrderlineInsert(DB& db, Identifier ol_d_id, Identifier ol_w_id, Identifier ol_o_id, Identifier ol_number, Identifier ol_i_id, Identifier ol_supply_w_id, Integer ol_quantity, uint64_t ol_amount, std::string& ol_dist_info, const ExecutionContext context) {
     // insert into ORDERLINE values (?,?,?,?,?,?,NULL,?,?,?)
     SharedGuard<TableBasepage> table(db.vmcache, db.getTableBasepageId("ORDERLINE", context.getWorkerId()), context.getWorkerId());
-    auto insert_guard = BTree<RowId, bool>(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertNext(true);
+    auto insert_guard = VisibilityBitmap(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertReserved(db.reserveRowId(table->visibility_basepage, context.getWorkerId()), false);
     assert(table->primary_key_index_basepage != INVALID_PAGE_ID);
-    BTree<CompositeKey<4>, size_t> pkey(db.vmcache, table->primary_key_index_basepage, context.getWorkerId());
-    pkey.insert(CompositeKey<4> { ol_d_id, ol_w_id, ol_o_id, ol_number }, insert_guard.key);
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_D_ID_CID], &ol_d_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_W_ID_CID], &ol_w_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_O_ID_CID], &ol_o_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_NUMBER_CID], &ol_number, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_I_ID_CID], &ol_i_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_SUPPLY_W_ID_CID], &ol_supply_w_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_D_ID_CID], &ol_d_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_W_ID_CID], &ol_w_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_O_ID_CID], &ol_o_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_NUMBER_CID], &ol_number, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_I_ID_CID], &ol_i_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_SUPPLY_W_ID_CID], &ol_supply_w_id, sizeof(Identifier), context.getWorkerId());
     uint64_t null = 0;
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_DELIVERY_D_CID], &null, sizeof(DateTime), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_QUANTITY_CID], &ol_quantity, sizeof(Integer), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_AMOUNT_CID], &ol_amount, sizeof(Decimal<2>), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_DELIVERY_D_CID], &null, sizeof(DateTime), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_QUANTITY_CID], &ol_quantity, sizeof(Integer), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_AMOUNT_CID], &ol_amount, sizeof(Decimal<2>), context.getWorkerId());
     char dist_info[24] = {};
     memcpy(dist_info, ol_dist_info.c_str(), std::min(ol_dist_info.size(), 24ul));
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[OL_DIST_INFO_CID], dist_info, 24, context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[OL_DIST_INFO_CID], dist_info, 24, context.getWorkerId());
+    BTree<CompositeKey<4>, size_t> pkey(db.vmcache, table->primary_key_index_basepage, context.getWorkerId());
+    pkey.insert(CompositeKey<4> { ol_d_id, ol_w_id, ol_o_id, ol_number }, insert_guard.rid);
+    insert_guard.setVisible();
 }
 
 bool runNewOrder(std::ostream& log, DB& db, Identifier w_id, Identifier d_id, Identifier c_id, const OrderLine* orderlines, uint32_t ol_cnt, bool all_local, DateTime o_entry_d, const ExecutionContext context) {
     // BEGIN TRANSACTION
+    TransactionScope transaction(db, context);
     uint64_t w_tax = runNOWarehouseSelect(db, w_id, context);
 
     auto district_select_result = runNODistrictUpdate(db, w_id, d_id, context);
@@ -382,22 +404,23 @@ void runPMCustomerUpdate(DB& db, Identifier w_id, Identifier d_id, Identifier c_
 void runPMHistoryInsert(DB& db, Identifier c_id, Identifier c_d_id, Identifier c_w_id, Identifier d_id, Identifier w_id, DateTime h_date, Decimal<2> h_amount, const std::string& h_data, const ExecutionContext context) {
     // insert into HISTORY values (?,?,?,?,?,?,?,?)
     SharedGuard<TableBasepage> table(db.vmcache, db.getTableBasepageId("HISTORY", context.getWorkerId()), context.getWorkerId());
-    auto insert_guard = BTree<RowId, bool>(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertNext(true);
+    auto insert_guard = VisibilityBitmap(db.vmcache, table->visibility_basepage, context.getWorkerId()).insertReserved(db.reserveRowId(table->visibility_basepage, context.getWorkerId()), true);
     // note: HISTORY does not have a primary key, so no index insert needed here
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_C_ID_CID], &c_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_C_D_ID_CID], &c_d_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_C_W_ID_CID], &c_w_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_D_ID_CID], &d_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_W_ID_CID], &w_id, sizeof(Identifier), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_DATE_CID], &h_date, sizeof(DateTime), context.getWorkerId());
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_AMOUNT_CID], &h_amount, sizeof(Decimal<2>), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_C_ID_CID], &c_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_C_D_ID_CID], &c_d_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_C_W_ID_CID], &c_w_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_D_ID_CID], &d_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_W_ID_CID], &w_id, sizeof(Identifier), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_DATE_CID], &h_date, sizeof(DateTime), context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_AMOUNT_CID], &h_amount, sizeof(Decimal<2>), context.getWorkerId());
     char data[24] = {};
     memcpy(data, h_data.c_str(), std::min(h_data.size(), 24ul));
-    db.appendFixedSizeValue(insert_guard.key, table->column_basepages[H_DATA_CID], &data, 24, context.getWorkerId());
+    db.appendFixedSizeValue(insert_guard.rid, table->column_basepages[H_DATA_CID], &data, 24, context.getWorkerId());
 }
 
 bool runPayment(std::ostream& log, DB& db, Identifier w_id, Identifier d_id, Identifier c_w_id, Identifier c_d_id, bool customer_based_on_last_name, Identifier c_id, const std::string& c_last, Decimal<2> h_amount, DateTime h_date, const ExecutionContext context) {
 	// BEGIN TRANSACTION
+    TransactionScope transaction(db, context);
     std::string w_name = runPMWarehouseSelect(db, w_id, context);
     runPMWarehouseUpdate(db, w_id, h_amount, context);
     std::string d_name = runPMDistrictSelect(db, w_id, d_id, context);
@@ -621,6 +644,7 @@ void runDeliveryCustomerUpdate(DB& db, Identifier w_id, Identifier d_id, Identif
 bool runDelivery(std::ostream& log, DB& db, Identifier w_id, Identifier carrier_id, DateTime ol_delivery_d, const ExecutionContext context) {
     for (Identifier d_id = 1; d_id <= 10; ++d_id) {
         // BEGIN TRANSACTION
+        TransactionScope transaction(db, context);
         auto neworder_select_result = runDeliveryNeworderSelect(db, w_id, d_id, context);
         if (!neworder_select_result.has_value()) {
             log << "WARNING: Delivery skipped for warehouse " << w_id << ", district " << d_id << std::endl;
@@ -643,7 +667,7 @@ bool runDelivery(std::ostream& log, DB& db, Identifier w_id, Identifier carrier_
         }
         if (rid != std::numeric_limits<RowId>::max()) {
             // mark row as deleted
-            BTree<RowId, bool>(db.vmcache, table->visibility_basepage, context.getWorkerId()).latchForUpdate(rid).value().update(false);
+            VisibilityBitmap(db.vmcache, table->visibility_basepage, context.getWorkerId()).latchForUpdate(rid).value().update(false);
         }
 
         auto order_update_result = runDeliveryOrderUpdate(db, w_id, d_id, o_id, carrier_id, context);
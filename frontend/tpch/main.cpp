@@ -22,9 +22,11 @@
 #include "prototype/execution/qep.hpp"
 #include "prototype/scheduling/job_manager.hpp"
 #include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 #include "prototype/storage/policy/basic_partitioning_strategy.hpp"
 #include "prototype/storage/policy/cache_partition.hpp"
 #include "prototype/storage/policy/data_temp_partitioning_strategy.hpp"
+#include "prototype/storage/policy/numa_partitioning_strategy.hpp"
 #include "prototype/storage/vmcache.hpp"
 #include "prototype/utils/errno.hpp"
 #include "prototype/utils/print_result.hpp"
@@ -44,14 +46,21 @@ DEFINE_uint64(parallel, 0, "Number of threads to use; defaults to using all avai
 DEFINE_bool(no_dirty_writeback, false, "Disable writing back dirty pages to disk; Warning: This will result in data loss!");
 DEFINE_bool(no_async_flush, false, "Disable asynchronous flushing of dirty pages using idle worker threads");
 DEFINE_bool(no_eviction_target, false, "Disable eviction target mechanism for avoiding interference between large temporary allocations and regular buffer pool traffic");
+DEFINE_uint64(page_cleaners, 0, "Number of dedicated threads that evict and write back pages in the background, so that faulting workers find free frames even when no worker is idle");
+DEFINE_double(page_cleaner_watermark, PAGE_CLEANER_DEFAULT_WATERMARK, "Fraction of the buffer pool capacity that page cleaner threads keep free");
+DEFINE_double(compressed_tier, 0.0, "Fraction of the memory limit's buffer frames to use for holding compressed copies of evicted pages, which can be faulted again without I/O; 0 disables the compressed page tier");
+DEFINE_bool(column_extents, false, "Store the data of newly loaded columns in extents of 16 consecutive pages (64 KiB) that are faulted and evicted as a unit, instead of in single pages");
 DEFINE_bool(exmap, false, "Use exmap (kernel module has to be loaded) to reduce vmcache overhead");
+DEFINE_bool(io_uring, false, "Use per-worker io_uring instances for reading and writing pages (write-back batches are submitted at once, prefetch reads overlap with the following work, demand faults still wait for their read)");
 DEFINE_bool(import_only, false, "Only import input data, do not run query");
 DEFINE_bool(collect_stats, false, "Collect statistics while running the queries into 'stats.csv'");
 DEFINE_bool(collect_latched_page_stat, false, "Include the number of latched data pages in the collected statistics; this has high overhead as it involves iterating over all cached pages at each collection interval");
 DEFINE_string(query, "q06", "Query to run; options are 'scan_nation', 'scan_lineitem', 'scan_partsupp', 'q06', 'q09_mod', and 'q09_mod_no_sel'");
-DEFINE_string(partitioning_strategy, "basic", "Partitioning strategy to use in vmcache; options are 'basic' and 'partitioned' (uses separate partitions for data and temporary pages)");
-DEFINE_string(eviction_policy, "clock", "Eviction policy to use within vmcache partitions; options are 'clock', 'random', and 'mru'");
+DEFINE_string(partitioning_strategy, "basic", "Partitioning strategy to use in vmcache; options are 'basic', 'partitioned' (uses separate partitions for data and temporary pages), and 'numa' (uses one partition per NUMA node)");
+DEFINE_string(eviction_policy, "clock", "Eviction policy to use within vmcache partitions; options are 'clock', 'random', 'mru', '2q', and 'state_clock' (clock over the page state array without a resident page hash set)");
+DEFINE_uint64(temp_memory_budget, 0, "Number of temporary pages a query may use before the start of its further pipelines is delayed; 0 disables the budget");
 DEFINE_uint64(partitioned_num_temp_pages, 0, "Number of pages to allocate to temporary data if the cache is partitioned");
+DEFINE_bool(partitioned_adaptive, false, "Resize the data and temporary partitions online if the cache is partitioned; 'partitioned_num_temp_pages' then only specifies the initial size of the temporary partition");
 DEFINE_uint64(repetitions, 10, "Number of times to repeat query execution, specify 0 to run indefinitely");
 DEFINE_uint64(warmup_time, 0, "Warmup time in seconds; if not specified, the queries will simply run for the specified number of repetitions");
 DEFINE_uint64(benchmark_time, 0, "Benchmark time in seconds; if not specified, the queries will simply run for the specified number of repetitions");
@@ -232,7 +241,7 @@ bool validateDatabase(DB& db) {
     const size_t expected_num_rows = 59986052;
     PageId lineitem_basepage_pid = db.getTableBasepageId("LINEITEM", worker_id);
     PageId lineitem_visibility_root_pid = SharedGuard<TableBasepage>(db.vmcache, lineitem_basepage_pid, worker_id)->visibility_basepage;
-    const size_t lineitem_cardinality = BTree<RowId, bool>(db.vmcache, lineitem_visibility_root_pid, worker_id).getCardinality();
+    const size_t lineitem_cardinality = VisibilityBitmap(db.vmcache, lineitem_visibility_root_pid, worker_id).getNumRows();
     if (lineitem_cardinality != expected_num_rows) {
         std::cerr << "Invalid row count " << lineitem_cardinality << ". Expected " << expected_num_rows << std::endl;
         return true;
@@ -309,7 +318,7 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    const char* const supported_partitioning_strategies[] = { "basic", "partitioned" };
+    const char* const supported_partitioning_strategies[] = { "basic", "partitioned", "numa" };
     bool partitioning_strategy_valid = false;
     for (size_t i = 0; i < sizeof(supported_partitioning_strategies) / sizeof(supported_partitioning_strategies[0]); i++) {
         if (FLAGS_partitioning_strategy == supported_partitioning_strategies[i]) {
@@ -322,7 +331,7 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    const char* const supported_eviction_policies[] = { "clock", "random", "mru" };
+    const char* const supported_eviction_policies[] = { "clock", "random", "mru", "2q", "state_clock" };
     bool eviction_policy_valid = false;
     for (size_t i = 0; i < sizeof(supported_eviction_policies) / sizeof(supported_eviction_policies[0]); i++) {
         if (FLAGS_eviction_policy == supported_eviction_policies[i]) {
@@ -347,13 +356,29 @@ int main(int argc, char** argv) {
             std::cout << "Error: Please specify a non-zero value for 'partitioned_num_temp_pages' for the partitioned strategy!" << std::endl;
             return -1;
         }
-        partitioning_strategy = createPartitioningStrategy<DataTempPartitioningStrategy>(FLAGS_eviction_policy, FLAGS_partitioned_num_temp_pages);
+        partitioning_strategy = createPartitioningStrategy<DataTempPartitioningStrategy>(FLAGS_eviction_policy, FLAGS_partitioned_num_temp_pages, FLAGS_partitioned_adaptive);
+    } else if (FLAGS_partitioning_strategy == "numa") {
+        partitioning_strategy = createPartitioningStrategy<NUMAPartitioningStrategy>(FLAGS_eviction_policy);
     }
 
     int ret = 0;
     {
         uint64_t num_threads = JobManager::configureNumThreads(FLAGS_parallel);
-        DB db(FLAGS_memory_limit, path, false, FLAGS_no_dirty_writeback, !FLAGS_no_async_flush, !FLAGS_no_eviction_target, num_threads + 1, FLAGS_exmap, true, std::move(partitioning_strategy));
+        VMCacheConfig config;
+        config.max_size = FLAGS_memory_limit;
+        config.path = path;
+        config.no_dirty_writeback = FLAGS_no_dirty_writeback;
+        config.flush_asynchronously = !FLAGS_no_async_flush;
+        config.use_eviction_target = !FLAGS_no_eviction_target;
+        config.use_exmap = FLAGS_exmap;
+        config.use_io_uring = FLAGS_io_uring;
+        config.stats_on_shutdown = true;
+        config.num_workers = num_threads + 1;
+        config.num_page_cleaners = FLAGS_page_cleaners;
+        config.page_cleaner_watermark = FLAGS_page_cleaner_watermark;
+        config.compressed_tier_fraction = FLAGS_compressed_tier;
+        DB db(config, std::move(partitioning_strategy));
+        db.setColumnExtents(FLAGS_column_extents);
         JobManager job_manager(num_threads, db);
         ExecutionContext context(job_manager, db, 0, num_threads, false);
 
@@ -428,6 +453,8 @@ int main(int argc, char** argv) {
 #endif
                             stream.begin = std::chrono::steady_clock::now();
                             stream.current_qep = getQEP(db, stream.query_name, context);
+                            if (FLAGS_temp_memory_budget > 0)
+                                stream.current_qep->setTempMemoryBudget(FLAGS_temp_memory_budget);
                             stream.current_qep->begin(context);
                         }
                     }
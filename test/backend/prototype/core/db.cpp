@@ -1,5 +1,8 @@
 #include "test/shared/db_test.hpp"
+#include "prototype/execution/paged_vector_iterator.hpp"
 #include "prototype/scheduling/execution_context.hpp"
+#include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 
 class DBFixture : public DBTestFixture { };
 
@@ -33,4 +36,41 @@ TEST_F(DBFixture, getTableBasepageId) {
         db->getTableBasepageId(tid_b, context->getWorkerId()),
         db->getTableBasepageId("TABLE_B", context->getWorkerId())
     );
+}
+
+TEST_F(DBFixture, reserveRowId) {
+    uint64_t schema_id = db->createSchema("TEST", 0);
+    uint64_t tid = db->createTable(schema_id, "TABLE_A", 1, 0);
+    SharedGuard<TableBasepage> table(db->vmcache, db->getTableBasepageId(tid, 0), 0);
+    const PageId visibility_basepage = table->visibility_basepage;
+    const PageId column_basepage = table->column_basepages[0];
+    table.release();
+
+    // two workers insert alternately, each into its own block of rows
+    std::vector<RowId> rids[2];
+    for (uint64_t value = 0; value < 3000; value++) {
+        const uint32_t worker_id = value % 2;
+        const RowId rid = db->reserveRowId(visibility_basepage, worker_id);
+        auto insert_guard = VisibilityBitmap(db->vmcache, visibility_basepage, worker_id).insertReserved(rid, true);
+        db->appendFixedSizeValue(rid, column_basepage, &value, sizeof(uint64_t), worker_id);
+        rids[worker_id].push_back(rid);
+    }
+    for (uint32_t worker_id = 0; worker_id < 2; worker_id++) {
+        for (size_t i = 0; i < rids[worker_id].size(); i++)
+            ASSERT_EQ(rids[worker_id][i], worker_id * VisibilityBitmap::reserved_block_size + i);
+    }
+
+    // the second worker's rows were appended to data pages past those that did not exist yet
+    VisibilityBitmap visibility(db->vmcache, visibility_basepage, 0);
+    EXPECT_EQ(visibility.getNumRows(), 2 * VisibilityBitmap::reserved_block_size);
+    std::vector<uint64_t> values;
+    PagedVectorIterator<uint64_t> it(db->vmcache, column_basepage, GeneralPagedVectorIterator::UNLOAD, 0);
+    visibility.forEachVisible(0, visibility.getNumRows(), [&](RowId rid) {
+        it.reposition(rid);
+        values.push_back(*it);
+        return true;
+    }, [&] { it.release(); });
+    ASSERT_EQ(values.size(), 3000);
+    for (size_t i = 0; i < values.size(); i++)
+        ASSERT_EQ(values[i], i < 1500 ? 2 * i : 2 * (i - 1500) + 1);
 }
\ No newline at end of file
@@ -22,7 +22,7 @@ protected:
         ExclusiveGuard<TableBasepage> t1_basepage(db->vmcache, t1_basepage_pid, 0);
         std::vector<Identifier> t1c1_values({ 1, 2, 1, 2, 2, 4, 5 });
         db->appendValues<Identifier>(0, t1_basepage->column_basepages[0], t1c1_values.begin(), t1c1_values.end(), 0);
-        BTree<RowId, bool> visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
+        VisibilityBitmap visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
         for (size_t i = 0; i < t1c1_values.size(); ++i)
             visibility.insertNext(true);
     }
@@ -52,13 +52,13 @@ protected:
         db->appendValues<Identifier>(0, t3_basepage->column_basepages[1], t3c2_values.begin(), t3c2_values.end(), 0);
         db->appendValues<Integer>(0, t3_basepage->column_basepages[2], t3c3_values.begin(), t3c3_values.end(), 0);
         db->appendValues<Identifier>(0, t3_basepage->column_basepages[3], t3c4_values.begin(), t3c4_values.end(), 0);
-        BTree<RowId, bool> t1_visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
+        VisibilityBitmap t1_visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
         for (size_t i = 0; i < t1c1_values.size(); ++i)
             t1_visibility.insertNext(true);
-        BTree<RowId, bool> t2_visibility(db->vmcache, t2_basepage->visibility_basepage, 0);
+        VisibilityBitmap t2_visibility(db->vmcache, t2_basepage->visibility_basepage, 0);
         for (size_t i = 0; i < t2c1_values.size(); ++i)
             t2_visibility.insertNext(true);
-        BTree<RowId, bool> t3_visibility(db->vmcache, t3_basepage->visibility_basepage, 0);
+        VisibilityBitmap t3_visibility(db->vmcache, t3_basepage->visibility_basepage, 0);
         for (size_t i = 0; i < t3c1_values.size(); ++i)
             t3_visibility.insertNext(true);
     }
@@ -144,6 +144,46 @@ TEST_F(JoinFixture, join_non_distinct_build_side) {
     EXPECT_TRUE(validateQueryResult(qep->getResult(), expected_result));
 }
 
+TEST_F(JoinFixture, join_partitioned) {
+    std::vector<std::unique_ptr<ExecutablePipeline>> pipelines;
+
+    // scan t2 and collect tuples
+    pipelines.push_back(std::make_unique<ExecutablePipeline>(0, *db, "T2", std::vector<NamedColumn>({ t2c1, t2c2 }), *context));
+    pipelines[0]->addJoinBreaker(db->vmcache, *context);
+
+    // init & build hash table, the probe handles the build side as if it did not fit into memory
+    auto join_build = JoinFactory::createBuildPipelines(pipelines, db->vmcache, *pipelines[0], t1c1.column->getValueTypeSize());
+    join_build->setMaxResidentPages(0);
+
+    // scan t1 and probe hash table
+    pipelines.push_back(std::make_unique<ExecutablePipeline>(3, *db, "T1", std::vector<NamedColumn>({ t1c1, t1c2 }), *context));
+    pipelines[3]->addJoinProbe(db->vmcache, *pipelines[2], std::vector<NamedColumn>({ t1c1, t2c2, t1c2 }));
+    pipelines[3]->addDefaultBreaker(*context);
+    auto qep = std::make_shared<QEP>(std::move(pipelines));
+
+    // execute
+    qep->begin(*context);
+    qep->waitForExecution(*context, db->vmcache);
+
+    // validate results
+    BatchVector expected_result(db->vmcache, sizeof(Identifier) + 2 * sizeof(Integer));
+    uint32_t* row = reinterpret_cast<uint32_t*>(expected_result.addRow());
+    row[0] = 1; row[1] = -11; row[2] = 11;
+    row = reinterpret_cast<uint32_t*>(expected_result.addRow());
+    row[0] = 1; row[1] = -99; row[2] = 11;
+    row = reinterpret_cast<uint32_t*>(expected_result.addRow());
+    row[0] = 2; row[1] = -22; row[2] = 22;
+    row = reinterpret_cast<uint32_t*>(expected_result.addRow());
+    row[0] = 2; row[1] = -33; row[2] = 22;
+    row = reinterpret_cast<uint32_t*>(expected_result.addRow());
+    row[0] = 2; row[1] = -66; row[2] = 22;
+    row = reinterpret_cast<uint32_t*>(expected_result.addRow());
+    row[0] = 5; row[1] = -55; row[2] = 55;
+    row = reinterpret_cast<uint32_t*>(expected_result.addRow());
+    row[0] = 5; row[1] = -77; row[2] = 55;
+    EXPECT_TRUE(validateQueryResult(qep->getResult(), expected_result));
+}
+
 TEST_F(JoinFixture, join_composite_key_8B) {
     std::vector<std::unique_ptr<ExecutablePipeline>> pipelines;
 
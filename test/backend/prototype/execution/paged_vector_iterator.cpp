@@ -0,0 +1,156 @@
+#include "test/shared/db_test.hpp"
+#include "prototype/core/db.hpp"
+#include "prototype/core/types.hpp"
+#include "prototype/execution/paged_vector_iterator.hpp"
+#include "prototype/storage/persistence/table.hpp"
+
+class PagedVectorIteratorFixture : public DBTestFixture {
+public:
+    static constexpr size_t NUM_DATA_PAGES = 32;
+    static constexpr size_t VALUES_PER_PAGE = PAGE_SIZE / sizeof(Identifier);
+
+    PageId column_basepage_pid;
+    std::vector<PageId> data_pages;
+
+protected:
+    void SetUp() override {
+        DBTestFixture::SetUp();
+
+        uint64_t tid = db->createTable(db->default_schema_id, "T1", 1, 0);
+        {
+            ExclusiveGuard<TableBasepage> table_basepage(db->vmcache, db->getTableBasepageId(tid, 0), 0);
+            column_basepage_pid = table_basepage->column_basepages[0];
+        }
+        std::vector<Identifier> values(NUM_DATA_PAGES * VALUES_PER_PAGE);
+        for (size_t i = 0; i < values.size(); i++)
+            values[i] = i;
+        db->appendValues<Identifier>(0, column_basepage_pid, values.begin(), values.end(), 0);
+        SharedGuard<ColumnBasepage> column_basepage(db->vmcache, column_basepage_pid, 0);
+        for (size_t i = 0; i < NUM_DATA_PAGES; i++)
+            data_pages.push_back(column_basepage->data_pages[i]);
+    }
+
+    bool isResident(PageId pid) {
+        return PAGE_STATE(db->vmcache.getPageState(pid).load()) != PAGE_STATE_EVICTED;
+    }
+};
+
+TEST_F(PagedVectorIteratorFixture, sequential_readahead) {
+    db->vmcache.evictAll(false, 0);
+    for (PageId pid : data_pages)
+        EXPECT_FALSE(isResident(pid));
+
+    PagedVectorIterator<Identifier> it(db->vmcache, column_basepage_pid, 0, 0);
+    for (size_t idx = 0; idx < NUM_DATA_PAGES * VALUES_PER_PAGE; idx++) {
+        it.reposition(idx);
+        ASSERT_EQ(*it, idx);
+        const size_t page_num = idx / VALUES_PER_PAGE;
+        // as soon as the second consecutive page has been loaded, the following pages are prefetched
+        if (page_num >= 1 && page_num + 1 < NUM_DATA_PAGES) {
+            EXPECT_TRUE(isResident(data_pages[page_num + 1]));
+        }
+        it.release();
+    }
+}
+
+TEST_F(PagedVectorIteratorFixture, readahead_window_trigger) {
+    db->vmcache.evictAll(false, 0);
+    const size_t window = GeneralPagedVectorIterator::READAHEAD_MIN_WINDOW;
+
+    PagedVectorIterator<Identifier> it(db->vmcache, column_basepage_pid, 0, 0);
+    // the first window starts at the second consecutive page, the next one is only requested once half of it has been consumed
+    for (size_t page_num = 0; page_num < 1 + window / 2; page_num++)
+        it.reposition(page_num * VALUES_PER_PAGE);
+    EXPECT_TRUE(isResident(data_pages[window]));
+    EXPECT_FALSE(isResident(data_pages[1 + window]));
+    it.reposition((1 + window / 2) * VALUES_PER_PAGE);
+    EXPECT_TRUE(isResident(data_pages[1 + window]));
+    it.release();
+}
+
+TEST_F(PagedVectorIteratorFixture, readahead_skips_holes) {
+    uint64_t tid = db->createTable(db->default_schema_id, "T2", 1, 0);
+    PageId basepage_pid;
+    {
+        SharedGuard<TableBasepage> table_basepage(db->vmcache, db->getTableBasepageId(tid, 0), 0);
+        basepage_pid = table_basepage->column_basepages[0];
+    }
+    // rows reserved by other workers may leave data pages unallocated (see 'DB::reserveRowId()'), here pages 3 and 4
+    const std::vector<size_t> page_nums { 0, 1, 2, 5, 6 };
+    for (size_t page_num : page_nums) {
+        const Identifier value = page_num;
+        db->appendFixedSizeValue(page_num * VALUES_PER_PAGE, basepage_pid, &value, sizeof(Identifier), 0);
+    }
+    std::vector<PageId> pids;
+    {
+        SharedGuard<ColumnBasepage> column_basepage(db->vmcache, basepage_pid, 0);
+        for (size_t page_num : page_nums)
+            pids.push_back(column_basepage->data_pages[page_num]);
+        EXPECT_EQ(column_basepage->data_pages[3], 0);
+        EXPECT_EQ(column_basepage->data_pages[4], 0);
+    }
+    db->vmcache.evictAll(false, 0);
+
+    PagedVectorIterator<Identifier> it(db->vmcache, basepage_pid, 0, 0);
+    it.reposition(1 * VALUES_PER_PAGE);
+    EXPECT_EQ(*it, 1);
+    it.release();
+    // the readahead window that starts at the second page continues after the holes
+    for (PageId pid : pids)
+        EXPECT_TRUE(isResident(pid));
+}
+
+TEST_F(PagedVectorIteratorFixture, no_readahead_for_random_access) {
+    db->vmcache.evictAll(false, 0);
+
+    PagedVectorIterator<Identifier> it(db->vmcache, column_basepage_pid, 0, 0);
+    it.reposition(10 * VALUES_PER_PAGE);
+    it.reposition(20 * VALUES_PER_PAGE);
+    it.reposition(5 * VALUES_PER_PAGE);
+    it.release();
+    size_t num_resident = 0;
+    for (PageId pid : data_pages)
+        num_resident += isResident(pid) ? 1 : 0;
+    EXPECT_EQ(num_resident, 4ul);
+}
+
+TEST_F(PagedVectorIteratorFixture, column_extents) {
+    db->setColumnExtents(true);
+    uint64_t tid = db->createTable(db->default_schema_id, "T2", 1, 0);
+    PageId basepage_pid;
+    {
+        SharedGuard<TableBasepage> table_basepage(db->vmcache, db->getTableBasepageId(tid, 0), 0);
+        basepage_pid = table_basepage->column_basepages[0];
+    }
+    EXPECT_EQ(GeneralPagedVectorIterator::getDataPageSize(db->vmcache, basepage_pid, 0), EXTENT_NUM_PAGES);
+    EXPECT_EQ(GeneralPagedVectorIterator::getDataPageSize(db->vmcache, column_basepage_pid, 0), 1ul);
+    // append in two steps, so that the second one continues filling the first extent
+    const size_t num_values = 3 * EXTENT_NUM_PAGES * VALUES_PER_PAGE;
+    std::vector<Identifier> values(num_values);
+    for (size_t i = 0; i < num_values; i++)
+        values[i] = i;
+    db->appendValues<Identifier>(0, basepage_pid, values.begin(), values.begin() + 100, 0);
+    db->appendValues<Identifier>(100, basepage_pid, values.begin() + 100, values.end(), 0);
+    {
+        SharedGuard<ColumnBasepage> column_basepage(db->vmcache, basepage_pid, 0);
+        for (size_t i = 0; i < 3; i++)
+            EXPECT_EQ(db->vmcache.getPageCount(column_basepage->data_pages[i]), EXTENT_NUM_PAGES);
+        EXPECT_EQ(column_basepage->data_pages[3], 0ul);
+        // values beyond the end of a data page are rejected
+        const PageId data_pid = column_basepage->data_pages[0];
+        ExclusiveGuard<ColumnDataPage> data_page(db->vmcache, data_pid, 0);
+        EXPECT_NO_THROW(data_page->getValues(db->vmcache.getPageCount(data_pid), 0, EXTENT_NUM_PAGES * VALUES_PER_PAGE, sizeof(Identifier)));
+        EXPECT_THROW(data_page->getValues(db->vmcache.getPageCount(data_pid), EXTENT_NUM_PAGES * VALUES_PER_PAGE - 1, 2, sizeof(Identifier)), std::runtime_error);
+    }
+
+    db->vmcache.evictAll(false, 0);
+    const size_t faulted_pages = db->vmcache.getTotalFaultedPageCount();
+    PagedVectorIterator<Identifier> it(db->vmcache, basepage_pid, 0, 0);
+    for (size_t idx = 0; idx < num_values; idx++) {
+        it.reposition(idx);
+        ASSERT_EQ(*it, idx);
+    }
+    it.release();
+    // each extent is read as a whole (plus the column's basepage)
+    EXPECT_LE(db->vmcache.getTotalFaultedPageCount() - faulted_pages, 3 * EXTENT_NUM_PAGES + 1);
+}
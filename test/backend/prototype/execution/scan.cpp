@@ -4,8 +4,8 @@
 #include "prototype/execution/scan.hpp"
 #include "prototype/execution/table_column.hpp"
 #include "prototype/scheduling/job_manager.hpp"
-#include "prototype/storage/persistence/btree.hpp"
 #include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 #include "prototype/utils/validation.hpp"
 
 class ScanFixture : public DBTestFixture {
@@ -28,7 +28,7 @@ protected:
         db->appendValues<Identifier>(0, t1_basepage->column_basepages[0], t1c1_values.begin(), t1c1_values.end(), 0);
         db->appendValues<Identifier>(0, t1_basepage->column_basepages[1], t1c2_values.begin(), t1c2_values.end(), 0);
         db->appendValues<Identifier>(0, t1_basepage->column_basepages[2], t1c3_values.begin(), t1c3_values.end(), 0);
-        BTree<RowId, bool> visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
+        VisibilityBitmap visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
         for (size_t i = 0; i < t1c1_values.size(); ++i)
             visibility.insertNext(i != 2); // mark row 2 (56, 33, 6) as deleted
     }
@@ -4,8 +4,8 @@
 #include "prototype/execution/sort.hpp"
 #include "prototype/execution/table_column.hpp"
 #include "prototype/scheduling/job_manager.hpp"
-#include "prototype/storage/persistence/btree.hpp"
 #include "prototype/storage/persistence/table.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
 #include "prototype/utils/validation.hpp"
 
 class SortFixture : public DBTestFixture {
@@ -28,7 +28,7 @@ protected:
         db->appendValues<Identifier>(0, t1_basepage->column_basepages[0], t1c1_values.begin(), t1c1_values.end(), 0);
         db->appendValues<Identifier>(0, t1_basepage->column_basepages[1], t1c2_values.begin(), t1c2_values.end(), 0);
         db->appendValues<Identifier>(0, t1_basepage->column_basepages[2], t1c3_values.begin(), t1c3_values.end(), 0);
-        BTree<RowId, bool> t1_visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
+        VisibilityBitmap t1_visibility(db->vmcache, t1_basepage->visibility_basepage, 0);
         for (size_t i = 0; i < t1c1_values.size(); ++i)
             t1_visibility.insertNext(true);
 
@@ -41,7 +41,7 @@ protected:
         for (size_t i = 0; i < t2_cardinality; ++i)
             t2c1_values.push_back(t2_cardinality - i);
         db->appendValues<Identifier>(0, t2_basepage->column_basepages[0], t2c1_values.begin(), t2c1_values.end(), 0);
-        BTree<RowId, bool> t2_visibility(db->vmcache, t2_basepage->visibility_basepage, 0);
+        VisibilityBitmap t2_visibility(db->vmcache, t2_basepage->visibility_basepage, 0);
         for (size_t i = 0; i < t2c1_values.size(); ++i)
             t2_visibility.insertNext(true);
 
@@ -159,3 +159,99 @@ TEST_F(SortFixture, sort_4096) {
     }
     EXPECT_EQ(num_result_rows, 4096);
 }
+
+TEST_F(SortFixture, sort_with_temp_memory_budget) {
+    std::vector<std::unique_ptr<ExecutablePipeline>> pipelines;
+    pipelines.push_back(std::make_unique<ExecutablePipeline>(pipelines.size(), *db, "T1", std::vector<NamedColumn>({ c1, c2 }), *context));
+    pipelines.back()->addSortBreaker(std::vector<NamedColumn>({ c1 }), std::vector<Order>({ Order::Ascending }), context->getWorkerCount());
+    // (1) is independent of (0) and starts executing at the same time
+    pipelines.push_back(std::make_unique<ExecutablePipeline>(pipelines.size(), *db, "T2", std::vector<NamedColumn>({ c1 }), *context));
+    pipelines.back()->addSortBreaker(std::vector<NamedColumn>({ c1 }), std::vector<Order>({ Order::Ascending }), context->getWorkerCount());
+    pipelines.push_back(std::make_unique<ExecutablePipeline>(pipelines.size()));
+    pipelines.back()->addSort(db->vmcache, *pipelines[0].get());
+    pipelines.back()->addDefaultBreaker(*context);
+    auto qep = std::make_shared<QEP>(std::move(pipelines));
+    // the sort breakers exceed this budget, so (2) may only start once (1) has finished
+    qep->setTempMemoryBudget(0);
+
+    // execute
+    qep->begin(*context);
+    qep->waitForExecution(*context, db->vmcache);
+    EXPECT_GT(qep->getTempMemoryBudget()->getPeakUsedPages(), 0);
+    EXPECT_GT(qep->getNumDelayedPipelines(), 0);
+
+    // validate results
+    BatchVector expected_result(db->vmcache, 2 * sizeof(Identifier));
+    Identifier* row = reinterpret_cast<Identifier*>(expected_result.addRow());
+    row[0] = 2; row[1] = 22;
+    row = reinterpret_cast<Identifier*>(expected_result.addRow());
+    row[0] = 3; row[1] = 44;
+    row = reinterpret_cast<Identifier*>(expected_result.addRow());
+    row[0] = 41; row[1] = 55;
+    row = reinterpret_cast<Identifier*>(expected_result.addRow());
+    row[0] = 51; row[1] = 11;
+    row = reinterpret_cast<Identifier*>(expected_result.addRow());
+    row[0] = 56; row[1] = 33;
+    EXPECT_TRUE(validateQueryResult(qep->getResult(), expected_result, true));
+}
+
+TEST_F(SortFixture, sort_spilled_runs_with_small_merge_fan_in) {
+    std::vector<std::unique_ptr<ExecutablePipeline>> pipelines;
+    pipelines.push_back(std::make_unique<ExecutablePipeline>(pipelines.size(), *db, "T2", std::vector<NamedColumn>({ c1 }), *context));
+    pipelines.back()->addSortBreaker(std::vector<NamedColumn>({ c1 }), std::vector<Order>({ Order::Ascending }), context->getWorkerCount());
+    pipelines.push_back(std::make_unique<ExecutablePipeline>(pipelines.size()));
+    auto sort = pipelines.back()->addSort(db->vmcache, *pipelines[0].get());
+    // the pre-sorted batches are spilled, so they are merged two runs at a time until at most two runs remain
+    sort->setMergeFanIn(2);
+    pipelines.back()->addDefaultBreaker(*context);
+    auto qep = std::make_shared<QEP>(std::move(pipelines));
+    qep->setTempMemoryBudget(0);
+
+    // execute
+    qep->begin(*context);
+    qep->waitForExecution(*context, db->vmcache);
+
+    // validate results
+    std::vector<std::shared_ptr<Batch>> batches;
+    qep->getResult()->consumeBatches(batches, context->getWorkerId());
+    int32_t last_val = 0;
+    size_t num_result_rows = 0;
+    for (auto& batch : batches) {
+        batch->pin(context->getWorkerId());
+        for (auto it = batch->begin(); it < batch->end(); it++) {
+            int32_t val = *reinterpret_cast<int32_t*>((*it).data);
+            EXPECT_LT(last_val, val);
+            last_val = val;
+            num_result_rows++;
+        }
+    }
+    EXPECT_EQ(num_result_rows, 4096);
+}
+
+TEST_F(SortFixture, spill_batch_over_temp_memory_budget) {
+    auto budget = TempMemoryBudget::create(0);
+    TempMemoryBudget* previous = db->vmcache.exchangeTempMemoryBudget(0, budget.get());
+    auto batch = std::make_shared<Batch>(db->vmcache, sizeof(Identifier), 0);
+    EXPECT_EQ(budget->getUsedPages(), 1);
+    uint32_t row_id;
+    Identifier* row;
+    for (Identifier i = 0; (row = reinterpret_cast<Identifier*>(batch->addRowIfPossible(row_id))) != nullptr; i++)
+        *row = i;
+    const uint32_t num_rows = batch->getCurrentSize();
+
+    // the budget is exceeded, so the rows are moved into a spillable batch
+    std::shared_ptr<Batch> spilled = Batch::spillIfOverBudget(batch, 0);
+    EXPECT_TRUE(spilled->isSpillable());
+    EXPECT_FALSE(spilled->isPinned());
+    db->vmcache.exchangeTempMemoryBudget(0, previous);
+    // the page is uncharged from the budget it was charged to, even outside of the budget's scope
+    batch = nullptr;
+    EXPECT_EQ(budget->getUsedPages(), 0);
+    EXPECT_EQ(budget->getPeakUsedPages(), 1);
+
+    spilled->pin(0);
+    ASSERT_EQ(spilled->getCurrentSize(), num_rows);
+    EXPECT_EQ(spilled->getValidRowCount(), num_rows);
+    for (uint32_t i = 0; i < num_rows; i++)
+        EXPECT_EQ(*reinterpret_cast<Identifier*>(spilled->getRow(i)), i);
+}
\ No newline at end of file
@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+
 #include "test/shared/db_test.hpp"
 #include "prototype/core/db.hpp"
 #include "prototype/core/types.hpp"
@@ -25,6 +31,74 @@ TEST(BTree, lowerBound) {
     EXPECT_EQ(lowerBound<size_t>(array2, 3, 7), 2);
 }
 
+template <typename KeyType, typename Generator>
+void checkLowerBound(Generator generate) {
+    std::mt19937_64 gen(42);
+    for (size_t size : { 0ul, 1ul, 7ul, 8ul, 15ul, 33ul, 100ul, 511ul }) {
+        std::vector<KeyType> keys;
+        while (keys.size() < size) {
+            keys.push_back(generate(gen));
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        }
+        for (size_t i = 0; i < 200; i++) {
+            const KeyType key = i < keys.size() ? keys[i] : generate(gen);
+            const size_t expected = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+            ASSERT_EQ(lowerBound<KeyType>(keys.data(), keys.size(), key), expected);
+        }
+    }
+}
+
+// the vectorized search kernels have to order keys with the most significant bit set correctly
+TEST(BTree, lowerBound_key_types) {
+    checkLowerBound<uint32_t>([](std::mt19937_64& gen) { return static_cast<uint32_t>(gen()) | (gen() % 2 ? 0x80000000u : 0u); });
+    checkLowerBound<uint64_t>([](std::mt19937_64& gen) { return gen(); });
+}
+
+// suffixes of up to eight bytes are searched as integers, longer ones with memcmp()
+TEST(BTree, key_prefix_search) {
+    std::mt19937_64 gen(42);
+    BTreeKeyPrefix<4> prefix;
+    uint8_t lower[BTreeKeyPrefix<4>::key_length];
+    uint8_t upper[BTreeKeyPrefix<4>::key_length];
+    for (size_t length : { 0ul, 4ul, 8ul, 9ul, 12ul, 15ul }) {
+        memset(lower, 0, sizeof(lower));
+        memset(upper, 0, sizeof(upper));
+        if (length < sizeof(upper))
+            memset(upper + length, 0xff, sizeof(upper) - length);
+        prefix.set(lower, upper);
+        ASSERT_EQ(prefix.suffixLength(), BTreeKeyPrefix<4>::key_length - length);
+        const size_t suffix_length = prefix.suffixLength();
+        for (size_t count : { 0ul, 1ul, 15ul, 16ul, 17ul, 100ul }) {
+            std::vector<std::vector<uint8_t>> sorted;
+            while (sorted.size() < count) {
+                std::vector<uint8_t> suffix(suffix_length);
+                for (uint8_t& byte : suffix)
+                    byte = gen() % 2 ? 0xff : static_cast<uint8_t>(gen());
+                sorted.push_back(suffix);
+                std::sort(sorted.begin(), sorted.end());
+                sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+            }
+            std::vector<uint8_t> suffixes;
+            for (const auto& suffix : sorted)
+                suffixes.insert(suffixes.end(), suffix.begin(), suffix.end());
+            for (size_t i = 0; i < 50; i++) {
+                uint8_t key[BTreeKeyPrefix<4>::key_length] = {};
+                if (i < count)
+                    memcpy(key + length, sorted[i].data(), suffix_length);
+                else if (i % 2 == 0)
+                    memset(key + length, 0xff, suffix_length);
+                else
+                    for (size_t j = length; j < sizeof(key); j++)
+                        key[j] = static_cast<uint8_t>(gen());
+                const std::vector<uint8_t> key_suffix(key + length, key + sizeof(key));
+                EXPECT_EQ(prefix.search(suffixes.data(), count, key, false), std::lower_bound(sorted.begin(), sorted.end(), key_suffix) - sorted.begin());
+                EXPECT_EQ(prefix.search(suffixes.data(), count, key, true), std::upper_bound(sorted.begin(), sorted.end(), key_suffix) - sorted.begin());
+            }
+        }
+    }
+}
+
 class BTreeFixture : public DBTestFixture {
 protected:
     template <typename KeyType, typename ValueType>
@@ -319,6 +393,31 @@ TEST_F(BTreeFixture, insertNext) {
     }
 }
 
+TEST_F(BTreeFixture, insertNext_range) {
+    const size_t key_count = (PAGE_SIZE * 8 / (sizeof(Identifier) * 8 + 1)) * 5;
+    BTree<RowId, bool> tree(db->vmcache, context->getWorkerId());
+    ASSERT_EQ(tree.insertNext(false).key, 0);
+    size_t next_key = 1;
+    while (next_key < key_count) {
+        auto insert_guard = tree.insertNext(true, key_count - next_key);
+        ASSERT_EQ(insert_guard.key, next_key);
+        ASSERT_GE(insert_guard.count, 1);
+        ASSERT_LE(insert_guard.count, key_count - next_key);
+        // all keys of a range are inserted into the latched leaf
+        ASSERT_EQ(insert_guard->getKey(insert_guard->n_keys - 1), next_key + insert_guard.count - 1);
+        next_key += insert_guard.count;
+    }
+    ASSERT_EQ(tree.getCardinality(), key_count);
+    ASSERT_EQ(tree.keyRange().second, key_count);
+    size_t expected_key = 0;
+    for (auto entry : tree) {
+        ASSERT_EQ(entry.first, expected_key);
+        ASSERT_EQ(entry.second, expected_key != 0);
+        expected_key++;
+    }
+    ASSERT_EQ(tree.insertNext(true, 1).key, key_count);
+}
+
 TEST_F(BTreeFixture, latchForUpdate) {
     const size_t key_count = (PAGE_SIZE * 8 / (sizeof(Identifier) * 8 + 1)) * 2;
     BTree<RowId, bool> tree(db->vmcache, context->getWorkerId());
@@ -375,8 +474,13 @@ TEST_F(BTreeFixture, merge) {
         ASSERT_EQ(SharedGuard<InnerNode>(db->vmcache, getRootPid(tree), context->getWorkerId())->n_keys, 1);
     }
     // this remove() should cause a merge
+    const PageId right_pid = SharedGuard<InnerNode>(db->vmcache, getRootPid(tree), context->getWorkerId())->children[1];
+    const size_t free_pages_before_merge = db->vmcache.getNumFreePages();
     ASSERT_EQ(tree.remove(pre_merge_removals), true);
     ASSERT_EQ(SharedGuard<InnerNode>(db->vmcache, getRootPid(tree), context->getWorkerId())->n_keys, 0);
+    // the merged right node has been returned to the free page list
+    EXPECT_EQ(db->vmcache.getNumFreePages(), free_pages_before_merge + 1);
+    EXPECT_EQ(db->vmcache.getFreePageListHead(), right_pid);
 
     // make sure that we can still access all keys remaining in the tree after the merge
     ASSERT_EQ(tree.getCardinality(), InnerNode::capacity - pre_merge_removals);
@@ -387,6 +491,237 @@ TEST_F(BTreeFixture, merge) {
     }
 }
 
+TEST_F(BTreeFixture, iterator_release_merge) {
+    BTree<RowId, uint64_t> tree(db->vmcache, context->getWorkerId());
+    typedef BTree<RowId, uint64_t>::InnerNode InnerNode;
+    typedef BTree<RowId, uint64_t>::LeafNode LeafNode;
+    for (size_t i = 0; i < InnerNode::capacity + 1; i++)
+        ASSERT_EQ(tree.insertNext(i).key, i);
+    ASSERT_EQ(SharedGuard<InnerNode>(db->vmcache, getRootPid(tree), context->getWorkerId())->n_keys, 1);
+    const PageId right_pid = SharedGuard<InnerNode>(db->vmcache, getRootPid(tree), context->getWorkerId())->children[1];
+    const RowId first_right_key = SharedGuard<LeafNode>(db->vmcache, right_pid, context->getWorkerId())->getKey(0);
+
+    // release the iterator while it is positioned within the right leaf, as index scans do after each entry
+    auto it = tree.lookup(first_right_key);
+    ASSERT_EQ((*it).first, first_right_key);
+    ++it;
+    it.release();
+
+    // merge the right leaf into the left one and reuse its page for something that is not a node
+    size_t removed = 0;
+    while (db->vmcache.getNumFreePages() == 0) {
+        ASSERT_TRUE(tree.remove(removed));
+        removed++;
+    }
+    ASSERT_EQ(db->vmcache.getFreePageListHead(), right_pid);
+    ASSERT_TRUE(tree.remove(first_right_key + 1));
+    {
+        ExclusiveGuard<LeafNode> page(db->vmcache, db->vmcache.allocatePage(context->getWorkerId()), context->getWorkerId());
+        ASSERT_EQ(page.pid, right_pid);
+        memset(page.data, 0xff, PAGE_SIZE);
+    }
+
+    // the iterator continues at the first remaining key following its position
+    RowId expected_key = first_right_key + 2;
+    for (; it != tree.end(); ++it) {
+        ASSERT_EQ((*it).first, expected_key);
+        ASSERT_EQ((*it).second, expected_key);
+        expected_key++;
+    }
+    EXPECT_EQ(expected_key, InnerNode::capacity + 1);
+}
+
+// merged leaves are freed and immediately reused for other pages while a concurrent reader descends the tree
+TEST_F(BTreeFixture, concurrent_lookup_merge) {
+    typedef BTree<RowId, uint64_t>::LeafNode LeafNode;
+    const size_t key_count = LeafNode::capacity * 64;
+    const size_t keep_every = 8; // the remaining keys leave the leaves underfull, so that they are merged
+    BTree<RowId, uint64_t> tree(db->vmcache, context->getWorkerId());
+    for (size_t i = 0; i < key_count; i++)
+        tree.insert(i, i);
+
+    std::atomic<bool> done = false;
+    std::atomic<size_t> num_missing = 0;
+    std::thread reader([&]() {
+        // the reader only latches optimistically, so it does not interfere with the pages of the idle worker 0
+        BTree<RowId, uint64_t> reader_tree(db->vmcache, getRootPid(tree), 0);
+        while (!done) {
+            for (size_t i = 0; i < key_count; i += keep_every) {
+                if (reader_tree.lookupValue(i) != std::optional<uint64_t>(i))
+                    num_missing++;
+            }
+        }
+    });
+
+    size_t num_reused = 0;
+    for (size_t i = 0; i < key_count; i++) {
+        if (i % keep_every == 0)
+            continue;
+        ASSERT_TRUE(tree.remove(i));
+        while (db->vmcache.getNumFreePages() > 0) {
+            // reuse the freed page for something that is not a node
+            ExclusiveGuard<LeafNode> page(db->vmcache, db->vmcache.allocatePage(context->getWorkerId()), context->getWorkerId());
+            memset(page.data, 0xff, PAGE_SIZE);
+            num_reused++;
+        }
+    }
+    done = true;
+    reader.join();
+
+    EXPECT_GT(num_reused, 0);
+    EXPECT_EQ(num_missing, 0);
+    ASSERT_EQ(tree.getCardinality(), key_count / keep_every);
+    for (size_t i = 0; i < key_count; i += keep_every)
+        ASSERT_EQ(tree.lookupValue(i), std::optional<uint64_t>(i));
+}
+
+TEST_F(BTreeFixture, bulkLoad) {
+    const size_t key_count = NODE_SIZE / (sizeof(size_t) * 2) * 512;
+    const size_t num_runs = 7;
+    // interleaved runs, as produced by workers processing morsels of an unsorted input
+    std::vector<std::vector<std::pair<size_t, size_t>>> runs(num_runs);
+    for (size_t i = 0; i < key_count; i++)
+        runs[(i * 31) % num_runs].emplace_back(i, key_count - i);
+    TestBTree tree(db->vmcache, context->getWorkerId());
+    tree.bulkLoad(runs);
+
+    ASSERT_EQ(tree.getCardinality(), key_count);
+    size_t expected_key = 0;
+    for (auto entry : tree) {
+        ASSERT_EQ(entry.first, expected_key);
+        ASSERT_EQ(entry.second, key_count - expected_key);
+        expected_key++;
+    }
+    for (size_t i = 0; i < key_count; i++)
+        ASSERT_EQ(tree.lookupValue(i), key_count - i);
+
+    // the levels decrease monotonically from the root
+    PageId root_pid = tree.getRootPid();
+    TestBTree::InnerNode* root = reinterpret_cast<TestBTree::InnerNode*>(db->vmcache.fixShared(root_pid, context->getWorkerId()));
+    ASSERT_GT(root->level, 1);
+    for (size_t i = 0; i < root->n_keys + 1; i++)
+        checkLevel(root->children[i], root->level - 1, db, context);
+    db->vmcache.unfixShared(root_pid);
+
+    // the bulk loaded tree accepts further inserts
+    tree.insert(key_count, 0);
+    ASSERT_EQ(tree.lookupValue(key_count), 0);
+    EXPECT_ANY_THROW(tree.bulkLoad(runs));
+}
+
+TEST_F(BTreeFixture, bulkLoad_duplicate_keys) {
+    BTree<uint32_t, size_t> tree(db->vmcache, context->getWorkerId());
+    std::vector<std::vector<std::pair<uint32_t, size_t>>> runs = { { { 1, 1 }, { 3, 3 } }, { { 2, 2 }, { 3, 4 } } };
+    EXPECT_ANY_THROW(tree.bulkLoad(runs));
+}
+
+TEST_F(BTreeFixture, bulkLoad_bool_values) {
+    const size_t key_count = (PAGE_SIZE * 8 / (sizeof(Identifier) * 8 + 1)) * 3 + 5;
+    std::vector<std::vector<std::pair<RowId, bool>>> runs(1);
+    for (size_t i = 0; i < key_count; i++)
+        runs[0].emplace_back(i, static_cast<bool>(i % 7));
+    BTree<RowId, bool> tree(db->vmcache, context->getWorkerId());
+    tree.bulkLoad(runs);
+    for (size_t i = 0; i < key_count; i++) {
+        auto it = tree.lookupExact(i);
+        ASSERT_NE(it, tree.end());
+        ASSERT_EQ((*it).second, static_cast<bool>(i % 7));
+    }
+    ASSERT_EQ(tree.insertNext(true).key, key_count);
+}
+
+using CompositeBTree = BTree<CompositeKey<3>, size_t, 256>;
+
+// returns the largest capacity among the leaves of 'tree'
+size_t maxLeafCapacity(CompositeBTree& tree, const std::shared_ptr<DB>& db, const std::shared_ptr<ExecutionContext>& context) {
+    PageId pid = tree.getRootPid();
+    while (true) {
+        SharedGuard<CompositeBTree::InnerNode> inner(db->vmcache, pid, context->getWorkerId());
+        pid = inner->getChild(0);
+        if (inner->level == 1)
+            break;
+    }
+    size_t max_capacity = 0;
+    while (pid != INVALID_PAGE_ID) {
+        SharedGuard<CompositeBTree::LeafNode> leaf(db->vmcache, pid, context->getWorkerId());
+        EXPECT_LE(leaf->n_keys, leaf->getCapacity());
+        max_capacity = std::max(max_capacity, leaf->getCapacity());
+        pid = leaf->next;
+    }
+    return max_capacity;
+}
+
+TEST_F(BTreeFixture, composite_keys) {
+    std::vector<CompositeKey<3>> keys;
+    for (Identifier w = 0; w < 4; w++) {
+        for (Identifier d = 0; d < 10; d++) {
+            for (Identifier c = 0; c < 100; c++)
+                keys.push_back(CompositeKey<3> { w, d, c * 1000 });
+        }
+    }
+    keys.push_back(CompositeKey<3> { 0x80000000u, 0, 0 });
+    std::vector<CompositeKey<3>> shuffled = keys;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+    CompositeBTree tree(db->vmcache, context->getWorkerId());
+    for (size_t i = 0; i < shuffled.size(); i++)
+        tree.insert(shuffled[i], shuffled[i].keys[0] * 1000000 + shuffled[i].keys[1] * 1000 + shuffled[i].keys[2] / 1000);
+
+    // keys that share their warehouse and district ids are truncated
+    EXPECT_GT(maxLeafCapacity(tree, db, context), CompositeBTree::LeafNode::capacity);
+    ASSERT_EQ(tree.getCardinality(), keys.size());
+    size_t i = 0;
+    for (auto entry : tree) {
+        ASSERT_TRUE(entry.first == keys[i]);
+        i++;
+    }
+    for (auto& key : keys) {
+        ASSERT_EQ(tree.lookupValue(key), key.keys[0] * 1000000 + key.keys[1] * 1000 + key.keys[2] / 1000);
+        // keys between existing ones are not found, lookup() returns the next greater key
+        ASSERT_FALSE(tree.lookupValue(key + 1).has_value());
+    }
+    auto it = tree.lookup(CompositeKey<3> { 1, 5, 1 });
+    ASSERT_NE(it, tree.end());
+    EXPECT_TRUE((*it).first == (CompositeKey<3> { 1, 5, 1000 }));
+
+    // remove most keys of a district, which merges its leaves
+    for (Identifier c = 0; c < 90; c++)
+        ASSERT_TRUE(tree.remove(CompositeKey<3> { 2, 3, c * 1000 }));
+    ASSERT_EQ(tree.getCardinality(), keys.size() - 90);
+    for (auto& key : keys) {
+        if (key.keys[0] == 2 && key.keys[1] == 3 && key.keys[2] < 90000)
+            ASSERT_FALSE(tree.lookupValue(key).has_value());
+        else
+            ASSERT_TRUE(tree.lookupValue(key).has_value());
+    }
+}
+
+TEST_F(BTreeFixture, composite_keys_bulkLoad) {
+    std::vector<std::vector<std::pair<CompositeKey<3>, size_t>>> runs(3);
+    size_t key_count = 0;
+    for (Identifier w = 0; w < 3; w++) {
+        for (Identifier d = 0; d < 10; d++) {
+            for (Identifier c = 0; c < 100; c++)
+                runs[c % 3].emplace_back(CompositeKey<3> { w, d, c }, key_count++);
+        }
+    }
+    CompositeBTree tree(db->vmcache, context->getWorkerId());
+    tree.bulkLoad(runs);
+    EXPECT_GT(maxLeafCapacity(tree, db, context), CompositeBTree::LeafNode::capacity);
+    ASSERT_EQ(tree.getCardinality(), key_count);
+    size_t expected_value = 0;
+    for (auto entry : tree) {
+        ASSERT_EQ(entry.second, expected_value);
+        expected_value++;
+    }
+    for (auto& run : runs) {
+        for (auto& entry : run)
+            ASSERT_EQ(tree.lookupValue(entry.first), entry.second);
+    }
+    // bulk loaded leaves have room for inserts after truncation
+    tree.insert(CompositeKey<3> { 1, 1, 1000 }, key_count);
+    ASSERT_EQ(tree.lookupValue(CompositeKey<3> { 1, 1, 1000 }), key_count);
+}
+
 TEST(BTree, InnerNode_remove) {
     BTreeInnerNode<RowId, PAGE_SIZE> node;
     node.n_keys = 4;
@@ -0,0 +1,146 @@
+#include <vector>
+
+#include "test/shared/db_test.hpp"
+#include "prototype/core/db.hpp"
+#include "prototype/scheduling/execution_context.hpp"
+#include "prototype/storage/persistence/visibility_bitmap.hpp"
+
+class VisibilityBitmapFixture : public DBTestFixture { };
+
+TEST_F(VisibilityBitmapFixture, insertNext) {
+    const size_t num_rows = VisibilityBitmapPage::capacity * 2 + 100;
+    VisibilityBitmap visibility(db->vmcache, context->getWorkerId());
+    EXPECT_EQ(visibility.getNumRows(), 0);
+    EXPECT_FALSE(visibility.isVisible(0));
+    for (size_t i = 0; i < num_rows; i++)
+        ASSERT_EQ(visibility.insertNext(i % 7 != 0).rid, i);
+
+    EXPECT_EQ(visibility.getNumRows(), num_rows);
+    size_t expected_visible = 0;
+    for (size_t i = 0; i < num_rows; i++) {
+        ASSERT_EQ(visibility.isVisible(i), i % 7 != 0);
+        expected_visible += i % 7 != 0;
+    }
+    EXPECT_FALSE(visibility.isVisible(num_rows));
+    EXPECT_FALSE(visibility.isVisible(VisibilityBitmapPage::capacity * 5));
+    EXPECT_EQ(visibility.countVisible(), expected_visible);
+}
+
+TEST_F(VisibilityBitmapFixture, insertNext_range) {
+    const size_t num_rows = VisibilityBitmapPage::capacity * 3;
+    VisibilityBitmap visibility(db->vmcache, context->getWorkerId());
+    ASSERT_EQ(visibility.insertNext(false, 10).count, 10);
+    size_t next_rid = 10;
+    while (next_rid < num_rows) {
+        auto insert_guard = visibility.insertNext(true, num_rows - next_rid);
+        ASSERT_EQ(insert_guard.rid, next_rid);
+        // a range never spans bitmap pages
+        ASSERT_EQ(insert_guard.count, std::min(num_rows - next_rid, VisibilityBitmapPage::capacity - next_rid % VisibilityBitmapPage::capacity));
+        next_rid += insert_guard.count;
+    }
+    EXPECT_EQ(visibility.getNumRows(), num_rows);
+    EXPECT_EQ(visibility.countVisible(), num_rows - 10);
+    EXPECT_FALSE(visibility.isVisible(9));
+    EXPECT_TRUE(visibility.isVisible(10));
+    EXPECT_EQ(visibility.insertNext(true).rid, num_rows);
+}
+
+TEST_F(VisibilityBitmapFixture, forEachVisible) {
+    const size_t num_rows = VisibilityBitmapPage::capacity + 1000;
+    VisibilityBitmap visibility(db->vmcache, context->getWorkerId());
+    for (size_t i = 0; i < num_rows; i++)
+        visibility.insertNext(i % 3 == 0);
+
+    for (auto [from, to] : std::vector<std::pair<size_t, size_t>> { { 0, num_rows }, { 5, 70 }, { 63, 65 }, { 64, 128 }, { 100, VisibilityBitmapPage::capacity + 200 }, { num_rows - 10, num_rows + 1000 }, { 20, 20 } }) {
+        std::vector<RowId> rids;
+        visibility.forEachVisible(from, to, [&](RowId rid) { rids.push_back(rid); return true; });
+        std::vector<RowId> expected_rids;
+        for (size_t i = from; i < std::min(to, num_rows); i++) {
+            if (i % 3 == 0)
+                expected_rids.push_back(i);
+        }
+        ASSERT_EQ(rids, expected_rids) << "[" << from << ", " << to << ")";
+    }
+
+    // stops as soon as the callback returns false
+    size_t num_calls = 0;
+    visibility.forEachVisible(0, num_rows, [&](RowId rid) { num_calls++; return rid < 300; });
+    EXPECT_EQ(num_calls, 101);
+
+    // the callback runs without the bitmap page latched, so it may update the rows it visits; 'page_end()' follows the rows of each bitmap page
+    size_t num_page_ends = 0;
+    visibility.forEachVisible(0, num_rows, [&](RowId rid) {
+        visibility.latchForUpdate(rid)->update(false);
+        return true;
+    }, [&] { num_page_ends++; });
+    EXPECT_EQ(num_page_ends, 2);
+    EXPECT_EQ(visibility.countVisible(), 0);
+}
+
+TEST_F(VisibilityBitmapFixture, reserveBlock) {
+    VisibilityBitmap visibility(db->vmcache, context->getWorkerId());
+    typedef std::pair<RowId, RowId> RowRange;
+    const RowId block = VisibilityBitmap::reserved_block_size;
+    // reserved blocks and bulk inserts are appended to the last page
+    EXPECT_EQ(visibility.reserveBlock(), RowRange(0, block));
+    EXPECT_EQ(visibility.getNumRows(), block);
+    EXPECT_EQ(visibility.countVisible(), 0);
+    EXPECT_EQ(visibility.insertNext(true, 10).rid, block);
+    EXPECT_EQ(visibility.reserveBlock(), RowRange(block + 10, 2 * block + 10));
+    EXPECT_EQ(visibility.insertNext(true).rid, 2 * block + 10);
+
+    // reserved rows are invisible until they are inserted, in any order
+    visibility.insertReserved(block + 15, true);
+    visibility.insertReserved(70, true);
+    visibility.insertReserved(3, false);
+    EXPECT_TRUE(visibility.isVisible(70));
+    EXPECT_FALSE(visibility.isVisible(3));
+    EXPECT_FALSE(visibility.isVisible(block + 14));
+
+    std::vector<RowId> rids;
+    visibility.forEachVisible(0, visibility.getNumRows(), [&](RowId rid) { rids.push_back(rid); return true; });
+    std::vector<RowId> expected_rids { 70 };
+    for (size_t i = 0; i < 10; i++)
+        expected_rids.push_back(block + i);
+    expected_rids.push_back(block + 15);
+    expected_rids.push_back(2 * block + 10);
+    EXPECT_EQ(rids, expected_rids);
+    EXPECT_EQ(visibility.countVisible(), expected_rids.size());
+
+    // the last block of a page ends with the page, the next block starts a new page
+    RowRange reserved;
+    do {
+        reserved = visibility.reserveBlock();
+        ASSERT_LE(reserved.second - reserved.first, block);
+    } while (reserved.second < VisibilityBitmapPage::capacity);
+    EXPECT_EQ(reserved.second, VisibilityBitmapPage::capacity);
+    EXPECT_EQ(visibility.reserveBlock(), RowRange(VisibilityBitmapPage::capacity, VisibilityBitmapPage::capacity + block));
+
+    // blocks are linked into a new directory page once the first one is full
+    const RowId directory_rows = VisibilityDirectoryPage::capacity * VisibilityBitmapPage::capacity;
+    while (visibility.reserveBlock().second < directory_rows) { }
+    EXPECT_EQ(visibility.reserveBlock().first, directory_rows);
+    visibility.insertReserved(directory_rows + 1, true);
+    EXPECT_TRUE(visibility.isVisible(directory_rows + 1));
+    EXPECT_EQ(visibility.getNumRows(), directory_rows + block);
+    EXPECT_EQ(visibility.countVisible(), expected_rids.size() + 1);
+}
+
+TEST_F(VisibilityBitmapFixture, latchForUpdate) {
+    const size_t num_rows = VisibilityBitmapPage::capacity + 10;
+    VisibilityBitmap visibility(db->vmcache, context->getWorkerId());
+    for (size_t i = 0; i < num_rows; i++)
+        visibility.insertNext(true);
+
+    for (size_t i = 0; i < num_rows; i += 2) {
+        auto update_guard = visibility.latchForUpdate(i);
+        ASSERT_TRUE(update_guard.has_value());
+        EXPECT_TRUE(update_guard->prev_value);
+        update_guard->update(false);
+    }
+    for (size_t i = 0; i < num_rows; i++)
+        ASSERT_EQ(visibility.isVisible(i), i % 2 == 1);
+    EXPECT_TRUE(visibility.latchForUpdate(1)->prev_value);
+    EXPECT_FALSE(visibility.latchForUpdate(num_rows).has_value());
+    EXPECT_EQ(visibility.countVisible(), num_rows / 2);
+}
\ No newline at end of file
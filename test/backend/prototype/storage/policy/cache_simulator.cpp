@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "prototype/storage/policy/cache_simulator.hpp"
+
+static std::vector<CacheTraceEntry> createCyclicTrace(size_t num_pages, size_t num_rounds) {
+    std::vector<CacheTraceEntry> trace;
+    double timestamp = 0.0;
+    for (size_t round = 0; round < num_rounds; round++) {
+        for (PageId pid = 0; pid < num_pages; pid++) {
+            // every fourth page is modified, decisions of the traced policy are ignored by the replay
+            trace.emplace_back(timestamp++, pid % 4 == 0 ? CacheAction::Write : CacheAction::Ref, pid);
+            trace.emplace_back(timestamp++, CacheAction::Evict, pid);
+        }
+    }
+    return trace;
+}
+
+TEST(CacheSimulator, read_traces) {
+    const std::string path = "cache_simulator_test.trc";
+    std::vector<CacheTraceEntry> entries { { 2.0, CacheAction::Ref, 3 }, { 1.0, CacheAction::Fault, 2 }, { 3.0, CacheAction::Write, 1 } };
+    const int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+    ASSERT_NE(fd, -1);
+    ASSERT_EQ(write(fd, entries.data(), entries.size() * sizeof(CacheTraceEntry)), static_cast<ssize_t>(entries.size() * sizeof(CacheTraceEntry)));
+    close(fd);
+
+    const std::vector<CacheTraceEntry> trace = readCacheTraces({ path });
+    unlink(path.c_str());
+    ASSERT_EQ(trace.size(), 3);
+    EXPECT_EQ(trace[0].getPid(), 2);
+    EXPECT_EQ(trace[0].getAction(), CacheAction::Fault);
+    EXPECT_EQ(trace[1].getPid(), 3);
+    EXPECT_EQ(trace[2].getAction(), CacheAction::Write);
+    EXPECT_EQ(getCacheTraceFootprint(trace), 2);
+}
+
+TEST(CacheSimulator, replay) {
+    const std::vector<CacheTraceEntry> trace = createCyclicTrace(256, 4);
+    EXPECT_EQ(getCacheTraceFootprint(trace), 256);
+    for (const std::string policy : { "clock", "random", "mru", "2q", "state_clock" }) {
+        // the whole footprint fits into memory: only compulsory faults
+        const CacheSimulationResult fits = simulateCache(trace, policy, 256, "cache_simulator_test.db", 100, 1000);
+        EXPECT_EQ(fits.num_frames, 256);
+        EXPECT_EQ(fits.num_accesses, 1024);
+        EXPECT_EQ(fits.num_faults, 256);
+        EXPECT_EQ(fits.num_dirty_writes, 0);
+        EXPECT_EQ(fits.simulated_io_ns, 256 * 100);
+        EXPECT_DOUBLE_EQ(fits.getHitRatio(), 0.75);
+
+        const CacheSimulationResult small = simulateCache(trace, policy, 128, "cache_simulator_test.db", 100, 1000);
+        EXPECT_GT(small.num_faults, 256);
+        EXPECT_GT(small.num_dirty_writes, 0);
+        EXPECT_EQ(small.simulated_io_ns, small.num_faults * 100 + small.num_dirty_writes * 1000);
+    }
+}
+
+TEST(CacheSimulator, replay_temporary_allocations) {
+    std::vector<CacheTraceEntry> trace = createCyclicTrace(256, 4);
+    // a quarter of the frames is taken by temporary pages for the whole run, except for a short-lived allocation that is dropped right away
+    trace.insert(trace.begin(), { { -3.0, CacheAction::TempAllocate, 64 }, { -2.0, CacheAction::TempAllocate, 16 }, { -1.0, CacheAction::TempDrop, 16 } });
+    EXPECT_EQ(getCacheTraceFootprint(trace), 256);
+    const CacheSimulationResult result = simulateCache(trace, "clock", 256, "cache_simulator_test.db", 100, 1000);
+    EXPECT_EQ(result.num_accesses, 1024);
+    EXPECT_GT(result.num_faults, 256);
+}
\ No newline at end of file
@@ -2,11 +2,16 @@
 
 #include <fcntl.h>
 #include <sys/file.h>
+#include <sys/wait.h>
+#include <thread>
 
 #include "prototype/storage/policy/basic_partitioning_strategy.hpp"
 #include "prototype/storage/policy/cache_partition.hpp"
+#include "prototype/storage/policy/data_temp_partitioning_strategy.hpp"
+#include "prototype/storage/policy/numa_partitioning_strategy.hpp"
 #include "prototype/storage/guard.hpp"
 #include "prototype/storage/vmcache.hpp"
+#include "prototype/storage/wal.hpp"
 
 #define MAX_PHYSICAL_PAGES 4
 
@@ -16,6 +21,14 @@ public:
     std::string lock_path;
     std::shared_ptr<VMCache> cache;
 
+    VMCacheConfig makeConfig(uint64_t max_size, uint64_t virtual_pages) const {
+        VMCacheConfig config;
+        config.max_size = max_size;
+        config.virtual_pages = virtual_pages;
+        config.path = path;
+        return config;
+    }
+
 protected:
     void SetUp() override {
         path = "vmcache_test.db";
@@ -32,13 +45,14 @@ protected:
                 throw std::runtime_error("Failed to delete existing vmcache test database");
         }
         // this configuration results in a limit of MAX_PHYSICAL_PAGES physical pages
-        cache = std::make_shared<VMCache>((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128, path, false, false, false, false, createPartitioningStrategy<BasicPartitioningStrategy>("clock"), false, false, 1);
+        cache = std::make_shared<VMCache>(makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128), createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
     }
 
     void TearDown() override {
         cache = nullptr;
 
         unlink(path.c_str());
+        unlink((path + ".extents").c_str());
         unlink(lock_path.c_str());
         flock(lock_fd, LOCK_UN);
         close(lock_fd);
@@ -55,7 +69,7 @@ TEST_F(VMCacheFixture, setup) {
 
 #define TEST_MAGIC 0xDEADBEEFDEADBEEFull
 TEST_F(VMCacheFixture, persist) {
-    PageId pid = cache->allocatePage();
+    PageId pid = cache->allocatePage(0);
     uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
     for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
         page[i] = TEST_MAGIC;
@@ -66,7 +80,7 @@ TEST_F(VMCacheFixture, persist) {
     // evict the page by filling up the cache with other pages
     std::vector<PageId> pids;
     for (size_t i = 0; i < MAX_PHYSICAL_PAGES; i++) {
-        pids.push_back(cache->allocatePage());
+        pids.push_back(cache->allocatePage(0));
         cache->fixShared(pids[i], 0);
     }
     EXPECT_EQ(cache->getTotalAccessedPageCount(), MAX_PHYSICAL_PAGES + 1);
@@ -88,8 +102,85 @@ TEST_F(VMCacheFixture, persist) {
     cache->unfixShared(pid);
 }
 
+TEST_F(VMCacheFixture, free_page_reuse) {
+    PageId pid = cache->allocatePage(0);
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
+        page[i] = TEST_MAGIC;
+    cache->freePage(pid, 0);
+    EXPECT_EQ(cache->getNumFreePages(), 1);
+    EXPECT_EQ(cache->getFreePageListHead(), pid);
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_UNLOCKED);
+
+    // the freed page is handed out again, zeroed
+    const size_t num_allocated_pages = cache->getNumAllocatedPages();
+    ASSERT_EQ(cache->allocatePage(0), pid);
+    EXPECT_EQ(cache->getNumAllocatedPages(), num_allocated_pages);
+    EXPECT_EQ(cache->getNumFreePages(), 0);
+    EXPECT_EQ(cache->getFreePageListHead(), INVALID_PAGE_ID);
+    page = reinterpret_cast<uint64_t*>(cache->fixShared(pid, 0));
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
+        ASSERT_EQ(page[i], 0);
+    cache->unfixShared(pid);
+
+    // afterwards, new pages are allocated again
+    EXPECT_EQ(cache->allocatePage(0), num_allocated_pages);
+}
+
+TEST_F(VMCacheFixture, free_page_list_order) {
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < 3; i++)
+        pids.push_back(cache->allocatePage(0));
+    for (PageId pid : pids) {
+        cache->fixExclusive(pid, 0);
+        cache->freePage(pid, 0);
+    }
+    // free pages are linked through the pages themselves, the list also survives eviction of the free pages
+    cache->evictAll(false, 0);
+    EXPECT_EQ(cache->getNumFreePages(), 3);
+    EXPECT_EQ(cache->allocatePage(0), pids[2]);
+    EXPECT_EQ(cache->allocatePage(0), pids[1]);
+    EXPECT_EQ(cache->allocatePage(0), pids[0]);
+    EXPECT_EQ(cache->getNumFreePages(), 0);
+}
+
+TEST_F(VMCacheFixture, free_page_list_anchor) {
+    const PageId anchor_pid = cache->allocatePage(0);
+    *reinterpret_cast<FreePageListAnchor*>(cache->fixExclusive(anchor_pid, 0) + sizeof(uint64_t)) = { INVALID_PAGE_ID, 0 };
+    cache->unfixExclusive(anchor_pid);
+    cache->openFreePageList(anchor_pid, sizeof(uint64_t), 0);
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < 3; i++)
+        pids.push_back(cache->allocatePage(0));
+    for (PageId pid : pids) {
+        cache->fixExclusive(pid, 0);
+        cache->freePage(pid, 0);
+    }
+    auto readAnchor = [&]() {
+        const FreePageListAnchor anchor = *reinterpret_cast<const FreePageListAnchor*>(cache->fixShared(anchor_pid, 0) + sizeof(uint64_t));
+        cache->unfixShared(anchor_pid);
+        return anchor;
+    };
+    // allocating and freeing pages does not latch the anchor, it is written lazily
+    const uint64_t anchor_version = cache->getPageState(anchor_pid).load() >> PAGE_VERSION_OFFSET;
+    EXPECT_EQ(cache->allocatePage(0), pids[2]);
+    EXPECT_EQ(cache->getPageState(anchor_pid).load() >> PAGE_VERSION_OFFSET, anchor_version);
+    EXPECT_EQ(readAnchor().head, INVALID_PAGE_ID);
+
+    // the anchor is written on shutdown, the list is restored from it after a restart
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128), createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    EXPECT_EQ(readAnchor().head, pids[1]);
+    EXPECT_EQ(readAnchor().num_pages, 2ul);
+    cache->openFreePageList(anchor_pid, sizeof(uint64_t), 0);
+    EXPECT_EQ(cache->getNumFreePages(), 2ul);
+    EXPECT_EQ(cache->allocatePage(0), pids[1]);
+    EXPECT_EQ(cache->allocatePage(0), pids[0]);
+    EXPECT_EQ(cache->getNumFreePages(), 0ul);
+}
+
 TEST_F(VMCacheFixture, sandbox) {
-    PageId pid = cache->allocatePage();
+    PageId pid = cache->allocatePage(0);
     uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
     for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
         page[i] = TEST_MAGIC;
@@ -97,7 +188,9 @@ TEST_F(VMCacheFixture, sandbox) {
 
     // re-initialize VMCache, this time in sandbox mode
     cache = nullptr;
-    cache = std::make_shared<VMCache>((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128, path, true, false, false, false, createPartitioningStrategy<BasicPartitioningStrategy>("clock"), false, false, 1);
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.sandbox = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
     page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
     // make sure that the page was persisted when we were not in sandbox mode
     for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
@@ -109,7 +202,7 @@ TEST_F(VMCacheFixture, sandbox) {
 
     // re-initialize VMCache again, the change made previously (zeroing out the page) should not have been persisted
     cache = nullptr;
-    cache = std::make_shared<VMCache>((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128, path, false, false, false, false, createPartitioningStrategy<BasicPartitioningStrategy>("clock"), false, false, 1);
+    cache = std::make_shared<VMCache>(makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128), createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
     page = reinterpret_cast<uint64_t*>(cache->fixShared(pid, 0));
     for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
         ASSERT_EQ(page[i], TEST_MAGIC);
@@ -121,7 +214,7 @@ struct DummyPage {
 };
 
 TEST_F(VMCacheFixture, OptimisticGuard) {
-    PageId pid = cache->allocatePage();
+    PageId pid = cache->allocatePage(0);
     {
         // page should be faulted
         OptimisticGuard<DummyPage> guard(*cache, pid, 0);
@@ -155,4 +248,995 @@ TEST_F(VMCacheFixture, OptimisticGuard) {
         cache->unfixExclusive(pid);
         ASSERT_THROW(guard.checkVersionAndRestart(), OLRestartException);
     }
+}
+
+TEST_F(VMCacheFixture, io_uring) {
+    PageId pid = cache->allocatePage(0);
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
+        page[i] = TEST_MAGIC;
+    cache->unfixExclusive(pid);
+
+    // re-initialize VMCache with io_uring enabled, the page now has to be read from the database file
+    cache = nullptr;
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.use_io_uring = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    ASSERT_TRUE(cache->isUsingIOUring());
+    page = reinterpret_cast<uint64_t*>(cache->fixShared(pid, 0));
+    EXPECT_EQ(cache->getTotalFaultedPageCount(), 1);
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++)
+        ASSERT_EQ(page[i], TEST_MAGIC);
+    cache->unfixShared(pid);
+}
+
+TEST_F(VMCacheFixture, prefetch) {
+    // write distinct values to a number of pages and persist them
+    const size_t num_pages = MAX_PHYSICAL_PAGES - 1;
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < num_pages; i++) {
+        pids.push_back(cache->allocatePage(0));
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pids[i], 0));
+        for (size_t j = 0; j < PAGE_SIZE / sizeof(uint64_t); j++)
+            page[j] = TEST_MAGIC + i;
+        cache->unfixExclusive(pids[i]);
+    }
+
+    for (bool use_io_uring : { false, true }) {
+        cache = nullptr;
+        VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+        config.use_io_uring = use_io_uring;
+        cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+        cache->prefetch(pids.data(), pids.size(), true, 0);
+        // with io_uring, the reads of the last batch are still in flight after 'prefetch()' returns
+        cache->completePrefetches(0);
+        // adjacent pages are read together, but each page is counted separately
+        EXPECT_EQ(cache->getTotalFaultedPageCount(), num_pages);
+        for (size_t i = 0; i < num_pages; i++) {
+            ASSERT_EQ(PAGE_STATE(cache->getPageState(pids[i]).load()), PAGE_STATE_UNLOCKED);
+            uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(pids[i], 0));
+            for (size_t j = 0; j < PAGE_SIZE / sizeof(uint64_t); j++)
+                ASSERT_EQ(page[j], TEST_MAGIC + i);
+            cache->unfixShared(pids[i]);
+        }
+        // prefetching resident pages does not fault them again
+        cache->prefetch(pids.data(), pids.size(), true, 0);
+        EXPECT_EQ(cache->getTotalFaultedPageCount(), num_pages);
+    }
+}
+
+TEST_F(VMCacheFixture, prefetch_in_flight) {
+    const size_t num_pages = MAX_PHYSICAL_PAGES - 1;
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < num_pages; i++) {
+        pids.push_back(cache->allocatePage(0));
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pids[i], 0));
+        page[0] = TEST_MAGIC + i;
+        cache->unfixExclusive(pids[i]);
+    }
+
+    cache = nullptr;
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.use_io_uring = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    cache->prefetch(pids.data(), pids.size(), true, 0);
+    // fixing a page whose read is still in flight reaps the prefetch reads while waiting for the latch
+    for (size_t i = 0; i < num_pages; i++) {
+        const uint64_t* page = reinterpret_cast<const uint64_t*>(cache->fixShared(pids[i], 0));
+        EXPECT_EQ(page[0], TEST_MAGIC + i);
+        cache->unfixShared(pids[i]);
+    }
+    EXPECT_EQ(cache->getTotalFaultedPageCount(), num_pages);
+}
+
+TEST_F(VMCacheFixture, read_failure) {
+    PageId pid = cache->allocatePage(0);
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
+    page[0] = TEST_MAGIC;
+    cache->unfixExclusive(pid);
+
+    for (bool use_io_uring : { false, true }) {
+        cache = nullptr;
+        VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+        config.use_io_uring = use_io_uring;
+        cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+        // the file is truncated behind the cache's back, so reading the page returns fewer bytes than expected
+        ASSERT_EQ(truncate(path.c_str(), 0), 0);
+        EXPECT_THROW(cache->fixShared(pid, 0), std::runtime_error);
+        EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+        EXPECT_EQ(cache->getPartitions().getCurrentPhysicalDataPageCount(), 0);
+        // prefetching is only a hint, failed reads leave the page evicted
+        cache->prefetch(&pid, 1, true, 0);
+        cache->completePrefetches(0);
+        EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+        EXPECT_EQ(cache->getTotalFaultedPageCount(), 0);
+        // restore the file for the next iteration
+        cache = nullptr;
+        ASSERT_EQ(truncate(path.c_str(), (pid + 1) * PAGE_SIZE), 0);
+    }
+}
+
+TEST_F(VMCacheFixture, temporary_page_pool) {
+    char* page = cache->allocateTemporaryPage(0);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(page) % 64, 0u);
+    cache->dropTemporaryPage(page, 0);
+    // the page is kept in the worker's pool and stays accounted as a physical temporary page
+    EXPECT_EQ(cache->getNumTemporaryPagesInUse(), 0);
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 1);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 1);
+
+    // allocations of the same size are served from the pool
+    EXPECT_EQ(cache->allocateTemporaryPage(0), page);
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 0);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 1);
+    char* huge_page = cache->allocateTemporaryHugePage(2, 0);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 3);
+    cache->dropTemporaryHugePage(huge_page, 2, 0);
+    cache->dropTemporaryPage(page, 0);
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 3);
+
+    cache->releaseTemporaryPagePool(0);
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 0);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 0);
+}
+
+TEST_F(VMCacheFixture, temporary_page_pool_owner) {
+    cache = nullptr;
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.num_workers = 2;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    // a page dropped by another worker is returned to the pool of the worker that allocated it
+    char* page = cache->allocateTemporaryPage(0);
+    cache->dropTemporaryPage(page, 1);
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 1);
+    char* other_page = cache->allocateTemporaryPage(1);
+    EXPECT_NE(other_page, page);
+    EXPECT_EQ(cache->allocateTemporaryPage(0), page);
+    cache->dropTemporaryPage(page, 0);
+
+    // pooled pages are given up before data pages are evicted
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 1);
+    std::vector<PageId> pids;
+    for (size_t i = 0; i + 1 < MAX_PHYSICAL_PAGES; i++) {
+        pids.push_back(cache->allocatePage(0));
+        cache->fixShared(pids.back(), 0);
+        cache->unfixShared(pids.back());
+    }
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 0);
+    EXPECT_EQ(cache->getTotalEvictedPageCount(), 0);
+    cache->dropTemporaryPage(other_page, 1);
+}
+
+TEST_F(VMCacheFixture, numa_partitions) {
+    auto strategy = std::make_unique<NUMAPartitioningStrategy<ClockEvictionCachePartition>>(2);
+    NUMAPartitioningStrategy<ClockEvictionCachePartition>* numa_strategy = strategy.get();
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig((2 * MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128), std::move(strategy));
+    const size_t node = numa_strategy->getNode(0);
+    ASSERT_LT(node, 2);
+
+    // all pages faulted by this worker are placed in its node's partition, which only manages half of the buffer pool
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < cache->getMaxPhysicalPages(); i++) {
+        pids.push_back(cache->allocatePage(0));
+        cache->fixExclusive(pids.back(), 0);
+        cache->unfixExclusive(pids.back());
+    }
+    EXPECT_GT(cache->getTotalEvictedPageCount(), 0);
+    size_t resident_pages = 0;
+    for (PageId pid : pids) {
+        if (PAGE_STATE(cache->getPageState(pid).load()) != PAGE_STATE_EVICTED) {
+            EXPECT_EQ(numa_strategy->getOwningNode(pid), node);
+            resident_pages++;
+        } else {
+            EXPECT_EQ(numa_strategy->getOwningNode(pid), numa_strategy->getNumNodes());
+        }
+    }
+    EXPECT_LE(resident_pages, (cache->getMaxPhysicalPages() + 1) / 2);
+
+    // temporary pages are accounted to the worker's node as well
+    char* page = cache->allocateTemporaryPage(0);
+    cache->dropTemporaryPage(page, 0);
+    cache->releaseTemporaryPagePool(0);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 0);
+}
+
+TEST_F(VMCacheFixture, numa_partitions_optimistic_fault) {
+    auto strategy = std::make_unique<NUMAPartitioningStrategy<ClockEvictionCachePartition>>(2);
+    NUMAPartitioningStrategy<ClockEvictionCachePartition>* numa_strategy = strategy.get();
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig((2 * MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128), std::move(strategy));
+    numa_strategy->setNode(0, 1);
+
+    // pages faulted by optimistic latches keep the node recorded by the partitioning strategy
+    const PageId pid = cache->allocatePage(0);
+    ASSERT_EQ(numa_strategy->getOwningNode(pid), numa_strategy->getNumNodes());
+    {
+        OptimisticGuard<uint64_t> guard(*cache, pid, 0);
+    }
+    EXPECT_EQ(numa_strategy->getOwningNode(pid), 1);
+
+    // the page is evicted from the partition of the faulting worker's node
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < cache->getMaxPhysicalPages(); i++) {
+        pids.push_back(cache->allocatePage(0));
+        cache->fixShared(pids.back(), 0);
+        cache->unfixShared(pids.back());
+    }
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+}
+
+TEST_F(VMCacheFixture, huge_page_backed_temporary_allocation) {
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(64ull * 1024ull * 1024ull, 128), createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    const size_t num_pages = LARGE_ALLOCATION_THRESHOLD + 1;
+    const size_t pages_per_huge_page = HUGE_PAGE_SIZE / PAGE_SIZE;
+    char* page = cache->allocateTemporaryHugePage(num_pages, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(page) % HUGE_PAGE_SIZE, 0);
+    EXPECT_EQ(TempPagePool::getOwner(page), 0u);
+    // the allocation is accounted at huge page granularity
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), (num_pages + pages_per_huge_page - 1) / pages_per_huge_page * pages_per_huge_page);
+    EXPECT_EQ(cache->getNumTemporaryPagesInUse(), num_pages);
+    memset(page, 0xab, num_pages * PAGE_SIZE);
+    cache->dropTemporaryHugePage(page, num_pages, 0);
+    EXPECT_EQ(cache->getNumTemporaryPagesInUse(), 0);
+
+    // the region is kept for the next allocation of the same size, which may come from another worker
+    const size_t huge_page_backed_pages = cache->getPartitions().getCurrentPhysicalTempPageCount();
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), huge_page_backed_pages);
+    EXPECT_EQ(cache->allocateTemporaryHugePage(num_pages, 0), page);
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 0);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), huge_page_backed_pages);
+    cache->dropTemporaryHugePage(page, num_pages, 0);
+
+    cache->releaseTemporaryPagePools();
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 0);
+    EXPECT_EQ(cache->getNumPooledTemporaryPages(), 0);
+}
+
+TEST_F(VMCacheFixture, batched_write_back) {
+    for (bool use_io_uring : { false, true }) {
+        cache = nullptr;
+        unlink(path.c_str());
+        VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+        config.use_io_uring = use_io_uring;
+        cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+        // dirtying more pages than fit into the cache writes them back in batches on eviction
+        const size_t num_pages = 4 * MAX_PHYSICAL_PAGES;
+        for (size_t i = 0; i < num_pages; i++) {
+            PageId pid = cache->allocatePage(0);
+            ASSERT_EQ(pid, i);
+            uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
+            for (size_t j = 0; j < PAGE_SIZE / sizeof(uint64_t); j++)
+                page[j] = TEST_MAGIC + i;
+            cache->unfixExclusive(pid);
+        }
+        EXPECT_GT(cache->getTotalDirtyWritePageCount(), 0);
+        EXPECT_LE(cache->getDirtyPageCount(), MAX_PHYSICAL_PAGES);
+        for (PageId pid = 0; pid < num_pages; pid++) {
+            uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(pid, 0));
+            for (size_t j = 0; j < PAGE_SIZE / sizeof(uint64_t); j++)
+                ASSERT_EQ(page[j], TEST_MAGIC + pid);
+            cache->unfixShared(pid);
+        }
+    }
+}
+
+TEST_F(VMCacheFixture, spillable_page) {
+    PageId spill_pid = cache->allocateSpillablePage(0);
+    EXPECT_TRUE(cache->isSpillablePage(spill_pid));
+    EXPECT_EQ(cache->getNumSpillablePagesInUse(), 1);
+    EXPECT_EQ(cache->getNumTemporaryPagesInUse(), 1);
+    // resident spillable pages are accounted as temporary pages
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 1);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalDataPageCount(), 0);
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->toPointer(spill_pid));
+    for (size_t j = 0; j < PAGE_SIZE / sizeof(uint64_t); j++) {
+        ASSERT_EQ(page[j], 0);
+        page[j] = TEST_MAGIC + j;
+    }
+    cache->unfixExclusive(spill_pid);
+
+    // accessing more data pages than fit into the cache spills the unlatched page
+    for (size_t i = 0; i < 2 * MAX_PHYSICAL_PAGES; i++) {
+        PageId pid = cache->allocatePage(0);
+        cache->fixExclusive(pid, 0);
+        cache->unfixExclusive(pid);
+    }
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(spill_pid).load()), PAGE_STATE_EVICTED);
+    EXPECT_TRUE(PAGE_MODIFIED(cache->getPageState(spill_pid).load()));
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalTempPageCount(), 0);
+
+    // the spilled contents are faulted back in
+    page = reinterpret_cast<uint64_t*>(cache->fixExclusive(spill_pid, 0));
+    for (size_t j = 0; j < PAGE_SIZE / sizeof(uint64_t); j++)
+        ASSERT_EQ(page[j], TEST_MAGIC + j);
+    // pages that were only read do not have to be written back again
+    cache->unfixExclusiveUnmodified(spill_pid);
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(spill_pid).load()), PAGE_STATE_UNLOCKED);
+    EXPECT_EQ(cache->getPageState(spill_pid).load() & PAGE_DIRTY_BIT, 0);
+
+    cache->dropSpillablePage(spill_pid, 0);
+    EXPECT_EQ(cache->getNumSpillablePagesInUse(), 0);
+    EXPECT_EQ(cache->getNumTemporaryPagesInUse(), 0);
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(spill_pid).load()), PAGE_STATE_EVICTED);
+
+    // dropped pages are reused and do not expose their spilled contents
+    EXPECT_EQ(cache->allocateSpillablePage(0), spill_pid);
+    page = reinterpret_cast<uint64_t*>(cache->toPointer(spill_pid));
+    for (size_t j = 0; j < PAGE_SIZE / sizeof(uint64_t); j++)
+        ASSERT_EQ(page[j], 0);
+    cache->unfixExclusive(spill_pid);
+    cache->dropSpillablePage(spill_pid, 0);
+}
+
+TEST_F(VMCacheFixture, wal_recovery) {
+    cache = nullptr;
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+        config.use_wal = true;
+        VMCache* crashing_cache = new VMCache(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+        crashing_cache->beginTransaction(0);
+        PageId pid = crashing_cache->allocatePage(0);
+        uint64_t* page = reinterpret_cast<uint64_t*>(crashing_cache->fixExclusive(pid, 0));
+        page[0] = TEST_MAGIC;
+        crashing_cache->unfixExclusive(pid, 0);
+        crashing_cache->commitTransaction(0);
+        // crash without writing back any dirty pages
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    // the committed page is restored from the log
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.use_wal = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    ASSERT_FALSE(cache->isEmpty());
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(0, 0));
+    EXPECT_EQ(page[0], TEST_MAGIC);
+    cache->unfixShared(0);
+    cache = nullptr;
+    unlink((path + ".wal").c_str());
+}
+
+TEST(WriteAheadLog, failed_flush) {
+    // writes to /dev/full fail with ENOSPC
+    WriteAheadLog wal("/dev/full");
+    alignas(PAGE_SIZE) char page[PAGE_SIZE] = {};
+    const uint64_t lsn = wal.append(0, 0, page);
+    EXPECT_THROW(wal.flush(lsn), std::runtime_error);
+    // the failed flush neither blocks later committers nor reports the lost records as durable
+    EXPECT_THROW(wal.flush(lsn), std::runtime_error);
+    std::thread([&]() { EXPECT_THROW(wal.flush(wal.append(1, 0, page)), std::runtime_error); }).join();
+    EXPECT_EQ(wal.getNumFlushes(), 0);
+}
+
+TEST_F(VMCacheFixture, wal_recovery_commit_order) {
+    cache = nullptr;
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+        config.use_wal = true;
+        config.num_workers = 2;
+        VMCache* crashing_cache = new VMCache(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+        PageId pid = crashing_cache->allocatePage(0);
+        crashing_cache->unfixExclusive(pid);
+        // two transactions modify the same page one after the other, but the later one commits first
+        for (uint32_t worker_id = 0; worker_id < 2; worker_id++) {
+            crashing_cache->beginTransaction(worker_id);
+            uint64_t* page = reinterpret_cast<uint64_t*>(crashing_cache->fixExclusive(pid, worker_id));
+            page[0] = TEST_MAGIC + worker_id;
+            crashing_cache->unfixExclusive(pid, worker_id);
+        }
+        crashing_cache->commitTransaction(1);
+        crashing_cache->commitTransaction(0);
+        // crash without writing back any dirty pages
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    // the image captured last is restored, although the other one was logged after it
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.use_wal = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(0, 0));
+    EXPECT_EQ(page[0], TEST_MAGIC + 1);
+    cache->unfixShared(0);
+    cache = nullptr;
+    unlink((path + ".wal").c_str());
+}
+
+TEST_F(VMCacheFixture, wal_free_page_list_recovery) {
+    cache = nullptr;
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+        config.use_wal = true;
+        VMCache* crashing_cache = new VMCache(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+        const PageId anchor_pid = crashing_cache->allocatePage(0);
+        *reinterpret_cast<FreePageListAnchor*>(crashing_cache->fixExclusive(anchor_pid, 0)) = { INVALID_PAGE_ID, 0 };
+        crashing_cache->unfixExclusive(anchor_pid);
+        crashing_cache->openFreePageList(anchor_pid, 0, 0);
+        std::vector<PageId> pids;
+        for (size_t i = 0; i < 3; i++) {
+            pids.push_back(crashing_cache->allocatePage(0));
+            crashing_cache->unfixExclusive(pids.back());
+        }
+        crashing_cache->checkpoint();
+        // the transaction frees two pages and allocates one of them again
+        crashing_cache->beginTransaction(0);
+        for (size_t i = 0; i < 2; i++) {
+            crashing_cache->fixExclusive(pids[i], 0);
+            crashing_cache->freePage(pids[i], 0);
+        }
+        PageId pid = crashing_cache->allocatePage(0);
+        uint64_t* page = reinterpret_cast<uint64_t*>(crashing_cache->fixExclusive(pid, 0));
+        page[0] = TEST_MAGIC;
+        crashing_cache->unfixExclusive(pid, 0);
+        crashing_cache->commitTransaction(0);
+        // crash without writing back any dirty pages
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    // the anchor was logged with the transaction, so only the page that remained free is handed out again
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.use_wal = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    cache->openFreePageList(0, 0, 0);
+    EXPECT_EQ(cache->getNumFreePages(), 1ul);
+    EXPECT_EQ(cache->getFreePageListHead(), 1ul);
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(2, 0));
+    EXPECT_EQ(page[0], TEST_MAGIC);
+    cache->unfixShared(2);
+    cache = nullptr;
+    unlink((path + ".wal").c_str());
+}
+
+TEST_F(VMCacheFixture, wal_no_steal) {
+    cache = nullptr;
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    VMCacheConfig config = makeConfig((MAX_PHYSICAL_PAGES + 1) * PAGE_SIZE, 128);
+    config.use_wal = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    PageId pid = cache->allocatePage(0);
+    cache->unfixExclusive(pid);
+    cache->checkpoint();
+
+    // the page is modified and released by a transaction that has not committed yet
+    cache->beginTransaction(0);
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
+    page[0] = TEST_MAGIC;
+    cache->unfixExclusive(pid, 0);
+    page[0] = 0; // not part of the transaction's image
+    EXPECT_TRUE(PAGE_UNCOMMITTED(cache->getPageState(pid).load()));
+
+    // neither checkpoints nor evictions write the page
+    EXPECT_EQ(cache->checkpoint(), 0);
+    cache->evictAll(false, 0);
+    EXPECT_NE(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+
+    // after the commit the page can be written back and evicted
+    cache->commitTransaction(0);
+    EXPECT_FALSE(PAGE_UNCOMMITTED(cache->getPageState(pid).load()));
+    EXPECT_EQ(cache->checkpoint(), 1);
+    cache->evictAll(false, 0);
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+    cache = nullptr;
+    unlink((path + ".wal").c_str());
+}
+
+TEST_F(VMCacheFixture, lazy_page_state_initialization) {
+    // page states are not initialized explicitly, pages that have never been allocated have to read as evicted
+    for (PageId pid = 0; pid < 128; pid++)
+        EXPECT_EQ(cache->getPageState(pid).load(), PAGE_STATE_EVICTED);
+
+    PageId pid = cache->allocatePage(0);
+    uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pid, 0));
+    page[0] = TEST_MAGIC;
+    cache->unfixExclusive(pid);
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_UNLOCKED);
+
+    // evicting all pages only needs to consider allocated pages
+    cache->evictAll(true, 0);
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+    EXPECT_EQ(cache->getDirtyPageCount(), 0);
+    page = reinterpret_cast<uint64_t*>(cache->fixShared(pid, 0));
+    EXPECT_EQ(page[0], TEST_MAGIC);
+    cache->unfixShared(pid);
+}
+
+TEST_F(VMCacheFixture, scan_resistant_eviction) {
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(256 * PAGE_SIZE, 4096), createPartitioningStrategy<BasicPartitioningStrategy>("2q"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    ASSERT_GT(max_physical_pages, 32);
+
+    // establish a hot set of pages that are accessed by point operations
+    std::vector<PageId> hot_pids;
+    for (size_t i = 0; i < max_physical_pages / 4; i++) {
+        hot_pids.push_back(cache->allocatePage(0));
+        cache->fixShared(hot_pids.back(), 0);
+        cache->unfixShared(hot_pids.back());
+    }
+    // a scan over more pages than fit into the cache must not evict the hot set
+    std::vector<PageId> scan_pids;
+    for (size_t i = 0; i < 4 * max_physical_pages; i++)
+        scan_pids.push_back(cache->allocatePage(0));
+    for (PageId pid : scan_pids) {
+        cache->fixShared(pid, 0, true);
+        cache->unfixShared(pid);
+    }
+    EXPECT_GT(cache->getTotalEvictedPageCount(), 0);
+    for (PageId pid : hot_pids)
+        EXPECT_NE(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+}
+
+TEST_F(VMCacheFixture, scan_resistant_eviction_skipped_candidates) {
+    cache = nullptr;
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    VMCacheConfig config = makeConfig(256 * PAGE_SIZE, 4096);
+    config.use_wal = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("2q"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    auto scan = [&](size_t num_pages) {
+        std::vector<PageId> pids;
+        for (size_t i = 0; i < num_pages; i++) {
+            pids.push_back(cache->allocatePage(0));
+            cache->fixShared(pids.back(), 0, true);
+            cache->unfixShared(pids.back());
+        }
+        return pids;
+    };
+
+    // probationary pages modified by a transaction that has not committed yet are selected for eviction, but cannot be evicted
+    const std::vector<PageId> scan_pids = scan(max_physical_pages);
+    std::vector<PageId> modified_pids;
+    cache->beginTransaction(0);
+    for (auto it = scan_pids.rbegin(); it != scan_pids.rend() && modified_pids.size() < 8; ++it) {
+        // latching a marked page exclusively would promote it to the main clock
+        if (PAGE_STATE(cache->getPageState(*it).load()) != PAGE_STATE_UNLOCKED)
+            continue;
+        reinterpret_cast<uint64_t*>(cache->fixExclusive(*it, 0))[0] = TEST_MAGIC;
+        cache->unfixExclusive(*it, 0);
+        modified_pids.push_back(*it);
+    }
+    ASSERT_EQ(modified_pids.size(), 8);
+    scan(2 * max_physical_pages);
+    for (PageId pid : modified_pids)
+        ASSERT_NE(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+
+    // they remain in the probationary queue, so that they are evicted by later scans once they are committed
+    //  note: committing latches the pages exclusively again, which promotes the ones that are currently marked
+    std::vector<PageId> probationary_pids;
+    for (PageId pid : modified_pids) {
+        if (PAGE_STATE(cache->getPageState(pid).load()) == PAGE_STATE_UNLOCKED)
+            probationary_pids.push_back(pid);
+    }
+    ASSERT_FALSE(probationary_pids.empty());
+    cache->commitTransaction(0);
+    scan(2 * max_physical_pages);
+    for (PageId pid : probationary_pids)
+        EXPECT_EQ(PAGE_STATE(cache->getPageState(pid).load()), PAGE_STATE_EVICTED);
+    cache = nullptr;
+    unlink((path + ".wal").c_str());
+}
+
+TEST_F(VMCacheFixture, adaptive_data_temp_partitioning) {
+    auto strategy = std::make_unique<DataTempPartitioningStrategy<ClockEvictionCachePartition>>(16, true);
+    DataTempPartitioningStrategy<ClockEvictionCachePartition>* data_temp_strategy = strategy.get();
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(256 * PAGE_SIZE, 4096), std::move(strategy));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    ASSERT_EQ(data_temp_strategy->getMaxTempPhysicalPages(), 16);
+
+    // fill the data partition
+    PageId pid = 0;
+    for (; pid < max_physical_pages; pid++) {
+        cache->allocatePage(0);
+        cache->fixShared(pid, 0);
+        cache->unfixShared(pid);
+    }
+    // temporary allocations exceeding the reservation grow the temporary partition at the expense of the data partition
+    std::vector<char*> pages;
+    for (size_t i = 0; i < max_physical_pages / 2; i++)
+        pages.push_back(cache->allocateTemporaryPage(0));
+    const size_t grown_temp_pages = data_temp_strategy->getMaxTempPhysicalPages();
+    EXPECT_GE(grown_temp_pages, max_physical_pages / 2);
+    EXPECT_GT(data_temp_strategy->getNumResizes(), 0);
+    EXPECT_LE(cache->getPartitions().getCurrentPhysicalDataPageCount() + cache->getPartitions().getCurrentPhysicalTempPageCount(), max_physical_pages);
+    // the data pages could be evicted right away, so the capacity was never exceeded
+    EXPECT_EQ(data_temp_strategy->getMaxOvershootPages(), 0);
+    for (char* page : pages)
+        cache->dropTemporaryPage(page, 0);
+    cache->releaseTemporaryPagePool(0);
+
+    // once the temporary memory is unused and data pages are faulted, adaptation hands memory back to the data partition
+    data_temp_strategy->adapt(); // ends the interval in which temporary allocations had to wait
+    EXPECT_EQ(data_temp_strategy->getMaxTempPhysicalPages(), grown_temp_pages);
+    for (size_t i = 0; i < max_physical_pages; i++, pid++) {
+        cache->allocatePage(0);
+        cache->fixShared(pid, 0);
+        cache->unfixShared(pid);
+    }
+    data_temp_strategy->adapt();
+    EXPECT_LT(data_temp_strategy->getMaxTempPhysicalPages(), grown_temp_pages);
+}
+
+TEST_F(VMCacheFixture, adaptive_data_temp_partitioning_without_idle_workers) {
+    auto strategy = std::make_unique<DataTempPartitioningStrategy<ClockEvictionCachePartition>>(16, true);
+    DataTempPartitioningStrategy<ClockEvictionCachePartition>* data_temp_strategy = strategy.get();
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(256 * PAGE_SIZE, 4096), std::move(strategy));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    auto fault_data_pages = [&](size_t num_pages) {
+        for (size_t i = 0; i < num_pages; i++) {
+            const PageId pid = cache->allocatePage(0);
+            cache->fixShared(pid, 0);
+            cache->unfixShared(pid);
+        }
+    };
+
+    fault_data_pages(max_physical_pages);
+    std::vector<char*> pages;
+    for (size_t i = 0; i < max_physical_pages / 2; i++)
+        pages.push_back(cache->allocateTemporaryPage(0));
+    const size_t grown_temp_pages = data_temp_strategy->getMaxTempPhysicalPages();
+    EXPECT_GE(grown_temp_pages, max_physical_pages / 2);
+    for (char* page : pages)
+        cache->dropTemporaryPage(page, 0);
+    cache->releaseTemporaryPagePool(0);
+
+    // without idle maintenance, data page faults end the adaptation intervals and hand the unused temporary memory back
+    std::this_thread::sleep_for(std::chrono::microseconds(PARTITION_ADAPTATION_INTERVAL_US));
+    fault_data_pages(1); // ends the interval in which temporary allocations had to wait
+    EXPECT_EQ(data_temp_strategy->getMaxTempPhysicalPages(), grown_temp_pages);
+    fault_data_pages(max_physical_pages);
+    std::this_thread::sleep_for(std::chrono::microseconds(PARTITION_ADAPTATION_INTERVAL_US));
+    fault_data_pages(1);
+    EXPECT_LT(data_temp_strategy->getMaxTempPhysicalPages(), grown_temp_pages);
+}
+
+TEST_F(VMCacheFixture, adaptive_data_temp_partitioning_overshoot) {
+    auto strategy = std::make_unique<DataTempPartitioningStrategy<ClockEvictionCachePartition>>(16, true);
+    DataTempPartitioningStrategy<ClockEvictionCachePartition>* data_temp_strategy = strategy.get();
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(256 * PAGE_SIZE, 4096), std::move(strategy));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    const size_t data_pages = max_physical_pages - 16;
+    // fill the data partition with pages that stay latched, so that they cannot be evicted when the temporary partition grows
+    for (PageId pid = 0; pid < data_pages; pid++) {
+        cache->allocatePage(0);
+        cache->fixShared(pid, 0);
+    }
+    std::vector<char*> pages;
+    for (size_t i = 0; i < 32; i++)
+        pages.push_back(cache->allocateTemporaryPage(0));
+    // the capacity is exceeded by the temporary pages that did not fit, but by no more
+    EXPECT_GT(data_temp_strategy->getMaxOvershootPages(), 0);
+    EXPECT_LE(data_temp_strategy->getMaxOvershootPages(), 16);
+    for (char* page : pages)
+        cache->dropTemporaryPage(page, 0);
+    for (PageId pid = 0; pid < data_pages; pid++)
+        cache->unfixShared(pid);
+}
+
+TEST_F(VMCacheFixture, page_state_clock_eviction) {
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(64 * PAGE_SIZE, 4096), createPartitioningStrategy<BasicPartitioningStrategy>("state_clock"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    ASSERT_GT(max_physical_pages, 8);
+    // the residency bitmap is accounted with one bit per page state entry
+    EXPECT_EQ(cache->getPartitions().getPageStateMemoryCost(4096), 4096 / 8);
+
+    PageId spill_pid = cache->allocateSpillablePage(0);
+    cache->unfixExclusive(spill_pid);
+    // write more pages than fit into the cache, dirty pages are written back on eviction
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < 4 * max_physical_pages; i++) {
+        pids.push_back(cache->allocatePage(0));
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pids.back(), 0));
+        page[0] = TEST_MAGIC + i;
+        cache->unfixExclusive(pids.back());
+    }
+    EXPECT_GT(cache->getTotalEvictedPageCount(), 0);
+    EXPECT_EQ(PAGE_STATE(cache->getPageState(spill_pid).load()), PAGE_STATE_EVICTED);
+    size_t resident_pages = 0;
+    for (PageId pid : pids) {
+        if (PAGE_STATE(cache->getPageState(pid).load()) != PAGE_STATE_EVICTED)
+            resident_pages++;
+    }
+    EXPECT_LE(resident_pages, max_physical_pages);
+    EXPECT_LE(cache->getPartitions().getCurrentPhysicalDataPageCount(), max_physical_pages);
+
+    for (size_t i = 0; i < pids.size(); i++) {
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(pids[i], 0));
+        EXPECT_EQ(page[0], TEST_MAGIC + i);
+        cache->unfixShared(pids[i]);
+    }
+    cache->fixExclusive(spill_pid, 0);
+    cache->unfixExclusive(spill_pid);
+    cache->dropSpillablePage(spill_pid, 0);
+}
+
+TEST_F(VMCacheFixture, page_cleaners) {
+    cache = nullptr;
+    VMCacheConfig config = makeConfig(256 * PAGE_SIZE, 4096);
+    config.num_page_cleaners = 1;
+    config.page_cleaner_watermark = 0.25;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    const size_t free_pages = cache->getPageCleanerFreePages();
+    ASSERT_EQ(free_pages, max_physical_pages / 4);
+
+    // the page cleaner evicts pages in the background until the watermark is restored
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < max_physical_pages; i++) {
+        pids.push_back(cache->allocatePage(0));
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pids.back(), 0));
+        page[0] = TEST_MAGIC + i;
+        cache->unfixExclusive(pids.back());
+    }
+    for (size_t i = 0; i < 10000 && cache->getPartitions().getCurrentPhysicalDataPageCount() > static_cast<int64_t>(max_physical_pages - free_pages); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_LE(cache->getPartitions().getCurrentPhysicalDataPageCount(), static_cast<int64_t>(max_physical_pages - free_pages));
+    EXPECT_GT(cache->getTotalEvictedPageCount(), 0);
+
+    for (size_t i = 0; i < pids.size(); i++) {
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(pids[i], 0));
+        EXPECT_EQ(page[0], TEST_MAGIC + i);
+        cache->unfixShared(pids[i]);
+    }
+}
+
+TEST_F(VMCacheFixture, async_flushing_skips_dirty_candidates) {
+    cache = nullptr;
+    VMCacheConfig config = makeConfig(256 * PAGE_SIZE, 4096);
+    config.flush_asynchronously = true;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    ASSERT_EQ(cache->getPageCleanerFreePages(), 0);
+    // fixed latencies, so that the dirty page target does not depend on the measured ones
+    cache->getEvictionCosts().setFixedLatencies(EVICTION_COST_DEFAULT_READ_NS, EVICTION_COST_DEFAULT_WRITE_NS);
+
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < 2 * max_physical_pages; i++) {
+        pids.push_back(cache->allocatePage(0));
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pids.back(), 0));
+        page[0] = TEST_MAGIC + i;
+        cache->unfixExclusive(pids.back());
+    }
+    cache->evictAll(false, 0);
+    // fill the buffer pool with clean pages, a few of which are modified again
+    for (size_t i = 0; i < max_physical_pages; i++) {
+        cache->fixShared(pids[i], 0);
+        cache->unfixShared(pids[i]);
+    }
+    const size_t num_dirty = cache->getEvictionCosts().getDirtyPageTarget(max_physical_pages) / 2;
+    ASSERT_GT(num_dirty, 2);
+    for (size_t i = 0; i < num_dirty; i++) {
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pids[i], 0));
+        page[1] = TEST_MAGIC;
+        cache->unfixExclusive(pids[i]);
+    }
+    ASSERT_EQ(cache->getDirtyPageCount(), num_dirty);
+
+    // while idle workers write back dirty pages asynchronously and few pages are dirty, clean pages are evicted instead
+    //  (dirty pages are only selected when a clock sweep finds no other candidates, e.g., while pages are being marked)
+    const size_t dirty_writes = cache->getTotalDirtyWritePageCount();
+    const size_t evicted_pages = cache->getTotalEvictedPageCount();
+    for (size_t i = max_physical_pages; i < pids.size(); i++) {
+        const uint64_t* page = reinterpret_cast<const uint64_t*>(cache->fixShared(pids[i], 0));
+        EXPECT_EQ(page[0], TEST_MAGIC + i);
+        cache->unfixShared(pids[i]);
+    }
+    EXPECT_GE(cache->getTotalEvictedPageCount() - evicted_pages, max_physical_pages - num_dirty);
+    EXPECT_LT(cache->getTotalDirtyWritePageCount() - dirty_writes, num_dirty / 2);
+    size_t resident_dirty = 0;
+    for (size_t i = 0; i < num_dirty; i++)
+        resident_dirty += PAGE_STATE(cache->getPageState(pids[i]).load()) != PAGE_STATE_EVICTED;
+    EXPECT_GT(resident_dirty, num_dirty / 2);
+}
+
+TEST_F(VMCacheFixture, dirty_candidates_weighed_by_default) {
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(256 * PAGE_SIZE, 4096), createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    ASSERT_EQ(cache->getPageCleanerFreePages(), 0);
+    // writes are expensive, so dirty candidates are admitted for eviction in about one of ten attempts
+    cache->getEvictionCosts().setFixedLatencies(EVICTION_COST_DEFAULT_READ_NS, 9 * EVICTION_COST_DEFAULT_READ_NS);
+
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < 2 * max_physical_pages; i++) {
+        pids.push_back(cache->allocatePage(0));
+        cache->fixShared(pids.back(), 0);
+        cache->unfixShared(pids.back());
+    }
+    cache->evictAll(false, 0);
+    // fill the buffer pool, every other page is modified
+    for (size_t i = 0; i < max_physical_pages; i++) {
+        if (i % 2 == 0) {
+            cache->fixShared(pids[i], 0);
+            cache->unfixShared(pids[i]);
+        } else {
+            reinterpret_cast<uint64_t*>(cache->fixExclusive(pids[i], 0))[0] = TEST_MAGIC;
+            cache->unfixExclusive(pids[i]);
+        }
+    }
+
+    // without page cleaners or asynchronous flushing, clean pages are still evicted preferably
+    for (size_t i = max_physical_pages; i < max_physical_pages + max_physical_pages / 4; i++) {
+        cache->fixShared(pids[i], 0);
+        cache->unfixShared(pids[i]);
+    }
+    size_t evicted_clean = 0;
+    size_t evicted_dirty = 0;
+    for (size_t i = 0; i < max_physical_pages; i++) {
+        if (PAGE_STATE(cache->getPageState(pids[i]).load()) == PAGE_STATE_EVICTED)
+            (i % 2 == 0 ? evicted_clean : evicted_dirty)++;
+    }
+    EXPECT_GT(evicted_clean, 2 * evicted_dirty);
+}
+
+TEST_F(VMCacheFixture, compressed_page_tier) {
+    cache = nullptr;
+    VMCacheConfig config = makeConfig(512 * PAGE_SIZE, 4096);
+    config.compressed_tier_fraction = 0.25;
+    cache = std::make_shared<VMCache>(config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    ASSERT_NE(cache->getCompressedTier(), nullptr);
+    // the tier's memory is taken from the buffer frames
+    EXPECT_LT(max_physical_pages, 400);
+    EXPECT_GE(cache->getCompressedTier()->getCapacity(), 96 * PAGE_SIZE);
+
+    // mostly zeroed pages compress well, pages of random data do not
+    auto randomValue = [](uint64_t i, uint64_t j) {
+        uint64_t z = i * 4096 + j + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    };
+    std::vector<PageId> pids;
+    for (size_t i = 0; i < 2 * max_physical_pages; i++) {
+        pids.push_back(cache->allocatePage(0));
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixExclusive(pids.back(), 0));
+        page[0] = TEST_MAGIC + i;
+        if (i % 16 == 0) {
+            for (size_t j = 1; j < PAGE_SIZE / sizeof(uint64_t); j++)
+                page[j] = randomValue(i, j);
+        }
+        cache->unfixExclusive(pids.back());
+    }
+    EXPECT_GE(cache->getTotalEvictedPageCount(), max_physical_pages);
+    EXPECT_GT(cache->getCompressedTier()->getNumInsertedPages(), 0);
+    EXPECT_GT(cache->getCompressedTier()->getNumRejectedPages(), 0);
+    // the index is paid for out of the tier's budget
+    EXPECT_GT(cache->getCompressedTier()->getIndexMemory(), 0);
+    EXPECT_LT(cache->getCompressedTier()->getIndexMemory(), cache->getCompressedTier()->getCapacity());
+
+    // evicted pages are faulted from the tier without I/O, except for the incompressible ones
+    const size_t faulted_pages = cache->getTotalFaultedPageCount();
+    for (size_t i = 0; i < pids.size(); i++) {
+        uint64_t* page = reinterpret_cast<uint64_t*>(cache->fixShared(pids[i], 0));
+        EXPECT_EQ(page[0], TEST_MAGIC + i);
+        EXPECT_EQ(page[PAGE_SIZE / sizeof(uint64_t) - 1], i % 16 == 0 ? randomValue(i, PAGE_SIZE / sizeof(uint64_t) - 1) : 0);
+        cache->unfixShared(pids[i]);
+    }
+    EXPECT_GT(cache->getCompressedTier()->getNumHits(), 0);
+    EXPECT_LE(cache->getTotalFaultedPageCount() - faulted_pages, pids.size() / 16 + 1);
+}
+
+TEST_F(VMCacheFixture, extents) {
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(256 * PAGE_SIZE, 4096), createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    const size_t max_physical_pages = cache->getMaxPhysicalPages();
+    // extents take consecutive page ids, single pages and extents can be mixed
+    const PageId single_pid = cache->allocatePage(0);
+    std::vector<PageId> extents;
+    for (size_t i = 0; i < 2 * max_physical_pages / EXTENT_NUM_PAGES; i++) {
+        extents.push_back(cache->allocateExtent(0));
+        EXPECT_EQ(extents.back(), single_pid + 1 + i * EXTENT_NUM_PAGES);
+        EXPECT_EQ(cache->getPageCount(extents.back()), EXTENT_NUM_PAGES);
+        uint64_t* extent = reinterpret_cast<uint64_t*>(cache->fixExclusive(extents.back(), 0));
+        for (size_t j = 0; j < EXTENT_NUM_PAGES; j++)
+            extent[j * PAGE_SIZE / sizeof(uint64_t)] = TEST_MAGIC + i * EXTENT_NUM_PAGES + j;
+        cache->unfixExclusive(extents.back());
+    }
+    EXPECT_EQ(cache->getPageCount(single_pid), 1);
+    EXPECT_EQ(cache->getNumAllocatedPages(), 1 + extents.size() * EXTENT_NUM_PAGES);
+    // extents are accounted, evicted and written with all of their pages
+    EXPECT_LE(cache->getPartitions().getCurrentPhysicalDataPageCount(), static_cast<int64_t>(max_physical_pages));
+    EXPECT_GT(cache->getTotalEvictedPageCount(), 0);
+    EXPECT_EQ(cache->getTotalEvictedPageCount() % EXTENT_NUM_PAGES, 0);
+    EXPECT_EQ(cache->getTotalDirtyWritePageCount() % EXTENT_NUM_PAGES, 0);
+    cache->evictAll(false, 0);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalDataPageCount(), 0);
+
+    // an extent that is never written is not part of the database file
+    const PageId unwritten_pid = cache->allocateExtent(0);
+    EXPECT_EQ(unwritten_pid, single_pid + 1 + extents.size() * EXTENT_NUM_PAGES);
+
+    // the page class is restored from the extent file after a restart
+    cache = nullptr;
+    cache = std::make_shared<VMCache>(makeConfig(256 * PAGE_SIZE, 4096), createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    EXPECT_EQ(cache->getNumAllocatedPages(), 1 + extents.size() * EXTENT_NUM_PAGES);
+    EXPECT_EQ(cache->getPageCount(single_pid), 1);
+    for (const PageId pid : extents)
+        EXPECT_EQ(cache->getPageCount(pid), EXTENT_NUM_PAGES);
+    // the record of the unwritten extent was dropped, so its page ids are allocated again
+    EXPECT_EQ(cache->getPageCount(unwritten_pid), 1);
+    // prefetching reads adjacent extents with a single request
+    cache->prefetch(extents.data(), 2, true, 0);
+    EXPECT_EQ(cache->getTotalFaultedPageCount(), 2 * EXTENT_NUM_PAGES);
+    EXPECT_EQ(cache->getPartitions().getCurrentPhysicalDataPageCount(), static_cast<int64_t>(2 * EXTENT_NUM_PAGES));
+    for (size_t i = 0; i < extents.size(); i++) {
+        const uint64_t* extent = reinterpret_cast<const uint64_t*>(cache->fixShared(extents[i], 0));
+        for (size_t j = 0; j < EXTENT_NUM_PAGES; j++)
+            ASSERT_EQ(extent[j * PAGE_SIZE / sizeof(uint64_t)], TEST_MAGIC + i * EXTENT_NUM_PAGES + j);
+        cache->unfixShared(extents[i]);
+    }
+    EXPECT_EQ(cache->getTotalFaultedPageCount(), extents.size() * EXTENT_NUM_PAGES);
+    EXPECT_EQ(cache->allocatePage(0), unwritten_pid);
+
+    // extents cannot be combined with the write-ahead log, whose records hold single pages
+    cache = nullptr;
+    unlink(path.c_str());
+    VMCacheConfig wal_config = makeConfig(256 * PAGE_SIZE, 4096);
+    wal_config.use_wal = true;
+    cache = std::make_shared<VMCache>(wal_config, createPartitioningStrategy<BasicPartitioningStrategy>("clock"));
+    EXPECT_THROW(cache->allocateExtent(0), std::runtime_error);
+    cache = nullptr;
+    unlink((path + ".wal").c_str());
+}
+
+TEST(VMCache, current_worker_id) {
+    // the worker id is set per thread, unregistered threads use the fallback
+    std::thread([]() {
+        EXPECT_EQ(VMCache::getCurrentWorkerId(7), 7u);
+        VMCache::setCurrentWorkerId(3);
+        EXPECT_EQ(VMCache::getCurrentWorkerId(7), 3u);
+        std::thread([]() { EXPECT_EQ(VMCache::getCurrentWorkerId(7), 7u); }).join();
+    }).join();
+}
+
+TEST(EvictionCostModel, costs) {
+    EvictionCostModel costs;
+    // equal read and write latencies: dirty pages cost twice as much as clean pages
+    EXPECT_EQ(costs.getDirtyPageCost(), 2 * costs.getCleanPageCost());
+    EXPECT_EQ(costs.getDirtyPageTarget(1000), 50);
+    EXPECT_EQ(costs.getTempPageCost(0), costs.getDirtyPageCost());
+    EXPECT_EQ(costs.getTempPageCost(42), 42);
+
+    // slow writes: fewer dirty pages are tolerated and dirty candidates are admitted less often
+    for (size_t i = 0; i < 1000; i++)
+        costs.recordWrite(10, 10 * 900000);
+    EXPECT_GT(costs.getDirtyPageCost(), 9 * costs.getCleanPageCost());
+    EXPECT_LT(costs.getDirtyPageTarget(1000), 11);
+    size_t num_admitted = 0;
+    for (size_t i = 0; i < 10000; i++)
+        num_admitted += costs.admitDirtyCandidate();
+    EXPECT_GT(num_admitted, 500);
+    EXPECT_LT(num_admitted, 1500);
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "prototype/utils/lz_compression.hpp"
+
+static void expectRoundTrip(const std::string& input, size_t max_compressed_size) {
+    std::string compressed(input.size() + input.size() / 255 + 16, '\0');
+    const size_t len = lzCompress(input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_GT(len, 0);
+    EXPECT_LE(len, max_compressed_size);
+    std::string output(input.size(), '\0');
+    ASSERT_TRUE(lzDecompress(compressed.data(), len, output.data(), output.size()));
+    EXPECT_EQ(output, input);
+}
+
+TEST(LZCompression, round_trip) {
+    expectRoundTrip("", 1);
+    expectRoundTrip("abc", 4);
+    expectRoundTrip(std::string(4096, '\0'), 64);
+    std::string text;
+    for (size_t i = 0; text.size() < 4096; i++)
+        text += "ORDERLINE " + std::to_string(i % 97) + " STOCK " + std::to_string(i % 13) + ";";
+    expectRoundTrip(text, 2048);
+
+    std::mt19937_64 rng(42);
+    std::string random(4096, '\0');
+    for (char& c : random)
+        c = static_cast<char>(rng());
+    expectRoundTrip(random, 4096 + 4096 / 255 + 16);
+}
+
+TEST(LZCompression, limits) {
+    std::mt19937_64 rng(42);
+    std::string random(4096, '\0');
+    for (char& c : random)
+        c = static_cast<char>(rng());
+    char buffer[2048];
+    // incompressible input does not fit
+    EXPECT_EQ(lzCompress(random.data(), random.size(), buffer, sizeof(buffer)), 0);
+
+    const std::string zeros(4096, '\0');
+    const size_t len = lzCompress(zeros.data(), zeros.size(), buffer, sizeof(buffer));
+    ASSERT_GT(len, 0);
+    std::string output(4096, '\0');
+    // wrong output size and truncated input are detected
+    EXPECT_FALSE(lzDecompress(buffer, len, output.data(), 4095));
+    EXPECT_FALSE(lzDecompress(buffer, len - 2, output.data(), output.size()));
+    // a match referring to data before the beginning of the output is rejected
+    const char invalid[] = { 0x10, 'a', 0x05, 0x00 };
+    EXPECT_FALSE(lzDecompress(invalid, sizeof(invalid), output.data(), 5));
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "prototype/utils/sharded_hashset.hpp"
+
+TEST(ShardedHashSet, erase) {
+    ShardedHashSet<uint64_t> set(1024);
+    EXPECT_EQ(set.erase(1), 0);
+
+    set.insert(1);
+    EXPECT_TRUE(set.contains(1));
+    EXPECT_EQ(set.erase(1), 1);
+    EXPECT_EQ(set.erase(1), 0);
+    EXPECT_FALSE(set.contains(1));
+}
+
+TEST(ShardedHashSet, tombstone_reclamation) {
+    ShardedHashSet<uint64_t> set(16 * 1024);
+    EXPECT_EQ(set.shardCount(), 16);
+    for (uint64_t i = 0; i < 1000; i++)
+        set.insert(i);
+    // without reclamation, the tombstones would eventually fill all buckets and make inserts fail
+    for (uint64_t round = 0; round < 100; round++) {
+        for (uint64_t i = 1000 + round * 1000; i < 2000 + round * 1000; i++)
+            set.insert(i);
+        for (uint64_t i = 1000 + round * 1000; i < 2000 + round * 1000; i++)
+            EXPECT_EQ(set.erase(i), 1);
+        EXPECT_LE(set.getNumTombstones(), set.shardCount() * (set.shardBucketCount() / 4));
+    }
+    for (uint64_t i = 0; i < 1000; i++)
+        EXPECT_TRUE(set.contains(i));
+    EXPECT_FALSE(set.contains(1000));
+}
+
+TEST(ShardedHashSet, concurrent_insert_erase) {
+    ShardedHashSet<uint64_t> set(8 * 1024);
+    const size_t num_threads = 4;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&set, t]() {
+            for (uint64_t round = 0; round < 50; round++) {
+                for (uint64_t i = 0; i < 500; i++)
+                    set.insert(t * 1000000 + round * 1000 + i);
+                for (uint64_t i = 0; i < 500; i++)
+                    EXPECT_EQ(set.erase(t * 1000000 + round * 1000 + i), 1);
+            }
+            for (uint64_t i = 0; i < 100; i++)
+                set.insert(t * 1000000 + i);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    size_t num_keys = 0;
+    for (size_t i = 0; i < set.bucketCount(); i++) {
+        const uint64_t key = set.getBucket(i);
+        if (key != decltype(set)::empty_bucket && key != decltype(set)::tombstone_bucket)
+            num_keys++;
+    }
+    EXPECT_EQ(num_keys, num_threads * 100);
+}
+
+TEST(ShardedHashSet, full_shard) {
+    ShardedHashSet<uint64_t> set(1024);
+    ASSERT_EQ(set.shardCount(), 1);
+    for (uint64_t i = 0; i < set.shardBucketCount(); i++)
+        set.insert(i);
+    EXPECT_FALSE(set.insert(set.shardBucketCount()));
+    EXPECT_TRUE(set.contains(0));
+    EXPECT_FALSE(set.contains(set.shardBucketCount()));
+    // the failed insert has left the shard, so that it can be modified again
+    EXPECT_EQ(set.erase(0), 1);
+    set.insert(set.shardBucketCount());
+    EXPECT_TRUE(set.contains(set.shardBucketCount()));
+}
+
+TEST(ShardedHashSet, concurrent_contains_during_reclamation) {
+    ShardedHashSet<uint64_t> set(2 * 1024);
+    for (uint64_t i = 0; i < 200; i++)
+        set.insert(i);
+    std::atomic_bool done { false };
+    std::thread reader([&set, &done]() {
+        // the keys inserted before are never erased, lookups have to find them while tombstones are reclaimed
+        while (!done)
+            for (uint64_t i = 0; i < 200; i++)
+                EXPECT_TRUE(set.contains(i));
+    });
+    for (uint64_t round = 0; round < 200; round++) {
+        for (uint64_t i = 1000 + round * 500; i < 1500 + round * 500; i++)
+            set.insert(i);
+        for (uint64_t i = 1000 + round * 500; i < 1500 + round * 500; i++)
+            EXPECT_EQ(set.erase(i), 1);
+    }
+    done = true;
+    reader.join();
+}
+
+TEST(ShardedHashSet, shard_headroom) {
+    // the shards together can hold more keys than requested, so that skewed shards do not fill up
+    ShardedHashSet<uint64_t> set(16 * 1024);
+    ASSERT_GT(set.shardCount(), 1);
+    EXPECT_GE(set.shardBucketCount(), 16 * 1024 / set.shardCount() + SHARDED_HASHSET_SHARD_HEADROOM_SIGMAS * 32);
+    for (uint64_t i = 0; i < 16 * 1024; i++)
+        ASSERT_TRUE(set.insert(i));
+    for (uint64_t i = 0; i < 16 * 1024; i++)
+        ASSERT_TRUE(set.contains(i));
+}
+
+TEST(ShardedHashSet, shard_clocks) {
+    ShardedHashSet<uint64_t> set(4 * 1024);
+    ASSERT_GT(set.shardCount(), 1);
+    EXPECT_EQ(set.advanceClock(0, 10), 0);
+    EXPECT_EQ(set.advanceClock(0, set.shardBucketCount()), 10);
+    EXPECT_EQ(set.advanceClock(0, 1), 10);
+    // each shard has its own clock hand
+    EXPECT_EQ(set.advanceClock(1, 1), 0);
+}
\ No newline at end of file
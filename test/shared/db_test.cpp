@@ -29,7 +29,11 @@ void DBTestFixture::SetUp() {
             throw std::runtime_error("Failed to delete existing test database");
     }
     uint64_t num_workers = JobManager::configureNumThreads(1);
-    db = std::make_shared<DB>(16ull * 1024ull * 1024ull * 1024ull, path, false, false, false, false, num_workers + 1, false);
+    VMCacheConfig config;
+    config.max_size = 16ull * 1024ull * 1024ull * 1024ull;
+    config.path = path;
+    config.num_workers = num_workers + 1;
+    db = std::make_shared<DB>(config);
     job_manager = std::make_shared<JobManager>(num_workers, *db);
     context = std::make_shared<ExecutionContext>(*job_manager, *db, 0, num_workers, false);
 }
@@ -42,6 +46,7 @@ void DBTestFixture::TearDown() {
 
     if (unlink(path.c_str()) != 0)
         throw std::runtime_error("Failed to delete test database");
+    unlink((path + ".extents").c_str()); // only created if extents were used
     if (unlink(lock_path.c_str()) != 0)
         throw std::runtime_error("Failed to delete test lock file");
     flock(lock_fd, LOCK_UN);